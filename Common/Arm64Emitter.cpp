@@ -3169,6 +3169,35 @@ void ARM64FloatEmitter::SMAX(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
 {
 	EmitThreeSame(0, EncodeSize(size), 0xC, Rd, Rn, Rm);
 }
+void ARM64FloatEmitter::ADD(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
+{
+	EmitThreeSame(0, EncodeSize(size), 0x10, Rd, Rn, Rm);
+}
+void ARM64FloatEmitter::SUB(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
+{
+	EmitThreeSame(1, EncodeSize(size), 0x10, Rd, Rn, Rm);
+}
+void ARM64FloatEmitter::MUL(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
+{
+	_assert_msg_(size != 64, "%s doesn't support 64-bit lanes", __FUNCTION__);
+	EmitThreeSame(0, EncodeSize(size), 0x13, Rd, Rn, Rm);
+}
+void ARM64FloatEmitter::SQADD(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
+{
+	EmitThreeSame(0, EncodeSize(size), 0x1, Rd, Rn, Rm);
+}
+void ARM64FloatEmitter::UQADD(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
+{
+	EmitThreeSame(1, EncodeSize(size), 0x1, Rd, Rn, Rm);
+}
+void ARM64FloatEmitter::SQSUB(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
+{
+	EmitThreeSame(0, EncodeSize(size), 0x5, Rd, Rn, Rm);
+}
+void ARM64FloatEmitter::UQSUB(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm)
+{
+	EmitThreeSame(1, EncodeSize(size), 0x5, Rd, Rn, Rm);
+}
 void ARM64FloatEmitter::FNEG(u8 size, ARM64Reg Rd, ARM64Reg Rn)
 {
 	Emit2RegMisc(IsQuad(Rd), 1, 2 | (size >> 6), 0xF, Rd, Rn);
@@ -3239,6 +3268,14 @@ void ARM64FloatEmitter::UQXTN2(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn)
 {
 	Emit2RegMisc(true, 1, dest_size >> 4, 0x14, Rd, Rn);
 }
+void ARM64FloatEmitter::SQXTUN(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn)
+{
+	Emit2RegMisc(false, 1, dest_size >> 4, 0x12, Rd, Rn);
+}
+void ARM64FloatEmitter::SQXTUN2(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn)
+{
+	Emit2RegMisc(true, 1, dest_size >> 4, 0x12, Rd, Rn);
+}
 void ARM64FloatEmitter::XTN(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn)
 {
 	Emit2RegMisc(false, 0, dest_size >> 4, 0x12, Rd, Rn);
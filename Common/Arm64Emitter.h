@@ -884,6 +884,15 @@ class ARM64FloatEmitter
 	void SMIN(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
 	void SMAX(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
 
+	// Integer arithmetic, size is the lane size.
+	void ADD(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
+	void SUB(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
+	void MUL(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
+	void SQADD(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
+	void UQADD(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
+	void SQSUB(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
+	void UQSUB(u8 size, ARM64Reg Rd, ARM64Reg Rn, ARM64Reg Rm);
+
 	void REV16(u8 size, ARM64Reg Rd, ARM64Reg Rn);
 	void REV32(u8 size, ARM64Reg Rd, ARM64Reg Rn);
 	void REV64(u8 size, ARM64Reg Rd, ARM64Reg Rn);
@@ -895,6 +904,8 @@ class ARM64FloatEmitter
 	void SQXTN2(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn);
 	void UQXTN(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn);
 	void UQXTN2(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn);
+	void SQXTUN(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn);
+	void SQXTUN2(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn);
 	void XTN(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn);
 	void XTN2(u8 dest_size, ARM64Reg Rd, ARM64Reg Rn);
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Sorted keys laid out as an implicit binary search tree in BFS order (Eytzinger layout), so a
+// search walks down the array instead of hopping all over it, and the first few levels share
+// cache lines.  Answers the same questions as std::lower_bound/upper_bound on the sorted keys,
+// as positions in that sorted order.
+class EytzingerIndex {
+public:
+	void Build(const std::vector<u32> &sorted) {
+		keys_.resize(sorted.size() + 1);
+		ranks_.resize(sorted.size() + 1);
+		size_t next = 0;
+		Fill(sorted, next, 1);
+	}
+
+	size_t size() const {
+		return keys_.empty() ? 0 : keys_.size() - 1;
+	}
+
+	// Number of keys <= key.
+	size_t UpperBound(u32 key) const {
+		size_t n = size();
+		size_t k = 1;
+		while (k <= n)
+			k = 2 * k + (keys_[k] <= key ? 1 : 0);
+		return Resolve(k, n);
+	}
+
+	// Number of keys < key.
+	size_t LowerBound(u32 key) const {
+		size_t n = size();
+		size_t k = 1;
+		while (k <= n)
+			k = 2 * k + (keys_[k] < key ? 1 : 0);
+		return Resolve(k, n);
+	}
+
+private:
+	void Fill(const std::vector<u32> &sorted, size_t &next, size_t k) {
+		if (k >= keys_.size())
+			return;
+		Fill(sorted, next, 2 * k);
+		ranks_[k] = (u32)next;
+		keys_[k] = sorted[next++];
+		Fill(sorted, next, 2 * k + 1);
+	}
+
+	size_t Resolve(size_t k, size_t n) const {
+		// Undo the trailing right turns and the last left turn, that's the first key that didn't match.
+		while (k & 1)
+			k >>= 1;
+		k >>= 1;
+		return k == 0 ? n : ranks_[k];
+	}
+
+	// 1-based, keys_[0] is unused.
+	std::vector<u32> keys_;
+	std::vector<u32> ranks_;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <string>
@@ -24,7 +25,7 @@ class PathBrowser {
 		HandlePath();
 	}
 	bool IsListingReady();
-	bool GetListing(std::vector<File::FileInfo> &fileInfo, const char *filter = nullptr, bool *cancel = nullptr);
+	bool GetListing(std::vector<File::FileInfo> &fileInfo, const char *filter = nullptr, std::atomic<bool> *cancel = nullptr);
 
 	bool CanNavigateUp();
 	void NavigateUp();
@@ -67,7 +68,7 @@ class PathBrowser {
 	std::mutex pendingLock_;
 	std::thread pendingThread_;
 	bool pendingActive_ = false;
-	bool pendingCancel_ = false;
+	std::atomic<bool> pendingCancel_{ false };
 	bool pendingStop_ = false;
 	bool ready_ = false;
 	bool success_ = true;
@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+#include "Common/Common.h"
+#include "Common/Log.h"
+#include "Common/File/VFS/PackFileReader.h"
+#include "Common/StringUtils.h"
+#include "ext/xxhash.h"
+
+#ifdef PACK_FILE_READER_MMAP
+#include <sys/mman.h>
+#endif
+
+// File layout, all little endian:
+//   PackFileHeader
+//   u32 buckets[(1 << bucketBits) + 1]: first entry with each value of the top bits of the hash.
+//   PackFileEntry entries[entryCount]: sorted by nameHash.
+//   names, not terminated, as they were packed.
+//   file data.
+static const char PACK_MAGIC[4] = { 'P', 'P', 'K', 'G' };
+static const uint32_t PACK_VERSION = 1;
+static const uint64_t PACK_PAGE_SIZE = 4096;
+// Small files are only aligned this much (but kept within a page.)
+static const uint64_t PACK_SMALL_ALIGN = 16;
+
+struct PackFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t bucketBits;
+	uint64_t bucketsOffset;
+	uint64_t entriesOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+
+struct PackFileEntry {
+	uint64_t nameHash;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+static_assert(sizeof(PackFileHeader) == 48, "Pack file header layout changed");
+static_assert(sizeof(PackFileEntry) == 32, "Pack file entry layout changed");
+
+// Both when packing and looking up: case insensitive, forward slashes, no leading slash.
+static std::string NormalizePackPath(const char *path) {
+	while (*path == '/' || *path == '\\')
+		path++;
+	std::string normalized = path;
+	for (char &c : normalized) {
+		if (c == '\\')
+			c = '/';
+		else if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+	}
+	return normalized;
+}
+
+static uint64_t HashPackPath(const std::string &normalized) {
+	return XXH3_64bits(normalized.data(), normalized.size());
+}
+
+// Aim for a handful of entries per bucket.
+static uint32_t BucketBitsForCount(size_t count) {
+	uint32_t bits = 0;
+	while (bits < 24 && ((size_t)4 << bits) < count)
+		bits++;
+	return bits;
+}
+
+static uint32_t BucketForHash(uint64_t hash, uint32_t bits) {
+	return bits == 0 ? 0 : (uint32_t)(hash >> (64 - bits));
+}
+
+PackFileReader *PackFileReader::Create(const Path &packFile, bool logErrors) {
+	PackFileReader *reader = new PackFileReader(packFile);
+	if (!reader->Open(logErrors)) {
+		delete reader;
+		return nullptr;
+	}
+	return reader;
+}
+
+bool PackFileReader::Open(bool logErrors) {
+	if (!file_.Open(path_, "rb")) {
+		if (logErrors)
+			ERROR_LOG(Log::IO, "Failed to open %s as a pack file", path_.c_str());
+		return false;
+	}
+
+	uint64_t fileSize = file_.GetSize();
+	PackFileHeader header{};
+	if (fileSize < sizeof(header) || !file_.ReadBytes(&header, sizeof(header)) || memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0) {
+		if (logErrors)
+			ERROR_LOG(Log::IO, "%s is not a pack file", path_.c_str());
+		return false;
+	}
+	if (header.version != PACK_VERSION) {
+		if (logErrors)
+			ERROR_LOG(Log::IO, "%s has unsupported pack version %d", path_.c_str(), header.version);
+		return false;
+	}
+
+	uint64_t bucketsSize = ((1ULL << std::min(header.bucketBits, 24U)) + 1) * sizeof(uint32_t);
+	uint64_t entriesSize = (uint64_t)header.entryCount * sizeof(PackFileEntry);
+	// Bounds are written as subtractions from fileSize, so a huge size can't wrap around past the check.
+	if (header.bucketBits > 24 || header.bucketsOffset != sizeof(header) || header.entriesOffset != header.bucketsOffset + bucketsSize ||
+		header.entriesOffset > fileSize || entriesSize > fileSize - header.entriesOffset ||
+		header.namesOffset != header.entriesOffset + entriesSize ||
+		header.namesOffset > fileSize || header.namesSize > fileSize - header.namesOffset) {
+		if (logErrors)
+			ERROR_LOG(Log::IO, "%s has a corrupt pack index", path_.c_str());
+		return false;
+	}
+
+#ifdef PACK_FILE_READER_MMAP
+	void *ptr = mmap(nullptr, (size_t)fileSize, PROT_READ, MAP_SHARED, fileno(file_.GetHandle()), 0);
+	if (ptr != MAP_FAILED) {
+		mapped_ = (const uint8_t *)ptr;
+		mappedSize_ = fileSize;
+		// The index is what we'll be hitting all the time.
+		madvise((void *)mapped_, (size_t)(header.namesOffset + header.namesSize), MADV_WILLNEED);
+	} else {
+		WARN_LOG(Log::IO, "Unable to map %s, using reads", path_.c_str());
+	}
+#endif
+
+	const uint8_t *index;
+	if (mapped_) {
+		index = mapped_;
+	} else {
+		// Keep the header in index_ too, so the offsets work the same way.
+		index_.resize((size_t)(header.namesOffset + header.namesSize));
+		memcpy(&index_[0], &header, sizeof(header));
+		if (!file_.ReadBytes(&index_[sizeof(header)], index_.size() - sizeof(header))) {
+			if (logErrors)
+				ERROR_LOG(Log::IO, "Failed to read the index of %s", path_.c_str());
+			return false;
+		}
+		index = index_.data();
+	}
+
+	buckets_ = (const uint32_t *)(index + header.bucketsOffset);
+	entries_ = (const PackFileEntry *)(index + header.entriesOffset);
+	names_ = (const char *)(index + header.namesOffset);
+	entryCount_ = header.entryCount;
+	bucketBits_ = header.bucketBits;
+
+	// Checked once here, so lookups and reads can trust the index.
+	if (!ValidateIndex(fileSize, header.namesSize)) {
+		if (logErrors)
+			ERROR_LOG(Log::IO, "%s has a corrupt pack index", path_.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool PackFileReader::ValidateIndex(uint64_t fileSize, uint64_t namesSize) {
+	uint32_t bucketCount = 1U << bucketBits_;
+	for (uint32_t b = 0; b < bucketCount; ++b) {
+		if (buckets_[b] > buckets_[b + 1] || buckets_[b + 1] > entryCount_)
+			return false;
+	}
+	if (buckets_[0] != 0 || buckets_[bucketCount] != entryCount_)
+		return false;
+
+	for (uint32_t i = 0; i < entryCount_; ++i) {
+		const PackFileEntry &entry = entries_[i];
+		if ((uint64_t)entry.nameOffset + entry.nameLength > namesSize)
+			return false;
+		if (entry.offset > fileSize || entry.size > fileSize - entry.offset)
+			return false;
+		if (i > 0 && entries_[i - 1].nameHash > entry.nameHash)
+			return false;
+		uint32_t b = BucketForHash(entry.nameHash, bucketBits_);
+		if (i < buckets_[b] || i >= buckets_[b + 1])
+			return false;
+	}
+	return true;
+}
+
+PackFileReader::~PackFileReader() {
+#ifdef PACK_FILE_READER_MMAP
+	if (mapped_)
+		munmap((void *)mapped_, (size_t)mappedSize_);
+#endif
+}
+
+int PackFileReader::FindEntry(const char *path) const {
+	std::string normalized = NormalizePackPath(path);
+	uint64_t hash = HashPackPath(normalized);
+	uint32_t b = BucketForHash(hash, bucketBits_);
+
+	const PackFileEntry *first = entries_ + buckets_[b];
+	const PackFileEntry *last = entries_ + buckets_[b + 1];
+	first = std::lower_bound(first, last, hash, [](const PackFileEntry &entry, uint64_t h) {
+		return entry.nameHash < h;
+	});
+	// Collisions are astronomically unlikely, but let's not hand out the wrong texture if one happens.
+	for (; first != last && first->nameHash == hash; ++first) {
+		if (first->nameLength == normalized.size() && strncasecmp(names_ + first->nameOffset, normalized.c_str(), normalized.size()) == 0)
+			return (int)(first - entries_);
+	}
+	return -1;
+}
+
+size_t PackFileReader::ReadAt(const PackFileEntry &entry, uint64_t pos, void *buffer, size_t length) {
+	if (pos >= entry.size)
+		return 0;
+	length = (size_t)std::min((uint64_t)length, entry.size - pos);
+	if (mapped_) {
+		memcpy(buffer, mapped_ + entry.offset + pos, length);
+		return length;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!file_.Seek((int64_t)(entry.offset + pos), SEEK_SET))
+		return 0;
+	size_t readBytes = fread(buffer, 1, length, file_.GetHandle());
+	return readBytes;
+}
+
+uint8_t *PackFileReader::ReadFile(const char *path, size_t *size) {
+	int index = FindEntry(path);
+	if (index < 0) {
+		ERROR_LOG(Log::IO, "Error opening %s from pack", path);
+		return nullptr;
+	}
+
+	const PackFileEntry &entry = entries_[index];
+	uint8_t *contents = new uint8_t[(size_t)entry.size + 1];
+	size_t readBytes = ReadAt(entry, 0, contents, (size_t)entry.size);
+	contents[readBytes] = 0;
+	*size = readBytes;
+	return contents;
+}
+
+bool PackFileReader::GetFileListing(const char *orig_path, std::vector<File::FileInfo> *listing, const char *filter) {
+	std::string path = orig_path;
+	if (!path.empty() && path.back() != '/') {
+		path.push_back('/');
+	}
+
+	std::set<std::string> filters;
+	std::string tmp;
+	if (filter) {
+		while (*filter) {
+			if (*filter == ':') {
+				filters.emplace("." + tmp);
+				tmp.clear();
+			} else {
+				tmp.push_back(*filter);
+			}
+			filter++;
+		}
+	}
+
+	if (tmp.size())
+		filters.emplace("." + tmp);
+
+	// Same approach as the zip reader, there's no directory structure to use.
+	std::set<std::string> files;
+	std::set<std::string> directories;
+	bool anyPrefixMatched = false;
+	for (uint32_t i = 0; i < entryCount_; ++i) {
+		const PackFileEntry &entry = entries_[i];
+		const char *name = names_ + entry.nameOffset;
+		if (entry.nameLength <= path.size() || strncmp(name, path.c_str(), path.size()) != 0)
+			continue;
+
+		anyPrefixMatched = true;
+		const char *rest = name + path.size();
+		size_t restLength = entry.nameLength - path.size();
+		const char *slashPos = (const char *)memchr(rest, '/', restLength);
+		if (slashPos) {
+			directories.emplace(rest, slashPos - rest);
+		} else {
+			files.emplace(rest, restLength);
+		}
+	}
+	if (!anyPrefixMatched) {
+		return false;
+	}
+
+	listing->clear();
+	listing->reserve(directories.size() + files.size());
+	for (const std::string &dir : directories) {
+		File::FileInfo info;
+		info.name = dir;
+		info.fullName = Path(path + dir);
+		info.exists = true;
+		info.isWritable = false;
+		info.isDirectory = true;
+		listing->push_back(info);
+	}
+
+	for (const std::string &file : files) {
+		File::FileInfo info;
+		info.name = file;
+		info.fullName = Path(path + file);
+		info.exists = true;
+		info.isWritable = false;
+		info.isDirectory = false;
+		if (filter) {
+			std::string ext = info.fullName.GetFileExtension();
+			if (filters.find(ext) == filters.end()) {
+				continue;
+			}
+		}
+		listing->push_back(info);
+	}
+
+	std::sort(listing->begin(), listing->end());
+	return true;
+}
+
+bool PackFileReader::GetFileInfo(const char *path, File::FileInfo *info) {
+	info->isDirectory = false;
+	info->isWritable = false;
+	info->size = 0;
+
+	int index = FindEntry(path);
+	if (index < 0) {
+		// Like zips, we have no directory entries.
+		info->exists = false;
+		return false;
+	}
+
+	info->size = entries_[index].size;
+	info->fullName = Path(path);
+	info->exists = true;
+	return true;
+}
+
+class PackFileReaderFileReference : public VFSFileReference {
+public:
+	int index;
+};
+
+class PackFileReaderOpenFile : public VFSOpenFile {
+public:
+	PackFileReaderFileReference *reference;
+	uint64_t pos = 0;
+};
+
+VFSFileReference *PackFileReader::GetFile(const char *path) {
+	int index = FindEntry(path);
+	if (index < 0) {
+		return nullptr;
+	}
+	PackFileReaderFileReference *ref = new PackFileReaderFileReference();
+	ref->index = index;
+	return ref;
+}
+
+bool PackFileReader::GetFileInfo(VFSFileReference *vfsReference, File::FileInfo *fileInfo) {
+	PackFileReaderFileReference *reference = (PackFileReaderFileReference *)vfsReference;
+	*fileInfo = File::FileInfo{};
+	fileInfo->size = entries_[reference->index].size;
+	fileInfo->exists = true;
+	return true;
+}
+
+void PackFileReader::ReleaseFile(VFSFileReference *vfsReference) {
+	PackFileReaderFileReference *reference = (PackFileReaderFileReference *)vfsReference;
+	delete reference;
+}
+
+VFSOpenFile *PackFileReader::OpenFileForRead(VFSFileReference *vfsReference, size_t *size) {
+	PackFileReaderFileReference *reference = (PackFileReaderFileReference *)vfsReference;
+	// Nothing to lock or decompress, so unlike zips, any number can be open at once.
+	PackFileReaderOpenFile *openFile = new PackFileReaderOpenFile();
+	openFile->reference = reference;
+	*size = (size_t)entries_[reference->index].size;
+	return openFile;
+}
+
+void PackFileReader::Rewind(VFSOpenFile *vfsOpenFile) {
+	PackFileReaderOpenFile *openFile = (PackFileReaderOpenFile *)vfsOpenFile;
+	openFile->pos = 0;
+}
+
+size_t PackFileReader::Read(VFSOpenFile *vfsOpenFile, void *buffer, size_t length) {
+	PackFileReaderOpenFile *openFile = (PackFileReaderOpenFile *)vfsOpenFile;
+	size_t readBytes = ReadAt(entries_[openFile->reference->index], openFile->pos, buffer, length);
+	openFile->pos += readBytes;
+	return readBytes;
+}
+
+void PackFileReader::CloseFile(VFSOpenFile *vfsOpenFile) {
+	PackFileReaderOpenFile *openFile = (PackFileReaderOpenFile *)vfsOpenFile;
+	delete openFile;
+}
+
+const uint8_t *PackFileReader::MapFile(VFSFileReference *vfsReference, size_t *size) {
+	if (!mapped_)
+		return nullptr;
+	PackFileReaderFileReference *reference = (PackFileReaderFileReference *)vfsReference;
+	const PackFileEntry &entry = entries_[reference->index];
+	*size = (size_t)entry.size;
+	return mapped_ + entry.offset;
+}
+
+static void CollectPackFiles(VFSBackend *source, const std::string &dir, std::vector<std::string> &files) {
+	std::vector<File::FileInfo> listing;
+	if (!source->GetFileListing(dir.c_str(), &listing, nullptr))
+		return;
+	for (const File::FileInfo &info : listing) {
+		if (info.name.empty() || info.name[0] == '.')
+			continue;
+		std::string name = dir.empty() ? info.name : dir + "/" + info.name;
+		if (info.isDirectory)
+			CollectPackFiles(source, name, files);
+		else
+			files.push_back(name);
+	}
+}
+
+static bool WritePadding(File::IOFile &out, uint64_t from, uint64_t to) {
+	static const uint8_t zeroes[PACK_PAGE_SIZE]{};
+	while (from < to) {
+		size_t chunk = (size_t)std::min(to - from, PACK_PAGE_SIZE);
+		if (!out.WriteBytes(zeroes, chunk))
+			return false;
+		from += chunk;
+	}
+	return true;
+}
+
+bool WritePackFile(VFSBackend *source, const Path &destination, std::string *error) {
+	std::vector<std::string> names;
+	CollectPackFiles(source, "", names);
+	// Data goes in name order, so the mip levels of a texture end up next to each other.
+	std::sort(names.begin(), names.end());
+
+	std::vector<PackFileEntry> entries;
+	entries.reserve(names.size());
+	std::string namesBlob;
+	for (const std::string &name : names) {
+		PackFileEntry entry{};
+		entry.nameHash = HashPackPath(NormalizePackPath(name.c_str()));
+		entry.nameOffset = (uint32_t)namesBlob.size();
+		entry.nameLength = (uint32_t)name.size();
+		namesBlob += name;
+		entries.push_back(entry);
+	}
+	if (namesBlob.size() > 0xFFFFFFFF || names.size() > 0xFFFFFFFF) {
+		*error = "Too many files to pack";
+		return false;
+	}
+
+	PackFileHeader header{};
+	memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+	header.version = PACK_VERSION;
+	header.entryCount = (uint32_t)entries.size();
+	header.bucketBits = BucketBitsForCount(entries.size());
+	header.bucketsOffset = sizeof(header);
+	header.entriesOffset = header.bucketsOffset + ((1ULL << header.bucketBits) + 1) * sizeof(uint32_t);
+	header.namesOffset = header.entriesOffset + entries.size() * sizeof(PackFileEntry);
+	header.namesSize = namesBlob.size();
+
+	File::IOFile out(destination, "wb");
+	if (!out.IsOpen()) {
+		*error = "Could not create " + destination.ToVisualString();
+		return false;
+	}
+
+	// Data first, the index goes in front once we know where everything ended up.
+	uint64_t pos = header.namesOffset + header.namesSize;
+	uint64_t dataStart = (pos + PACK_PAGE_SIZE - 1) & ~(PACK_PAGE_SIZE - 1);
+	out.Seek((int64_t)dataStart, SEEK_SET);
+	pos = dataStart;
+	for (size_t i = 0; i < names.size(); ++i) {
+		size_t size = 0;
+		uint8_t *data = source->ReadFile(names[i].c_str(), &size);
+		if (!data) {
+			*error = "Could not read " + names[i];
+			return false;
+		}
+
+		uint64_t start;
+		if (size >= PACK_PAGE_SIZE) {
+			start = (pos + PACK_PAGE_SIZE - 1) & ~(PACK_PAGE_SIZE - 1);
+		} else {
+			start = (pos + PACK_SMALL_ALIGN - 1) & ~(PACK_SMALL_ALIGN - 1);
+			// Don't make a small read touch two pages.
+			if ((start & ~(PACK_PAGE_SIZE - 1)) != ((start + size - 1) & ~(PACK_PAGE_SIZE - 1)) && size != 0)
+				start = (start + PACK_PAGE_SIZE - 1) & ~(PACK_PAGE_SIZE - 1);
+		}
+
+		bool success = WritePadding(out, pos, start) && out.WriteBytes(data, size);
+		delete[] data;
+		if (!success) {
+			*error = "Failed writing to " + destination.ToVisualString();
+			return false;
+		}
+		entries[i].offset = start;
+		entries[i].size = size;
+		pos = start + size;
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const PackFileEntry &a, const PackFileEntry &b) {
+		return a.nameHash < b.nameHash;
+	});
+	std::vector<uint32_t> buckets(((size_t)1 << header.bucketBits) + 1);
+	uint32_t next = 0;
+	for (uint32_t b = 0; b < (uint32_t)buckets.size(); ++b) {
+		while (next < entries.size() && BucketForHash(entries[next].nameHash, header.bucketBits) < b)
+			next++;
+		buckets[b] = next;
+	}
+	buckets.back() = (uint32_t)entries.size();
+
+	bool success = out.Seek(0, SEEK_SET);
+	success = success && out.WriteBytes(&header, sizeof(header));
+	success = success && out.WriteArray(buckets.data(), buckets.size());
+	success = success && out.WriteArray(entries.data(), entries.size());
+	success = success && out.WriteBytes(namesBlob.data(), namesBlob.size());
+	success = success && WritePadding(out, header.namesOffset + header.namesSize, dataStart);
+	if (!success) {
+		*error = "Failed writing to " + destination.ToVisualString();
+		return false;
+	}
+
+	INFO_LOG(Log::IO, "Packed %d files into %s (%lld bytes)", (int)entries.size(), destination.c_str(), (long long)pos);
+	return true;
+}
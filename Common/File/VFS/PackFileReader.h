@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ppsspp_config.h"
+
+#include "Common/File/VFS/VFS.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+
+// Where possible the whole pack is mapped, so reads are copies out of the page cache (or no copy
+// at all, see MapFile), and any number of files can be open at once.
+#if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS) && !PPSSPP_PLATFORM(SWITCH) && PPSSPP_ARCH(64BIT)
+#define PACK_FILE_READER_MMAP
+#endif
+
+struct PackFileEntry;
+
+// Read-only single file container, meant for large texture packs. Unlike a zip, there's no
+// compression and no per-file header: a hash index (sorted, with a bucket table on the top bits
+// of the hash) leads straight to each file's data, which is stored as is. Lookups are case
+// insensitive, like ZipFileReader's.
+//
+// Files of a page or more start on a page boundary, smaller ones never straddle one.
+class PackFileReader : public VFSBackend {
+public:
+	static PackFileReader *Create(const Path &packFile, bool logErrors = true);
+	~PackFileReader();
+
+	// use delete[] on the returned value.
+	uint8_t *ReadFile(const char *path, size_t *size) override;
+
+	VFSFileReference *GetFile(const char *path) override;
+	bool GetFileInfo(VFSFileReference *vfsReference, File::FileInfo *fileInfo) override;
+	void ReleaseFile(VFSFileReference *vfsReference) override;
+
+	VFSOpenFile *OpenFileForRead(VFSFileReference *vfsReference, size_t *size) override;
+	void Rewind(VFSOpenFile *vfsOpenFile) override;
+	size_t Read(VFSOpenFile *vfsOpenFile, void *buffer, size_t length) override;
+	void CloseFile(VFSOpenFile *vfsOpenFile) override;
+	const uint8_t *MapFile(VFSFileReference *vfsReference, size_t *size) override;
+
+	bool GetFileListing(const char *path, std::vector<File::FileInfo> *listing, const char *filter) override;
+	bool GetFileInfo(const char *path, File::FileInfo *info) override;
+	std::string toString() const override {
+		return path_.ToString();
+	}
+
+	size_t FileCount() const { return entryCount_; }
+
+private:
+	explicit PackFileReader(const Path &path) : path_(path) {}
+	bool Open(bool logErrors);
+	bool ValidateIndex(uint64_t fileSize, uint64_t namesSize);
+	int FindEntry(const char *path) const;
+	size_t ReadAt(const PackFileEntry &entry, uint64_t pos, void *buffer, size_t length);
+
+	Path path_;
+	File::IOFile file_;
+
+	// Point into the mapping, or into index_ when we couldn't map.
+	const uint32_t *buckets_ = nullptr;
+	const PackFileEntry *entries_ = nullptr;
+	const char *names_ = nullptr;
+	uint32_t entryCount_ = 0;
+	uint32_t bucketBits_ = 0;
+
+	const uint8_t *mapped_ = nullptr;
+	uint64_t mappedSize_ = 0;
+
+	// Only used without a mapping.
+	std::vector<uint8_t> index_;
+	std::mutex lock_;
+};
+
+// Packs every file in source (recursively, except hidden files) into a new pack file at
+// destination. On failure, returns false with a description in *error.
+bool WritePackFile(VFSBackend *source, const Path &destination, std::string *error);
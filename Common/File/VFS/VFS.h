@@ -53,6 +53,9 @@ class VFSBackend : public VFSInterface {
 	virtual void Rewind(VFSOpenFile *vfsOpenFile) = 0;
 	virtual size_t Read(VFSOpenFile *vfsOpenFile, void *buffer, size_t length) = 0;
 	virtual void CloseFile(VFSOpenFile *vfsOpenFile) = 0;
+	// The whole file's contents, valid until the backend is deleted. Only backends that have them
+	// in memory already (or mapped) can do this, the rest return nullptr - use the reads instead.
+	virtual const uint8_t *MapFile(VFSFileReference *vfsReference, size_t *size) { return nullptr; }
 
 	// Filter support is optional but nice to have
 	virtual bool GetFileInfo(const char *path, File::FileInfo *info) = 0;
@@ -614,6 +614,8 @@ struct DeviceCaps {
 	bool requiresHalfPixelOffset;
 	bool provokingVertexLast;  // GL behavior, what the PSP does
 	bool verySlowShaderCompiler;
+	// ReadbackMode::OLD_DATA_OK returns results from an earlier frame without waiting, rather than blocking.
+	bool delayedReadbackSupported;
 
 	// From the other backends, we can detect if D3D9 support is known bad (like on Xe) and disable it.
 	bool supportsD3D9;
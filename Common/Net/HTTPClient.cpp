@@ -106,7 +106,7 @@ static void FormatAddr(char *addrbuf, size_t bufsize, const addrinfo *info) {
 	}
 }
 
-bool Connection::Connect(int maxTries, double timeout, bool *cancelConnect) {
+bool Connection::Connect(int maxTries, double timeout, std::atomic<bool> *cancelConnect) {
 	if (port_ <= 0) {
 		ERROR_LOG(Log::IO, "Bad port");
 		return false;
@@ -368,7 +368,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 		"Host: %s\r\n"
 		"User-Agent: %s\r\n"
 		"Accept: %s\r\n"
-		"Connection: close\r\n"
+		"Connection: %s\r\n"
 		"%s"
 		"\r\n";
 
@@ -377,6 +377,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 		host_.c_str(),
 		userAgent_.c_str(),
 		req.acceptMime,
+		keepAlive_ ? "keep-alive" : "close",
 		otherHeaders ? otherHeaders : "");
 	buffer.Append(data);
 	bool flushed = buffer.FlushSocket(sock(), dataTimeout_, progress->cancelled);
@@ -387,22 +388,12 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 }
 
 int Client::ReadResponseHeaders(net::Buffer *readbuf, std::vector<std::string> &responseHeaders, net::RequestProgress *progress) {
-	// Snarf all the data we can into RAM. A little unsafe but hey.
-	static constexpr float CANCEL_INTERVAL = 0.25f;
-	bool ready = false;
-	double endTimeout = time_now_d() + dataTimeout_;
-	while (!ready) {
-		if (progress->cancelled && *progress->cancelled)
-			return -1;
-		ready = fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false);
-		if (!ready && time_now_d() > endTimeout) {
-			ERROR_LOG(Log::HTTP, "HTTP headers timed out");
-			return -1;
-		}
-	};
-	// Let's hope all the headers are available in a single packet...
-	if (readbuf->Read(sock(), 4096) < 0) {
-		ERROR_LOG(Log::HTTP, "Failed to read HTTP headers :(");
+	// Read until the end of the headers.  Some of the entity may come along too, it stays in readbuf.
+	// On a persistent connection, the next response may already be fully buffered.
+	static constexpr size_t MAX_HEADERS_SIZE = 65536;
+	if (!readbuf->ReadUntil(sock(), "\r\n\r\n", MAX_HEADERS_SIZE, dataTimeout_, progress->cancelled)) {
+		if (!progress->cancelled || !*progress->cancelled)
+			ERROR_LOG(Log::HTTP, "Failed to read HTTP headers");
 		return -1;
 	}
 
@@ -97,6 +97,8 @@ int RequestHeader::ParseHttpHeader(const char *buffer) {
 			type = FULL;
 		else
 			type = SIMPLE;
+		// HTTP/1.1 connections persist unless the client says otherwise.
+		keepAlive = strstr(buffer, "HTTP/1.1") != nullptr;
 		return 0;
 	}
 
@@ -153,6 +155,18 @@ void RequestHeader::ParseHeaders(net::InputSink *sink) {
 		}
 	}
 
+	std::string connection;
+	if (GetOther("connection", &connection)) {
+		std::transform(connection.begin(), connection.end(), connection.begin(), tolower);
+		if (connection.find("close") != std::string::npos)
+			keepAlive = false;
+		else if (connection.find("keep-alive") != std::string::npos)
+			keepAlive = true;
+	}
+	// Handlers don't always consume the body, so we couldn't find the next request after it.
+	if (content_length > 0)
+		keepAlive = false;
+
 	VERBOSE_LOG(Log::IO, "finished parsing request.");
 	ok = line_count > 1 && resource != nullptr;
 }
@@ -37,6 +37,8 @@ class RequestHeader {
 		UNSUPPORTED,
 	};
 	Method method = UNSUPPORTED;
+	// Whether the client is willing to send more requests on this connection.
+	bool keepAlive = false;
 	bool ok = false;
 	void ParseHeaders(net::InputSink *sink);
 	bool GetParamValue(const char *param_name, std::string *value) const;
@@ -51,7 +51,7 @@ class HTTPSRequest : public Request {
 	int resultCode_ = 0;
 	bool completed_ = false;
 	bool failed_ = false;
-	bool cancelled_ = false;
+	std::atomic<bool> cancelled_{ false };
 	bool joined_ = false;
 
 	// Naett state
@@ -23,7 +23,7 @@ enum class ProgressBarMode {
 // Abstract request.
 class Request {
 public:
-	Request(RequestMethod method, const std::string &url, std::string_view name, bool *cancelled, ProgressBarMode mode);
+	Request(RequestMethod method, const std::string &url, std::string_view name, std::atomic<bool> *cancelled, ProgressBarMode mode);
 	virtual ~Request() {}
 
 	void SetAccept(const char *mime) {
@@ -24,13 +24,22 @@
 
 #endif
 
+#if PPSSPP_PLATFORM(LINUX)
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#define HTTP_SERVER_EPOLL 1
+#endif
+
 #if PPSSPP_PLATFORM(UWP)
 #define in6addr_any IN6ADDR_ANY_INIT
 #endif
 
 #include <algorithm>
 #include <functional>
+#include <limits>
+#include <memory>
 
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <thread>
@@ -42,9 +51,11 @@
 
 #include "Common/Buffer.h"
 #include "Common/Log.h"
+#include "Common/Thread/ThreadUtil.h"
 
 
 void NewThreadExecutor::Run(std::function<void()> func) {
+	std::lock_guard<std::mutex> guard(lock_);
 	threads_.push_back(std::thread(func));
 }
 
@@ -60,8 +71,24 @@ namespace http {
 // Note: charset here helps prevent XSS.
 const char *const DEFAULT_MIME_TYPE = "text/html; charset=utf-8";
 
+// How long a kept-alive connection may sit between requests.
+static const double KEEPALIVE_TIMEOUT = 15.0;
+static const size_t FILE_CHUNK_SIZE = 64 * 1024;
+
+struct Server::Connection {
+	explicit Connection(int s) : fd(s), in(s), out(s) {}
+
+	int fd;
+	net::InputSink in;
+	net::OutputSink out;
+	int requests = 0;
+	// Only used in event loop mode, under connectionsLock_.
+	bool idle = false;
+	double lastActive = 0.0;
+};
+
 ServerRequest::ServerRequest(int fd)
-	: fd_(fd) {
+	: fd_(fd), ownsSinks_(true) {
 	in_ = new net::InputSink(fd);
 	out_ = new net::OutputSink(fd);
 	header_.ParseHeaders(in_);
@@ -73,8 +100,21 @@ ServerRequest::ServerRequest(int fd)
 	}
 }
 
+ServerRequest::ServerRequest(int fd, net::InputSink *in, net::OutputSink *out)
+	: in_(in), out_(out), fd_(fd), ownsSinks_(false) {
+	header_.ParseHeaders(in_);
+
+	if (header_.ok) {
+		VERBOSE_LOG(Log::IO, "The request carried with it %i bytes", (int)header_.content_length);
+	} else {
+		Close();
+	}
+}
+
 ServerRequest::~ServerRequest() {
 	Close();
+	if (!ownsSinks_)
+		return;
 
 	if (!in_->Empty()) {
 		ERROR_LOG(Log::IO, "Input not empty - invalid request?");
@@ -107,12 +147,16 @@ void ServerRequest::WriteHttpResponseHeader(const char *ver, int status, int64_t
 	default: statusStr = "OK"; break;
 	}
 
+	bool websocket = mimeType && strcmp(mimeType, "websocket") == 0;
+	// Without a length, the client can only find the end of the body by us closing.
+	keepAlive_ = !ownsSinks_ && header_.keepAlive && size >= 0 && !websocket;
+
 	net::OutputSink *buffer = Out();
 	buffer->Printf("HTTP/%s %03d %s\r\n", ver, status, statusStr);
 	buffer->Push("Server: PPSSPPServer v0.1\r\n");
-	if (!mimeType || strcmp(mimeType, "websocket") != 0) {
+	if (!websocket) {
 		buffer->Printf("Content-Type: %s\r\n", mimeType ? mimeType : DEFAULT_MIME_TYPE);
-		buffer->Push("Connection: close\r\n");
+		buffer->Push(keepAlive_ ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
 	}
 	if (size >= 0) {
 		buffer->Printf("Content-Length: %llu\r\n", size);
@@ -123,6 +167,67 @@ void ServerRequest::WriteHttpResponseHeader(const char *ver, int status, int64_t
 	buffer->Push("\r\n");
 }
 
+static int64_t ReadFileAt(FILE *fp, char *dest, size_t bytes, int64_t offset) {
+#if PPSSPP_PLATFORM(WINDOWS)
+	if (_fseeki64(fp, offset, SEEK_SET) != 0)
+		return -1;
+	return (int64_t)fread(dest, 1, bytes, fp);
+#elif PPSSPP_PLATFORM(ANDROID) || (defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS < 64)
+	return pread64(fileno(fp), dest, bytes, offset);
+#else
+	return pread(fileno(fp), dest, bytes, (off_t)offset);
+#endif
+}
+
+bool ServerRequest::WriteFileRange(FILE *fp, int64_t offset, int64_t length) const {
+	_assert_(fd_);
+	// The header and anything else pushed so far have to go out first.
+	if (!out_->Flush()) {
+		keepAlive_ = false;
+		return false;
+	}
+
+#ifdef HTTP_SERVER_EPOLL
+	// Old Android API levels lack sendfile64, so larger offsets take the copying path.
+	bool offsetFits = offset + length <= (int64_t)std::numeric_limits<off_t>::max();
+	int fileFd = fileno(fp);
+	while (offsetFits && length > 0) {
+		off_t pos = (off_t)offset;
+		ssize_t sent = sendfile(fd_, fileFd, &pos, (size_t)std::min(length, (int64_t)0x40000000));
+		if (sent > 0) {
+			offset += sent;
+			length -= sent;
+		} else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			if (!fd_util::WaitUntilReady(fd_, 5.0, true)) {
+				keepAlive_ = false;
+				return false;
+			}
+		} else if (sent < 0 && (errno == EINVAL || errno == ENOSYS)) {
+			// Not every kind of file supports it, fall back to copying.
+			break;
+		} else {
+			// Error, or the file got shorter than promised.
+			keepAlive_ = false;
+			return false;
+		}
+	}
+#endif
+
+	std::unique_ptr<char[]> buf;
+	if (length > 0)
+		buf.reset(new char[FILE_CHUNK_SIZE]);
+	while (length > 0) {
+		int64_t bytes = ReadFileAt(fp, buf.get(), (size_t)std::min(length, (int64_t)FILE_CHUNK_SIZE), offset);
+		if (bytes <= 0 || !out_->Push(buf.get(), (size_t)bytes)) {
+			keepAlive_ = false;
+			return false;
+		}
+		offset += bytes;
+		length -= bytes;
+	}
+	return true;
+}
+
 void ServerRequest::WritePartial() const {
 	_assert_(fd_);
 	out_->Flush();
@@ -136,9 +241,12 @@ void ServerRequest::Write() {
 
 void ServerRequest::Close() {
 	if (fd_) {
-		closesocket(fd_);
+		// Borrowed connections are closed by their owner.
+		if (ownsSinks_)
+			closesocket(fd_);
 		fd_ = 0;
 	}
+	keepAlive_ = false;
 }
 
 Server::Server(NewThreadExecutor *executor)
@@ -148,6 +256,7 @@ Server::Server(NewThreadExecutor *executor)
 }
 
 Server::~Server() {
+	StopEventLoop();
 	delete executor_;
 }
 
@@ -276,6 +385,9 @@ bool Server::RunSlice(double timeout) {
 	if (timeout <= 0.0) {
 		timeout = 86400.0;
 	}
+	if (epollFd_ != -1) {
+		return RunEventLoopSlice(timeout);
+	}
 	if (!fd_util::WaitUntilReady(listener_, timeout, false)) {
 		return false;
 	}
@@ -313,22 +425,257 @@ bool Server::Run(int port) {
 }
 
 void Server::Stop() {
+	StopEventLoop();
 	closesocket(listener_);
 }
 
 void Server::HandleConnection(int conn_fd) {
-	ServerRequest request(conn_fd);
-	if (!request.IsOK()) {
-		WARN_LOG(Log::IO, "Bad request, ignoring.");
-		return;
+	Connection conn(conn_fd);
+	while (ServeRequest(&conn, false) == ServeResult::KEEP_ALIVE) {
+		// Wait for the next request, but don't hold up shutdown.
+		double endTime = time_now_d() + KEEPALIVE_TIMEOUT;
+		bool ready = !conn.in.Empty();
+		while (!ready && !stopping_ && time_now_d() < endTime) {
+			ready = fd_util::WaitUntilReady(conn_fd, 0.5, false);
+		}
+		if (!ready)
+			break;
 	}
-	HandleRequest(request);
+	closesocket(conn_fd);
+}
+
+Server::ServeResult Server::ServeRequest(Connection *conn, bool handOffUpgrades) {
+	std::shared_ptr<ServerRequest> request = std::make_shared<ServerRequest>(conn->fd, &conn->in, &conn->out);
+	if (!request->IsOK()) {
+		// After the first request, this is usually just the client closing.
+		if (conn->requests == 0)
+			WARN_LOG(Log::IO, "Bad request, ignoring.");
+		return ServeResult::CLOSE;
+	}
+	conn->requests++;
+
+	std::string upgrade;
+	if (handOffUpgrades && request->GetHeader("upgrade", &upgrade)) {
+		// Upgraded connections (websockets) stay busy until they close, so they get their own thread.
+		{
+			std::lock_guard<std::mutex> guard(connectionsLock_);
+			connections_.erase(conn);
+		}
+		executor_->Run([this, request, conn] {
+			HandleRequest(*request);
+			conn->out.Flush();
+			closesocket(conn->fd);
+			delete conn;
+		});
+		return ServeResult::HANDED_OFF;
+	}
+
+	HandleRequest(*request);
 
 	// TODO: Way to mark the content body as read, read it here if never read.
 	// This allows the handler to stream if need be.
+	if (!conn->out.Flush() || !request->KeepAlive())
+		return ServeResult::CLOSE;
+	return ServeResult::KEEP_ALIVE;
+}
+
+bool Server::UseEventLoop(int workerCount) {
+#ifdef HTTP_SERVER_EPOLL
+	if (epollFd_ != -1)
+		return true;
+	if (listener_ < 0 || workerCount <= 0)
+		return false;
+
+	// epoll_create1 is too new for our oldest Android target.  The size is ignored.
+	epollFd_ = epoll_create(64);
+	if (epollFd_ < 0) {
+		ERROR_LOG(Log::IO, "epoll_create failed: %d", errno);
+		epollFd_ = -1;
+		return false;
+	}
+
+	// The listener is the only entry without a Connection.
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.ptr = nullptr;
+	if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, listener_, &ev) < 0) {
+		ERROR_LOG(Log::IO, "Failed to watch HTTP listener: %d", errno);
+		close(epollFd_);
+		epollFd_ = -1;
+		return false;
+	}
+
+	stopping_ = false;
+	for (int i = 0; i < workerCount; ++i) {
+		workers_.push_back(std::thread(&Server::EventLoopWorker, this));
+	}
+	INFO_LOG(Log::IO, "HTTP server using event loop with %d workers", workerCount);
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Server::RunEventLoopSlice(double timeout) {
+#ifdef HTTP_SERVER_EPOLL
+	epoll_event events[64];
+	int count = epoll_wait(epollFd_, events, (int)ARRAY_SIZE(events), (int)(timeout * 1000.0));
+	if (count < 0 && errno != EINTR) {
+		ERROR_LOG(Log::IO, "epoll_wait failed: %d", errno);
+	}
+
+	for (int i = 0; i < count; ++i) {
+		Connection *conn = (Connection *)events[i].data.ptr;
+		if (!conn) {
+			AcceptConnections();
+			continue;
+		}
+
+		// EPOLLONESHOT disarmed it, so it's the worker's until rearmed.  Errors and hangups also
+		// go to a worker, which will notice while reading.
+		std::lock_guard<std::mutex> guard(connectionsLock_);
+		conn->idle = false;
+		readyQueue_.push_back(conn);
+		readyCond_.notify_one();
+	}
+
+	double now = time_now_d();
+	if (now >= lastIdleCheck_ + 1.0) {
+		CloseIdleConnections(now);
+		lastIdleCheck_ = now;
+	}
+	return count > 0;
+#else
+	return false;
+#endif
+}
+
+void Server::AcceptConnections() {
+#ifdef HTTP_SERVER_EPOLL
+	// The listener is non-blocking, so take everything that's waiting.
+	while (true) {
+		int conn_fd = accept(listener_, nullptr, nullptr);
+		if (conn_fd < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				ERROR_LOG(Log::IO, "socket accept failed: %d", errno);
+			return;
+		}
+
+		// Wait for the request to arrive before tying up a worker with it.
+		Connection *conn = new Connection(conn_fd);
+		std::lock_guard<std::mutex> guard(connectionsLock_);
+		conn->idle = true;
+		conn->lastActive = time_now_d();
+		epoll_event ev{};
+		ev.events = EPOLLIN | EPOLLONESHOT;
+		ev.data.ptr = conn;
+		if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, conn_fd, &ev) < 0) {
+			ERROR_LOG(Log::IO, "Failed to watch HTTP connection: %d", errno);
+			closesocket(conn_fd);
+			delete conn;
+			continue;
+		}
+		connections_.insert(conn);
+	}
+#endif
+}
+
+void Server::EventLoopWorker() {
+	SetCurrentThreadName("HTTPWorker");
+
+	std::unique_lock<std::mutex> lock(connectionsLock_);
+	while (true) {
+		readyCond_.wait(lock, [&] { return stopping_ || !readyQueue_.empty(); });
+		if (stopping_)
+			break;
+		Connection *conn = readyQueue_.front();
+		readyQueue_.pop_front();
+		lock.unlock();
+
+		ServeResult result;
+		do {
+			result = ServeRequest(conn, true);
+			// Pipelined requests may already be buffered, and epoll won't tell us about those.
+		} while (result == ServeResult::KEEP_ALIVE && !conn->in.Empty() && !stopping_);
+
+		// A handed off connection may already be gone, so don't touch it.
+		if (result == ServeResult::KEEP_ALIVE) {
+			RearmConnection(conn);
+		} else if (result == ServeResult::CLOSE) {
+			CloseConnection(conn);
+		}
+		lock.lock();
+	}
+}
 
-	// TODO: Could handle keep alive here.
-	request.Write();
+void Server::RearmConnection(Connection *conn) {
+#ifdef HTTP_SERVER_EPOLL
+	std::lock_guard<std::mutex> guard(connectionsLock_);
+	conn->idle = true;
+	conn->lastActive = time_now_d();
+	epoll_event ev{};
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.ptr = conn;
+	if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, conn->fd, &ev) < 0) {
+		connections_.erase(conn);
+		closesocket(conn->fd);
+		delete conn;
+	}
+#endif
+}
+
+void Server::CloseConnection(Connection *conn) {
+	std::lock_guard<std::mutex> guard(connectionsLock_);
+	connections_.erase(conn);
+#ifdef HTTP_SERVER_EPOLL
+	epoll_ctl(epollFd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+#endif
+	closesocket(conn->fd);
+	delete conn;
+}
+
+void Server::CloseIdleConnections(double now) {
+	std::lock_guard<std::mutex> guard(connectionsLock_);
+	for (auto it = connections_.begin(); it != connections_.end(); ) {
+		Connection *conn = *it;
+		if (conn->idle && now > conn->lastActive + KEEPALIVE_TIMEOUT) {
+#ifdef HTTP_SERVER_EPOLL
+			epoll_ctl(epollFd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+#endif
+			closesocket(conn->fd);
+			delete conn;
+			it = connections_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void Server::StopEventLoop() {
+	{
+		// Also lets kept-alive connections in thread mode finish up.
+		std::lock_guard<std::mutex> guard(connectionsLock_);
+		stopping_ = true;
+		readyCond_.notify_all();
+	}
+	if (epollFd_ == -1)
+		return;
+
+	for (auto &worker : workers_)
+		worker.join();
+	workers_.clear();
+
+	// Workers are gone, so what's left is idle or was never picked up.
+	for (Connection *conn : connections_) {
+		closesocket(conn->fd);
+		delete conn;
+	}
+	connections_.clear();
+	readyQueue_.clear();
+#ifdef HTTP_SERVER_EPOLL
+	close(epollFd_);
+#endif
+	epollFd_ = -1;
 }
 
 void Server::HandleRequest(const ServerRequest &request) {
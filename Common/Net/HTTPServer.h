@@ -1,8 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
 #include <functional>
 #include <map>
+#include <mutex>
+#include <set>
 #include <thread>
+#include <vector>
 
 #include "Common/Net/HTTPHeaders.h"
 #include "Common/Net/Resolve.h"
@@ -13,6 +20,7 @@ class NewThreadExecutor {
 	void Run(std::function<void()> func);
 
 private:
+	std::mutex lock_;
 	std::vector<std::thread> threads_;
 };
 
@@ -28,6 +36,8 @@ namespace http {
 class ServerRequest {
 public:
 	ServerRequest(int fd);
+	// Reads the next request on a persistent connection.  The sinks and socket stay owned by the caller.
+	ServerRequest(int fd, net::InputSink *in, net::OutputSink *out);
 	~ServerRequest();
 
 	const char *resource() const {
@@ -61,11 +71,21 @@ class ServerRequest {
 	// If size is negative, no Content-Length: line is written.
 	void WriteHttpResponseHeader(const char *ver, int status, int64_t size = -1, const char *mimeType = nullptr, const char *otherHeaders = nullptr) const;
 
+	// Sends length bytes of fp from offset as part of the body, after anything already in Out().
+	// Uses sendfile() where available so the data isn't copied through our buffers.
+	bool WriteFileRange(FILE *fp, int64_t offset, int64_t length) const;
+
+	// Whether another request can follow on this connection.  Decided when the response header is
+	// written: the client must allow it, and the response needs a Content-Length.
+	bool KeepAlive() const { return keepAlive_; }
+
 private:
 	net::InputSink *in_;
 	net::OutputSink *out_;
 	RequestHeader header_;
 	int fd_;
+	bool ownsSinks_;
+	mutable bool keepAlive_ = false;
 };
 
 // Register handlers on this class to serve stuff.
@@ -88,6 +108,11 @@ class Server {
 	bool Listen(int port, net::DNSType type = net::DNSType::ANY);
 	void Stop();
 
+	// Call after Listen().  Serves connections from a fixed pool of worker threads woken by epoll,
+	// instead of a thread per connection, so idle keep-alive connections don't hold a thread.
+	// Returns false if unsupported on this platform (only Linux and Android so far.)
+	bool UseEventLoop(int workerCount);
+
 	void RegisterHandler(const char *url_path, UrlHandlerFunc handler);
 	void SetFallbackHandler(UrlHandlerFunc handler);
 
@@ -101,10 +126,26 @@ class Server {
 	}
 
 private:
+	struct Connection;
+	enum class ServeResult {
+		KEEP_ALIVE,
+		CLOSE,
+		HANDED_OFF,
+	};
+
 	bool Listen6(int port, bool ipv6_only);
 	bool Listen4(int port);
 
 	void HandleConnection(int conn_fd);
+	ServeResult ServeRequest(Connection *conn, bool handOffUpgrades);
+
+	bool RunEventLoopSlice(double timeout);
+	void AcceptConnections();
+	void EventLoopWorker();
+	void RearmConnection(Connection *conn);
+	void CloseConnection(Connection *conn);
+	void CloseIdleConnections(double now);
+	void StopEventLoop();
 
 	// Things like default 404, etc.
 	void HandleRequestDefault(const ServerRequest &request);
@@ -113,13 +154,23 @@ class Server {
 	void HandleListing(const ServerRequest &request);
 	void Handle404(const ServerRequest &request);
 
-	int listener_;
+	int listener_ = -1;
 	int port_ = 0;
 
 	UrlHandlerMap handlers_;
 	UrlHandlerFunc fallback_;
 
 	NewThreadExecutor *executor_;
+
+	// Event loop mode.  Connections are either idle (waiting in epoll), or owned by a worker.
+	int epollFd_ = -1;
+	std::vector<std::thread> workers_;
+	std::deque<Connection *> readyQueue_;
+	std::set<Connection *> connections_;
+	std::mutex connectionsLock_;
+	std::condition_variable readyCond_;
+	double lastIdleCheck_ = 0.0;
+	std::atomic<bool> stopping_{};
 };
 
 }  // namespace http
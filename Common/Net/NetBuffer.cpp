@@ -34,7 +34,7 @@ void RequestProgress::Update(int64_t downloaded, int64_t totalBytes, bool done)
 	}
 }
 
-bool Buffer::FlushSocket(uintptr_t sock, double timeout, bool *cancelled) {
+bool Buffer::FlushSocket(uintptr_t sock, double timeout, std::atomic<bool> *cancelled) {
 	static constexpr float CANCEL_INTERVAL = 0.25f;
 	for (size_t pos = 0, end = data_.size(); pos < end; ) {
 		bool ready = false;
@@ -130,4 +130,82 @@ int Buffer::Read(int fd, size_t sz) {
 	return (int)received;
 }
 
+static bool IsWouldBlock() {
+#if PPSSPP_PLATFORM(WINDOWS)
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EWOULDBLOCK || errno == EAGAIN;
+#endif
+}
+
+bool Buffer::ReadUntil(uintptr_t sock, const char *delim, size_t maxSize, double timeout, std::atomic<bool> *cancelled) {
+	static constexpr float CANCEL_INTERVAL = 0.25f;
+	const size_t delimLen = strlen(delim);
+	double endTimeout = time_now_d() + timeout;
+	size_t searched = 0;
+	while (true) {
+		// Only search the new data (plus enough overlap for a split delimiter.)
+		size_t start = searched >= delimLen ? searched - delimLen + 1 : 0;
+		if (std::search(data_.begin() + start, data_.end(), delim, delim + delimLen) != data_.end())
+			return true;
+		searched = data_.size();
+		if (data_.size() >= maxSize)
+			return false;
+
+		if (cancelled && *cancelled)
+			return false;
+		if (!fd_util::WaitUntilReady((int)sock, CANCEL_INTERVAL, false)) {
+			if (time_now_d() > endTimeout) {
+				ERROR_LOG(Log::IO, "ReadUntil timed out");
+				return false;
+			}
+			continue;
+		}
+
+		char buf[4096];
+		int retval = recv(sock, buf, (int)std::min(sizeof(buf), maxSize - data_.size()), MSG_NOSIGNAL);
+		if (retval == 0) {
+			// Closed by the other side.
+			return false;
+		} else if (retval < 0) {
+			if (!IsWouldBlock())
+				return false;
+			continue;
+		}
+		memcpy(Append((size_t)retval), buf, retval);
+	}
+}
+
+bool Buffer::TakeExactly(uintptr_t sock, size_t size, char *dest, double timeout, std::atomic<bool> *cancelled) {
+	static constexpr float CANCEL_INTERVAL = 0.25f;
+	size_t pos = std::min(size, data_.size());
+	Take(pos, dest);
+
+	double endTimeout = time_now_d() + timeout;
+	while (pos < size) {
+		if (cancelled && *cancelled)
+			return false;
+		if (!fd_util::WaitUntilReady((int)sock, CANCEL_INTERVAL, false)) {
+			if (time_now_d() > endTimeout) {
+				ERROR_LOG(Log::IO, "TakeExactly timed out");
+				return false;
+			}
+			continue;
+		}
+
+		int retval = recv(sock, dest + pos, (int)std::min(size - pos, (size_t)0x40000000), MSG_NOSIGNAL);
+		if (retval == 0) {
+			return false;
+		} else if (retval < 0) {
+			if (!IsWouldBlock())
+				return false;
+			continue;
+		}
+		pos += retval;
+		// The timeout is for stalls, not the whole transfer.
+		endTimeout = time_now_d() + timeout;
+	}
+	return true;
+}
+
 }  // namespace
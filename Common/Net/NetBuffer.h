@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 
@@ -9,25 +10,31 @@ namespace net {
 
 class RequestProgress {
 public:
-	explicit RequestProgress(bool *c) : cancelled(c) {}
+	explicit RequestProgress(std::atomic<bool> *c) : cancelled(c) {}
 
 	void Update(int64_t downloaded, int64_t totalBytes, bool done);
 
 	float progress = 0.0f;
 	float kBps = 0.0f;
-	bool *cancelled = nullptr;
+	std::atomic<bool> *cancelled = nullptr;
 	std::function<void(int64_t, int64_t, bool)> callback;
 };
 
 class Buffer : public ::Buffer {
 public:
-	bool FlushSocket(uintptr_t sock, double timeout, bool *cancelled = nullptr);
+	bool FlushSocket(uintptr_t sock, double timeout, std::atomic<bool> *cancelled = nullptr);
 
 	bool ReadAllWithProgress(int fd, int knownSize, RequestProgress *progress);
 
 	// < 0: error
 	// >= 0: number of bytes read
 	int Read(int fd, size_t sz);
+
+	// Reads until delim appears somewhere in the buffer.  Anything already buffered counts, so this
+	// works for pipelined responses.  Fails on timeout, close, or if maxSize is reached first.
+	bool ReadUntil(uintptr_t sock, const char *delim, size_t maxSize, double timeout, std::atomic<bool> *cancelled = nullptr);
+	// Fills dest with exactly size bytes, buffered data first, then straight from the socket.
+	bool TakeExactly(uintptr_t sock, size_t size, char *dest, double timeout, std::atomic<bool> *cancelled = nullptr);
 };
 
 }
@@ -1,6 +1,12 @@
+#include "ppsspp_config.h"
+
 #include <algorithm>
 #include <cstring>
 
+#if PPSSPP_ARCH(SSE2)
+#include <emmintrin.h>
+#endif
+
 #include "Common/Thread/ParallelLoop.h"
 #include "Common/CPUDetect.h"
 
@@ -130,7 +136,7 @@ void ParallelMemcpy(ThreadManager *threadMan, void *dst, const void *src, size_t
 void ParallelMemset(ThreadManager *threadMan, void *dst, uint8_t value, size_t bytes, TaskPriority priority) {
 	// This threshold can probably be a lot bigger.
 	if (bytes < 128 * 1024) {
-		memset(dst, 0, bytes);
+		memset(dst, value, bytes);
 		return;
 	}
 
@@ -141,3 +147,61 @@ void ParallelMemset(ThreadManager *threadMan, void *dst, uint8_t value, size_t b
 		memset(d + l, value, h - l);
 	}, 0, (int)bytes, 128 * 1024, priority);
 }
+
+void StreamingMemcpy(void *dst, const void *src, size_t bytes) {
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+#if PPSSPP_ARCH(SSE2)
+	if (bytes >= 256) {
+		// Align the destination, the stores need it.  Loads can be unaligned.
+		size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+		memcpy(d, s, head);
+		d += head;
+		s += head;
+		bytes -= head;
+
+		size_t blocks = bytes & ~(size_t)63;
+		for (size_t i = 0; i < blocks; i += 64) {
+			__m128i a = _mm_loadu_si128((const __m128i *)(s + i));
+			__m128i b = _mm_loadu_si128((const __m128i *)(s + i + 16));
+			__m128i c = _mm_loadu_si128((const __m128i *)(s + i + 32));
+			__m128i e = _mm_loadu_si128((const __m128i *)(s + i + 48));
+			_mm_stream_si128((__m128i *)(d + i), a);
+			_mm_stream_si128((__m128i *)(d + i + 16), b);
+			_mm_stream_si128((__m128i *)(d + i + 32), c);
+			_mm_stream_si128((__m128i *)(d + i + 48), e);
+		}
+		// Make the stores visible before anyone else (like the GPU thread) looks.
+		_mm_sfence();
+		d += blocks;
+		s += blocks;
+		bytes -= blocks;
+	}
+#endif
+	memcpy(d, s, bytes);
+}
+
+void StreamingMemset(void *dst, uint8_t value, size_t bytes) {
+	uint8_t *d = (uint8_t *)dst;
+#if PPSSPP_ARCH(SSE2)
+	if (bytes >= 256) {
+		size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+		memset(d, value, head);
+		d += head;
+		bytes -= head;
+
+		const __m128i v = _mm_set1_epi8((char)value);
+		size_t blocks = bytes & ~(size_t)63;
+		for (size_t i = 0; i < blocks; i += 64) {
+			_mm_stream_si128((__m128i *)(d + i), v);
+			_mm_stream_si128((__m128i *)(d + i + 16), v);
+			_mm_stream_si128((__m128i *)(d + i + 32), v);
+			_mm_stream_si128((__m128i *)(d + i + 48), v);
+		}
+		_mm_sfence();
+		d += blocks;
+		bytes -= blocks;
+	}
+#endif
+	memset(d, value, bytes);
+}
@@ -46,3 +46,8 @@ void ParallelRangeLoop(ThreadManager *threadMan, const std::function<void(int, i
 // NOTE: These support a max of 2GB.
 void ParallelMemcpy(ThreadManager *threadMan, void *dst, const void *src, size_t bytes, TaskPriority priority = TaskPriority::NORMAL);
 void ParallelMemset(ThreadManager *threadMan, void *dst, uint8_t value, size_t bytes, TaskPriority priority = TaskPriority::NORMAL);
+
+// Copies/fills using non-temporal stores where supported, skipping the CPU caches.
+// Good for large destinations that won't be read back by the CPU soon, like VRAM.
+void StreamingMemcpy(void *dst, const void *src, size_t bytes);
+void StreamingMemset(void *dst, uint8_t value, size_t bytes);
@@ -113,6 +113,7 @@ struct Config {
 	bool bHideSlowWarnings;
 	bool bHideStateWarnings;
 	bool bPreloadFunctions;
+	bool bFuncScanCache;
 	uint32_t uJitDisableFlags;
 
 	bool bDisableHTTPS;
@@ -232,6 +233,7 @@ struct Config {
 	int iMaxRecent;
 	int iCurrentStateSlot;
 	int iRewindSnapshotInterval;
+	int iRewindMemoryBudget;  // In MB. Ini-only.
 	bool bUISound;
 	bool bEnableStateUndo;
 	std::string sStateLoadUndoGame;
@@ -249,6 +251,7 @@ struct Config {
 	int iSplineBezierQuality; // 0 = low , 1 = Intermediate , 2 = High
 	bool bHardwareTessellation;
 	bool bShaderCache;  // Hidden ini-only setting, useful for debugging shader compile times.
+	bool bPredictReadbacks;  // Hidden ini-only setting, off by default: lets steady per-frame readbacks use old data.
 	bool bUberShaderVertex;
 	bool bUberShaderFragment;
 
@@ -0,0 +1,323 @@
+// Copyright (c) 2025- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/MachineContext.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Core/Debugger/JitSampler.h"
+#include "Core/Debugger/SymbolMap.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/MIPS/MIPS.h"
+
+#if defined(MACHINE_CONTEXT_SUPPORTED) && PPSSPP_PLATFORM(WINDOWS)
+#define JIT_SAMPLER_SUSPEND
+#elif defined(MACHINE_CONTEXT_SUPPORTED) && defined(__linux__) && !defined(__LIBRETRO__)
+#define JIT_SAMPLER_SIGNAL
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+struct JitSample {
+	uintptr_t hostPC;
+	u32 guestPC;
+};
+
+// Single producer: the signal handler or the suspending thread.  Drained with resultsMutex held.
+// Only atomics are touched, so it's fine for the handler to interrupt a drain.
+class JitSampleRing {
+public:
+	bool Push(const JitSample &sample) {
+		uint32_t write = write_.load(std::memory_order_relaxed);
+		if (write - read_.load(std::memory_order_acquire) >= CAPACITY)
+			return false;
+		samples_[write & (CAPACITY - 1)] = sample;
+		write_.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	template <typename F>
+	void Drain(F func) {
+		uint32_t read = read_.load(std::memory_order_relaxed);
+		uint32_t write = write_.load(std::memory_order_acquire);
+		for (; read != write; ++read)
+			func(samples_[read & (CAPACITY - 1)]);
+		read_.store(read, std::memory_order_release);
+	}
+
+private:
+	// At the default interval, several seconds worth.
+	static constexpr uint32_t CAPACITY = 8192;
+
+	JitSample samples_[CAPACITY];
+	alignas(64) std::atomic<uint32_t> write_{};
+	alignas(64) std::atomic<uint32_t> read_{};
+};
+
+static JitSampleRing sampleRing;
+static std::atomic<bool> samplerActive{};
+static std::atomic<bool> samplerStop{};
+static std::atomic<uint32_t> samplesDropped{};
+static std::thread samplerThread;
+
+// Protects the results below, only the emu thread adds to them.
+static std::mutex resultsMutex;
+static std::unordered_map<std::string, u64> foldedCounts;
+static std::unordered_map<u32, u64> functionCounts;
+static u64 totalSamples;
+
+static uintptr_t PCFromContext(const SContext *ctx) {
+#ifdef CTX_RIP
+	return (uintptr_t)ctx->CTX_RIP;
+#else
+	return (uintptr_t)ctx->CTX_PC;
+#endif
+}
+
+#if defined(JIT_SAMPLER_SIGNAL)
+
+static pthread_t samplerTarget;
+static bool signalInstalled = false;
+
+static void JitSamplerSignalHandler(int sig, siginfo_t *info, void *raw_context) {
+	// Stays installed after stopping, so a late signal is harmless.
+	if (!samplerActive)
+		return;
+	ucontext_t *context = (ucontext_t *)raw_context;
+	JitSample sample{ PCFromContext((const SContext *)&context->uc_mcontext), currentMIPS ? currentMIPS->pc : 0 };
+	if (!sampleRing.Push(sample))
+		samplesDropped++;
+}
+
+static bool StartSampling() {
+	if (!signalInstalled) {
+		struct sigaction sa{};
+		sa.sa_sigaction = &JitSamplerSignalHandler;
+		// Restart where possible, but blocking calls on the emu thread may still see EINTR.
+		sa.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&sa.sa_mask);
+		if (sigaction(SIGPROF, &sa, nullptr) != 0)
+			return false;
+		signalInstalled = true;
+	}
+	samplerTarget = pthread_self();
+	return true;
+}
+
+static void TakeSample() {
+	pthread_kill(samplerTarget, SIGPROF);
+}
+
+static void StopSampling() {
+}
+
+#elif defined(JIT_SAMPLER_SUSPEND)
+
+static HANDLE samplerTarget = nullptr;
+
+static bool StartSampling() {
+	return DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &samplerTarget, THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, 0) != FALSE;
+}
+
+static void TakeSample() {
+	if (SuspendThread(samplerTarget) == (DWORD)-1)
+		return;
+	CONTEXT ctx{};
+	ctx.ContextFlags = CONTEXT_CONTROL;
+	if (GetThreadContext(samplerTarget, &ctx)) {
+		JitSample sample{ PCFromContext(&ctx), currentMIPS ? currentMIPS->pc : 0 };
+		if (!sampleRing.Push(sample))
+			samplesDropped++;
+	}
+	ResumeThread(samplerTarget);
+}
+
+static void StopSampling() {
+	CloseHandle(samplerTarget);
+	samplerTarget = nullptr;
+}
+
+#endif
+
+bool JitSamplerStart(int intervalUsec) {
+#if defined(JIT_SAMPLER_SIGNAL) || defined(JIT_SAMPLER_SUSPEND)
+	if (samplerActive)
+		return true;
+	if (!StartSampling()) {
+		ERROR_LOG(Log::JIT, "Unable to start jit sampler");
+		return false;
+	}
+
+	samplerStop = false;
+	samplerActive = true;
+	samplerThread = std::thread([intervalUsec] {
+		SetCurrentThreadName("JitSampler");
+		while (!samplerStop) {
+			std::this_thread::sleep_for(std::chrono::microseconds(intervalUsec));
+			if (!samplerStop)
+				TakeSample();
+		}
+	});
+	INFO_LOG(Log::JIT, "Jit sampler started, every %d us", intervalUsec);
+	return true;
+#else
+	WARN_LOG(Log::JIT, "Jit sampler not supported on this platform");
+	return false;
+#endif
+}
+
+void JitSamplerStop() {
+#if defined(JIT_SAMPLER_SIGNAL) || defined(JIT_SAMPLER_SUSPEND)
+	if (!samplerActive)
+		return;
+	samplerStop = true;
+	samplerThread.join();
+	StopSampling();
+
+	// Pick up the last few.
+	JitSamplerProcess();
+	samplerActive = false;
+	uint32_t dropped = samplesDropped.exchange(0);
+	if (dropped != 0)
+		WARN_LOG(Log::JIT, "Jit sampler dropped %d samples, run loop too slow to keep up", dropped);
+#endif
+}
+
+bool JitSamplerActive() {
+	return samplerActive;
+}
+
+// Profiling tools split on spaces and semicolons.
+static std::string SanitizeFrame(std::string name) {
+	for (char &c : name) {
+		if (c == ' ' || c == ';')
+			c = '_';
+	}
+	return name;
+}
+
+static u32 GuestFunctionStart(u32 addr) {
+	if (!g_symbolMap || addr == 0)
+		return 0;
+	u32 start = g_symbolMap->GetFunctionStart(addr);
+	return start == SymbolMap::INVALID_ADDRESS ? 0 : start;
+}
+
+static std::string GuestFunctionName(u32 start) {
+	if (start == 0 || !g_symbolMap)
+		return "[unknown]";
+	std::string label = g_symbolMap->GetLabelString(start);
+	if (label.empty())
+		return StringFromFormat("z_un_%08x", start);
+	return SanitizeFrame(label);
+}
+
+void JitSamplerProcess() {
+	if (!samplerActive)
+		return;
+
+	// Can't look at the jit while it might be changing.
+	std::lock_guard<std::recursive_mutex> jitGuard(MIPSComp::jitLock);
+	std::lock_guard<std::mutex> guard(resultsMutex);
+	sampleRing.Drain([](const JitSample &sample) {
+		const u8 *ptr = (const u8 *)sample.hostPC;
+		u32 guestAddr = sample.guestPC;
+		std::string leaf;
+		if (MIPSComp::jit && MIPSComp::jit->CodeInRange(ptr)) {
+			u32 blockAddr = MIPSComp::jit->GetBlockAddressFromCodePtr(ptr);
+			if (blockAddr != 0) {
+				guestAddr = blockAddr;
+				leaf = StringFromFormat("block_%08x", blockAddr);
+			} else if (MIPSComp::jit->DescribeCodePtr(ptr, leaf)) {
+				leaf = SanitizeFrame(leaf);
+			} else {
+				leaf = "[jit]";
+			}
+		} else {
+			// Interpreter, HLE, or anything else outside the jit.
+			leaf = "[host]";
+		}
+
+		u32 funcStart = GuestFunctionStart(guestAddr);
+		foldedCounts[GuestFunctionName(funcStart) + ";" + leaf]++;
+		functionCounts[funcStart]++;
+		totalSamples++;
+	});
+}
+
+void JitSamplerReset() {
+	JitSamplerProcess();
+	std::lock_guard<std::mutex> guard(resultsMutex);
+	foldedCounts.clear();
+	functionCounts.clear();
+	totalSamples = 0;
+}
+
+u64 JitSamplerTotalSamples() {
+	std::lock_guard<std::mutex> guard(resultsMutex);
+	return totalSamples;
+}
+
+std::vector<JitSamplerFunction> JitSamplerHotFunctions(size_t maxCount) {
+	std::vector<JitSamplerFunction> functions;
+	{
+		std::lock_guard<std::mutex> guard(resultsMutex);
+		functions.reserve(functionCounts.size());
+		for (const auto &it : functionCounts)
+			functions.push_back(JitSamplerFunction{ "", it.first, it.second });
+	}
+
+	std::sort(functions.begin(), functions.end(), [](const JitSamplerFunction &a, const JitSamplerFunction &b) {
+		return a.samples > b.samples;
+	});
+	if (functions.size() > maxCount)
+		functions.resize(maxCount);
+	// Only name the ones we return.
+	for (JitSamplerFunction &func : functions)
+		func.name = GuestFunctionName(func.address);
+	return functions;
+}
+
+std::string JitSamplerFoldedStacks() {
+	std::vector<std::pair<std::string, u64>> stacks;
+	{
+		std::lock_guard<std::mutex> guard(resultsMutex);
+		stacks.assign(foldedCounts.begin(), foldedCounts.end());
+	}
+	// Stable output makes runs easier to diff.
+	std::sort(stacks.begin(), stacks.end());
+
+	std::string result;
+	for (const auto &stack : stacks)
+		result += StringFromFormat("%s %llu\n", stack.first.c_str(), (unsigned long long)stack.second);
+	return result;
+}
+
+bool JitSamplerWriteFoldedStacks(const Path &filename) {
+	return File::WriteStringToFile(true, JitSamplerFoldedStacks(), filename);
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2025- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+class Path;
+
+// Sampling profiler for the emu thread.  A helper thread periodically grabs the host pc of the
+// emu thread (and the emulated pc), which are later symbolized into the jit block and guest
+// function they were in.  Only supported where we can read another thread's machine context.
+
+struct JitSamplerFunction {
+	std::string name;
+	u32 address;
+	u64 samples;
+};
+
+// Call these from the thread running the emulator, which is the one that gets sampled.
+bool JitSamplerStart(int intervalUsec = 1000);
+void JitSamplerStop();
+bool JitSamplerActive();
+
+// The rest are fine from any thread, e.g. the debugger's.
+// Symbolizes pending samples, called regularly by the run loop.  Cheap when not sampling.
+void JitSamplerProcess();
+void JitSamplerReset();
+
+u64 JitSamplerTotalSamples();
+// Sorted by samples, most first.
+std::vector<JitSamplerFunction> JitSamplerHotFunctions(size_t maxCount);
+// One "guest_func;leaf count" line per stack, as consumed by flamegraph.pl and friends.
+std::string JitSamplerFoldedStacks();
+bool JitSamplerWriteFoldedStacks(const Path &filename);
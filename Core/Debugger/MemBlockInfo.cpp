@@ -81,30 +81,143 @@ class MemSlabMap {
 };
 
 struct PendingNotifyMem {
-	MemBlockFlags flags;
 	uint32_t start;
 	uint32_t size;
 	uint32_t copySrc;
-	uint64_t ticks;
 	uint32_t pc;
-	char tag[128];
+	uint64_t ticks;
+	// Order across all threads, so rings can be applied in the order things happened.
+	uint32_t seq;
+	uint16_t tagId;
+	uint16_t flags;
+};
+static_assert(sizeof(PendingNotifyMem) == 32, "Keep pending notifies compact");
+
+// Each notifying thread gets its own ring, so recording never waits on another thread.
+// Only the owning thread pushes or interns tags.  Draining happens under pendingReadMutex, and the
+// owner only resets its tags while holding that lock, so drained tag ids are always valid.
+class MemNotifyRing {
+public:
+	static constexpr uint16_t INVALID_TAG = 0xFFFF;
+
+	bool Push(const PendingNotifyMem &info) {
+		uint32_t write = write_.load(std::memory_order_relaxed);
+		if (write - read_.load(std::memory_order_acquire) >= CAPACITY)
+			return false;
+		records_[write & (CAPACITY - 1)] = info;
+		write_.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	uint32_t Pending() const {
+		return write_.load(std::memory_order_relaxed) - read_.load(std::memory_order_relaxed);
+	}
+
+	// Only call with pendingReadMutex held.
+	template <typename F>
+	void Drain(F func) {
+		uint32_t read = read_.load(std::memory_order_relaxed);
+		uint32_t write = write_.load(std::memory_order_acquire);
+		for (; read != write; ++read) {
+			const PendingNotifyMem &info = records_[read & (CAPACITY - 1)];
+			func(info, Tag(info.tagId));
+		}
+		read_.store(read, std::memory_order_release);
+	}
+
+	uint16_t InternTag(const char *tag, size_t length) {
+		if (length >= 128)
+			length = 127;
+		uint32_t hash = HashTag(tag, length);
+		for (uint32_t i = 0; i < TAG_HASH_SIZE; ++i) {
+			uint32_t slot = (hash + i) & (TAG_HASH_SIZE - 1);
+			uint16_t id = tagSlots_[slot];
+			if (id == 0) {
+				if (tagCount_ >= MAX_TAGS || tagDataUsed_ + length + 1 > TAG_DATA_SIZE)
+					return INVALID_TAG;
+				id = (uint16_t)tagCount_++;
+				tagOffsets_[id] = tagDataUsed_;
+				tagHashes_[id] = hash;
+				memcpy(&tagData_[tagDataUsed_], tag, length);
+				tagData_[tagDataUsed_ + length] = '\0';
+				tagDataUsed_ += (uint32_t)length + 1;
+				tagSlots_[slot] = id + 1;
+				return id;
+			}
+
+			--id;
+			const char *existing = Tag(id);
+			if (tagHashes_[id] == hash && strncmp(existing, tag, length) == 0 && existing[length] == '\0')
+				return id;
+		}
+		return INVALID_TAG;
+	}
+
+	// Only call with pendingReadMutex held, after draining.
+	void ResetTags() {
+		memset(tagSlots_, 0, sizeof(tagSlots_));
+		tagCount_ = 0;
+		tagDataUsed_ = 0;
+	}
+
+	// Set when the thread exits, the ring is freed once drained.
+	std::atomic<bool> abandoned{};
+
+private:
+	static constexpr uint32_t CAPACITY = 4096;
+	static constexpr uint32_t MAX_TAGS = 2048;
+	static constexpr uint32_t TAG_HASH_SIZE = 4096;
+	static constexpr uint32_t TAG_DATA_SIZE = 64 * 1024;
+
+	const char *Tag(uint16_t id) const {
+		return &tagData_[tagOffsets_[id]];
+	}
+
+	static uint32_t HashTag(const char *tag, size_t length) {
+		// FNV-1a, tags are short.
+		uint32_t hash = 2166136261U;
+		for (size_t i = 0; i < length && tag[i] != '\0'; ++i)
+			hash = (hash ^ (uint8_t)tag[i]) * 16777619U;
+		return hash;
+	}
+
+	PendingNotifyMem records_[CAPACITY];
+	alignas(64) std::atomic<uint32_t> write_{};
+	alignas(64) std::atomic<uint32_t> read_{};
+
+	uint16_t tagSlots_[TAG_HASH_SIZE]{};
+	uint32_t tagHashes_[MAX_TAGS];
+	uint32_t tagOffsets_[MAX_TAGS];
+	uint32_t tagCount_ = 0;
+	uint32_t tagDataUsed_ = 0;
+	char tagData_[TAG_DATA_SIZE];
+};
+
+struct ThreadNotifyRing {
+	~ThreadNotifyRing() {
+		if (ring)
+			ring->abandoned = true;
+	}
+
+	MemNotifyRing *ring = nullptr;
 };
 
-// 160 KB.
-static constexpr size_t MAX_PENDING_NOTIFIES = 1024;
-static constexpr size_t MAX_PENDING_NOTIFIES_THREAD = 1000;
+// Wake the flush thread at this many pending in a ring.  A full ring flushes on its own thread.
+static constexpr uint32_t FLUSH_THRESHOLD_NOTIFIES = 1000;
 static MemSlabMap allocMap;
 static MemSlabMap suballocMap;
 static MemSlabMap writeMap;
 static MemSlabMap textureMap;
-static std::vector<PendingNotifyMem> pendingNotifies;
 static std::atomic<uint32_t> pendingNotifyMinAddr1;
 static std::atomic<uint32_t> pendingNotifyMaxAddr1;
 static std::atomic<uint32_t> pendingNotifyMinAddr2;
 static std::atomic<uint32_t> pendingNotifyMaxAddr2;
-// To prevent deadlocks, acquire Read before Write if you're going to acquire both.
-static std::mutex pendingWriteMutex;
+static std::atomic<uint32_t> pendingNotifySeq;
+// Held while applying notifies to the maps.  To prevent deadlocks, acquire before notifyRingsMutex.
 static std::mutex pendingReadMutex;
+static std::mutex notifyRingsMutex;
+static std::vector<MemNotifyRing *> notifyRings;
+static thread_local ThreadNotifyRing threadNotifyRing;
 static int detailedOverride;
 
 static std::thread flushThread;
@@ -398,50 +511,129 @@ void MemSlabMap::FillHeads(Slab *slab) {
 
 size_t FormatMemWriteTagAtNoFlush(char *buf, size_t sz, const char *prefix, uint32_t start, uint32_t size);
 
-void FlushPendingMemInfo() {
+struct DrainedNotifyMem {
+	PendingNotifyMem info;
+	const char *tag;
+};
+
+// Sometimes we get duplicates, quickly check the last few.
+static inline bool MergeRecentMemInfo(std::vector<DrainedNotifyMem> &batch, const DrainedNotifyMem &next) {
+	if (batch.size() < 4)
+		return false;
+
+	const PendingNotifyMem &info = next.info;
+	for (size_t i = 1; i <= 4; ++i) {
+		auto &prev = batch[batch.size() - i];
+		if (prev.info.copySrc != 0)
+			return false;
+
+		if (prev.info.flags != info.flags)
+			continue;
+
+		if (prev.info.start >= info.start + info.size || prev.info.start + prev.info.size <= info.start)
+			continue;
+
+		// This means there's overlap, but not a match, so we can't combine any.
+		if (prev.info.start != info.start || prev.info.size > info.size)
+			return false;
+
+		prev.tag = next.tag;
+		prev.info.size = info.size;
+		prev.info.ticks = info.ticks;
+		prev.info.pc = info.pc;
+		return true;
+	}
+
+	return false;
+}
+
+// Pass a ring to also reset its tag table once everything is applied.
+static void FlushPendingMemInfo(MemNotifyRing *resetTagsRing) {
 	// This lock prevents us from another thread reading while we're busy flushing.
 	std::lock_guard<std::mutex> guard(pendingReadMutex);
-	std::vector<PendingNotifyMem> thisBatch;
+
+	// Reset before draining: anything pushed after the drain updates these after we did.
+	pendingNotifyMinAddr1 = 0xFFFFFFFF;
+	pendingNotifyMaxAddr1 = 0;
+	pendingNotifyMinAddr2 = 0xFFFFFFFF;
+	pendingNotifyMaxAddr2 = 0;
+
+	// Only used under the lock, kept around to avoid reallocating.
+	static std::vector<DrainedNotifyMem> drained;
+	static std::vector<DrainedNotifyMem> thisBatch;
+	static std::vector<MemNotifyRing *> freeRings;
+	drained.clear();
+	thisBatch.clear();
+	freeRings.clear();
 	{
-		std::lock_guard<std::mutex> guard(pendingWriteMutex);
-		thisBatch = std::move(pendingNotifies);
-		pendingNotifies.clear();
-		pendingNotifies.reserve(MAX_PENDING_NOTIFIES);
+		std::lock_guard<std::mutex> ringsGuard(notifyRingsMutex);
+		for (size_t i = 0; i < notifyRings.size(); ++i) {
+			MemNotifyRing *ring = notifyRings[i];
+			bool abandoned = ring->abandoned;
+			ring->Drain([](const PendingNotifyMem &info, const char *tag) {
+				drained.push_back({ info, tag });
+			});
+			// The tags of abandoned rings are still used below, so just unlist it for now.
+			if (abandoned) {
+				notifyRings[i--] = notifyRings.back();
+				notifyRings.pop_back();
+				freeRings.push_back(ring);
+			}
+		}
+	}
+
+	// With several threads notifying, put everything back in order.
+	auto seqLess = [](const DrainedNotifyMem &a, const DrainedNotifyMem &b) {
+		return (int32_t)(a.info.seq - b.info.seq) < 0;
+	};
+	if (!std::is_sorted(drained.begin(), drained.end(), seqLess))
+		std::sort(drained.begin(), drained.end(), seqLess);
 
-		pendingNotifyMinAddr1 = 0xFFFFFFFF;
-		pendingNotifyMaxAddr1 = 0;
-		pendingNotifyMinAddr2 = 0xFFFFFFFF;
-		pendingNotifyMaxAddr2 = 0;
+	for (const DrainedNotifyMem &entry : drained) {
+		if (entry.info.copySrc != 0 || !MergeRecentMemInfo(thisBatch, entry))
+			thisBatch.push_back(entry);
 	}
 
-	for (const auto &info : thisBatch) {
+	for (const auto &entry : thisBatch) {
+		const PendingNotifyMem &info = entry.info;
+		MemBlockFlags flags = (MemBlockFlags)info.flags;
 		if (info.copySrc != 0) {
 			char tagData[128];
-			size_t tagSize = FormatMemWriteTagAtNoFlush(tagData, sizeof(tagData), info.tag, info.copySrc, info.size);
+			FormatMemWriteTagAtNoFlush(tagData, sizeof(tagData), entry.tag, info.copySrc, info.size);
 			writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, tagData);
 			continue;
 		}
 
-		if (info.flags & MemBlockFlags::ALLOC) {
-			allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		} else if (info.flags & MemBlockFlags::FREE) {
+		if (flags & MemBlockFlags::ALLOC) {
+			allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, entry.tag);
+		} else if (flags & MemBlockFlags::FREE) {
 			// Maintain the previous allocation tag for debugging.
 			allocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
 			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
 		}
-		if (info.flags & MemBlockFlags::SUB_ALLOC) {
-			suballocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		} else if (info.flags & MemBlockFlags::SUB_FREE) {
+		if (flags & MemBlockFlags::SUB_ALLOC) {
+			suballocMap.Mark(info.start, info.size, info.ticks, info.pc, true, entry.tag);
+		} else if (flags & MemBlockFlags::SUB_FREE) {
 			// Maintain the previous allocation tag for debugging.
 			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
 		}
-		if (info.flags & MemBlockFlags::TEXTURE) {
-			textureMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
+		if (flags & MemBlockFlags::TEXTURE) {
+			textureMap.Mark(info.start, info.size, info.ticks, info.pc, true, entry.tag);
 		}
-		if (info.flags & MemBlockFlags::WRITE) {
-			writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
+		if (flags & MemBlockFlags::WRITE) {
+			writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, entry.tag);
 		}
 	}
+
+	for (MemNotifyRing *ring : freeRings)
+		delete ring;
+	if (resetTagsRing)
+		resetTagsRing->ResetTags();
+}
+
+void FlushPendingMemInfo() {
+	FlushMemInfoRun();
+	FlushPendingMemInfo(nullptr);
 }
 
 static inline uint32_t NormalizeAddress(uint32_t addr) {
@@ -450,77 +642,150 @@ static inline uint32_t NormalizeAddress(uint32_t addr) {
 	return addr & 0x3FFFFFFF;
 }
 
-static inline bool MergeRecentMemInfo(const PendingNotifyMem &info, size_t copyLength) {
-	if (pendingNotifies.size() < 4)
-		return false;
+static inline void AtomicMin(std::atomic<uint32_t> &value, uint32_t v) {
+	uint32_t cur = value.load(std::memory_order_relaxed);
+	while (v < cur && !value.compare_exchange_weak(cur, v)) {
+		continue;
+	}
+}
 
-	for (size_t i = 1; i <= 4; ++i) {
-		auto &prev = pendingNotifies[pendingNotifies.size() - i];
-		if (prev.copySrc != 0)
-			return false;
+static inline void AtomicMax(std::atomic<uint32_t> &value, uint32_t v) {
+	uint32_t cur = value.load(std::memory_order_relaxed);
+	while (v > cur && !value.compare_exchange_weak(cur, v)) {
+		continue;
+	}
+}
 
-		if (prev.flags != info.flags)
-			continue;
+static MemNotifyRing *GetThreadNotifyRing() {
+	MemNotifyRing *ring = threadNotifyRing.ring;
+	if (!ring) {
+		ring = new MemNotifyRing();
+		threadNotifyRing.ring = ring;
+		std::lock_guard<std::mutex> guard(notifyRingsMutex);
+		notifyRings.push_back(ring);
+	}
+	return ring;
+}
 
-		if (prev.start >= info.start + info.size || prev.start + prev.size <= info.start)
-			continue;
+static void QueueNotify(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t copySrc, uint32_t pc, const char *tag, size_t tagLength) {
+	MemNotifyRing *ring = GetThreadNotifyRing();
+	uint16_t tagId = ring->InternTag(tag, tagLength);
+	if (tagId == MemNotifyRing::INVALID_TAG) {
+		// Out of tag space, so apply everything and start the table over.
+		FlushPendingMemInfo(ring);
+		tagId = ring->InternTag(tag, tagLength);
+	}
 
-		// This means there's overlap, but not a match, so we can't combine any.
-		if (prev.start != info.start || prev.size > info.size)
-			return false;
+	PendingNotifyMem info{ start, size, copySrc, pc };
+	info.ticks = CoreTiming::GetTicks();
+	info.seq = pendingNotifySeq++;
+	info.tagId = tagId;
+	info.flags = (uint16_t)((uint32_t)flags & 0xFFFF);
+	if (!ring->Push(info)) {
+		// The flush thread didn't keep up, do it here.
+		FlushPendingMemInfo(nullptr);
+		ring->Push(info);
+	}
 
-		memcpy(prev.tag, info.tag, copyLength + 1);
-		prev.size = info.size;
-		prev.ticks = info.ticks;
-		prev.pc = info.pc;
-		return true;
+	// This must happen after the push, see FlushPendingMemInfo.
+	if (start < 0x08000000) {
+		AtomicMin(pendingNotifyMinAddr1, start);
+		AtomicMax(pendingNotifyMaxAddr1, start + size);
+	} else {
+		AtomicMin(pendingNotifyMinAddr2, start);
+		AtomicMax(pendingNotifyMaxAddr2, start + size);
 	}
 
-	return false;
+	if (ring->Pending() > FLUSH_THRESHOLD_NOTIFIES && !flushThreadPending) {
+		{
+			std::lock_guard<std::mutex> guard(flushLock);
+			flushThreadPending = true;
+		}
+		flushCond.notify_one();
+	}
+}
+
+// Small writes tend to come in runs (structs copied one after another, a buffer cleared in
+// pieces), see NotifyMemInfoRun.  Any other notify queues the run first, so order is kept.
+struct PendingRunNotify {
+	uint32_t destPtr;
+	// Zero for a plain write.
+	uint32_t srcPtr;
+	uint32_t size;
+	uint32_t pc;
+	const char *tag;
+};
+
+static PendingRunNotify pendingRun;
+static std::mutex pendingRunLock;
+static std::atomic<bool> pendingRunValid;
+
+void FlushMemInfoRun() {
+	if (!pendingRunValid.load(std::memory_order_relaxed))
+		return;
+
+	PendingRunNotify run;
+	{
+		std::lock_guard<std::mutex> guard(pendingRunLock);
+		if (!pendingRunValid)
+			return;
+		run = pendingRun;
+		pendingRunValid = false;
+	}
+	if (run.srcPtr != 0)
+		NotifyMemInfoCopyPC(run.destPtr, run.srcPtr, run.size, run.pc, run.tag);
+	else
+		NotifyMemInfoPC(MemBlockFlags::WRITE, run.destPtr, run.size, run.pc, run.tag, strlen(run.tag));
+}
+
+void NotifyMemInfoRun(uint32_t destPtr, uint32_t srcPtr, uint32_t size, const char *tag) {
+	if (size == 0)
+		return;
+	// Large writes don't come in runs, and memchecks need to see each write as it happens.
+	if (size >= MEMINFO_MIN_SIZE || CBreakPoints::HasMemChecks()) {
+		if (srcPtr != 0)
+			NotifyMemInfoCopy(destPtr, srcPtr, size, tag);
+		else
+			NotifyMemInfo(MemBlockFlags::WRITE, destPtr, size, tag, strlen(tag));
+		return;
+	}
+	if (!MemBlockInfoDetailed())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(pendingRunLock);
+		PendingRunNotify &run = pendingRun;
+		if (pendingRunValid && run.tag == tag && run.destPtr + run.size == destPtr && run.size + size < MEMINFO_MIN_SIZE * 64) {
+			if (srcPtr == 0 && run.srcPtr == 0) {
+				run.size += size;
+				return;
+			}
+			// Reading back what the run wrote would need the run's tag first.
+			bool readsRun = srcPtr < destPtr && srcPtr + size > run.destPtr;
+			if (srcPtr != 0 && run.srcPtr + run.size == srcPtr && !readsRun) {
+				run.size += size;
+				return;
+			}
+		}
+	}
+
+	FlushMemInfoRun();
+	std::lock_guard<std::mutex> guard(pendingRunLock);
+	pendingRun = PendingRunNotify{ destPtr, srcPtr, size, currentMIPS->pc, tag };
+	pendingRunValid = true;
 }
 
 void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t pc, const char *tagStr, size_t strLength) {
 	if (size == 0) {
 		return;
 	}
+	FlushMemInfoRun();
 	// Clear the uncached and kernel bits.
 	start = NormalizeAddress(start);
 
-	bool needFlush = false;
 	// When the setting is off, we skip smaller info to keep things fast.
 	if (MemBlockInfoDetailed(size) && flags != MemBlockFlags::READ) {
-		PendingNotifyMem info{ flags, start, size };
-		info.ticks = CoreTiming::GetTicks();
-		info.pc = pc;
-
-		size_t copyLength = strLength;
-		if (copyLength >= sizeof(info.tag)) {
-			copyLength = sizeof(info.tag) - 1;
-		}
-		memcpy(info.tag, tagStr, copyLength);
-		info.tag[copyLength] = 0;
-
-		std::lock_guard<std::mutex> guard(pendingWriteMutex);
-		// Sometimes we get duplicates, quickly check.
-		if (!MergeRecentMemInfo(info, copyLength)) {
-			if (start < 0x08000000) {
-				pendingNotifyMinAddr1 = std::min(pendingNotifyMinAddr1.load(), start);
-				pendingNotifyMaxAddr1 = std::max(pendingNotifyMaxAddr1.load(), start + size);
-			} else {
-				pendingNotifyMinAddr2 = std::min(pendingNotifyMinAddr2.load(), start);
-				pendingNotifyMaxAddr2 = std::max(pendingNotifyMaxAddr2.load(), start + size);
-			}
-			pendingNotifies.push_back(info);
-		}
-		needFlush = pendingNotifies.size() > MAX_PENDING_NOTIFIES_THREAD;
-	}
-
-	if (needFlush) {
-		{
-			std::lock_guard<std::mutex> guard(flushLock);
-			flushThreadPending = true;
-		}
-		flushCond.notify_one();
+		QueueNotify(flags, start, size, 0, pc, tagStr, strLength);
 	}
 
 	if (!(flags & MemBlockFlags::SKIP_MEMCHECK)) {
@@ -537,51 +802,32 @@ void NotifyMemInfo(MemBlockFlags flags, uint32_t start, uint32_t size, const cha
 }
 
 void NotifyMemInfoCopy(uint32_t destPtr, uint32_t srcPtr, uint32_t size, const char *prefix) {
+	NotifyMemInfoCopyPC(destPtr, srcPtr, size, currentMIPS->pc, prefix);
+}
+
+void NotifyMemInfoCopyPC(uint32_t destPtr, uint32_t srcPtr, uint32_t size, uint32_t pc, const char *prefix) {
 	if (size == 0)
 		return;
+	FlushMemInfoRun();
 
-	bool needsFlush = false;
 	if (CBreakPoints::HasMemChecks()) {
 		// This will cause a flush, but it's needed to trigger memchecks with proper data.
 		char tagData[128];
 		size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), prefix, srcPtr, size);
-		NotifyMemInfo(MemBlockFlags::READ, srcPtr, size, tagData, tagSize);
-		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, size, tagData, tagSize);
+		NotifyMemInfoPC(MemBlockFlags::READ, srcPtr, size, pc, tagData, tagSize);
+		NotifyMemInfoPC(MemBlockFlags::WRITE, destPtr, size, pc, tagData, tagSize);
 	} else if (MemBlockInfoDetailed(size)) {
 		srcPtr = NormalizeAddress(srcPtr);
 		destPtr = NormalizeAddress(destPtr);
 
-		PendingNotifyMem info{ MemBlockFlags::WRITE, destPtr, size };
-		info.copySrc = srcPtr;
-		info.ticks = CoreTiming::GetTicks();
-		info.pc = currentMIPS->pc;
-
 		// Store the prefix for now.  The correct tag will be calculated on flush.
-		truncate_cpy(info.tag, prefix);
-
-		std::lock_guard<std::mutex> guard(pendingWriteMutex);
-		if (destPtr < 0x08000000) {
-			pendingNotifyMinAddr1 = std::min(pendingNotifyMinAddr1.load(), destPtr);
-			pendingNotifyMaxAddr1 = std::max(pendingNotifyMaxAddr1.load(), destPtr + size);
-		} else {
-			pendingNotifyMinAddr2 = std::min(pendingNotifyMinAddr2.load(), destPtr);
-			pendingNotifyMaxAddr2 = std::max(pendingNotifyMaxAddr2.load(), destPtr + size);
-		}
-		pendingNotifies.push_back(info);
-		needsFlush = pendingNotifies.size() > MAX_PENDING_NOTIFIES_THREAD;
-	}
-
-	if (needsFlush) {
-		{
-			std::lock_guard<std::mutex> guard(flushLock);
-			flushThreadPending = true;
-		}
-		flushCond.notify_one();
+		QueueNotify(MemBlockFlags::WRITE, destPtr, size, srcPtr, pc, prefix, strlen(prefix));
 	}
 }
 
 std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
+	FlushMemInfoRun();
 
 	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
 		FlushPendingMemInfo();
@@ -598,6 +844,7 @@ std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
 
 std::vector<MemBlockInfo> FindMemInfoByFlag(MemBlockFlags flags, uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
+	FlushMemInfoRun();
 
 	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
 		FlushPendingMemInfo();
@@ -620,6 +867,7 @@ static const char *FindWriteTagByFlag(MemBlockFlags flags, uint32_t start, uint3
 	start = NormalizeAddress(start);
 
 	if (flush) {
+		FlushMemInfoRun();
 		if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
 			FlushPendingMemInfo();
 		if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
@@ -691,8 +939,6 @@ static void FlushMemInfoThread() {
 
 void MemBlockInfoInit() {
 	std::lock_guard<std::mutex> guard(pendingReadMutex);
-	std::lock_guard<std::mutex> guardW(pendingWriteMutex);
-	pendingNotifies.reserve(MAX_PENDING_NOTIFIES);
 	pendingNotifyMinAddr1 = 0xFFFFFFFF;
 	pendingNotifyMaxAddr1 = 0;
 	pendingNotifyMinAddr2 = 0xFFFFFFFF;
@@ -706,12 +952,18 @@ void MemBlockInfoInit() {
 void MemBlockInfoShutdown() {
 	{
 		std::lock_guard<std::mutex> guard(pendingReadMutex);
-		std::lock_guard<std::mutex> guardW(pendingWriteMutex);
+		std::lock_guard<std::mutex> ringsGuard(notifyRingsMutex);
 		allocMap.Reset();
 		suballocMap.Reset();
 		writeMap.Reset();
 		textureMap.Reset();
-		pendingNotifies.clear();
+		for (MemNotifyRing *ring : notifyRings) {
+			ring->Drain([](const PendingNotifyMem &info, const char *tag) {});
+		}
+	}
+	{
+		std::lock_guard<std::mutex> guard(pendingRunLock);
+		pendingRunValid = false;
 	}
 
 	if (flushThreadRunning.load()) {
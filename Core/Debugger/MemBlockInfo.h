@@ -54,6 +54,12 @@ struct MemBlockInfo {
 void NotifyMemInfo(MemBlockFlags flags, uint32_t start, uint32_t size, const char *tag, size_t tagLength);
 void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t pc, const char *tag, size_t tagLength);
 void NotifyMemInfoCopy(uint32_t destPtr, uint32_t srcPtr, uint32_t size, const char *prefix);
+void NotifyMemInfoCopyPC(uint32_t destPtr, uint32_t srcPtr, uint32_t size, uint32_t pc, const char *prefix);
+// A copy (srcPtr != 0) or write, which may be merged with the previous one if it continues it.
+// Small writes only need this with detailed mem info on.  The tag must be a string constant.
+void NotifyMemInfoRun(uint32_t destPtr, uint32_t srcPtr, uint32_t size, const char *tag);
+// Queues a pending merged run, done by any other notify too.
+void FlushMemInfoRun();
 
 // This lets us avoid calling strlen on string constants, instead the string length (including null,
 // so we have to subtract 1) is computed at compile time.
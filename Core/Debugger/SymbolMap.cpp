@@ -30,6 +30,7 @@
 #endif
 
 #include <algorithm>
+#include <deque>
 #include <memory>
 #ifndef NO_ARMIPS
 #include <string_view>
@@ -39,6 +40,7 @@
 #include "zlib.h"
 
 #include "Common/CommonTypes.h"
+#include "Common/Data/Collections/EytzingerIndex.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
@@ -62,6 +64,188 @@ struct LabelDefinition {
 
 SymbolMap *g_symbolMap;
 
+// Functions or data, by absolute start address.  Sizes and extra can be patched in place for
+// entries that are already here, adding or removing entries needs a rebuild.
+struct SymbolRangeIndex {
+	explicit SymbolRangeIndex(size_t count) : sizes(count), extra(count) {}
+
+	EytzingerIndex index;
+	std::vector<u32> starts;
+	std::vector<std::atomic<u32>> sizes;
+	// Function index, or data type.
+	std::vector<std::atomic<int>> extra;
+
+	int Find(u32 start) const {
+		size_t i = index.LowerBound(start);
+		return i < starts.size() && starts[i] == start ? (int)i : -1;
+	}
+
+	u32 Containing(u32 address) const {
+		size_t i = index.UpperBound(address);
+		if (i == 0)
+			return SymbolMap::INVALID_ADDRESS;
+		u32 start = starts[i - 1];
+		if (start <= address && start + sizes[i - 1] > address)
+			return start;
+		return SymbolMap::INVALID_ADDRESS;
+	}
+};
+
+struct SymbolLabelIndex {
+	explicit SymbolLabelIndex(size_t count) : namePtrs(count) {}
+
+	EytzingerIndex index;
+	std::vector<u32> addresses;
+	// Into names or renamed.  Swapped in place on rename, the old name stays valid.
+	std::vector<std::atomic<const char *>> namePtrs;
+	// All names at build time, each null terminated, with duplicates stored only once.
+	std::string names;
+	// Names set since the build.  Only touched under the symbol map lock, deque so they never move.
+	std::deque<std::string> renamed;
+
+	int FindIndex(u32 address) const {
+		size_t i = index.LowerBound(address);
+		return i < addresses.size() && addresses[i] == address ? (int)i : -1;
+	}
+
+	const char *Find(u32 address) const {
+		int i = FindIndex(address);
+		return i == -1 ? nullptr : namePtrs[i].load(std::memory_order_acquire);
+	}
+};
+
+struct SymbolMapSnapshot {
+	std::shared_ptr<SymbolRangeIndex> functions;
+	std::shared_ptr<SymbolLabelIndex> labels;
+	std::shared_ptr<SymbolRangeIndex> data;
+};
+
+template <typename T, typename F>
+static std::shared_ptr<SymbolRangeIndex> BuildRangeIndex(const std::map<u32, const T> &active, F getExtra) {
+	auto result = std::make_shared<SymbolRangeIndex>(active.size());
+	result->starts.reserve(active.size());
+	for (const auto &it : active) {
+		size_t i = result->starts.size();
+		result->starts.push_back(it.first);
+		result->sizes[i].store(it.second.size, std::memory_order_relaxed);
+		result->extra[i].store(getExtra(it.second), std::memory_order_relaxed);
+	}
+	result->index.Build(result->starts);
+	return result;
+}
+
+std::shared_ptr<const SymbolMapSnapshot> SymbolMap::Snapshot() {
+	std::shared_ptr<const SymbolMapSnapshot> snapshot = std::atomic_load(&snapshot_);
+	if (snapshot && snapshotDirty_ == 0)
+		return snapshot;
+	// Other threads can keep using the old one, but our own changes have to show up.
+	bool ownChanges = lastChangedBy_ == std::this_thread::get_id();
+	if (snapshot && updateDepth_ != 0 && !ownChanges)
+		return snapshot;
+
+	std::unique_lock<std::recursive_mutex> guard(lock_, std::defer_lock);
+	if (!snapshot || ownChanges) {
+		// Nothing to hand out yet, or it wouldn't have our changes.  Have to wait.
+		guard.lock();
+	} else if (!guard.try_lock()) {
+		// Someone is changing symbols right now.  Rather than wait for them, use what we have.
+		return snapshot;
+	}
+	if (activeNeedUpdate_)
+		UpdateActiveSymbols();
+	if (snapshotDirty_ != 0 || !snapshot_)
+		RebuildSnapshot();
+	return std::atomic_load(&snapshot_);
+}
+
+void SymbolMap::RebuildSnapshot() {
+	std::lock_guard<std::recursive_mutex> guard(lock_);
+	int dirty = snapshotDirty_;
+	auto snapshot = std::make_shared<SymbolMapSnapshot>();
+	// Only the parts that changed are rebuilt, the rest is shared with the previous snapshot.
+	if (snapshot_)
+		*snapshot = *snapshot_;
+
+	if ((dirty & SNAPSHOT_FUNCTIONS) || !snapshot->functions)
+		snapshot->functions = BuildRangeIndex(activeFunctions, [](const FunctionEntry &func) { return func.index; });
+	if ((dirty & SNAPSHOT_DATA) || !snapshot->data)
+		snapshot->data = BuildRangeIndex(activeData, [](const DataEntry &entry) { return (int)entry.type; });
+
+	if ((dirty & SNAPSHOT_LABELS) || !snapshot->labels) {
+		auto labelIndex = std::make_shared<SymbolLabelIndex>(activeLabels.size());
+		labelIndex->addresses.reserve(activeLabels.size());
+		std::vector<u32> nameOffsets;
+		nameOffsets.reserve(activeLabels.size());
+		std::unordered_map<std::string, u32> interned;
+		for (const auto &it : activeLabels) {
+			auto name = interned.emplace(it.second.name, (u32)labelIndex->names.size());
+			if (name.second) {
+				labelIndex->names.append(it.second.name);
+				labelIndex->names.push_back('\0');
+			}
+			labelIndex->addresses.push_back(it.first);
+			nameOffsets.push_back(name.first->second);
+		}
+		// Only now that names is done growing can we point into it.
+		for (size_t i = 0; i < nameOffsets.size(); ++i)
+			labelIndex->namePtrs[i].store(labelIndex->names.c_str() + nameOffsets[i], std::memory_order_relaxed);
+		labelIndex->index.Build(labelIndex->addresses);
+		snapshot->labels = labelIndex;
+	}
+
+	std::atomic_store(&snapshot_, std::shared_ptr<const SymbolMapSnapshot>(snapshot));
+	// Only clean once it's published, or a reader might take the old one as current.  Nothing can
+	// change meanwhile, that needs lock_.
+	snapshotDirty_ = 0;
+}
+
+// The patches below update an entry that's already in the current snapshot, so that single edits
+// (like renaming a function) don't need a full rebuild.  Called with lock_ held.
+void SymbolMap::PatchFunctionSize(u32 address, u32 size) {
+	// If it's being rebuilt anyway, the new size will be picked up.
+	if (snapshotDirty_ & SNAPSHOT_FUNCTIONS)
+		return;
+	int i = snapshot_->functions->Find(address);
+	if (i == -1)
+		InvalidateSnapshot(SNAPSHOT_FUNCTIONS);
+	else
+		snapshot_->functions->sizes[i].store(size, std::memory_order_relaxed);
+}
+
+void SymbolMap::PatchLabelName(u32 address, const char *name) {
+	if (snapshotDirty_ & SNAPSHOT_LABELS)
+		return;
+	SymbolLabelIndex &labelIndex = *snapshot_->labels;
+	int i = labelIndex.FindIndex(address);
+	if (i == -1) {
+		InvalidateSnapshot(SNAPSHOT_LABELS);
+		return;
+	}
+	labelIndex.renamed.emplace_back(name);
+	labelIndex.namePtrs[i].store(labelIndex.renamed.back().c_str(), std::memory_order_release);
+}
+
+void SymbolMap::PatchData(u32 address, u32 size, DataType type) {
+	if (snapshotDirty_ & SNAPSHOT_DATA)
+		return;
+	int i = snapshot_->data->Find(address);
+	if (i == -1) {
+		InvalidateSnapshot(SNAPSHOT_DATA);
+		return;
+	}
+	snapshot_->data->sizes[i].store(size, std::memory_order_relaxed);
+	snapshot_->data->extra[i].store((int)type, std::memory_order_relaxed);
+}
+
+void SymbolMap::BeginUpdate() {
+	updateDepth_++;
+}
+
+void SymbolMap::EndUpdate() {
+	_dbg_assert_(updateDepth_ > 0);
+	updateDepth_--;
+}
+
 void SymbolMap::SortSymbols() {
 	std::lock_guard<std::recursive_mutex> guard(lock_);
 
@@ -79,6 +263,7 @@ void SymbolMap::Clear() {
 	activeModuleEnds.clear();
 	modules.clear();
 	activeNeedUpdate_ = false;
+	InvalidateSnapshot(SNAPSHOT_ALL);
 }
 
 bool SymbolMap::LoadSymbolMap(const Path &filename) {
@@ -332,13 +517,10 @@ void SymbolMap::SaveNocashSym(const Path &filename) const {
 }
 
 SymbolType SymbolMap::GetSymbolType(u32 address) {
-	if (activeNeedUpdate_)
-		UpdateActiveSymbols();
-
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	if (activeFunctions.find(address) != activeFunctions.end())
+	auto snapshot = Snapshot();
+	if (snapshot->functions->Find(address) != -1)
 		return ST_FUNCTION;
-	if (activeData.find(address) != activeData.end())
+	if (snapshot->data->Find(address) != -1)
 		return ST_DATA;
 	return ST_NONE;
 }
@@ -402,16 +584,16 @@ u32 SymbolMap::GetNextSymbolAddress(u32 address, SymbolType symmask) {
 }
 
 std::string SymbolMap::GetDescription(unsigned int address) {
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	const char* labelName = NULL;
+	auto snapshot = Snapshot();
+	const char *labelName = nullptr;
 
-	u32 funcStart = GetFunctionStart(address);
+	u32 funcStart = snapshot->functions->Containing(address);
 	if (funcStart != INVALID_ADDRESS) {
-		labelName = GetLabelName(funcStart);
+		labelName = snapshot->labels->Find(funcStart);
 	} else {
-		u32 dataStart = GetDataStart(address);
+		u32 dataStart = snapshot->data->Containing(address);
 		if (dataStart != INVALID_ADDRESS)
-			labelName = GetLabelName(dataStart);
+			labelName = snapshot->labels->Find(dataStart);
 	}
 
 	if (labelName != NULL)
@@ -467,6 +649,7 @@ void SymbolMap::AddModule(const char *name, u32 address, u32 size) {
 			it->size = size;
 			activeModuleEnds.emplace(it->start + it->size, *it);
 			activeNeedUpdate_ = true;
+			InvalidateSnapshot(SNAPSHOT_ALL);
 			return;
 		}
 	}
@@ -480,12 +663,14 @@ void SymbolMap::AddModule(const char *name, u32 address, u32 size) {
 	modules.push_back(mod);
 	activeModuleEnds.emplace(mod.start + mod.size, mod);
 	activeNeedUpdate_ = true;
+	InvalidateSnapshot(SNAPSHOT_ALL);
 }
 
 void SymbolMap::UnloadModule(u32 address, u32 size) {
 	std::lock_guard<std::recursive_mutex> guard(lock_);
 	activeModuleEnds.erase(address + size);
 	activeNeedUpdate_ = true;
+	InvalidateSnapshot(SNAPSHOT_ALL);
 }
 
 u32 SymbolMap::GetModuleRelativeAddr(u32 address, int moduleIndex) const {
@@ -586,6 +771,7 @@ void SymbolMap::AddFunction(const char* name, u32 address, u32 size, int moduleI
 		if (active != activeFunctions.end() && active->second.module == moduleIndex) {
 			activeFunctions.erase(active);
 			activeFunctions.emplace(address, existing->second);
+			PatchFunctionSize(address, size);
 		}
 	} else {
 		FunctionEntry func;
@@ -597,6 +783,7 @@ void SymbolMap::AddFunction(const char* name, u32 address, u32 size, int moduleI
 
 		if (IsModuleActive(moduleIndex)) {
 			activeFunctions.emplace(address, func);
+			InvalidateSnapshot(SNAPSHOT_FUNCTIONS);
 		}
 	}
 
@@ -604,45 +791,17 @@ void SymbolMap::AddFunction(const char* name, u32 address, u32 size, int moduleI
 }
 
 u32 SymbolMap::GetFunctionStart(u32 address) {
-	if (activeNeedUpdate_)
-		UpdateActiveSymbols();
-
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	auto it = activeFunctions.upper_bound(address);
-	if (it == activeFunctions.end()) {
-		// check last element
-		auto rit = activeFunctions.rbegin();
-		if (rit != activeFunctions.rend()) {
-			u32 start = rit->first;
-			u32 size = rit->second.size;
-			if (start <= address && start+size > address)
-				return start;
-		}
-		// otherwise there's no function that contains this address
-		return INVALID_ADDRESS;
-	}
-
-	if (it != activeFunctions.begin()) {
-		it--;
-		u32 start = it->first;
-		u32 size = it->second.size;
-		if (start <= address && start+size > address)
-			return start;
-	}
-
-	return INVALID_ADDRESS;
+	return Snapshot()->functions->Containing(address);
 }
 
 u32 SymbolMap::FindPossibleFunctionAtAfter(u32 address) {
-	if (activeNeedUpdate_)
-		UpdateActiveSymbols();
-
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	auto it = activeFunctions.lower_bound(address);
-	if (it == activeFunctions.end()) {
+	auto snapshot = Snapshot();
+	const SymbolRangeIndex &functions = *snapshot->functions;
+	size_t i = functions.index.LowerBound(address);
+	if (i >= functions.starts.size()) {
 		return (u32)-1;
 	}
-	return it->first;
+	return functions.starts[i];
 }
 
 u32 SymbolMap::GetFunctionSize(u32 startAddress) {
@@ -672,12 +831,12 @@ u32 SymbolMap::GetFunctionSize(u32 startAddress) {
 		return func->second.size;
 	}
 
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	auto it = activeFunctions.find(startAddress);
-	if (it == activeFunctions.end())
+	auto snapshot = Snapshot();
+	int i = snapshot->functions->Find(startAddress);
+	if (i == -1)
 		return INVALID_ADDRESS;
 
-	return it->second.size;
+	return snapshot->functions->sizes[i];
 }
 
 u32 SymbolMap::GetFunctionModuleAddress(u32 startAddress) {
@@ -693,19 +852,16 @@ u32 SymbolMap::GetFunctionModuleAddress(u32 startAddress) {
 }
 
 int SymbolMap::GetFunctionNum(u32 address) {
-	if (activeNeedUpdate_)
-		UpdateActiveSymbols();
-
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	u32 start = GetFunctionStart(address);
+	auto snapshot = Snapshot();
+	u32 start = snapshot->functions->Containing(address);
 	if (start == INVALID_ADDRESS)
 		return INVALID_ADDRESS;
 
-	auto it = activeFunctions.find(start);
-	if (it == activeFunctions.end())
+	int i = snapshot->functions->Find(start);
+	if (i == -1)
 		return INVALID_ADDRESS;
 
-	return it->second.index;
+	return snapshot->functions->extra[i];
 }
 
 void SymbolMap::AssignFunctionIndices() {
@@ -719,6 +875,7 @@ void SymbolMap::AssignFunctionIndices() {
 			it->second.index = index++;
 		}
 	}
+	InvalidateSnapshot(SNAPSHOT_FUNCTIONS);
 }
 
 void SymbolMap::UpdateActiveSymbols() {
@@ -731,6 +888,8 @@ void SymbolMap::UpdateActiveSymbols() {
 
 	// On startup and shutdown, we can skip the rest.  Tiny optimization.
 	if (activeModuleEnds.empty() || (functions.empty() && labels.empty() && data.empty())) {
+		activeNeedUpdate_ = false;
+		snapshotDirty_ |= SNAPSHOT_ALL;
 		return;
 	}
 
@@ -768,6 +927,8 @@ void SymbolMap::UpdateActiveSymbols() {
 
 	AssignFunctionIndices();
 	activeNeedUpdate_ = false;
+	// Not InvalidateSnapshot(), this often runs on a reader's behalf, and the change was already noted.
+	snapshotDirty_ |= SNAPSHOT_ALL;
 }
 
 bool SymbolMap::SetFunctionSize(u32 startAddress, u32 newSize) {
@@ -784,6 +945,7 @@ bool SymbolMap::SetFunctionSize(u32 startAddress, u32 newSize) {
 			func->second.size = newSize;
 			activeFunctions.erase(funcInfo);
 			activeFunctions.emplace(startAddress, func->second);
+			PatchFunctionSize(startAddress, newSize);
 		}
 	}
 
@@ -807,6 +969,7 @@ bool SymbolMap::RemoveFunction(u32 startAddress, bool removeName) {
 		functions.erase(it2);
 	}
 	activeFunctions.erase(it);
+	InvalidateSnapshot(SNAPSHOT_FUNCTIONS);
 
 	if (removeName) {
 		auto labelIt = activeLabels.find(startAddress);
@@ -817,6 +980,7 @@ bool SymbolMap::RemoveFunction(u32 startAddress, bool removeName) {
 				labels.erase(labelIt2);
 			}
 			activeLabels.erase(labelIt);
+			InvalidateSnapshot(SNAPSHOT_LABELS);
 		}
 	}
 
@@ -867,6 +1031,7 @@ void SymbolMap::AddLabel(const char* name, u32 address, int moduleIndex) {
 		labels[symbolKey] = label;
 		if (IsModuleActive(moduleIndex)) {
 			activeLabels.emplace(address, label);
+			InvalidateSnapshot(SNAPSHOT_LABELS);
 		}
 	}
 }
@@ -891,6 +1056,7 @@ void SymbolMap::SetLabelName(const char* name, u32 address) {
 			if (active != activeLabels.end() && active->second.module == label->second.module) {
 				activeLabels.erase(active);
 				activeLabels.emplace(address, label->second);
+				PatchLabelName(address, label->second.name);
 			}
 		}
 	}
@@ -918,8 +1084,8 @@ const char *SymbolMap::GetLabelNameRel(u32 relAddress, int moduleIndex) const {
 }
 
 std::string SymbolMap::GetLabelString(u32 address) {
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	const char *label = GetLabelName(address);
+	auto snapshot = Snapshot();
+	const char *label = snapshot->labels->Find(address);
 	if (label == NULL)
 		return "";
 	return label;
@@ -974,6 +1140,7 @@ void SymbolMap::AddData(u32 address, u32 size, DataType type, int moduleIndex) {
 		if (active != activeData.end() && active->second.module == moduleIndex) {
 			activeData.erase(active);
 			activeData.emplace(address, existing->second);
+			PatchData(address, size, type);
 		}
 	} else {
 		DataEntry entry;
@@ -985,52 +1152,21 @@ void SymbolMap::AddData(u32 address, u32 size, DataType type, int moduleIndex) {
 		data[symbolKey] = entry;
 		if (IsModuleActive(moduleIndex)) {
 			activeData.emplace(address, entry);
+			InvalidateSnapshot(SNAPSHOT_DATA);
 		}
 	}
 }
 
 u32 SymbolMap::GetDataStart(u32 address) {
-	if (activeNeedUpdate_)
-		UpdateActiveSymbols();
-
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	auto it = activeData.upper_bound(address);
-	if (it == activeData.end())
-	{
-		// check last element
-		auto rit = activeData.rbegin();
-
-		if (rit != activeData.rend())
-		{
-			u32 start = rit->first;
-			u32 size = rit->second.size;
-			if (start <= address && start+size > address)
-				return start;
-		}
-		// otherwise there's no data that contains this address
-		return INVALID_ADDRESS;
-	}
-
-	if (it != activeData.begin()) {
-		it--;
-		u32 start = it->first;
-		u32 size = it->second.size;
-		if (start <= address && start+size > address)
-			return start;
-	}
-
-	return INVALID_ADDRESS;
+	return Snapshot()->data->Containing(address);
 }
 
 u32 SymbolMap::GetDataSize(u32 startAddress) {
-	if (activeNeedUpdate_)
-		UpdateActiveSymbols();
-
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	auto it = activeData.find(startAddress);
-	if (it == activeData.end())
+	auto snapshot = Snapshot();
+	int i = snapshot->data->Find(startAddress);
+	if (i == -1)
 		return INVALID_ADDRESS;
-	return it->second.size;
+	return snapshot->data->sizes[i];
 }
 
 u32 SymbolMap::GetDataModuleAddress(u32 startAddress) {
@@ -1045,14 +1181,11 @@ u32 SymbolMap::GetDataModuleAddress(u32 startAddress) {
 }
 
 DataType SymbolMap::GetDataType(u32 startAddress) {
-	if (activeNeedUpdate_)
-		UpdateActiveSymbols();
-
-	std::lock_guard<std::recursive_mutex> guard(lock_);
-	auto it = activeData.find(startAddress);
-	if (it == activeData.end())
+	auto snapshot = Snapshot();
+	int i = snapshot->data->Find(startAddress);
+	if (i == -1)
 		return DATATYPE_NONE;
-	return it->second.type;
+	return (DataType)snapshot->data->extra[i].load(std::memory_order_relaxed);
 }
 
 void SymbolMap::GetLabels(std::vector<LabelDefinition> &dest) {
@@ -17,11 +17,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <set>
 #include <map>
 #include <string>
 #include <mutex>
+#include <thread>
 
 #include "Common/CommonTypes.h"
 #include "Common/File/Path.h"
@@ -58,6 +61,7 @@ enum DataType {
 };
 
 struct LabelDefinition;
+struct SymbolMapSnapshot;
 
 #ifdef _WIN32
 struct HWND__;
@@ -120,7 +124,31 @@ class SymbolMap {
 
 	void UpdateActiveSymbols();
 
+	// Around adding many symbols at once (e.g. after a function scan.)  Until the last EndUpdate(),
+	// lookups from other threads keep using the symbols from before, instead of rebuilding after
+	// every change.
+	void BeginUpdate();
+	void EndUpdate();
+
 private:
+	enum {
+		SNAPSHOT_FUNCTIONS = 1,
+		SNAPSHOT_LABELS = 2,
+		SNAPSHOT_DATA = 4,
+		SNAPSHOT_ALL = 7,
+	};
+
+	// Lookups that only need the active symbols go through this, without taking the lock.
+	std::shared_ptr<const SymbolMapSnapshot> Snapshot();
+	void RebuildSnapshot();
+	void InvalidateSnapshot(int parts) {
+		snapshotDirty_ |= parts;
+		lastChangedBy_ = std::this_thread::get_id();
+	}
+	void PatchFunctionSize(u32 address, u32 size);
+	void PatchLabelName(u32 address, const char *name);
+	void PatchData(u32 address, u32 size, DataType type);
+
 	void AssignFunctionIndices();
 	const char *GetLabelName(u32 address);
 	const char *GetLabelNameRel(u32 relAddress, int moduleIndex) const;
@@ -172,6 +200,15 @@ class SymbolMap {
 
 	mutable std::recursive_mutex lock_;
 	bool sawUnknownModule = false;
+
+	// Copy of the active symbols for lookups.  Edits to existing entries are patched into it,
+	// anything else rebuilds the parts that changed (under lock_) on next use.  Readers grab a
+	// reference and can keep using it while a new one is published.
+	std::shared_ptr<const SymbolMapSnapshot> snapshot_;
+	std::atomic<int> snapshotDirty_{ SNAPSHOT_ALL };
+	std::atomic<int> updateDepth_{};
+	// Whoever changed symbols last must see their own changes, so never gets a stale snapshot.
+	std::atomic<std::thread::id> lastChangedBy_{};
 };
 
 extern SymbolMap *g_symbolMap;
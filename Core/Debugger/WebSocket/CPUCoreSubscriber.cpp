@@ -19,6 +19,7 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/Debugger/Breakpoints.h"
+#include "Core/Debugger/JitSampler.h"
 #include "Core/Debugger/WebSocket/CPUCoreSubscriber.h"
 #include "Core/Debugger/WebSocket/WebSocketUtils.h"
 #include "Core/HLE/sceKernelThread.h"
@@ -35,6 +36,8 @@ DebuggerSubscriber *WebSocketCPUCoreInit(DebuggerEventHandlerMap &map) {
 	map["cpu.getReg"] = &WebSocketCPUGetReg;
 	map["cpu.setReg"] = &WebSocketCPUSetReg;
 	map["cpu.evaluate"] = &WebSocketCPUEvaluate;
+	map["cpu.profile.get"] = &WebSocketCPUProfileGet;
+	map["cpu.profile.reset"] = &WebSocketCPUProfileReset;
 
 	return nullptr;
 }
@@ -413,3 +416,50 @@ void WebSocketCPUEvaluate(DebuggerRequest &req) {
 	json.writeUint("uintValue", val);
 	json.writeString("floatValue", RegValueAsFloat(val));
 }
+
+// Get the functions the jit sampler caught most often (cpu.profile.get)
+//
+// Sampling is started by the host, e.g. headless with --jit-profile.
+//
+// Parameters:
+//  - count: optional number of functions to list, most samples first (default 100.)
+//
+// Response (same event name):
+//  - active: boolean, whether the emu thread is currently being sampled.
+//  - totalSamples: number of samples taken since the last reset.
+//  - functions: array of objects, each with properties:
+//     - name: string function name, or "[unknown]" for samples outside any known function.
+//     - address: unsigned integer start address of the function, or 0 if unknown.
+//     - samples: number of samples within the function.
+void WebSocketCPUProfileGet(DebuggerRequest &req) {
+	uint32_t count = 100;
+	if (!req.ParamU32("count", &count, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	// Pick up anything the run loop hasn't gotten to yet.
+	JitSamplerProcess();
+	std::vector<JitSamplerFunction> functions = JitSamplerHotFunctions(count);
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("active", JitSamplerActive());
+	json.writeFloat("totalSamples", (double)JitSamplerTotalSamples());
+	json.pushArray("functions");
+	for (const JitSamplerFunction &func : functions) {
+		json.pushDict();
+		json.writeString("name", func.name);
+		json.writeUint("address", func.address);
+		json.writeFloat("samples", (double)func.samples);
+		json.pop();
+	}
+	json.pop();
+}
+
+// Clear jit sampler results, keeping it running (cpu.profile.reset)
+//
+// No parameters.
+//
+// Response (same event name) with no extra data.
+void WebSocketCPUProfileReset(DebuggerRequest &req) {
+	JitSamplerReset();
+	req.Respond();
+}
@@ -28,3 +28,5 @@ void WebSocketCPUGetAllRegs(DebuggerRequest &req);
 void WebSocketCPUGetReg(DebuggerRequest &req);
 void WebSocketCPUSetReg(DebuggerRequest &req);
 void WebSocketCPUEvaluate(DebuggerRequest &req);
+void WebSocketCPUProfileGet(DebuggerRequest &req);
+void WebSocketCPUProfileReset(DebuggerRequest &req);
@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <cmath>
+
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
@@ -26,7 +28,10 @@
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSStackWalk.h"
+#include "Core/HLE/HLEProfiler.h"
+#include "Core/HLE/sceIo.h"
 #include "Core/HLE/sceKernelThread.h"
+#include "Core/HW/AsyncIOManager.h"
 #include "Core/Reporting.h"
 
 DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
@@ -41,6 +46,10 @@ DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
 	map["hle.func.scan"] = &WebSocketHLEFuncScan;
 	map["hle.module.list"] = &WebSocketHLEModuleList;
 	map["hle.backtrace"] = &WebSocketHLEBacktrace;
+	map["hle.profile.start"] = &WebSocketHLEProfileStart;
+	map["hle.profile.stop"] = &WebSocketHLEProfileStop;
+	map["hle.profile.get"] = &WebSocketHLEProfileGet;
+	map["hle.io.stats"] = &WebSocketHLEIoStats;
 
 	return nullptr;
 }
@@ -601,3 +610,99 @@ void WebSocketHLEBacktrace(DebuggerRequest &req) {
 	}
 	json.pop();
 }
+
+// Start profiling HLE calls (hle.profile.start)
+//
+// Parameters:
+//  - reset: optional boolean, whether to clear previous results first (default true.)
+//
+// Response (same event name) with no extra data.
+void WebSocketHLEProfileStart(DebuggerRequest &req) {
+	bool reset = true;
+	if (!req.ParamBool("reset", &reset, DebuggerParamType::OPTIONAL))
+		return;
+
+	if (reset)
+		HLEProfilerReset();
+	HLEProfilerSetEnabled(true);
+	req.Respond();
+}
+
+// Stop profiling HLE calls, keeping the results (hle.profile.stop)
+//
+// No parameters.
+//
+// Response (same event name) with no extra data.
+void WebSocketHLEProfileStop(DebuggerRequest &req) {
+	HLEProfilerSetEnabled(false);
+	req.Respond();
+}
+
+// Get HLE call profile results (hle.profile.get)
+//
+// Parameters:
+//  - count: optional number of functions to list, most total time first (default 100.)
+//
+// Response (same event name):
+//  - enabled: boolean, whether calls are currently being profiled.
+//  - bucketLimits: array of numbers, upper limit in nanoseconds of each histogram bucket but the last.
+//  - functions: array of objects, each with properties:
+//     - module: string module name.
+//     - name: string function name.
+//     - nid: unsigned integer function nid.
+//     - calls: number of calls.
+//     - totalNsec: number, total host time in nanoseconds.
+//     - avgNsec: number, average host time per call in nanoseconds.
+//     - maxNsec: number, slowest call in nanoseconds.
+//     - totalCycles: number of emulated cycles the calls took.
+//     - histogram: array of call counts per host time bucket.
+void WebSocketHLEProfileGet(DebuggerRequest &req) {
+	uint32_t count = 100;
+	if (!req.ParamU32("count", &count, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	JsonWriter &json = req.Respond();
+	HLEProfilerWriteJson(json, count);
+}
+
+// Get host timings of file operations run on the io thread (hle.io.stats)
+//
+// Parameters:
+//  - reset: optional boolean, whether to clear the stats after reading them (default false.)
+//
+// Response (same event name):
+//  - queued: number of operations waiting to start.
+//  - classes: array of objects, each with properties:
+//     - name: string, one of "streaming" (small reads), "bulk" (large reads), or "write".
+//     - count: number of operations finished.
+//     - bytes: number of bytes requested.
+//     - avgWaitUsec: number, average time from scheduling to starting in microseconds.
+//     - maxWaitUsec: number, longest wait to start in microseconds.
+//     - avgServiceUsec: number, average time to run in microseconds.
+//     - maxServiceUsec: number, slowest operation in microseconds.
+void WebSocketHLEIoStats(DebuggerRequest &req) {
+	bool reset = false;
+	if (!req.ParamBool("reset", &reset, DebuggerParamType::OPTIONAL))
+		return;
+
+	static const char *const classNames[IO_CLASS_COUNT] = { "streaming", "bulk", "write" };
+	AsyncIOStats stats[IO_CLASS_COUNT];
+	__IoGetAsyncStats(stats, reset);
+
+	JsonWriter &json = req.Respond();
+	json.writeInt("queued", __IoQueuedAsyncRequests());
+	json.pushArray("classes");
+	for (int i = 0; i < IO_CLASS_COUNT; ++i) {
+		const AsyncIOStats &s = stats[i];
+		json.pushDict();
+		json.writeString("name", classNames[i]);
+		json.writeFloat("count", (double)s.count);
+		json.writeFloat("bytes", (double)s.bytes);
+		json.writeFloat("avgWaitUsec", s.count == 0 ? 0.0 : floor(s.totalWait * 1000000.0 / s.count));
+		json.writeFloat("maxWaitUsec", floor(s.maxWait * 1000000.0));
+		json.writeFloat("avgServiceUsec", s.count == 0 ? 0.0 : floor(s.totalService * 1000000.0 / s.count));
+		json.writeFloat("maxServiceUsec", floor(s.maxService * 1000000.0));
+		json.pop();
+	}
+	json.pop();
+}
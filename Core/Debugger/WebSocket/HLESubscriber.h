@@ -32,3 +32,7 @@ void WebSocketHLEFuncRename(DebuggerRequest &req);
 void WebSocketHLEFuncScan(DebuggerRequest &req);
 void WebSocketHLEModuleList(DebuggerRequest &req);
 void WebSocketHLEBacktrace(DebuggerRequest &req);
+void WebSocketHLEProfileStart(DebuggerRequest &req);
+void WebSocketHLEProfileStop(DebuggerRequest &req);
+void WebSocketHLEProfileGet(DebuggerRequest &req);
+void WebSocketHLEIoStats(DebuggerRequest &req);
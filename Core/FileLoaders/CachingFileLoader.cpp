@@ -258,7 +258,11 @@ void CachingFileLoader::StartReadAhead(s64 pos) {
 		// Already going.
 		return;
 	}
-	if (cacheSize_ + BLOCK_READAHEAD > MAX_BLOCKS_CACHED) {
+
+	// Remote backends want to keep enough in flight to hide their latency.
+	s64 readAheadBlocks = backend_->ReadAheadSize() >> BLOCK_SHIFT;
+	readAheadBlocks = std::clamp(readAheadBlocks, (s64)BLOCK_READAHEAD, (s64)MAX_BLOCKS_READAHEAD);
+	if (cacheSize_ + readAheadBlocks > MAX_BLOCKS_CACHED) {
 		// Not enough space to readahead.
 		return;
 	}
@@ -266,21 +270,27 @@ void CachingFileLoader::StartReadAhead(s64 pos) {
 	aheadThreadRunning_ = true;
 	if (aheadThread_.joinable())
 		aheadThread_.join();
-	aheadThread_ = std::thread([this, pos] {
+	aheadThread_ = std::thread([this, pos, readAheadBlocks] {
 		SetCurrentThreadName("FileLoaderReadAhead");
 
 		AndroidJNIThreadContext jniContext;
 
 		std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
 		s64 cacheStartPos = pos >> BLOCK_SHIFT;
-		s64 cacheEndPos = cacheStartPos + BLOCK_READAHEAD - 1;
+		s64 cacheEndPos = std::min(cacheStartPos + readAheadBlocks, (filesize_ + BLOCK_SIZE - 1) >> BLOCK_SHIFT) - 1;
 
 		for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
 			auto block = blocks_.find(i);
 			if (block == blocks_.end()) {
 				guard.unlock();
-				SaveIntoCache(i << BLOCK_SHIFT, BLOCK_SIZE * BLOCK_READAHEAD, Flags::NONE, true);
-				break;
+				// Reads stop at the next cached block, so this fills one gap at a time.
+				size_t blocks = (size_t)std::min(cacheEndPos - i + 1, (s64)MAX_BLOCKS_PER_READ);
+				SaveIntoCache(i << BLOCK_SHIFT, blocks << BLOCK_SHIFT, Flags::NONE, true);
+				guard.lock();
+				if (blocks_.find(i) == blocks_.end()) {
+					// Out of space.
+					break;
+				}
 			}
 		}
 
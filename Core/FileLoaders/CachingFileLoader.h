@@ -55,6 +55,7 @@ class CachingFileLoader : public ProxiedFileLoader {
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_CACHED = 4096, // 256 MB
 		BLOCK_READAHEAD = 4,
+		MAX_BLOCKS_READAHEAD = 128, // 8 MB
 	};
 
 	s64 filesize_ = 0;
@@ -19,30 +19,47 @@
 
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/FileLoaders/HTTPFileLoader.h"
 
 HTTPFileLoader::HTTPFileLoader(const ::Path &filename)
-	: url_(filename.ToString()), progress_(&cancel_), filename_(filename) {
+	: url_(filename.ToString()), filename_(filename) {
+	for (int i = 0; i < MAX_CONNECTIONS; ++i) {
+		Connection *conn = new Connection(&cancel_);
+		conn->client.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+		conn->client.SetDataTimeout(20.0);
+		conn->client.SetKeepAlive(true);
+		connections_.push_back(conn);
+	}
+}
+
+static bool HasConnectionClose(const std::vector<std::string> &responseHeaders) {
+	std::string value;
+	if (!http::GetHeaderValue(responseHeaders, "Connection", &value))
+		return false;
+	std::transform(value.begin(), value.end(), value.begin(), tolower);
+	return value.find("close") != value.npos;
 }
 
 void HTTPFileLoader::Prepare() {
 	std::call_once(preparedFlag_, [this](){
-		client_.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+		// Nothing else can use the connections until we're done here.
+		Connection *conn = connections_[0];
 
 		std::vector<std::string> responseHeaders;
 		Url resourceURL = url_;
 		int redirectsLeft = 20;
 		while (redirectsLeft > 0) {
 			responseHeaders.clear();
-			int code = SendHEAD(resourceURL, responseHeaders);
+			int code = SendHEAD(conn, resourceURL, responseHeaders);
 			if (code == -400) {
 				// Already reported the error.
 				return;
 			}
 
 			if (code == 301 || code == 302 || code == 303 || code == 307 || code == 308) {
-				Disconnect();
+				Disconnect(conn);
 
 				std::string redirectURL;
 				if (http::GetHeaderValue(responseHeaders, "Location", &redirectURL)) {
@@ -51,7 +68,7 @@ void HTTPFileLoader::Prepare() {
 
 					if (url.ToString() == url_.ToString() || url.ToString() == resourceURL.ToString()) {
 						ERROR_LOG(Log::Loader, "HTTP request failed, hit a redirect loop");
-						latestError_ = "Could not connect (redirect loop)";
+						SetLatestError("Could not connect (redirect loop)");
 						return;
 					}
 
@@ -62,15 +79,15 @@ void HTTPFileLoader::Prepare() {
 
 				// No Location header?
 				ERROR_LOG(Log::Loader, "HTTP request failed, invalid redirect");
-				latestError_ = "Could not connect (invalid response)";
+				SetLatestError("Could not connect (invalid response)");
 				return;
 			}
 
 			if (code != 200) {
 				// Leave size at 0, invalid.
 				ERROR_LOG(Log::Loader, "HTTP request failed, got %03d for %s", code, filename_.c_str());
-				latestError_ = "Could not connect (invalid response)";
-				Disconnect();
+				SetLatestError("Could not connect (invalid response)");
+				Disconnect(conn);
 				return;
 			}
 
@@ -101,8 +118,12 @@ void HTTPFileLoader::Prepare() {
 			}
 		}
 
-		// TODO: Keepalive instead.
-		Disconnect();
+		// HEAD has no entity, so the connection can be used for range requests right away.
+		if (HasConnectionClose(responseHeaders)) {
+			Disconnect(conn);
+		} else {
+			conn->reused = true;
+		}
 
 		if (!acceptsRange) {
 			WARN_LOG(Log::Loader, "HTTP server did not advertise support for range requests.");
@@ -115,44 +136,44 @@ void HTTPFileLoader::Prepare() {
 	});
 }
 
-int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseHeaders) {
+int HTTPFileLoader::SendHEAD(Connection *conn, const Url &url, std::vector<std::string> &responseHeaders) {
 	if (!url.Valid()) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, invalid URL: '%s'", url.ToString().c_str());
-		latestError_ = "Invalid URL";
+		SetLatestError("Invalid URL");
 		return -400;
 	}
 
-	if (!client_.Resolve(url.Host().c_str(), url.Port())) {
+	Disconnect(conn);
+	if (!conn->client.Resolve(url.Host().c_str(), url.Port())) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, unable to resolve: |%s| port %d", url.Host().c_str(), url.Port());
-		latestError_ = "Could not connect (name not resolved)";
+		SetLatestError("Could not connect (name not resolved)");
 		return -400;
 	}
+	conn->resolved = true;
 
-	double timeout = 20.0;
-
-	client_.SetDataTimeout(timeout);
-	Connect(10.0);
-	if (!connected_) {
+	if (!Connect(conn, 10.0)) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, failed to connect: %s port %d (resource: '%s')", url.Host().c_str(), url.Port(), url.Resource().c_str());
-		latestError_ = "Could not connect (refused to connect)";
+		SetLatestError("Could not connect (refused to connect)");
 		return -400;
 	}
 
 	http::RequestParams req(url.Resource(), "*/*");
-	int err = client_.SendRequest("HEAD", req, nullptr, &progress_);
+	int err = conn->client.SendRequest("HEAD", req, nullptr, &conn->progress);
 	if (err < 0) {
 		ERROR_LOG(Log::Loader, "HTTP request failed, failed to send request: %s port %d", url.Host().c_str(), url.Port());
-		latestError_ = "Could not connect (could not request data)";
-		Disconnect();
+		SetLatestError("Could not connect (could not request data)");
+		Disconnect(conn);
 		return -400;
 	}
 
-	net::Buffer readbuf;
-	return client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
+	return conn->client.ReadResponseHeaders(&conn->readbuf, responseHeaders, &conn->progress);
 }
 
 HTTPFileLoader::~HTTPFileLoader() {
-	Disconnect();
+	for (Connection *conn : connections_) {
+		Disconnect(conn);
+		delete conn;
+	}
 }
 
 bool HTTPFileLoader::Exists() {
@@ -180,7 +201,6 @@ Path HTTPFileLoader::GetPath() const {
 
 size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
 	Prepare();
-	std::lock_guard<std::mutex> guard(readAtMutex_);
 
 	s64 absoluteEnd = std::min(absolutePos + (s64)bytes, filesize_);
 	if (absolutePos >= filesize_ || bytes == 0) {
@@ -188,32 +208,122 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		return 0;
 	}
 
-	Connect(10.0);
-	if (!connected_) {
-		return 0;
+	Connection *conn = AcquireConnection();
+	size_t readBytes = ReadRanges(conn, absolutePos, (size_t)(absoluteEnd - absolutePos), (u8 *)data);
+	ReleaseConnection(conn);
+	return readBytes;
+}
+
+size_t HTTPFileLoader::ReadRanges(Connection *conn, s64 pos, size_t bytes, u8 *data) {
+	const size_t chunks = (bytes + PIPELINE_CHUNK - 1) / PIPELINE_CHUNK;
+	auto chunkPos = [&](size_t i) {
+		return pos + (s64)(i * PIPELINE_CHUNK);
+	};
+	auto chunkSize = [&](size_t i) {
+		return std::min((size_t)PIPELINE_CHUNK, bytes - i * PIPELINE_CHUNK);
+	};
+
+	size_t sent = 0;
+	size_t received = 0;
+	// Responses on this connection during this read.  If it fails after some, the server isn't keeping it alive.
+	int responsesOnConn = 0;
+	// Retry a lost connection once per chunk, the server can close kept-alive connections at any time.
+	size_t lastLost = (size_t)-1;
+
+	double firstSendTime = 0.0;
+	double latency = -1.0;
+	while (received < chunks) {
+		if (!Connect(conn, 10.0))
+			break;
+
+		// Keep requests in flight so the server always has something to send.  Only once the server
+		// has kept this connection open, though, otherwise anything after the first request is lost.
+		const size_t depth = keepAlive_ && conn->reused ? MAX_PIPELINE_DEPTH : 1;
+		RangeResult result = RangeResult::OK;
+		while (sent < chunks && sent - received < depth) {
+			if (sent == 0)
+				firstSendTime = time_now_d();
+			if (!SendRangeRequest(conn, chunkPos(sent), chunkSize(sent))) {
+				result = RangeResult::LOST;
+				break;
+			}
+			sent++;
+		}
+
+		double headersTime = 0.0;
+		if (result == RangeResult::OK) {
+			result = ReadRangeResponse(conn, chunkPos(received), chunkSize(received), data + received * PIPELINE_CHUNK, &headersTime);
+		}
+
+		if (result == RangeResult::OK) {
+			if (received == 0)
+				latency = headersTime - firstSendTime;
+			received++;
+			responsesOnConn++;
+			conn->reused = true;
+			if (conn->closeAfterResponse || !keepAlive_) {
+				// Anything else we sent on this connection is lost, send it again on the next one.
+				Disconnect(conn);
+				sent = received;
+				responsesOnConn = 0;
+			}
+			continue;
+		}
+
+		Disconnect(conn);
+		sent = received;
+		if (result == RangeResult::LOST && lastLost != received && !cancel_) {
+			if (responsesOnConn > 0 && keepAlive_) {
+				// It served responses, and then closed without saying so.  Stop asking to keep alive.
+				WARN_LOG(Log::Loader, "HTTP server closed a kept-alive connection early, disabling keep-alive");
+				keepAlive_ = false;
+			}
+			responsesOnConn = 0;
+			lastLost = received;
+			continue;
+		}
+
+		if (result == RangeResult::LOST)
+			SetLatestError("Invalid response reading data");
+		break;
+	}
+
+	size_t readBytes = std::min(received * PIPELINE_CHUNK, bytes);
+	if (latency >= 0.0) {
+		double transferTime = time_now_d() - firstSendTime - latency;
+		// Small reads are mostly latency, so don't measure bandwidth from them.
+		double bytesPerSecond = readBytes >= PIPELINE_CHUNK && transferTime > 0.0 ? readBytes / transferTime : 0.0;
+		UpdateStats(latency, bytesPerSecond);
 	}
+	return readBytes;
+}
 
+bool HTTPFileLoader::SendRangeRequest(Connection *conn, s64 pos, size_t bytes) {
 	char requestHeaders[4096];
 	// Note that the Range header is *inclusive*.
 	snprintf(requestHeaders, sizeof(requestHeaders),
-		"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
+		"Range: bytes=%lld-%lld\r\n", (long long)pos, (long long)(pos + bytes - 1));
 
+	conn->client.SetKeepAlive(keepAlive_);
 	http::RequestParams req(url_.Resource(), "*/*");
-	int err = client_.SendRequest("GET", req, requestHeaders, &progress_);
-	if (err < 0) {
-		latestError_ = "Invalid response reading data";
-		Disconnect();
-		return 0;
-	}
+	return conn->client.SendRequest("GET", req, requestHeaders, &conn->progress) >= 0;
+}
 
-	net::Buffer readbuf;
+HTTPFileLoader::RangeResult HTTPFileLoader::ReadRangeResponse(Connection *conn, s64 pos, size_t bytes, u8 *data, double *headersTime) {
 	std::vector<std::string> responseHeaders;
-	int code = client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
+	int code = conn->client.ReadResponseHeaders(&conn->readbuf, responseHeaders, &conn->progress);
+	if (code < 0) {
+		return RangeResult::LOST;
+	}
+	*headersTime = time_now_d();
+
 	if (code != 206) {
 		ERROR_LOG(Log::Loader, "HTTP server did not respond with range, received code=%03d", code);
-		latestError_ = "Invalid response reading data";
-		Disconnect();
-		return 0;
+		SetLatestError("Invalid response reading data");
+		return RangeResult::FAILED;
+	}
+	if (HasConnectionClose(responseHeaders)) {
+		conn->closeAfterResponse = true;
 	}
 
 	// TODO: Expire cache via ETag, etc.
@@ -222,14 +332,14 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 	for (std::string header : responseHeaders) {
 		if (startsWithNoCase(header, "Content-Range:")) {
 			// TODO: More correctness.  Whitespace can be missing or different.
-			s64 first = -1, last = -1, total = -1;
+			long long first = -1, last = -1, total = -1;
 			std::string lowerHeader = header;
 			std::transform(lowerHeader.begin(), lowerHeader.end(), lowerHeader.begin(), tolower);
 			if (sscanf(lowerHeader.c_str(), "content-range: bytes %lld-%lld/%lld", &first, &last, &total) >= 2) {
-				if (first == absolutePos && last == absoluteEnd - 1) {
+				if (first == pos && last == pos + (s64)bytes - 1) {
 					supportedResponse = true;
 				} else {
-					ERROR_LOG(Log::Loader, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, absolutePos, absoluteEnd - 1);
+					ERROR_LOG(Log::Loader, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, (long long)pos, (long long)(pos + bytes - 1));
 				}
 			} else {
 				ERROR_LOG(Log::Loader, "Unexpected HTTP range response: %s", header.c_str());
@@ -237,32 +347,114 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		}
 	}
 
-	// TODO: Would be nice to read directly.
-	net::Buffer output;
-	int res = client_.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress_);
-	if (res != 0) {
-		ERROR_LOG(Log::Loader, "Unable to read HTTP response entity: %d", res);
-		// Let's take anything we got anyway.  Not worse than returning nothing?
+	if (!supportedResponse) {
+		ERROR_LOG(Log::Loader, "HTTP server did not respond with the range we wanted.");
+		SetLatestError("Invalid response reading data");
+		return RangeResult::FAILED;
 	}
 
-	// TODO: Keepalive instead.
-	Disconnect();
+	std::string contentLength;
+	if (!http::GetHeaderValue(responseHeaders, "Content-Length", &contentLength)) {
+		// Without a length, the entity ends when the server closes the connection.
+		conn->closeAfterResponse = true;
+		net::Buffer output;
+		int res = conn->client.ReadResponseEntity(&conn->readbuf, responseHeaders, &output, &conn->progress);
+		if (res != 0 || output.size() < bytes) {
+			ERROR_LOG(Log::Loader, "Unable to read HTTP response entity: %d", res);
+			return RangeResult::LOST;
+		}
+		output.Take(bytes, (char *)data);
+		return RangeResult::OK;
+	}
 
-	if (!supportedResponse) {
-		ERROR_LOG(Log::Loader, "HTTP server did not respond with the range we wanted.");
-		latestError_ = "Invalid response reading data";
-		return 0;
+	if (atoll(contentLength.c_str()) != (long long)bytes) {
+		ERROR_LOG(Log::Loader, "Unexpected HTTP response length %s, wanted %lld", contentLength.c_str(), (long long)bytes);
+		SetLatestError("Invalid response reading data");
+		return RangeResult::FAILED;
 	}
 
-	size_t readBytes = output.size();
-	output.Take(readBytes, (char *)data);
-	filepos_ = absolutePos + readBytes;
-	return readBytes;
+	if (!conn->readbuf.TakeExactly(conn->client.sock(), bytes, (char *)data, 20.0, &cancel_)) {
+		ERROR_LOG(Log::Loader, "Unable to read HTTP response entity");
+		return RangeResult::LOST;
+	}
+	return RangeResult::OK;
+}
+
+void HTTPFileLoader::UpdateStats(double latency, double bytesPerSecond) {
+	std::lock_guard<std::mutex> guard(statsMutex_);
+	// Smooth out jitter, but still adapt within a few reads.
+	const double weight = 0.25;
+	latency_ = latency_ == 0.0 ? latency : latency_ + (latency - latency_) * weight;
+	if (bytesPerSecond > 0.0)
+		bytesPerSecond_ = bytesPerSecond_ == 0.0 ? bytesPerSecond : bytesPerSecond_ + (bytesPerSecond - bytesPerSecond_) * weight;
+}
+
+void HTTPFileLoader::SetLatestError(const char *error) {
+	std::lock_guard<std::mutex> guard(statsMutex_);
+	latestError_ = error;
+}
+
+s64 HTTPFileLoader::ReadAheadSize() {
+	std::lock_guard<std::mutex> guard(statsMutex_);
+	// Enough to cover a round trip at the measured bandwidth, with some slack for jitter.
+	s64 bdp = (s64)(bytesPerSecond_ * latency_ * 2.0);
+	return std::clamp(bdp, (s64)MIN_READAHEAD, (s64)MAX_READAHEAD);
 }
 
-void HTTPFileLoader::Connect(double timeout) {
-	if (!connected_) {
+HTTPFileLoader::Connection *HTTPFileLoader::AcquireConnection() {
+	std::unique_lock<std::mutex> guard(poolMutex_);
+	Connection *conn = nullptr;
+	poolCond_.wait(guard, [&] {
+		// Prefer one that's already open, to skip the handshake.
+		for (Connection *c : connections_) {
+			if (!c->inUse && c->connected) {
+				conn = c;
+				return true;
+			}
+		}
+		for (Connection *c : connections_) {
+			if (!c->inUse) {
+				conn = c;
+				return true;
+			}
+		}
+		return false;
+	});
+	conn->inUse = true;
+	return conn;
+}
+
+void HTTPFileLoader::ReleaseConnection(Connection *conn) {
+	std::lock_guard<std::mutex> guard(poolMutex_);
+	conn->inUse = false;
+	poolCond_.notify_one();
+}
+
+bool HTTPFileLoader::Connect(Connection *conn, double timeout) {
+	if (conn->connected)
+		return true;
+
+	if (!conn->resolved) {
+		if (!conn->client.Resolve(url_.Host().c_str(), url_.Port())) {
+			SetLatestError("Could not connect (name not resolved)");
+			return false;
+		}
+		conn->resolved = true;
+	}
+
+	// Other connections may be checking this, so only write it if we have to.
+	if (cancel_)
 		cancel_ = false;
-		connected_ = client_.Connect(3, timeout, &cancel_);
+	conn->connected = conn->client.Connect(3, timeout, &cancel_);
+	return conn->connected;
+}
+
+void HTTPFileLoader::Disconnect(Connection *conn) {
+	if (conn->connected) {
+		conn->client.Disconnect();
 	}
+	conn->connected = false;
+	conn->reused = false;
+	conn->closeAfterResponse = false;
+	conn->readbuf.clear();
 }
@@ -17,16 +17,25 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <vector>
 
 #include "Common/File/Path.h"
 #include "Common/Net/HTTPClient.h"
+#include "Common/Net/NetBuffer.h"
 #include "Common/Net/Resolve.h"
 #include "Common/Net/URL.h"
 #include "Common/CommonTypes.h"
 #include "Core/Loaders.h"
 
+// Reads a file over HTTP using range requests.
+//
+// Connections are kept alive and pooled, so concurrent readers (like the caching loader's
+// read-ahead thread) don't block each other, and large reads are split into several range
+// requests pipelined on one connection.  If the server closes connections anyway, we fall back
+// to a new connection per request.
 class HTTPFileLoader : public FileLoader {
 public:
 	HTTPFileLoader(const ::Path &filename);
@@ -45,38 +54,85 @@ class HTTPFileLoader : public FileLoader {
 		return ReadAt(absolutePos, bytes * count, data, flags) / bytes;
 	}
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override;
+	s64 ReadAheadSize() override;
 
 	void Cancel() override {
 		cancel_ = true;
 	}
 
 	std::string LatestError() const override {
+		std::lock_guard<std::mutex> guard(statsMutex_);
 		return latestError_;
 	}
 
 private:
+	enum {
+		MAX_CONNECTIONS = 4,
+		// Larger reads are split into requests of this size, so the first bytes arrive sooner.
+		PIPELINE_CHUNK = 256 * 1024,
+		MAX_PIPELINE_DEPTH = 8,
+		MIN_READAHEAD = 256 * 1024,
+		MAX_READAHEAD = 8 * 1024 * 1024,
+	};
+
+	struct Connection {
+		Connection(std::atomic<bool> *cancel) : progress(cancel) {}
+
+		http::Client client;
+		// Persists between responses, may hold the start of the next pipelined response.
+		net::Buffer readbuf;
+		net::RequestProgress progress;
+		bool resolved = false;
+		bool connected = false;
+		// Whether this connection has already served a response, so may have been closed by the server.
+		bool reused = false;
+		// The server said it will close the connection after the current response.
+		bool closeAfterResponse = false;
+		bool inUse = false;
+	};
+
+	enum class RangeResult {
+		OK,
+		// The connection failed (closed, timed out), retrying on a new one may help.
+		LOST,
+		// The server gave a bad response.
+		FAILED,
+	};
+
 	void Prepare();
-	int SendHEAD(const Url &url, std::vector<std::string> &responseHeaders);
+	int SendHEAD(Connection *conn, const Url &url, std::vector<std::string> &responseHeaders);
 
-	void Connect(double timeout);
+	Connection *AcquireConnection();
+	void ReleaseConnection(Connection *conn);
+	bool Connect(Connection *conn, double timeout);
+	void Disconnect(Connection *conn);
 
-	void Disconnect() {
-		if (connected_) {
-			client_.Disconnect();
-		}
-		connected_ = false;
-	}
+	// Reads [pos, pos + bytes) using one connection, pipelining requests if possible.
+	// Returns how many bytes from the start were read successfully.
+	size_t ReadRanges(Connection *conn, s64 pos, size_t bytes, u8 *data);
+	bool SendRangeRequest(Connection *conn, s64 pos, size_t bytes);
+	RangeResult ReadRangeResponse(Connection *conn, s64 pos, size_t bytes, u8 *data, double *headersTime);
+	void UpdateStats(double latency, double bytesPerSecond);
+	void SetLatestError(const char *error);
 
 	s64 filesize_ = 0;
-	s64 filepos_ = 0;
 	Url url_;
-	http::Client client_;
-	net::RequestProgress progress_;
 	::Path filename_;
-	bool connected_ = false;
-	bool cancel_ = false;
-	const char *latestError_ = "";
+	// Set from the UI thread, checked by the connections while they wait.
+	std::atomic<bool> cancel_{ false };
 
 	std::once_flag preparedFlag_;
-	std::mutex readAtMutex_;
+
+	std::mutex poolMutex_;
+	std::condition_variable poolCond_;
+	std::vector<Connection *> connections_;
+	// Cleared if a reused connection fails, since the server doesn't really keep them alive.
+	std::atomic<bool> keepAlive_{ true };
+
+	// Also guards latestError_, since any connection can fail while LatestError() is asked.
+	mutable std::mutex statsMutex_;
+	const char *latestError_ = "";
+	// Smoothed estimates, used to size read-ahead to the bandwidth-delay product.
+	double latency_ = 0.0;
+	double bytesPerSecond_ = 0.0;
 };
@@ -15,7 +15,10 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <cstring>
 
 #include "ppsspp_config.h"
 
@@ -38,6 +41,60 @@
 #include <fcntl.h>
 #endif
 
+#ifdef LOCAL_FILE_LOADER_MMAP
+#include <csetjmp>
+#include <mutex>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// How far ahead of a sequential read to ask the kernel to read in.
+static const s64 SEQUENTIAL_PREFETCH_SIZE = 2 * 1024 * 1024;
+
+// Not always 4K, Apple silicon and some Android devices use 16K pages.
+static s64 MappedPageSize() {
+	static const s64 pageSize = (s64)sysconf(_SC_PAGESIZE);
+	return pageSize;
+}
+
+// If the file shrinks under us (truncated, or the drive went away), touching the missing pages
+// raises SIGBUS rather than failing a read.  We catch that around the copy and read short instead.
+static thread_local sigjmp_buf *mappedReadJump = nullptr;
+static struct sigaction oldSigbusAction;
+static std::once_flag sigbusHandlerOnce;
+
+static void MappedReadSigbusHandler(int sig, siginfo_t *info, void *raw_context) {
+	sigjmp_buf *jump = mappedReadJump;
+	if (jump) {
+		mappedReadJump = nullptr;
+		siglongjmp(*jump, 1);
+	}
+
+	// Not from a mapped read, pass it on.
+	if (oldSigbusAction.sa_flags & SA_SIGINFO) {
+		oldSigbusAction.sa_sigaction(sig, info, raw_context);
+		return;
+	}
+	if (oldSigbusAction.sa_handler == SIG_DFL) {
+		// Will crash as usual once we return to the faulting access.
+		signal(sig, SIG_DFL);
+		return;
+	}
+	if (oldSigbusAction.sa_handler == SIG_IGN)
+		return;
+	oldSigbusAction.sa_handler(sig);
+}
+
+static void InstallSigbusHandler() {
+	struct sigaction sa{};
+	sa.sa_sigaction = &MappedReadSigbusHandler;
+	sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGBUS, &sa, &oldSigbusAction);
+}
+#endif
+
 #ifdef HAVE_LIBRETRO_VFS
 #include <streams/file_stream.h>
 #endif
@@ -55,6 +112,58 @@ void LocalFileLoader::DetectSizeFd() {
 	lseek(fd_, 0, SEEK_SET);
 #endif
 }
+
+#ifdef LOCAL_FILE_LOADER_MMAP
+void LocalFileLoader::MapFile() {
+	// Only regular files, pipes and such can't be mapped.
+	struct stat st;
+	if (filesize_ == 0 || fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode))
+		return;
+
+	void *ptr = mmap(nullptr, (size_t)filesize_, PROT_READ, MAP_SHARED, fd_, 0);
+	if (ptr == MAP_FAILED) {
+		WARN_LOG(Log::FileSystem, "Unable to map %s, using reads", filename_.c_str());
+		return;
+	}
+	std::call_once(sigbusHandlerOnce, &InstallSigbusHandler);
+	mapped_ = (const u8 *)ptr;
+}
+
+size_t LocalFileLoader::ReadMapped(s64 absolutePos, size_t bytes, size_t count, void *data) {
+	if (absolutePos < 0 || (u64)absolutePos >= filesize_)
+		return 0;
+	size_t size = (size_t)std::min((u64)(bytes * count), filesize_ - (u64)absolutePos);
+
+	// Continuing where the last read ended?  Then ask for the next chunk ahead of time, so we
+	// don't fault on each page.  Concurrent readers may race on these, but it's just a hint.
+	s64 end = absolutePos + (s64)size;
+	if (lastReadEnd_.exchange(end) == absolutePos) {
+		s64 prefetched = prefetchedUntil_;
+		if (prefetched < end + SEQUENTIAL_PREFETCH_SIZE / 2) {
+			// Has to start on a page boundary.
+			s64 start = std::max(prefetched, absolutePos) & ~(MappedPageSize() - 1);
+			s64 until = std::min(end + SEQUENTIAL_PREFETCH_SIZE, (s64)filesize_);
+			if (until > start)
+				madvise((void *)(mapped_ + start), (size_t)(until - start), MADV_WILLNEED);
+			prefetchedUntil_ = until;
+		}
+	}
+
+	sigjmp_buf jump;
+	if (sigsetjmp(jump, 1) != 0) {
+		// The handler already cleared mappedReadJump.
+		ERROR_LOG(Log::FileSystem, "Read from %s at %lld failed, file truncated or removed?", filename_.c_str(), (long long)absolutePos);
+		return 0;
+	}
+	mappedReadJump = &jump;
+	// Keep the compiler from moving the copy outside the guarded region.
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+	memcpy(data, mapped_ + absolutePos, size);
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+	mappedReadJump = nullptr;
+	return size / bytes;
+}
+#endif
 #endif
 
 LocalFileLoader::LocalFileLoader(const Path &filename)
@@ -84,6 +193,9 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 		fd_ = fd;
 		isOpenedByFd_ = true;
 		DetectSizeFd();
+#ifdef LOCAL_FILE_LOADER_MMAP
+		MapFile();
+#endif
 		return;
 	}
 #endif
@@ -98,6 +210,9 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 	}
 
 	DetectSizeFd();
+#ifdef LOCAL_FILE_LOADER_MMAP
+	MapFile();
+#endif
 
 #else // _WIN32
 
@@ -127,6 +242,11 @@ LocalFileLoader::~LocalFileLoader() {
 #if defined(HAVE_LIBRETRO_VFS)
     filestream_close(handle_);
 #elif !defined(_WIN32)
+#ifdef LOCAL_FILE_LOADER_MMAP
+	if (mapped_) {
+		munmap((void *)mapped_, (size_t)filesize_);
+	}
+#endif
 	if (fd_ != -1) {
 		close(fd_);
 	}
@@ -184,6 +304,11 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 		return 0;
 	}
 
+#ifdef LOCAL_FILE_LOADER_MMAP
+	if (mapped_)
+		return ReadMapped(absolutePos, bytes, count, data);
+#endif
+
 #if defined(HAVE_LIBRETRO_VFS)
     std::lock_guard<std::mutex> guard(readLock_);
 	filestream_seek(handle_, absolutePos, RETRO_VFS_SEEK_POSITION_START);
@@ -17,8 +17,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
+#include "ppsspp_config.h"
 #include "Common/CommonTypes.h"
 #include "Common/File/Path.h"
 #include "Core/Loaders.h"
@@ -32,6 +34,13 @@ typedef void *HANDLE;
 typedef RFILE* HANDLE;
 #endif
 
+// On desktop Linux, the file is mapped instead, so reads are just copies out of the page cache,
+// which the kernel can reclaim and share between processes reading the same file.  Elsewhere,
+// files are more likely to be on removable storage or behind a content provider.
+#if defined(__linux__) && !PPSSPP_PLATFORM(ANDROID) && !defined(HAVE_LIBRETRO_VFS) && PPSSPP_ARCH(64BIT)
+#define LOCAL_FILE_LOADER_MMAP
+#endif
+
 class LocalFileLoader : public FileLoader {
 public:
 	LocalFileLoader(const Path &filename);
@@ -49,6 +58,15 @@ class LocalFileLoader : public FileLoader {
 #if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS)
 	void DetectSizeFd();
 	int fd_ = -1;
+#ifdef LOCAL_FILE_LOADER_MMAP
+	void MapFile();
+	size_t ReadMapped(s64 absolutePos, size_t bytes, size_t count, void *data);
+
+	const u8 *mapped_ = nullptr;
+	// End of the last read, and how far we've asked the kernel to read ahead.
+	std::atomic<s64> lastReadEnd_{ -1 };
+	std::atomic<s64> prefetchedUntil_{ 0 };
+#endif
 #else
 	HANDLE handle_ = 0;
 #endif
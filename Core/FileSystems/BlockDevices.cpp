@@ -26,7 +26,9 @@
 #include "Common/Swap.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/DirListing.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/Loaders.h"
+#include "Core/ThreadPools.h"
 #include "Core/FileSystems/BlockDevices.h"
 #include "libchdr/chd.h"
 
@@ -39,6 +41,13 @@ extern "C"
 
 std::mutex NPDRMDemoBlockDevice::mutex_;
 
+// Decrypted table blocks to keep around, games often alternate between a few files.
+static const int NPDRM_CACHE_BLOCKS = 64;
+// Most table blocks decrypted at once (across threads), and how far to decrypt ahead when
+// reading sequentially.  Together they need to fit in the cache with room to spare.
+static const int NPDRM_MAX_BATCH = 16;
+static const int NPDRM_READAHEAD = 8;
+
 BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 	if (!fileLoader->Exists()) {
 		return nullptr;
@@ -418,8 +427,10 @@ NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
 	blockSize = blockLBAs*2048;
 	numBlocks = (lbaSize+blockLBAs-1)/blockLBAs; // total blocks;
 
-	blockBuf = new u8[blockSize];
-	tempBuf  = new u8[blockSize];
+	cacheBuf_ = new u8[(size_t)blockSize * NPDRM_CACHE_BLOCKS];
+	cache_.resize(NPDRM_CACHE_BLOCKS);
+	for (int i = 0; i < NPDRM_CACHE_BLOCKS; ++i)
+		cache_[i].data = cacheBuf_ + (size_t)i * blockSize;
 
 	tableOffset = *(u32*)(np_header+0x6c); // table offset
 
@@ -444,81 +455,183 @@ NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
 		p[7] ^= k0;
 		p += 8;
 	}
-
-	currentBlock = -1;
 }
 
 NPDRMDemoBlockDevice::~NPDRMDemoBlockDevice()
 {
-	std::lock_guard<std::mutex> guard(mutex_);
 	delete [] table;
-	delete [] tempBuf;
-	delete [] blockBuf;
+	delete [] cacheBuf_;
 }
 
 int lzrc_decompress(void *out, int out_len, void *in, int in_len);
 
 bool NPDRMDemoBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 {
-	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
-	std::lock_guard<std::mutex> guard(mutex_);
-	CIPHER_KEY ckey;
-	int block, lba, lzsize;
-	size_t readSize;
-	u8 *readBuf;
+	std::lock_guard<std::mutex> guard(cacheMutex_);
+	return ReadLBAs(blockNumber, 1, outPtr, uncached);
+}
 
-	lba = blockNumber-currentBlock;
-	if(lba>=0 && lba<blockLBAs){
-		memcpy(outPtr, blockBuf+lba*2048, 2048);
-		return true;
+bool NPDRMDemoBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	std::lock_guard<std::mutex> guard(cacheMutex_);
+	// Split big reads so a batch can't evict its own blocks.
+	const int batchLBAs = NPDRM_MAX_BATCH * blockLBAs;
+	while (count > 0) {
+		int n = std::min(count, batchLBAs);
+		if (!ReadLBAs(minBlock, n, outPtr, false))
+			return false;
+		minBlock += n;
+		count -= n;
+		outPtr += n * GetBlockSize();
 	}
+	return true;
+}
 
-	block = blockNumber/blockLBAs;
-	lba = blockNumber%blockLBAs;
-	currentBlock = block*blockLBAs;
+bool NPDRMDemoBlockDevice::ReadLBAs(u32 minLBA, int count, u8 *outPtr, bool uncached) {
+	const int firstBlock = minLBA / blockLBAs;
+	const int lastBlock = (minLBA + count - 1) / blockLBAs;
+	if ((u32)lastBlock >= numBlocks) {
+		ERROR_LOG(Log::Loader, "NPDRM read out of range: %08x (%d)", minLBA, count);
+		memset(outPtr, 0, count * GetBlockSize());
+		return false;
+	}
 
-	if(table[block].unk_1c!=0){
-		if((u32)block==(numBlocks-1))
-			return true; // demos make by fake_np
-		else
-			return false;
+	// When reading sequentially and about to run out, decrypt the next few blocks in the same batch.
+	int decodeEnd = lastBlock;
+	if (minLBA == nextSequentialLBA_ && !uncached && (u32)lastBlock + 1 < numBlocks && !FindCached(lastBlock + 1))
+		decodeEnd = std::min(lastBlock + NPDRM_READAHEAD, (int)numBlocks - 1);
+	nextSequentialLBA_ = minLBA + count;
+
+	std::vector<int> missing;
+	for (int block = firstBlock; block <= decodeEnd; ++block) {
+		if (!FindCached(block))
+			missing.push_back(block);
+	}
+	std::vector<DecodeResult> results;
+	if (!missing.empty())
+		DecodeBlocks(missing, results, uncached);
+
+	bool success = true;
+	const CachedBlock *cached = nullptr;
+	for (int i = 0; i < count; ++i) {
+		const u32 lba = minLBA + i;
+		const int block = lba / blockLBAs;
+		if (!cached || cached->block != block)
+			cached = FindCached(block);
+		if (cached) {
+			memcpy(outPtr + i * GetBlockSize(), cached->data + (lba % blockLBAs) * GetBlockSize(), GetBlockSize());
+			continue;
+		}
+
+		auto it = std::find(missing.begin(), missing.end(), block);
+		if (it == missing.end() || results[it - missing.begin()] == DecodeResult::FAILED)
+			success = false;
 	}
+	return success;
+}
 
-	if(table[block].size<blockSize)
-		readBuf = tempBuf;
-	else
-		readBuf = blockBuf;
+void NPDRMDemoBlockDevice::DecodeBlocks(const std::vector<int> &blocks, std::vector<DecodeResult> &results, bool uncached) {
+	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	const size_t n = blocks.size();
+	results.assign(n, DecodeResult::FAILED);
+
+	auto storedSize = [&](int block) -> size_t {
+		const table_info &info = table[block];
+		if (info.unk_1c != 0 || info.size <= 0 || info.size > blockSize)
+			return 0;
+		return (size_t)info.size;
+	};
 
-	readSize = fileLoader_->ReadAt(psarOffset+table[block].offset, 1, table[block].size, readBuf, flags);
-	if(readSize != (size_t)table[block].size){
-		if((u32)block==(numBlocks-1))
-			return true;
-		else
-			return false;
+	std::vector<size_t> rawOffsets(n + 1);
+	for (size_t i = 0; i < n; ++i)
+		rawOffsets[i + 1] = rawOffsets[i] + storedSize(blocks[i]);
+	std::vector<u8> raw(rawOffsets[n]);
+
+	// Reading stays on this thread, in as few requests as possible since blocks are usually stored back to back.
+	std::vector<CachedBlock *> slots(n, nullptr);
+	for (size_t i = 0; i < n; ) {
+		size_t end = i + 1;
+		while (end < n && blocks[end] == blocks[end - 1] + 1 && storedSize(blocks[end]) != 0 && table[blocks[end]].offset == table[blocks[end - 1]].offset + table[blocks[end - 1]].size)
+			end++;
+
+		size_t runSize = rawOffsets[end] - rawOffsets[i];
+		size_t readSize = runSize == 0 ? 0 : fileLoader_->ReadAt(psarOffset + table[blocks[i]].offset, runSize, raw.data() + rawOffsets[i], flags);
+		for (size_t j = i; j < end; ++j) {
+			if (storedSize(blocks[j]) != 0 && readSize >= rawOffsets[j + 1] - rawOffsets[i])
+				slots[j] = AllocCached(blocks[j]);
+		}
+		i = end;
+	}
+
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		for (int i = l; i < h; ++i) {
+			if (slots[i]) {
+				results[i] = DecodeBlock(blocks[i], raw.data() + rawOffsets[i], slots[i]->data);
+			} else if ((u32)blocks[i] == numBlocks - 1) {
+				// Demos made by fake_np have a broken last block.
+				results[i] = DecodeResult::EMPTY;
+			}
+		}
+	}, 0, (int)n, 1);
+
+	bool decodeFailed = false;
+	for (size_t i = 0; i < n; ++i) {
+		if (slots[i] && results[i] != DecodeResult::OK) {
+			slots[i]->block = -1;
+			slots[i]->lastUse = 0;
+			decodeFailed = true;
+		}
 	}
+	if (decodeFailed)
+		NotifyReadError();
+}
+
+NPDRMDemoBlockDevice::DecodeResult NPDRMDemoBlockDevice::DecodeBlock(int block, u8 *raw, u8 *out) {
+	const int size = table[block].size;
 
-	if((table[block].flag&1)==0){
+	if ((table[block].flag & 1) == 0) {
 		// skip mac check
 	}
 
-	if((table[block].flag&4)==0){
-		sceDrmBBCipherInit(&ckey, 1, 2, hkey, vkey, table[block].offset>>4);
-		sceDrmBBCipherUpdate(&ckey, readBuf, table[block].size);
+	if ((table[block].flag & 4) == 0) {
+		// The shared buffer in amctrl isn't safe to use from several threads.
+		CIPHER_KEY ckey;
+		u32 kirkBuf[AMCTRL_KIRK_BUF_SIZE / 4];
+		sceDrmBBCipherInit(&ckey, 1, 2, hkey, vkey, table[block].offset >> 4);
+		bbcipher_update(&ckey, (u8 *)kirkBuf, raw, size);
 		sceDrmBBCipherFinal(&ckey);
 	}
 
-	if(table[block].size<blockSize){
-		lzsize = lzrc_decompress(blockBuf, 0x00100000, readBuf, table[block].size);
-		if(lzsize!=blockSize){
-			ERROR_LOG(Log::Loader, "LZRC decompress error! lzsize=%d\n", lzsize);
-			NotifyReadError();
-			return false;
+	if (size < blockSize) {
+		int lzsize = lzrc_decompress(out, blockSize, raw, size);
+		if (lzsize != blockSize) {
+			ERROR_LOG(Log::Loader, "LZRC decompress error! lzsize=%d", lzsize);
+			return DecodeResult::FAILED;
 		}
+	} else {
+		memcpy(out, raw, blockSize);
 	}
+	return DecodeResult::OK;
+}
 
-	memcpy(outPtr, blockBuf+lba*2048, 2048);
+NPDRMDemoBlockDevice::CachedBlock *NPDRMDemoBlockDevice::FindCached(int block) {
+	for (CachedBlock &cached : cache_) {
+		if (cached.block == block) {
+			cached.lastUse = ++useCounter_;
+			return &cached;
+		}
+	}
+	return nullptr;
+}
 
-	return true;
+NPDRMDemoBlockDevice::CachedBlock *NPDRMDemoBlockDevice::AllocCached(int block) {
+	CachedBlock *oldest = &cache_[0];
+	for (CachedBlock &cached : cache_) {
+		if (cached.lastUse < oldest->lastUse)
+			oldest = &cached;
+	}
+	oldest->block = block;
+	oldest->lastUse = ++useCounter_;
+	return oldest;
 }
 
 /*
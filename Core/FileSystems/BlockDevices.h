@@ -24,6 +24,7 @@
 // with CISO images.
 
 #include <mutex>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Core/ELF/PBPReader.h"
@@ -113,11 +114,34 @@ class NPDRMDemoBlockDevice : public BlockDevice {
 	~NPDRMDemoBlockDevice();
 
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
+	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
 	u32 GetNumBlocks() const override {return (u32)lbaSize;}
 	bool IsDisc() const override { return false; }
 
 private:
+	enum class DecodeResult {
+		OK,
+		// Nothing to read, but not an error (the padding at the end of some demos.)
+		EMPTY,
+		FAILED,
+	};
+
+	struct CachedBlock {
+		int block = -1;
+		u64 lastUse = 0;
+		u8 *data = nullptr;
+	};
+
+	bool ReadLBAs(u32 minLBA, int count, u8 *outPtr, bool uncached);
+	void DecodeBlocks(const std::vector<int> &blocks, std::vector<DecodeResult> &results, bool uncached);
+	DecodeResult DecodeBlock(int block, u8 *raw, u8 *out);
+	CachedBlock *FindCached(int block);
+	CachedBlock *AllocCached(int block);
+
+	// Protects the kirk engine's shared buffers, which the header setup uses.
 	static std::mutex mutex_;
+	// Protects the cache below.
+	std::mutex cacheMutex_;
 	u32 lbaSize;
 
 	u32 psarOffset;
@@ -129,9 +153,11 @@ class NPDRMDemoBlockDevice : public BlockDevice {
 	u8 hkey[16];
 	struct table_info *table;
 
-	int currentBlock;
-	u8 *blockBuf;
-	u8 *tempBuf;
+	// Decrypted (and decompressed) table blocks, least recently used goes first.
+	std::vector<CachedBlock> cache_;
+	u8 *cacheBuf_ = nullptr;
+	u64 useCounter_ = 0;
+	u32 nextSequentialLBA_ = 0;
 };
 
 struct CHDImpl;
@@ -70,9 +70,187 @@
 #include <fcntl.h>
 #endif
 
+#if HOST_IS_CASE_SENSITIVE
+
+static std::string LowerCasePath(const std::string &path) {
+	std::string lower = path;
+	for (char &c : lower)
+		c = tolower(c);
+	return lower;
+}
+
+// Drops empty components (leading, trailing, and doubled slashes.)
+static std::string NormalizeRelativePath(const std::string &path) {
+	std::string result;
+	result.reserve(path.size());
+	size_t start = 0;
+	while (start < path.size()) {
+		size_t end = path.find('/', start);
+		if (end == std::string::npos)
+			end = path.size();
+		if (end > start) {
+			if (!result.empty())
+				result.push_back('/');
+			result.append(path, start, end - start);
+		}
+		start = end + 1;
+	}
+	return result;
+}
+
+bool PathCaseIndex::FixPathCase(std::string &path, FixPathCaseBehavior behavior) {
+	if (basePath_.Type() == PathType::CONTENT_URI) {
+		// Nothing to do, just like FixPathCase().
+		return true;
+	}
+
+	size_t len = path.size();
+	if (len != 0 && path[len - 1] == '/')
+		len--;
+	if (len == 0)
+		return true;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	std::string dirPath;
+	size_t start = 0;
+	while (start < len) {
+		size_t i = path.find('/', start);
+		if (i == std::string::npos || i > len)
+			i = len;
+
+		if (i > start) {
+			std::string component = path.substr(start, i - start);
+			if (!FixComponent(dirPath, component)) {
+				// Same rules as FixPathCase() for what counts as success.
+				return behavior == FPC_PARTIAL_ALLOWED || (behavior == FPC_PATH_MUST_EXIST && i >= len);
+			}
+
+			path.replace(start, i - start, component);
+			if (!dirPath.empty())
+				dirPath.push_back('/');
+			dirPath += component;
+		}
+
+		start = i + 1;
+	}
+
+	return true;
+}
+
+bool PathCaseIndex::FixComponent(const std::string &dirPath, std::string &component) {
+	auto lookup = [&](const Listing *listing) {
+		if (!listing)
+			return false;
+		if (listing->names.count(component))
+			return true;
+		auto it = listing->lowerNames.find(LowerCasePath(component));
+		if (it == listing->lowerNames.end())
+			return false;
+		component = it->second;
+		return true;
+	};
+
+	return lookup(GetListing(dirPath));
+}
+
+PathCaseIndex::Listing *PathCaseIndex::GetListing(const std::string &dirPath) {
+	std::string key = LowerCasePath(dirPath);
+	auto it = listings_.find(key);
+	// Names can be created, renamed or deleted behind our back too, so a hit needs a stat to check,
+	// but that's still far cheaper than listing the directory again.
+	if (it != listings_.end() && it->second.actualPath == dirPath && !IsStale(it->second))
+		return &it->second;
+
+	Path localPath = dirPath.empty() ? basePath_ : basePath_ / dirPath;
+	File::FileInfo info;
+	if (!File::GetFileInfo(localPath, &info) || !info.isDirectory) {
+		if (it != listings_.end())
+			listings_.erase(it);
+		return nullptr;
+	}
+
+	DIR *dirp = opendir(localPath.c_str());
+	if (!dirp)
+		return nullptr;
+
+	Listing &listing = listings_[key];
+	listing.actualPath = dirPath;
+	listing.mtime = (int64_t)info.mtime;
+	listing.loadTime = (int64_t)time(nullptr);
+	listing.names.clear();
+	listing.lowerNames.clear();
+	while (struct dirent *result = readdir(dirp)) {
+		std::string name = result->d_name;
+		if (name == "." || name == "..")
+			continue;
+		listing.lowerNames[LowerCasePath(name)] = name;
+		listing.names.insert(std::move(name));
+	}
+	closedir(dirp);
+	return &listing;
+}
+
+bool PathCaseIndex::IsStale(const Listing &listing) const {
+	File::FileInfo info;
+	Path localPath = listing.actualPath.empty() ? basePath_ : basePath_ / listing.actualPath;
+	if (!File::GetFileInfo(localPath, &info))
+		return true;
+	// mtime only has seconds, so anything changed around when we listed it can't be trusted.
+	return (int64_t)info.mtime != listing.mtime || listing.mtime >= listing.loadTime - 1;
+}
+
+void PathCaseIndex::AddListing(const std::string &dirPath, const std::vector<File::FileInfo> &files) {
+	std::string normalized = NormalizeRelativePath(dirPath);
+	Path localPath = normalized.empty() ? basePath_ : basePath_ / normalized;
+	File::FileInfo info;
+	if (!File::GetFileInfo(localPath, &info))
+		return;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	Listing &listing = listings_[LowerCasePath(normalized)];
+	listing.actualPath = normalized;
+	listing.mtime = (int64_t)info.mtime;
+	listing.loadTime = (int64_t)time(nullptr);
+	listing.names.clear();
+	listing.lowerNames.clear();
+	for (const File::FileInfo &file : files) {
+		if (file.name == "." || file.name == "..")
+			continue;
+		listing.lowerNames[LowerCasePath(file.name)] = file.name;
+		listing.names.insert(file.name);
+	}
+}
+
+void PathCaseIndex::Invalidate(const std::string &path) {
+	std::string key = LowerCasePath(NormalizeRelativePath(path));
+	size_t slash = key.find_last_of('/');
+	std::string parentKey = slash == std::string::npos ? "" : key.substr(0, slash);
+
+	std::lock_guard<std::mutex> guard(lock_);
+	listings_.erase(parentKey);
+	if (key.empty())
+		return;
+	for (auto it = listings_.begin(); it != listings_.end(); ) {
+		if (it->first == key || (startsWith(it->first, key) && it->first[key.size()] == '/'))
+			it = listings_.erase(it);
+		else
+			++it;
+	}
+}
+
+void PathCaseIndex::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	listings_.clear();
+}
+
+#endif
+
 DirectoryFileSystem::DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path & _basePath, FileSystemFlags _flags) : basePath(_basePath), flags(_flags) {
 	File::CreateFullPath(basePath);
 	hAlloc = _hAlloc;
+#if HOST_IS_CASE_SENSITIVE
+	caseIndex_.reset(new PathCaseIndex(basePath));
+#endif
 }
 
 DirectoryFileSystem::~DirectoryFileSystem() {
@@ -113,9 +291,15 @@ Path DirectoryFileSystem::GetLocalPath(std::string internalPath) const {
 	return basePath / internalPath;
 }
 
-bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, FileAccess access, u32 &error) {
+bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, FileAccess access, u32 &error, PathCaseIndex *caseIndex) {
 	error = 0;
 
+#if HOST_IS_CASE_SENSITIVE
+	auto fixPathCase = [&](std::string &path, FixPathCaseBehavior behavior) {
+		return caseIndex ? caseIndex->FixPathCase(path, behavior) : FixPathCase(basePath, path, behavior);
+	};
+#endif
+
 	if (access == FILEACCESS_NONE) {
 		error = SCE_KERNEL_ERROR_ERRNO_INVALID_ARGUMENT;
 		return false;
@@ -124,7 +308,7 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 #if HOST_IS_CASE_SENSITIVE
 	if (access & (FILEACCESS_APPEND | FILEACCESS_CREATE | FILEACCESS_WRITE)) {
 		DEBUG_LOG(Log::FileSystem, "Checking case for path %s", fileName.c_str());
-		if (!FixPathCase(basePath, fileName, FPC_PATH_MUST_EXIST)) {
+		if (!fixPathCase(fileName, FPC_PATH_MUST_EXIST)) {
 			error = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 			return false;  // or go on and attempt (for a better error code than just 0?)
 		}
@@ -257,7 +441,7 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 
 #if HOST_IS_CASE_SENSITIVE
 	if (!success && !(access & FILEACCESS_CREATE)) {
-		if (!FixPathCase(basePath, fileName, FPC_PATH_MUST_EXIST)) {
+		if (!fixPathCase(fileName, FPC_PATH_MUST_EXIST)) {
 			error = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 			return false;
 		}
@@ -452,10 +636,12 @@ bool DirectoryFileSystem::MkDir(const std::string &dirname) {
 	// duplicate (different case) directories
 
 	std::string fixedCase = dirname;
-	if (!FixPathCase(basePath, fixedCase, FPC_PARTIAL_ALLOWED))
+	if (!caseIndex_->FixPathCase(fixedCase, FPC_PARTIAL_ALLOWED))
 		result = false;
 	else
 		result = File::CreateFullPath(GetLocalPath(fixedCase));
+	// Might have created several levels of directories.
+	caseIndex_->Clear();
 #else
 	result = File::CreateFullPath(GetLocalPath(dirname));
 #endif
@@ -469,19 +655,23 @@ bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 #if HOST_IS_CASE_SENSITIVE
 	// Maybe we're lucky?
 	if (File::DeleteDirRecursively(fullName)) {
+		caseIndex_->Invalidate(dirname);
 		MemoryStick_NotifyWrite();
 		return (bool)ReplayApplyDisk(ReplayAction::RMDIR, true, CoreTiming::GetGlobalTimeUs());
 	}
 
 	// Nope, fix case and try again.  Should we try again?
 	std::string fullPath = dirname;
-	if (!FixPathCase(basePath, fullPath, FPC_FILE_MUST_EXIST))
+	if (!caseIndex_->FixPathCase(fullPath, FPC_FILE_MUST_EXIST))
 		return (bool)ReplayApplyDisk(ReplayAction::RMDIR, false, CoreTiming::GetGlobalTimeUs());
 
 	fullName = GetLocalPath(fullPath);
 #endif
 
 	bool result = File::DeleteDirRecursively(fullName);
+#if HOST_IS_CASE_SENSITIVE
+	caseIndex_->Invalidate(fullPath);
+#endif
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::RMDIR, result, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -507,7 +697,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 
 #if HOST_IS_CASE_SENSITIVE
 	// In case TO should overwrite a file with different case.  Check error code?
-	if (!FixPathCase(basePath, fullTo, FPC_PATH_MUST_EXIST))
+	if (!caseIndex_->FixPathCase(fullTo, FPC_PATH_MUST_EXIST))
 		return ReplayApplyDisk(ReplayAction::FILE_RENAME, -1, CoreTiming::GetGlobalTimeUs());
 #endif
 
@@ -520,7 +710,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 	{
 		// May have failed due to case sensitivity on FROM, so try again.  Check error code?
 		std::string fullFromPath = from;
-		if (!FixPathCase(basePath, fullFromPath, FPC_FILE_MUST_EXIST))
+		if (!caseIndex_->FixPathCase(fullFromPath, FPC_FILE_MUST_EXIST))
 			return ReplayApplyDisk(ReplayAction::FILE_RENAME, -1, CoreTiming::GetGlobalTimeUs());
 		fullFrom = GetLocalPath(fullFromPath);
 
@@ -528,6 +718,13 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 	}
 #endif
 
+#if HOST_IS_CASE_SENSITIVE
+	if (retValue) {
+		caseIndex_->Invalidate(from);
+		caseIndex_->Invalidate(fullTo);
+	}
+#endif
+
 	// TODO: Better error codes.
 	int result = retValue ? 0 : (int)SCE_KERNEL_ERROR_ERRNO_FILE_ALREADY_EXISTS;
 	MemoryStick_NotifyWrite();
@@ -544,12 +741,14 @@ bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 	{
 		// May have failed due to case sensitivity, so try again.  Try even if it fails?
 		std::string fullNamePath = filename;
-		if (!FixPathCase(basePath, fullNamePath, FPC_FILE_MUST_EXIST))
+		if (!caseIndex_->FixPathCase(fullNamePath, FPC_FILE_MUST_EXIST))
 			return (bool)ReplayApplyDisk(ReplayAction::FILE_REMOVE, false, CoreTiming::GetGlobalTimeUs());
 		localPath = GetLocalPath(fullNamePath);
 
 		retValue = File::Delete(localPath);
 	}
+	if (retValue)
+		caseIndex_->Invalidate(filename);
 #endif
 
 	MemoryStick_NotifyWrite();
@@ -560,7 +759,14 @@ int DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const
 	OpenFileEntry entry;
 	entry.hFile.fileSystemFlags_ = flags;
 	u32 err = 0;
+#if HOST_IS_CASE_SENSITIVE
+	bool success = entry.hFile.Open(basePath, filename, (FileAccess)(access & FILEACCESS_PSP_FLAGS), err, caseIndex_.get());
+	// Might be a new file.
+	if (success && (access & FILEACCESS_CREATE))
+		caseIndex_->Invalidate(filename);
+#else
 	bool success = entry.hFile.Open(basePath, filename, (FileAccess)(access & FILEACCESS_PSP_FLAGS), err);
+#endif
 	if (err == 0 && !success) {
 		err = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 	}
@@ -681,7 +887,7 @@ PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
 	Path fullName = GetLocalPath(filename);
 	if (!File::GetFileInfo(fullName, &info)) {
 #if HOST_IS_CASE_SENSITIVE
-		if (! FixPathCase(basePath, filename, FPC_FILE_MUST_EXIST))
+		if (!caseIndex_->FixPathCase(filename, FPC_FILE_MUST_EXIST))
 			return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
 		fullName = GetLocalPath(filename);
 
@@ -803,15 +1009,20 @@ std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(const std::string &p
 	const int flags = File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES;
 	bool success = File::GetFilesInDir(localPath, &files, nullptr, flags);
 #if HOST_IS_CASE_SENSITIVE
+	std::string listedPath = path;
 	if (!success) {
 		// TODO: Case sensitivity should be checked on a file system basis, right?
 		std::string fixedPath = path;
-		if (FixPathCase(basePath, fixedPath, FPC_FILE_MUST_EXIST)) {
+		if (caseIndex_->FixPathCase(fixedPath, FPC_FILE_MUST_EXIST)) {
 			// May have failed due to case sensitivity, try again
 			localPath = GetLocalPath(fixedPath);
 			success = File::GetFilesInDir(localPath, &files, nullptr, flags);
+			listedPath = fixedPath;
 		}
 	}
+	// Save the case index from having to list it again.  With STRIP_PSP, the path doesn't match what it indexes.
+	if (success && !(Flags() & FileSystemFlags::STRIP_PSP))
+		caseIndex_->AddListing(listedPath, files);
 #endif
 	if (!success) {
 		if (exists)
@@ -879,7 +1090,7 @@ u64 DirectoryFileSystem::FreeSpace(const std::string &path) {
 
 #if HOST_IS_CASE_SENSITIVE
 	std::string fixedCase = path;
-	if (FixPathCase(basePath, fixedCase, FPC_FILE_MUST_EXIST)) {
+	if (caseIndex_->FixPathCase(fixedCase, FPC_FILE_MUST_EXIST)) {
 		// May have failed due to case sensitivity, try again.
 		if (free_disk_space(GetLocalPath(fixedCase), result)) {
 			return ReplayApplyDisk64(ReplayAction::FREESPACE, result, CoreTiming::GetGlobalTimeUs());
@@ -919,7 +1130,12 @@ void DirectoryFileSystem::DoState(PointerWrap &p) {
 			Do(p, entry.access);
 			u32 err;
 			bool brokenFile = false;
-			if (!entry.hFile.Open(basePath,entry.guestFilename,entry.access, err)) {
+#if HOST_IS_CASE_SENSITIVE
+			PathCaseIndex *caseIndex = caseIndex_.get();
+#else
+			PathCaseIndex *caseIndex = nullptr;
+#endif
+			if (!entry.hFile.Open(basePath, entry.guestFilename, entry.access, err, caseIndex)) {
 				ERROR_LOG(Log::FileSystem, "Failed to reopen file while loading state: %s", entry.guestFilename.c_str());
 				brokenFile = true;
 			}
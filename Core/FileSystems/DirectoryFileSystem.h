@@ -20,7 +20,12 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "Common/File/DirListing.h"
 #include "Common/File/Path.h"
 #include "Core/FileSystems/FileSystem.h"
 
@@ -28,6 +33,46 @@
 typedef void * HANDLE;
 #endif
 
+#if HOST_IS_CASE_SENSITIVE
+// Remembers the real case of names under a base path, one directory listing at a time, so that
+// fixing the case of a path doesn't need to list every directory along it again.  Listings are
+// loaded lazily and reloaded when the directory's mtime shows it changed, and changes the
+// emulator makes itself should also be invalidated directly.
+class PathCaseIndex {
+public:
+	explicit PathCaseIndex(const Path &basePath) : basePath_(basePath) {}
+
+	// Same contract as FixPathCase(basePath, path, behavior).
+	bool FixPathCase(std::string &path, FixPathCaseBehavior behavior);
+	// A listing we already have, dirPath must already have the right case.
+	void AddListing(const std::string &dirPath, const std::vector<File::FileInfo> &files);
+	// Forgets the directory containing path, and path itself and anything under it if it's a directory.
+	void Invalidate(const std::string &path);
+	void Clear();
+
+private:
+	struct Listing {
+		std::string actualPath;
+		int64_t mtime = 0;
+		int64_t loadTime = 0;
+		std::unordered_set<std::string> names;
+		// Lowercased name to the actual one.
+		std::unordered_map<std::string, std::string> lowerNames;
+	};
+
+	Listing *GetListing(const std::string &dirPath);
+	bool IsStale(const Listing &listing) const;
+	bool FixComponent(const std::string &dirPath, std::string &component);
+
+	Path basePath_;
+	std::mutex lock_;
+	// By lowercased directory path, relative to basePath_.
+	std::unordered_map<std::string, Listing> listings_;
+};
+#else
+class PathCaseIndex;
+#endif
+
 struct DirectoryFileHandle {
 	enum Flags {
 		NORMAL,
@@ -50,7 +95,7 @@ struct DirectoryFileHandle {
 		: replay_(flags != SKIP_REPLAY), fileSystemFlags_(fileSystemFlags) {}
 
 	Path GetLocalPath(const Path &basePath, std::string localpath) const;
-	bool Open(const Path &basePath, std::string &fileName, FileAccess access, u32 &err);
+	bool Open(const Path &basePath, std::string &fileName, FileAccess access, u32 &err, PathCaseIndex *caseIndex = nullptr);
 	size_t Read(u8* pointer, s64 size);
 	size_t Write(const u8* pointer, s64 size);
 	size_t Seek(s32 position, FileMove type);
@@ -99,6 +144,9 @@ class DirectoryFileSystem : public IFileSystem {
 	Path basePath;
 	IHandleAllocator *hAlloc;
 	FileSystemFlags flags;
+#if HOST_IS_CASE_SENSITIVE
+	std::unique_ptr<PathCaseIndex> caseIndex_;
+#endif
 
 	Path GetLocalPath(std::string internalPath) const;
 };
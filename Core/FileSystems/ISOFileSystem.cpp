@@ -251,6 +251,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 				}
 			}
 			root->children.push_back(entry);
+			root->childIndex.emplace(entry->name, entry);
 		}
 	}
 	root->valid = true;
@@ -277,6 +278,12 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	if (pathLength <= pathIndex)
 		return treeroot;
 
+	// Games tend to open and stat the same files over and over.
+	std::string indexKey = path.substr(pathIndex);
+	auto indexed = pathIndex_.find(indexKey);
+	if (indexed != pathIndex_.end())
+		return indexed->second;
+
 	TreeEntry *entry = treeroot;
 	while (true) {
 		if (!entry->valid) {
@@ -290,14 +297,10 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 				nextSlashIndex = pathLength;
 
 			const std::string firstPathComponent = path.substr(pathIndex, nextSlashIndex - pathIndex);
-			for (size_t i = 0; i < entry->children.size(); i++) {
-				const std::string &n = entry->children[i]->name;
-				if (firstPathComponent == n) {
-					//yay we got it
-					nextEntry = entry->children[i];
-					name = n;
-					break;
-				}
+			auto child = entry->childIndex.find(firstPathComponent);
+			if (child != entry->childIndex.end()) {
+				nextEntry = child->second;
+				name = child->first;
 			}
 		}
 		
@@ -309,8 +312,10 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 			if (pathIndex < pathLength && path[pathIndex] == '/')
 				++pathIndex;
 
-			if (pathLength <= pathIndex)
+			if (pathLength <= pathIndex) {
+				pathIndex_[indexKey] = entry;
 				return entry;
+			}
 		} else {
 			if (catchError)
 				ERROR_LOG(Log::FileSystem, "File '%s' not found", path.c_str());
@@ -709,6 +714,7 @@ ISOFileSystem::TreeEntry::~TreeEntry() {
 	for (size_t i = 0; i < children.size(); ++i)
 		delete children[i];
 	children.clear();
+	childIndex.clear();
 }
 
 void ISOFileSystem::DoState(PointerWrap &p) {
@@ -20,6 +20,7 @@
 #include <map>
 #include <list>
 #include <memory>
+#include <unordered_map>
 
 #include "FileSystem.h"
 
@@ -76,6 +77,8 @@ class ISOFileSystem : public IFileSystem {
 
 		bool valid = false;
 		std::vector<TreeEntry *> children;
+		// By name, the first one wins (like the old linear search.)
+		std::unordered_map<std::string, TreeEntry *> childIndex;
 	};
 
 	struct OpenFileEntry {
@@ -95,6 +98,9 @@ class ISOFileSystem : public IFileSystem {
 	u32 lastReadBlock_;
 
 	TreeEntry entireISO;
+	// Paths (as passed to GetFromPath, minus any leading "./" or "/") already resolved.
+	// The tree never changes, so these never go stale.
+	std::unordered_map<std::string, TreeEntry *> pathIndex_;
 
 	void ReadDirectory(TreeEntry *root);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
@@ -40,6 +40,7 @@
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/HLE/sceKernelInterrupt.h"
 #include "Core/HLE/HLE.h"
+#include "Core/HLE/HLEProfiler.h"
 
 enum
 {
@@ -294,6 +295,14 @@ bool WriteSyscall(const char *moduleName, u32 nib, u32 address)
 	}
 }
 
+const char *GetFuncModuleName(const HLEFunction *func) {
+	for (const HLEModule &module : moduleDB) {
+		if (func >= module.funcTable && func < module.funcTable + module.numFunctions)
+			return module.name;
+	}
+	return nullptr;
+}
+
 const char *GetFuncName(int moduleIndex, int func)
 {
 	if (moduleIndex >= 0 && moduleIndex < (int)moduleDB.size())
@@ -625,7 +634,7 @@ static void updateSyscallStats(int modulenum, int funcnum, double total)
 	}
 }
 
-inline void CallSyscallWithFlags(const HLEFunction *info)
+inline void RunSyscallWithFlags(const HLEFunction *info)
 {
 	latestSyscall = info;
 	latestSyscallPC = currentMIPS->pc;
@@ -652,7 +661,7 @@ inline void CallSyscallWithFlags(const HLEFunction *info)
 		SetDeadbeefRegs();
 }
 
-inline void CallSyscallWithoutFlags(const HLEFunction *info)
+inline void RunSyscallWithoutFlags(const HLEFunction *info)
 {
 	latestSyscall = info;
 	latestSyscallPC = currentMIPS->pc;
@@ -664,6 +673,30 @@ inline void CallSyscallWithoutFlags(const HLEFunction *info)
 		SetDeadbeefRegs();
 }
 
+// Includes hleFinishSyscall(), since callbacks and rescheduling are part of the cost.
+static void RunSyscallProfiled(const HLEFunction *info, void (*run)(const HLEFunction *)) {
+	u64 startTicks = CoreTiming::GetTicks();
+	TimeSpan span;
+	run(info);
+	HLEProfilerRecord(info, (u64)span.ElapsedNanos(), (s64)(CoreTiming::GetTicks() - startTicks));
+}
+
+inline void CallSyscallWithFlags(const HLEFunction *info)
+{
+	if (hleProfilerEnabled.load(std::memory_order_relaxed))
+		RunSyscallProfiled(info, &RunSyscallWithFlags);
+	else
+		RunSyscallWithFlags(info);
+}
+
+inline void CallSyscallWithoutFlags(const HLEFunction *info)
+{
+	if (hleProfilerEnabled.load(std::memory_order_relaxed))
+		RunSyscallProfiled(info, &RunSyscallWithoutFlags);
+	else
+		RunSyscallWithoutFlags(info);
+}
+
 const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op)
 {
 	u32 callno = (op >> 6) & 0xFFFFF; //20 bits
@@ -100,6 +100,8 @@ const char *GetFuncName(int module, int func);
 const HLEFunction *GetFunc(const char *module, u32 nib);
 int GetFuncIndex(int moduleIndex, u32 nib);
 int GetModuleIndex(const char *modulename);
+// Name of the module whose table func is in, or nullptr.
+const char *GetFuncModuleName(const HLEFunction *func);
 
 void RegisterModule(const char *name, int numFunctions, const HLEFunction *funcTable);
 
@@ -0,0 +1,200 @@
+// Copyright (c) 2025- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "Common/BitScan.h"
+#include "Common/Data/Format/JSONWriter.h"
+#include "Core/HLE/HLE.h"
+#include "Core/HLE/HLEProfiler.h"
+
+std::atomic<bool> hleProfilerEnabled{};
+
+struct HLEProfileEvent {
+	const HLEFunction *func;
+	u32 nanos;
+	s32 cycles;
+};
+
+// Single producer (the thread it belongs to), drained with profileMutex held.
+class HLEProfileRing {
+public:
+	bool Push(const HLEProfileEvent &ev) {
+		uint32_t write = write_.load(std::memory_order_relaxed);
+		if (write - read_.load(std::memory_order_acquire) >= CAPACITY)
+			return false;
+		events_[write & (CAPACITY - 1)] = ev;
+		write_.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	template <typename F>
+	void Drain(F func) {
+		uint32_t read = read_.load(std::memory_order_relaxed);
+		uint32_t write = write_.load(std::memory_order_acquire);
+		for (; read != write; ++read)
+			func(events_[read & (CAPACITY - 1)]);
+		read_.store(read, std::memory_order_release);
+	}
+
+	// Set when the thread exits, the ring is freed once drained.
+	std::atomic<bool> abandoned{};
+
+private:
+	static constexpr uint32_t CAPACITY = 2048;
+
+	HLEProfileEvent events_[CAPACITY];
+	alignas(64) std::atomic<uint32_t> write_{};
+	alignas(64) std::atomic<uint32_t> read_{};
+};
+
+struct ThreadProfileRing {
+	~ThreadProfileRing() {
+		if (ring)
+			ring->abandoned = true;
+	}
+
+	HLEProfileRing *ring = nullptr;
+};
+
+static std::mutex profileMutex;
+static std::vector<HLEProfileRing *> profileRings;
+static std::unordered_map<const HLEFunction *, HLEProfileEntry> profileEntries;
+static thread_local ThreadProfileRing threadProfileRing;
+
+static int BucketForNanos(u32 nanos) {
+	if (nanos < 256)
+		return 0;
+	int bucket = 31 - (int)clz32_nonzero(nanos) - 7;
+	return std::min(bucket, HLE_PROFILE_BUCKETS - 1);
+}
+
+static void MergeEvent(const HLEProfileEvent &ev) {
+	auto it = profileEntries.find(ev.func);
+	if (it == profileEntries.end()) {
+		HLEProfileEntry entry{};
+		entry.func = ev.func;
+		entry.moduleName = GetFuncModuleName(ev.func);
+		it = profileEntries.emplace(ev.func, entry).first;
+	}
+
+	HLEProfileEntry &entry = it->second;
+	entry.calls++;
+	entry.totalNanos += ev.nanos;
+	entry.maxNanos = std::max(entry.maxNanos, (u64)ev.nanos);
+	entry.totalCycles += ev.cycles;
+	entry.histogram[BucketForNanos(ev.nanos)]++;
+}
+
+// Only call with profileMutex held.
+static void MergeRings() {
+	for (size_t i = 0; i < profileRings.size(); ++i) {
+		HLEProfileRing *ring = profileRings[i];
+		bool abandoned = ring->abandoned;
+		ring->Drain(&MergeEvent);
+		if (abandoned) {
+			delete ring;
+			profileRings[i--] = profileRings.back();
+			profileRings.pop_back();
+		}
+	}
+}
+
+void HLEProfilerSetEnabled(bool enabled) {
+	hleProfilerEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void HLEProfilerReset() {
+	std::lock_guard<std::mutex> guard(profileMutex);
+	MergeRings();
+	profileEntries.clear();
+}
+
+void HLEProfilerRecord(const HLEFunction *func, u64 nanos, s64 cycles) {
+	HLEProfileRing *ring = threadProfileRing.ring;
+	if (!ring) {
+		ring = new HLEProfileRing();
+		threadProfileRing.ring = ring;
+		std::lock_guard<std::mutex> guard(profileMutex);
+		profileRings.push_back(ring);
+	}
+
+	HLEProfileEvent ev{ func, (u32)std::min(nanos, (u64)0xFFFFFFFF), (s32)std::max(std::min(cycles, (s64)0x7FFFFFFF), (s64)-0x7FFFFFFF) };
+	if (!ring->Push(ev)) {
+		std::lock_guard<std::mutex> guard(profileMutex);
+		MergeRings();
+		ring->Push(ev);
+	}
+}
+
+std::vector<HLEProfileEntry> HLEProfilerSnapshot() {
+	std::vector<HLEProfileEntry> entries;
+	{
+		std::lock_guard<std::mutex> guard(profileMutex);
+		MergeRings();
+		entries.reserve(profileEntries.size());
+		for (const auto &it : profileEntries)
+			entries.push_back(it.second);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const HLEProfileEntry &a, const HLEProfileEntry &b) {
+		return a.totalNanos > b.totalNanos;
+	});
+	return entries;
+}
+
+u64 HLEProfilerBucketLimit(int bucket) {
+	if (bucket >= HLE_PROFILE_BUCKETS - 1)
+		return 0;
+	return 256ULL << bucket;
+}
+
+void HLEProfilerWriteJson(json::JsonWriter &json, size_t maxEntries) {
+	std::vector<HLEProfileEntry> entries = HLEProfilerSnapshot();
+	if (entries.size() > maxEntries)
+		entries.resize(maxEntries);
+
+	json.writeBool("enabled", hleProfilerEnabled.load(std::memory_order_relaxed));
+	json.pushArray("bucketLimits");
+	for (int i = 0; i < HLE_PROFILE_BUCKETS - 1; ++i)
+		json.writeFloat((double)HLEProfilerBucketLimit(i));
+	json.pop();
+
+	json.pushArray("functions");
+	for (const HLEProfileEntry &entry : entries) {
+		json.pushDict();
+		json.writeString("module", entry.moduleName ? entry.moduleName : "");
+		json.writeString("name", entry.func->name ? entry.func->name : "");
+		json.writeUint("nid", entry.func->ID);
+		// Might not fit in 32 bits, so these are all doubles.
+		json.writeFloat("calls", (double)entry.calls);
+		json.writeFloat("totalNsec", (double)entry.totalNanos);
+		json.writeFloat("avgNsec", (double)(entry.totalNanos / entry.calls));
+		json.writeFloat("maxNsec", (double)entry.maxNanos);
+		json.writeFloat("totalCycles", (double)entry.totalCycles);
+		json.pushArray("histogram");
+		for (int i = 0; i < HLE_PROFILE_BUCKETS; ++i)
+			json.writeFloat((double)entry.histogram[i]);
+		json.pop();
+		json.pop();
+	}
+	json.pop();
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2025- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace json {
+class JsonWriter;
+}
+
+struct HLEFunction;
+
+// Optional syscall profiling: per HLE function call counts, a histogram of host time, and
+// the emulated cycles it ate.  Calls are recorded into per-thread buffers, which are merged
+// when they fill up or when someone asks for the results.
+// Toggled from the debugger thread, checked on every syscall, so read it relaxed.
+extern std::atomic<bool> hleProfilerEnabled;
+
+enum {
+	// Bucket 0 is under 256 ns, each following bucket doubles, the last is everything 4 ms and up.
+	HLE_PROFILE_BUCKETS = 16,
+};
+
+struct HLEProfileEntry {
+	const HLEFunction *func;
+	const char *moduleName;
+	u64 calls;
+	u64 totalNanos;
+	u64 maxNanos;
+	s64 totalCycles;
+	u64 histogram[HLE_PROFILE_BUCKETS];
+};
+
+void HLEProfilerSetEnabled(bool enabled);
+void HLEProfilerReset();
+void HLEProfilerRecord(const HLEFunction *func, u64 nanos, s64 cycles);
+
+// Sorted by total host time, most first.
+std::vector<HLEProfileEntry> HLEProfilerSnapshot();
+// Upper limit (exclusive) of a histogram bucket, in nanoseconds.  0 for the last, unbounded one.
+u64 HLEProfilerBucketLimit(int bucket);
+// Writes "enabled", "bucketLimits", and "functions" (up to maxEntries) into the current dict.
+void HLEProfilerWriteJson(json::JsonWriter &json, size_t maxEntries);
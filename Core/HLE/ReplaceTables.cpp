@@ -24,6 +24,7 @@
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Log.h"
 #include "Common/Swap.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/Config.h"
 #include "Core/System.h"
 #include "Core/Debugger/Breakpoints.h"
@@ -54,6 +55,26 @@ enum class GPUReplacementSkip {
 
 static int skipGPUReplacements = 0;
 
+// Below these, a plain memcpy on the emu thread wins.  Streaming is only for VRAM, which the
+// game rarely reads back, so it's not worth evicting its working set for.
+static constexpr u32 PARALLEL_COPY_MIN = 512 * 1024;
+static constexpr u32 STREAMING_COPY_MIN = 256 * 1024;
+
+// The caller deals with overlap.
+static void CopyReplaceMemory(u32 destPtr, u8 *dst, const u8 *src, u32 bytes) {
+	if (bytes >= STREAMING_COPY_MIN && Memory::IsVRAMAddress(destPtr)) {
+		StreamingMemcpy(dst, src, bytes);
+	} else if (bytes >= PARALLEL_COPY_MIN) {
+		ParallelMemcpy(&g_threadManager, dst, src, bytes);
+	} else {
+		memcpy(dst, src, bytes);
+	}
+}
+
+static bool RangesOverlap(u32 destPtr, u32 srcPtr, u32 bytes) {
+	return std::min(destPtr, srcPtr) + bytes > std::max(destPtr, srcPtr);
+}
+
 // I think these have to be pretty accurate as these are libc replacements,
 // but we can probably get away with approximating the VFPU vsin/vcos and vrot
 // pretty roughly.
@@ -143,7 +164,7 @@ static int Replace_memcpy() {
 
 		if (!dst || !src) {
 			// Already logged.
-		} else if (std::min(destPtr, srcPtr) + bytes > std::max(destPtr, srcPtr)) {
+		} else if (RangesOverlap(destPtr, srcPtr, bytes)) {
 			// Overlap.  Star Ocean breaks if it's not handled in 16 bytes blocks.
 			const u32 blocks = bytes & ~0x0f;
 			for (u32 offset = 0; offset < blocks; offset += 0x10) {
@@ -153,7 +174,7 @@ static int Replace_memcpy() {
 				dst[offset] = src[offset];
 			}
 		} else {
-			memmove(dst, src, bytes);
+			CopyReplaceMemory(destPtr, dst, src, bytes);
 		}
 	}
 	RETURN(destPtr);
@@ -171,7 +192,7 @@ static int Replace_memcpy() {
 				gpu->PerformWriteFormattedFromMemory(destPtr, bytes, 512, GE_FORMAT_8888);
 			}
 		} else {
-			NotifyMemInfoCopy(destPtr, srcPtr, bytes, "ReplaceMemcpy/");
+			NotifyMemInfoRun(destPtr, srcPtr, bytes, "ReplaceMemcpy/");
 		}
 	}
 
@@ -273,13 +294,16 @@ static int Replace_memcpy16() {
 		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
 		const u8 *src = Memory::GetPointerRange(srcPtr, bytes);
 		if (dst && src) {
-			memmove(dst, src, bytes);
+			if (RangesOverlap(destPtr, srcPtr, bytes))
+				memmove(dst, src, bytes);
+			else
+				CopyReplaceMemory(destPtr, dst, src, bytes);
 		}
 	}
 	RETURN(destPtr);
 
 	if (MemBlockInfoDetailed(bytes)) {
-		NotifyMemInfoCopy(destPtr, srcPtr, bytes, "ReplaceMemcpy16/");
+		NotifyMemInfoRun(destPtr, srcPtr, bytes, "ReplaceMemcpy16/");
 	}
 
 	return 10 + bytes / 4;  // approximation
@@ -341,13 +365,16 @@ static int Replace_memmove() {
 		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
 		const u8 *src = Memory::GetPointerRange(srcPtr, bytes);
 		if (dst && src) {
-			memmove(dst, src, bytes);
+			if (RangesOverlap(destPtr, srcPtr, bytes))
+				memmove(dst, src, bytes);
+			else
+				CopyReplaceMemory(destPtr, dst, src, bytes);
 		}
 	}
 	RETURN(destPtr);
 
 	if (MemBlockInfoDetailed(bytes)) {
-		NotifyMemInfoCopy(destPtr, srcPtr, bytes, "ReplaceMemmove/");
+		NotifyMemInfoRun(destPtr, srcPtr, bytes, "ReplaceMemmove/");
 	}
 
 	return 10 + bytes / 4;  // approximation
@@ -364,12 +391,17 @@ static int Replace_memset() {
 	if (!skip && bytes != 0) {
 		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
 		if (dst) {
-			memset(dst, value, bytes);
+			if (bytes >= STREAMING_COPY_MIN && Memory::IsVRAMAddress(destPtr))
+				StreamingMemset(dst, value, bytes);
+			else if (bytes >= PARALLEL_COPY_MIN)
+				ParallelMemset(&g_threadManager, dst, value, bytes);
+			else
+				memset(dst, value, bytes);
 		}
 	}
 	RETURN(destPtr);
 
-	NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceMemset");
+	NotifyMemInfoRun(destPtr, 0, bytes, "ReplaceMemset");
 
 	return 10 + bytes / 4;  // approximation
 }
@@ -1619,6 +1651,7 @@ void Replacement_Init() {
 }
 
 void Replacement_Shutdown() {
+	FlushMemInfoRun();
 	replacedInstructions.clear();
 	replacementNameLookup.clear();
 }
@@ -41,6 +41,7 @@
 #include "Core/FrameTiming.h"
 #include "Core/Reporting.h"
 #include "Core/Core.h"
+#include "Core/Debugger/MemBlockInfo.h"
 #include "Core/System.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
@@ -565,6 +566,7 @@ static void NotifyUserIfSlow() {
 
 void __DisplayFlip(int cyclesLate) {
 	__DisplaySetFramerate();
+	FlushMemInfoRun();
 
 	flippedThisFrame = true;
 	// We flip only if the framebuffer was dirty. This eliminates flicker when using
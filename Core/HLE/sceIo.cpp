@@ -809,6 +809,27 @@ static std::string IODetermineFilename(const FileNode *f) {
 	return StringFromFormat("%s offset 0x%08llx", f->fullpath.c_str(), offset);
 }
 
+void __IoGetAsyncStats(AsyncIOStats *stats, bool reset) {
+	for (int i = 0; i < IO_CLASS_COUNT; ++i)
+		stats[i] = ioManager.GetStats((AsyncIOClass)i);
+	if (reset)
+		ioManager.ResetStats();
+}
+
+int __IoQueuedAsyncRequests() {
+	return ioManager.QueuedRequests();
+}
+
+// Roughly where the next read will come from on the disc, for ordering async reads.
+static s64 IODiscPosition(FileNode *f) {
+	if (!(pspFileSystem.FlagsFromFilename(f->fullpath) & FileSystemFlags::UMD))
+		return -1;
+	u64 offset = pspFileSystem.GetSeekPos(f->handle);
+	if ((pspFileSystem.DevType(f->handle) & PSPDevType::BLOCK) != 0)
+		return (s64)(offset * 2048);
+	return (s64)f->FileInfo().startSector * 2048 + (s64)offset;
+}
+
 u32 __IoGetFileHandleFromId(u32 id, u32 &outError)
 {
 	FileNode *f = __IoGetFd(id, outError);
@@ -1101,6 +1122,7 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 				ev.buf = data;
 				ev.bytes = validSize;
 				ev.invalidateAddr = data_addr;
+				ev.discPosition = IODiscPosition(f);
 				ioManager.ScheduleOperation(ev);
 				return false;
 			} else {
@@ -35,6 +35,11 @@ u32 sceIoIoctl(u32 id, u32 cmd, u32 indataPtr, u32 inlen, u32 outdataPtr, u32 ou
 int __IoIoctl(u32 id, u32 cmd, u32 indataPtr, u32 inlen, u32 outdataPtr, u32 outlen, int &usec);
 
 u32 __IoGetFileHandleFromId(u32 id, u32 &outError);
+
+struct AsyncIOStats;
+// Fills IO_CLASS_COUNT entries with host timings of operations run on the io thread.
+void __IoGetAsyncStats(AsyncIOStats *stats, bool reset);
+int __IoQueuedAsyncRequests();
 void __IoCopyDate(ScePspDateTime& date_out, const tm& date_in);
 
 KernelObject *__KernelFileNodeObject();
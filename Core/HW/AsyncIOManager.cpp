@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <climits>
 #include <condition_variable>
 #include <mutex>
 
@@ -22,6 +24,7 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
 #include "Common/Serialize/SerializeSet.h"
+#include "Common/TimeUtil.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
@@ -39,6 +42,11 @@ bool AsyncIOManager::HasOperation(u32 handle) {
 	return false;
 }
 
+// Reads up to this size are assumed to be streaming audio/video, and are run first.
+static const size_t STREAMING_READ_MAX = 64 * 1024;
+// Anything waiting longer than this (host time) goes next, so bulk loads can't starve.
+static const double MAX_QUEUE_WAIT = 0.025;
+
 void AsyncIOManager::ScheduleOperation(const AsyncIOEvent &ev) {
 	{
 		std::lock_guard<std::mutex> guard(resultsLock_);
@@ -46,15 +54,108 @@ void AsyncIOManager::ScheduleOperation(const AsyncIOEvent &ev) {
 			ERROR_LOG_REPORT(Log::sceIo, "Scheduling operation for file %d while one is pending (type %d)", ev.handle, ev.type);
 		}
 	}
+
+	AsyncIOClass ioClass = IO_CLASS_WRITE;
+	if (ev.type == IO_EVENT_READ)
+		ioClass = ev.bytes <= STREAMING_READ_MAX ? IO_CLASS_STREAMING : IO_CLASS_BULK;
+	{
+		std::lock_guard<std::mutex> guard(requestsLock_);
+		requests_.push_back(Request{ ev, ioClass, time_now_d(), false });
+	}
 	ScheduleEvent(ev);
 }
 
 void AsyncIOManager::Shutdown() {
+	{
+		std::lock_guard<std::mutex> guard(requestsLock_);
+		requests_.clear();
+		discHead_ = 0;
+	}
 	std::lock_guard<std::mutex> guard(resultsLock_);
 	resultsPending_.clear();
 	results_.clear();
 }
 
+bool AsyncIOManager::TakeNextRequest(Request &req) {
+	std::lock_guard<std::mutex> guard(requestsLock_);
+	if (requests_.empty())
+		return false;
+
+	// Only one operation per file is ever pending, so any order is safe.  Ranked by:
+	// 1. Anything the emu thread is blocked on, or that has waited too long, oldest first.
+	// 2. Streaming reads, then bulk reads and writes.
+	// 3. Elevator order by disc position (continuing upward from the last read, then wrapping),
+	//    with anything not on the disc first.
+	double now = time_now_d();
+	size_t best = 0;
+	int bestTier = INT_MAX;
+	u64 bestKey = 0;
+	for (size_t i = 0; i < requests_.size(); ++i) {
+		const Request &r = requests_[i];
+		int tier;
+		u64 key = 0;
+		if (r.urgent || now - r.queuedTime >= MAX_QUEUE_WAIT) {
+			tier = 0;
+		} else {
+			tier = r.ioClass == IO_CLASS_STREAMING ? 1 : 2;
+			if (r.ev.discPosition >= discHead_)
+				key = 1 + (u64)(r.ev.discPosition - discHead_);
+			else if (r.ev.discPosition >= 0)
+				key = 0x8000000000000000ULL + (u64)r.ev.discPosition;
+		}
+
+		// Ties go to the oldest.
+		if (tier < bestTier || (tier == bestTier && key < bestKey)) {
+			best = i;
+			bestTier = tier;
+			bestKey = key;
+		}
+	}
+
+	req = requests_[best];
+	requests_.erase(requests_.begin() + best);
+	if (req.ev.discPosition >= 0)
+		discHead_ = req.ev.discPosition + (s64)req.ev.bytes;
+	return true;
+}
+
+void AsyncIOManager::BoostRequest(u32 handle) {
+	std::lock_guard<std::mutex> guard(requestsLock_);
+	for (Request &r : requests_) {
+		if (r.ev.handle == handle)
+			r.urgent = true;
+	}
+}
+
+void AsyncIOManager::RecordStats(const Request &req, double startTime, double endTime) {
+	std::lock_guard<std::mutex> guard(requestsLock_);
+	AsyncIOStats &stats = stats_[req.ioClass];
+	double wait = startTime - req.queuedTime;
+	double service = endTime - startTime;
+	stats.count++;
+	stats.bytes += req.ev.bytes;
+	stats.totalWait += wait;
+	stats.maxWait = std::max(stats.maxWait, wait);
+	stats.totalService += service;
+	stats.maxService = std::max(stats.maxService, service);
+}
+
+AsyncIOStats AsyncIOManager::GetStats(AsyncIOClass ioClass) {
+	std::lock_guard<std::mutex> guard(requestsLock_);
+	return stats_[ioClass];
+}
+
+void AsyncIOManager::ResetStats() {
+	std::lock_guard<std::mutex> guard(requestsLock_);
+	for (AsyncIOStats &stats : stats_)
+		stats = AsyncIOStats{};
+}
+
+int AsyncIOManager::QueuedRequests() {
+	std::lock_guard<std::mutex> guard(requestsLock_);
+	return (int)requests_.size();
+}
+
 bool AsyncIOManager::HasResult(u32 handle) {
 	std::lock_guard<std::mutex> guard(resultsLock_);
 	return results_.find(handle) != results_.end();
@@ -87,6 +188,7 @@ bool AsyncIOManager::ReadResult(u32 handle, AsyncIOResult &result) {
 }
 
 bool AsyncIOManager::WaitResult(u32 handle, AsyncIOResult &result) {
+	BoostRequest(handle);
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
 	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
@@ -101,6 +203,7 @@ bool AsyncIOManager::WaitResult(u32 handle, AsyncIOResult &result) {
 u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 	AsyncIOResult result;
 
+	BoostRequest(handle);
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
 	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
@@ -116,7 +219,18 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 	return 0;
 }
 
-void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
+void AsyncIOManager::ProcessEvent(AsyncIOEvent ref) {
+	// The event itself just says there's a request to run, but not necessarily this one.
+	Request req{ ref, IO_CLASS_WRITE, 0.0, false };
+	if (ref.type == IO_EVENT_READ || ref.type == IO_EVENT_WRITE) {
+		if (!TakeNextRequest(req)) {
+			ERROR_LOG_REPORT(Log::sceIo, "IO event without a request");
+			return;
+		}
+	}
+
+	const AsyncIOEvent &ev = req.ev;
+	double startTime = time_now_d();
 	switch (ev.type) {
 	case IO_EVENT_READ:
 		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr);
@@ -128,7 +242,9 @@ void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 
 	default:
 		ERROR_LOG_REPORT(Log::sceIo, "Unsupported IO event type");
+		return;
 	}
+	RecordStats(req, startTime, time_now_d());
 }
 
 void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr) {
@@ -20,7 +20,10 @@
 #include <map>
 #include <set>
 #include <mutex>
+#include <vector>
 
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
 #include "Core/ThreadEventQueue.h"
 
 class NoBase {
@@ -34,6 +37,16 @@ enum AsyncIOEventType {
 	IO_EVENT_WRITE,
 };
 
+// Operations are not run in the order scheduled, see AsyncIOManager::TakeNextRequest().
+enum AsyncIOClass {
+	// Small reads, likely audio or video streaming, which go ahead of bulk loads.
+	IO_CLASS_STREAMING,
+	IO_CLASS_BULK,
+	IO_CLASS_WRITE,
+
+	IO_CLASS_COUNT,
+};
+
 struct AsyncIOEvent {
 	AsyncIOEvent(AsyncIOEventType t) : type(t) {}
 	AsyncIOEventType type;
@@ -41,6 +54,8 @@ struct AsyncIOEvent {
 	u8 *buf;
 	size_t bytes;
 	u32 invalidateAddr;
+	// Byte offset on the disc image, used to order reads.  -1 if not on a disc.
+	s64 discPosition = -1;
 
 	operator AsyncIOEventType() const {
 		return type;
@@ -77,6 +92,16 @@ struct AsyncIOResult {
 	u32 invalidateAddr;
 };
 
+// Host time spent by operations, from scheduling until they started and while running.
+struct AsyncIOStats {
+	u64 count;
+	u64 bytes;
+	double totalWait;
+	double maxWait;
+	double totalService;
+	double maxService;
+};
+
 typedef ThreadEventQueue<NoBase, AsyncIOEvent, AsyncIOEventType, IO_EVENT_INVALID, IO_EVENT_SYNC, IO_EVENT_FINISH> IOThreadEventQueue;
 class AsyncIOManager : public IOThreadEventQueue {
 public:
@@ -90,6 +115,10 @@ class AsyncIOManager : public IOThreadEventQueue {
 	bool WaitResult(u32 handle, AsyncIOResult &result);
 	u64 ResultFinishTicks(u32 handle);
 
+	AsyncIOStats GetStats(AsyncIOClass ioClass);
+	void ResetStats();
+	int QueuedRequests();
+
 protected:
 	void ProcessEvent(AsyncIOEvent ref) override;
 	bool ShouldExitEventLoop() override {
@@ -97,6 +126,18 @@ class AsyncIOManager : public IOThreadEventQueue {
 	}
 
 private:
+	struct Request {
+		AsyncIOEvent ev;
+		AsyncIOClass ioClass;
+		double queuedTime;
+		// Set when the emu thread blocks on the result.
+		bool urgent;
+	};
+
+	bool TakeNextRequest(Request &req);
+	void BoostRequest(u32 handle);
+	void RecordStats(const Request &req, double startTime, double endTime);
+
 	bool PopResult(u32 handle, AsyncIOResult &result);
 	bool ReadResult(u32 handle, AsyncIOResult &result);
 	void Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr);
@@ -108,4 +149,11 @@ class AsyncIOManager : public IOThreadEventQueue {
 	std::condition_variable resultsWait_;
 	std::set<u32> resultsPending_;
 	std::map<u32, AsyncIOResult> results_;
+
+	// Scheduled but not yet started, in the order scheduled.  Each has an event in the queue,
+	// which runs whichever request is best at the time.
+	std::mutex requestsLock_;
+	std::vector<Request> requests_;
+	s64 discHead_ = 0;
+	AsyncIOStats stats_[IO_CLASS_COUNT]{};
 };
@@ -83,6 +83,12 @@ class FileLoader {
 		return ReadAt(absolutePos, 1, bytes, data, flags);
 	}
 
+	// How far caching loaders should read ahead of the last read, or 0 to use their default.
+	// Remote loaders can size this to cover their latency.
+	virtual s64 ReadAheadSize() {
+		return 0;
+	}
+
 	// Cancel any operations that might block, if possible.
 	virtual void Cancel() {}
 
@@ -129,6 +135,9 @@ class ProxiedFileLoader : public FileLoader {
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override {
 		return backend_->ReadAt(absolutePos, bytes, data, flags);
 	}
+	s64 ReadAheadSize() override {
+		return backend_->ReadAheadSize();
+	}
 
 protected:
 	FileLoader *backend_;
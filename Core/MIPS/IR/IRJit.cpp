@@ -73,6 +73,9 @@ IRJit::IRJit(MIPSState *mipsState, bool actualJit) : frontend_(mipsState->HasDef
 #endif
 	opts.optimizeForInterpreter = jo.optimizeForInterpreter;
 	frontend_.SetOptions(opts);
+
+	useThreadedInterpreter_ = !actualJit && !jo.Disabled(JitDisable::IR_THREADED);
+	blocks_.SetUseThreadedInterpreter(useThreadedInterpreter_);
 }
 
 IRJit::~IRJit() {
@@ -291,7 +294,10 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 				block->profileStats_.executions += 1;
 				block->profileStats_.totalNanos += elapsedNanos;
 #else
-				mips->pc = IRInterpret(mips, instPtr);
+				if (useThreadedInterpreter_)
+					mips->pc = IRThreadedInterpret(mips, blocks_.GetThreadedArenaPtr() + offset + 1);
+				else
+					mips->pc = IRInterpret(mips, instPtr);
 #endif
 				// Note: this will "jump to zero" on a badly constructed block missing exits.
 				if (!Memory::IsValid4AlignedAddress(mips->pc)) {
@@ -342,6 +348,8 @@ void IRBlockCache::Clear() {
 	byPage_.clear();
 	arena_.clear();
 	arena_.shrink_to_fit();
+	threadedArena_.clear();
+	threadedArena_.shrink_to_fit();
 }
 
 IRBlockCache::IRBlockCache(bool compileToNative) : compileToNative_(compileToNative) {}
@@ -358,6 +366,10 @@ int IRBlockCache::AllocateBlock(int emAddr, u32 origSize, const std::vector<IRIn
 	for (int i = 0; i < insts.size(); i++) {
 		arena_.push_back(insts[i]);
 	}
+	if (useThreaded_) {
+		threadedArena_.resize(arena_.size());
+		IRThreadedDecode(insts.data(), (int)insts.size(), threadedArena_.data() + offset);
+	}
 	int newBlockIndex = (int)blocks_.size();
 	blocks_.push_back(IRBlock(emAddr, origSize, offset, (u32)insts.size()));
 	return newBlockIndex;
@@ -27,6 +27,7 @@
 #include "Core/MIPS/IR/IRRegCache.h"
 #include "Core/MIPS/IR/IRInst.h"
 #include "Core/MIPS/IR/IRFrontend.h"
+#include "Core/MIPS/IR/IRThreadedInterpreter.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 
 #ifndef offsetof
@@ -118,6 +119,10 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	IRBlockCache(bool compileToNative);
 
 	void Clear();
+	// Also keeps a pre-decoded copy of each block for IRThreadedInterpret, at the same offsets.
+	void SetUseThreadedInterpreter(bool use) {
+		useThreaded_ = use;
+	}
 	std::vector<int> FindInvalidatedBlockNumbers(u32 address, u32 length);
 	void FinalizeBlock(int blockNum, bool preload = false);
 	int GetNumBlocks() const override { return (int)blocks_.size(); }
@@ -140,6 +145,9 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	const IRInst *GetArenaPtr() const {
 		return arena_.data();
 	}
+	const IRThreadedInst *GetThreadedArenaPtr() const {
+		return threadedArena_.data();
+	}
 	bool IsValidBlock(int blockNum) const override {
 		return blockNum >= 0 && blockNum < (int)blocks_.size() && blocks_[blockNum].IsValid();
 	}
@@ -194,6 +202,8 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	bool compileToNative_;
 	std::vector<IRBlock> blocks_;
 	std::vector<IRInst> arena_;
+	std::vector<IRThreadedInst> threadedArena_;
+	bool useThreaded_ = false;
 	std::unordered_map<u32, std::vector<int>> byPage_;
 };
 
@@ -249,6 +259,7 @@ class IRJit : public JitInterface {
 	MIPSState *mips_;
 
 	bool compilerEnabled_ = true;
+	bool useThreadedInterpreter_ = false;
 
 	// where to write branch-likely trampolines. not used atm
 	// u32 blTrampolines_;
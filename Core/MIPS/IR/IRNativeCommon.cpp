@@ -537,6 +537,47 @@ bool IRNativeJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 	if (offset == -1)
 		return false;
 
+	int block_offset = INT_MAX;
+	int block_num = FindBlockFromOffset(offset, &block_offset);
+
+	// Used by profiling tools that don't like spaces.
+	if (block_num == -1) {
+		name = "unknownOrDeletedBlock";
+		return true;
+	}
+
+	const IRBlock *block = blocks_.GetBlock(block_num);
+	if (block) {
+		u32 start = 0, size = 0;
+		block->GetRange(start, size);
+
+		// It helps to know which func this block is inside.
+		const std::string label = g_symbolMap ? g_symbolMap->GetDescription(start) : "";
+		if (!label.empty())
+			name = StringFromFormat("block%d_%08x_%s_0x%x", block_num, start, label.c_str(), block_offset);
+		else
+			name = StringFromFormat("block%d_%08x_0x%x", block_num, start, block_offset);
+		return true;
+	}
+	return false;
+}
+
+u32 IRNativeJit::GetBlockAddressFromCodePtr(const u8 *ptr) {
+	int offset = backend_->OffsetFromCodePtr(ptr);
+	if (offset == -1)
+		return 0;
+
+	int block_offset;
+	int block_num = FindBlockFromOffset(offset, &block_offset);
+	const IRBlock *block = block_num == -1 ? nullptr : blocks_.GetBlock(block_num);
+	if (!block)
+		return 0;
+	u32 start = 0, size = 0;
+	block->GetRange(start, size);
+	return start;
+}
+
+int IRNativeJit::FindBlockFromOffset(int offset, int *blockOffset) const {
 	int block_num = -1;
 	int block_offset = INT_MAX;
 	for (int i = 0; i < blocks_.GetNumBlocks(); ++i) {
@@ -561,26 +602,8 @@ bool IRNativeJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 		}
 	}
 
-	// Used by profiling tools that don't like spaces.
-	if (block_num == -1) {
-		name = "unknownOrDeletedBlock";
-		return true;
-	}
-
-	const IRBlock *block = blocks_.GetBlock(block_num);
-	if (block) {
-		u32 start = 0, size = 0;
-		block->GetRange(start, size);
-
-		// It helps to know which func this block is inside.
-		const std::string label = g_symbolMap ? g_symbolMap->GetDescription(start) : "";
-		if (!label.empty())
-			name = StringFromFormat("block%d_%08x_%s_0x%x", block_num, start, label.c_str(), block_offset);
-		else
-			name = StringFromFormat("block%d_%08x_0x%x", block_num, start, block_offset);
-		return true;
-	}
-	return false;
+	*blockOffset = block_offset;
+	return block_num;
 }
 
 bool IRNativeJit::CodeInRange(const u8 *ptr) const {
@@ -187,6 +187,7 @@ class IRNativeJit : public IRJit {
 	void ClearCache() override;
 
 	bool DescribeCodePtr(const u8 *ptr, std::string &name) override;
+	u32 GetBlockAddressFromCodePtr(const u8 *ptr) override;
 	bool CodeInRange(const u8 *ptr) const override;
 	bool IsAtDispatchFetch(const u8 *ptr) const override;
 	const u8 *GetDispatcher() const override;
@@ -200,6 +201,7 @@ class IRNativeJit : public IRJit {
 	void Init(IRNativeBackend &backend);
 	bool CompileNativeBlock(IRBlockCache *irBlockCache, int block_num, bool preload) override;
 	void FinalizeNativeBlock(IRBlockCache *irBlockCache, int block_num) override;
+	int FindBlockFromOffset(int offset, int *blockOffset) const;
 
 	IRNativeBackend *backend_ = nullptr;
 	IRNativeHooks hooks_;
@@ -0,0 +1,483 @@
+#include <cstring>
+
+#include "ppsspp_config.h"
+#include "Common/Common.h"
+#include "Common/BitScan.h"
+#include "Common/Data/Convert/SmallDataConvert.h"
+
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/IR/IRThreadedInterpreter.h"
+
+#ifdef mips
+// Why do MIPS compilers define something so generic?  Try to keep defined, at least...
+#undef mips
+#define mips mips
+#endif
+
+// MSVC doesn't support labels as values, so it gets a plain switch over the handler index.
+#if defined(__GNUC__) || defined(__clang__)
+#define IR_THREADED_GOTO 1
+#endif
+
+// Returned by IRInterpret for a single op followed by this exit, when it didn't exit early.
+static const u32 FALLBACK_CONTINUE = 0xFFFFFFFF;
+
+#define IR_THREADED_HANDLERS(X) \
+	X(Fallback) \
+	X(SetConst) X(Add) X(Sub) X(And) X(Or) X(Xor) X(Mov) \
+	X(AddConst) X(OptAddConst) X(SubConst) X(AndConst) X(OptAndConst) X(OrConst) X(OptOrConst) X(XorConst) \
+	X(ShlImm) X(ShrImm) X(SarImm) X(Clz) \
+	X(MtLo) X(MtHi) X(MfLo) X(MfHi) X(Mult) X(MultU) \
+	X(Slt) X(SltU) X(SltConst) X(SltUConst) \
+	X(Load8) X(Load8Ext) X(Load16) X(Load16Ext) X(Load32) X(LoadFloat) \
+	X(Store8) X(Store16) X(Store32) X(StoreFloat) \
+	X(LoadVec4) X(StoreVec4) X(Vec4Mov) X(Vec4Add) X(Vec4Sub) X(Vec4Mul) X(Vec4Scale) \
+	X(FMov) X(FAdd) X(FSub) \
+	X(ExitToConst) X(ExitToReg) X(ExitToPC) \
+	X(ExitToConstIfEq) X(ExitToConstIfNeq) X(ExitToConstIfGtZ) X(ExitToConstIfGeZ) X(ExitToConstIfLtZ) X(ExitToConstIfLeZ) \
+	X(AddConst_Load32) X(Load32_AddConst) \
+	X(Slt_ExitToConstIfEq) X(Slt_ExitToConstIfNeq) X(SltU_ExitToConstIfEq) X(SltU_ExitToConstIfNeq) \
+	X(SltConst_ExitToConstIfEq) X(SltConst_ExitToConstIfNeq) X(SltUConst_ExitToConstIfEq) X(SltUConst_ExitToConstIfNeq) \
+	X(Vec4Mul_Vec4Add) X(Vec4Scale_Vec4Add)
+
+enum IRThreadedHandler {
+#define IR_THREADED_ENUM(name) IRH_##name,
+	IR_THREADED_HANDLERS(IR_THREADED_ENUM)
+#undef IR_THREADED_ENUM
+	IRH_COUNT,
+};
+
+// The bodies of the ops, shared between the single and fused handlers.
+// These must match IRInterpret exactly.
+
+static inline void DoAddConst(MIPSState *mips, const IRInst &inst) {
+	mips->r[inst.dest] = mips->r[inst.src1] + inst.constant;
+}
+
+static inline void DoLoad32(MIPSState *mips, const IRInst &inst) {
+	mips->r[inst.dest] = Memory::ReadUnchecked_U32(mips->r[inst.src1] + inst.constant);
+}
+
+static inline void DoSlt(MIPSState *mips, const IRInst &inst) {
+	mips->r[inst.dest] = (s32)mips->r[inst.src1] < (s32)mips->r[inst.src2];
+}
+
+static inline void DoSltU(MIPSState *mips, const IRInst &inst) {
+	mips->r[inst.dest] = mips->r[inst.src1] < mips->r[inst.src2];
+}
+
+static inline void DoSltConst(MIPSState *mips, const IRInst &inst) {
+	mips->r[inst.dest] = (s32)mips->r[inst.src1] < (s32)inst.constant;
+}
+
+static inline void DoSltUConst(MIPSState *mips, const IRInst &inst) {
+	mips->r[inst.dest] = mips->r[inst.src1] < inst.constant;
+}
+
+static inline void DoVec4Add(MIPSState *mips, const IRInst &inst) {
+#if defined(_M_SSE)
+	_mm_store_ps(&mips->f[inst.dest], _mm_add_ps(_mm_load_ps(&mips->f[inst.src1]), _mm_load_ps(&mips->f[inst.src2])));
+#elif PPSSPP_ARCH(ARM_NEON)
+	vst1q_f32(&mips->f[inst.dest], vaddq_f32(vld1q_f32(&mips->f[inst.src1]), vld1q_f32(&mips->f[inst.src2])));
+#else
+	for (int i = 0; i < 4; i++)
+		mips->f[inst.dest + i] = mips->f[inst.src1 + i] + mips->f[inst.src2 + i];
+#endif
+}
+
+static inline void DoVec4Sub(MIPSState *mips, const IRInst &inst) {
+#if defined(_M_SSE)
+	_mm_store_ps(&mips->f[inst.dest], _mm_sub_ps(_mm_load_ps(&mips->f[inst.src1]), _mm_load_ps(&mips->f[inst.src2])));
+#elif PPSSPP_ARCH(ARM_NEON)
+	vst1q_f32(&mips->f[inst.dest], vsubq_f32(vld1q_f32(&mips->f[inst.src1]), vld1q_f32(&mips->f[inst.src2])));
+#else
+	for (int i = 0; i < 4; i++)
+		mips->f[inst.dest + i] = mips->f[inst.src1 + i] - mips->f[inst.src2 + i];
+#endif
+}
+
+static inline void DoVec4Mul(MIPSState *mips, const IRInst &inst) {
+#if defined(_M_SSE)
+	_mm_store_ps(&mips->f[inst.dest], _mm_mul_ps(_mm_load_ps(&mips->f[inst.src1]), _mm_load_ps(&mips->f[inst.src2])));
+#elif PPSSPP_ARCH(ARM_NEON)
+	vst1q_f32(&mips->f[inst.dest], vmulq_f32(vld1q_f32(&mips->f[inst.src1]), vld1q_f32(&mips->f[inst.src2])));
+#else
+	for (int i = 0; i < 4; i++)
+		mips->f[inst.dest + i] = mips->f[inst.src1 + i] * mips->f[inst.src2 + i];
+#endif
+}
+
+static inline void DoVec4Scale(MIPSState *mips, const IRInst &inst) {
+#if defined(_M_SSE)
+	_mm_store_ps(&mips->f[inst.dest], _mm_mul_ps(_mm_load_ps(&mips->f[inst.src1]), _mm_set1_ps(mips->f[inst.src2])));
+#elif PPSSPP_ARCH(ARM_NEON)
+	vst1q_f32(&mips->f[inst.dest], vmulq_lane_f32(vld1q_f32(&mips->f[inst.src1]), vdup_n_f32(mips->f[inst.src2]), 0));
+#else
+	const float factor = mips->f[inst.src2];
+	for (int i = 0; i < 4; i++)
+		mips->f[inst.dest + i] = mips->f[inst.src1 + i] * factor;
+#endif
+}
+
+static const void *const *g_threadedLabels = nullptr;
+
+u32 IRThreadedInterpret(MIPSState *mips, const IRThreadedInst *inst) {
+#ifdef IR_THREADED_GOTO
+	static const void *const labels[IRH_COUNT] = {
+#define IR_THREADED_LABEL(name) &&L_##name,
+		IR_THREADED_HANDLERS(IR_THREADED_LABEL)
+#undef IR_THREADED_LABEL
+	};
+
+	// Called by IRThreadedDecode to fetch the label table.
+	if (!inst) {
+		g_threadedLabels = labels;
+		return 0;
+	}
+
+#define HANDLER(name) L_##name:
+#define NEXT(n) do { inst += (n); goto *inst->label; } while (false)
+	goto *inst->label;
+#else
+#define HANDLER(name) case IRH_##name:
+#define NEXT(n) do { inst += (n); goto dispatch; } while (false)
+dispatch:
+	switch ((IRThreadedHandler)inst->handler) {
+#endif
+
+	HANDLER(Fallback) {
+		const IRInst temp[2] = {
+			inst->inst,
+			{ IROp::ExitToConst, { 0 }, 0, 0, FALLBACK_CONTINUE },
+		};
+		u32 pc = IRInterpret(mips, temp);
+		if (pc != FALLBACK_CONTINUE)
+			return pc;
+		NEXT(1);
+	}
+
+	HANDLER(SetConst)
+		mips->r[inst->inst.dest] = inst->inst.constant;
+		NEXT(1);
+	HANDLER(Add)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] + mips->r[inst->inst.src2];
+		NEXT(1);
+	HANDLER(Sub)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] - mips->r[inst->inst.src2];
+		NEXT(1);
+	HANDLER(And)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] & mips->r[inst->inst.src2];
+		NEXT(1);
+	HANDLER(Or)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] | mips->r[inst->inst.src2];
+		NEXT(1);
+	HANDLER(Xor)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] ^ mips->r[inst->inst.src2];
+		NEXT(1);
+	HANDLER(Mov)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1];
+		NEXT(1);
+	HANDLER(AddConst)
+		DoAddConst(mips, inst->inst);
+		NEXT(1);
+	HANDLER(OptAddConst)
+		mips->r[inst->inst.dest] += inst->inst.constant;
+		NEXT(1);
+	HANDLER(SubConst)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] - inst->inst.constant;
+		NEXT(1);
+	HANDLER(AndConst)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] & inst->inst.constant;
+		NEXT(1);
+	HANDLER(OptAndConst)
+		mips->r[inst->inst.dest] &= inst->inst.constant;
+		NEXT(1);
+	HANDLER(OrConst)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] | inst->inst.constant;
+		NEXT(1);
+	HANDLER(OptOrConst)
+		mips->r[inst->inst.dest] |= inst->inst.constant;
+		NEXT(1);
+	HANDLER(XorConst)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] ^ inst->inst.constant;
+		NEXT(1);
+
+	HANDLER(ShlImm)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] << (int)inst->inst.src2;
+		NEXT(1);
+	HANDLER(ShrImm)
+		mips->r[inst->inst.dest] = mips->r[inst->inst.src1] >> (int)inst->inst.src2;
+		NEXT(1);
+	HANDLER(SarImm)
+		mips->r[inst->inst.dest] = (s32)mips->r[inst->inst.src1] >> (int)inst->inst.src2;
+		NEXT(1);
+	HANDLER(Clz)
+		mips->r[inst->inst.dest] = clz32(mips->r[inst->inst.src1]);
+		NEXT(1);
+
+	HANDLER(MtLo)
+		mips->lo = mips->r[inst->inst.src1];
+		NEXT(1);
+	HANDLER(MtHi)
+		mips->hi = mips->r[inst->inst.src1];
+		NEXT(1);
+	HANDLER(MfLo)
+		mips->r[inst->inst.dest] = mips->lo;
+		NEXT(1);
+	HANDLER(MfHi)
+		mips->r[inst->inst.dest] = mips->hi;
+		NEXT(1);
+	HANDLER(Mult) {
+		s64 result = (s64)(s32)mips->r[inst->inst.src1] * (s64)(s32)mips->r[inst->inst.src2];
+		memcpy(&mips->lo, &result, 8);
+		NEXT(1);
+	}
+	HANDLER(MultU) {
+		u64 result = (u64)mips->r[inst->inst.src1] * (u64)mips->r[inst->inst.src2];
+		memcpy(&mips->lo, &result, 8);
+		NEXT(1);
+	}
+
+	HANDLER(Slt)
+		DoSlt(mips, inst->inst);
+		NEXT(1);
+	HANDLER(SltU)
+		DoSltU(mips, inst->inst);
+		NEXT(1);
+	HANDLER(SltConst)
+		DoSltConst(mips, inst->inst);
+		NEXT(1);
+	HANDLER(SltUConst)
+		DoSltUConst(mips, inst->inst);
+		NEXT(1);
+
+	HANDLER(Load8)
+		mips->r[inst->inst.dest] = Memory::ReadUnchecked_U8(mips->r[inst->inst.src1] + inst->inst.constant);
+		NEXT(1);
+	HANDLER(Load8Ext)
+		mips->r[inst->inst.dest] = SignExtend8ToU32(Memory::ReadUnchecked_U8(mips->r[inst->inst.src1] + inst->inst.constant));
+		NEXT(1);
+	HANDLER(Load16)
+		mips->r[inst->inst.dest] = Memory::ReadUnchecked_U16(mips->r[inst->inst.src1] + inst->inst.constant);
+		NEXT(1);
+	HANDLER(Load16Ext)
+		mips->r[inst->inst.dest] = SignExtend16ToU32(Memory::ReadUnchecked_U16(mips->r[inst->inst.src1] + inst->inst.constant));
+		NEXT(1);
+	HANDLER(Load32)
+		DoLoad32(mips, inst->inst);
+		NEXT(1);
+	HANDLER(LoadFloat)
+		mips->f[inst->inst.dest] = Memory::ReadUnchecked_Float(mips->r[inst->inst.src1] + inst->inst.constant);
+		NEXT(1);
+
+	HANDLER(Store8)
+		Memory::WriteUnchecked_U8(mips->r[inst->inst.src3], mips->r[inst->inst.src1] + inst->inst.constant);
+		NEXT(1);
+	HANDLER(Store16)
+		Memory::WriteUnchecked_U16(mips->r[inst->inst.src3], mips->r[inst->inst.src1] + inst->inst.constant);
+		NEXT(1);
+	HANDLER(Store32)
+		Memory::WriteUnchecked_U32(mips->r[inst->inst.src3], mips->r[inst->inst.src1] + inst->inst.constant);
+		NEXT(1);
+	HANDLER(StoreFloat)
+		Memory::WriteUnchecked_Float(mips->f[inst->inst.src3], mips->r[inst->inst.src1] + inst->inst.constant);
+		NEXT(1);
+
+	HANDLER(LoadVec4)
+		memcpy(&mips->f[inst->inst.dest], Memory::GetPointerUnchecked(mips->r[inst->inst.src1] + inst->inst.constant), 4 * 4);
+		NEXT(1);
+	HANDLER(StoreVec4)
+		memcpy((float *)Memory::GetPointerUnchecked(mips->r[inst->inst.src1] + inst->inst.constant), &mips->f[inst->inst.dest], 4 * 4);
+		NEXT(1);
+	HANDLER(Vec4Mov)
+		memcpy(&mips->f[inst->inst.dest], &mips->f[inst->inst.src1], 4 * sizeof(float));
+		NEXT(1);
+	HANDLER(Vec4Add)
+		DoVec4Add(mips, inst->inst);
+		NEXT(1);
+	HANDLER(Vec4Sub)
+		DoVec4Sub(mips, inst->inst);
+		NEXT(1);
+	HANDLER(Vec4Mul)
+		DoVec4Mul(mips, inst->inst);
+		NEXT(1);
+	HANDLER(Vec4Scale)
+		DoVec4Scale(mips, inst->inst);
+		NEXT(1);
+
+	HANDLER(FMov)
+		mips->f[inst->inst.dest] = mips->f[inst->inst.src1];
+		NEXT(1);
+	HANDLER(FAdd)
+		mips->f[inst->inst.dest] = mips->f[inst->inst.src1] + mips->f[inst->inst.src2];
+		NEXT(1);
+	HANDLER(FSub)
+		mips->f[inst->inst.dest] = mips->f[inst->inst.src1] - mips->f[inst->inst.src2];
+		NEXT(1);
+
+	HANDLER(ExitToConst)
+		return inst->inst.constant;
+	HANDLER(ExitToReg)
+		return mips->r[inst->inst.src1];
+	HANDLER(ExitToPC)
+		return mips->pc;
+	HANDLER(ExitToConstIfEq)
+		if (mips->r[inst->inst.src1] == mips->r[inst->inst.src2])
+			return inst->inst.constant;
+		NEXT(1);
+	HANDLER(ExitToConstIfNeq)
+		if (mips->r[inst->inst.src1] != mips->r[inst->inst.src2])
+			return inst->inst.constant;
+		NEXT(1);
+	HANDLER(ExitToConstIfGtZ)
+		if ((s32)mips->r[inst->inst.src1] > 0)
+			return inst->inst.constant;
+		NEXT(1);
+	HANDLER(ExitToConstIfGeZ)
+		if ((s32)mips->r[inst->inst.src1] >= 0)
+			return inst->inst.constant;
+		NEXT(1);
+	HANDLER(ExitToConstIfLtZ)
+		if ((s32)mips->r[inst->inst.src1] < 0)
+			return inst->inst.constant;
+		NEXT(1);
+	HANDLER(ExitToConstIfLeZ)
+		if ((s32)mips->r[inst->inst.src1] <= 0)
+			return inst->inst.constant;
+		NEXT(1);
+
+	// Fused pairs.  These just run both ops back to back, skipping a dispatch.
+	HANDLER(AddConst_Load32)
+		DoAddConst(mips, inst[0].inst);
+		DoLoad32(mips, inst[1].inst);
+		NEXT(2);
+	HANDLER(Load32_AddConst)
+		DoLoad32(mips, inst[0].inst);
+		DoAddConst(mips, inst[1].inst);
+		NEXT(2);
+
+#define COMPARE_EXIT_HANDLER(cmp, exitName, test) \
+	HANDLER(cmp##_##exitName) \
+		Do##cmp(mips, inst[0].inst); \
+		if (mips->r[inst[1].inst.src1] test mips->r[inst[1].inst.src2]) \
+			return inst[1].inst.constant; \
+		NEXT(2);
+
+	COMPARE_EXIT_HANDLER(Slt, ExitToConstIfEq, ==)
+	COMPARE_EXIT_HANDLER(Slt, ExitToConstIfNeq, !=)
+	COMPARE_EXIT_HANDLER(SltU, ExitToConstIfEq, ==)
+	COMPARE_EXIT_HANDLER(SltU, ExitToConstIfNeq, !=)
+	COMPARE_EXIT_HANDLER(SltConst, ExitToConstIfEq, ==)
+	COMPARE_EXIT_HANDLER(SltConst, ExitToConstIfNeq, !=)
+	COMPARE_EXIT_HANDLER(SltUConst, ExitToConstIfEq, ==)
+	COMPARE_EXIT_HANDLER(SltUConst, ExitToConstIfNeq, !=)
+#undef COMPARE_EXIT_HANDLER
+
+	HANDLER(Vec4Mul_Vec4Add)
+		DoVec4Mul(mips, inst[0].inst);
+		DoVec4Add(mips, inst[1].inst);
+		NEXT(2);
+	HANDLER(Vec4Scale_Vec4Add)
+		DoVec4Scale(mips, inst[0].inst);
+		DoVec4Add(mips, inst[1].inst);
+		NEXT(2);
+
+#ifndef IR_THREADED_GOTO
+	default:
+		break;
+	}
+#endif
+
+#undef HANDLER
+#undef NEXT
+
+	// Unreachable, every handler either continues or returns.
+	Crash();
+	return 0;
+}
+
+static IRThreadedHandler SingleHandler(IROp op) {
+	switch (op) {
+#define SINGLE(name) case IROp::name: return IRH_##name;
+	SINGLE(SetConst) SINGLE(Add) SINGLE(Sub) SINGLE(And) SINGLE(Or) SINGLE(Xor) SINGLE(Mov)
+	SINGLE(AddConst) SINGLE(OptAddConst) SINGLE(SubConst) SINGLE(AndConst) SINGLE(OptAndConst) SINGLE(OrConst) SINGLE(OptOrConst) SINGLE(XorConst)
+	SINGLE(ShlImm) SINGLE(ShrImm) SINGLE(SarImm) SINGLE(Clz)
+	SINGLE(MtLo) SINGLE(MtHi) SINGLE(MfLo) SINGLE(MfHi) SINGLE(Mult) SINGLE(MultU)
+	SINGLE(Slt) SINGLE(SltU) SINGLE(SltConst) SINGLE(SltUConst)
+	SINGLE(Load8) SINGLE(Load8Ext) SINGLE(Load16) SINGLE(Load16Ext) SINGLE(Load32) SINGLE(LoadFloat)
+	SINGLE(Store8) SINGLE(Store16) SINGLE(Store32) SINGLE(StoreFloat)
+	SINGLE(LoadVec4) SINGLE(StoreVec4) SINGLE(Vec4Mov) SINGLE(Vec4Add) SINGLE(Vec4Sub) SINGLE(Vec4Mul) SINGLE(Vec4Scale)
+	SINGLE(FMov) SINGLE(FAdd) SINGLE(FSub)
+	SINGLE(ExitToConst) SINGLE(ExitToReg) SINGLE(ExitToPC)
+	SINGLE(ExitToConstIfEq) SINGLE(ExitToConstIfNeq) SINGLE(ExitToConstIfGtZ) SINGLE(ExitToConstIfGeZ) SINGLE(ExitToConstIfLtZ) SINGLE(ExitToConstIfLeZ)
+#undef SINGLE
+	default:
+		return IRH_Fallback;
+	}
+}
+
+// Returns IRH_Fallback if the pair can't be fused.
+static IRThreadedHandler FusedHandler(IROp first, IROp second) {
+	switch (first) {
+	case IROp::AddConst:
+		return second == IROp::Load32 ? IRH_AddConst_Load32 : IRH_Fallback;
+	case IROp::Load32:
+		return second == IROp::AddConst ? IRH_Load32_AddConst : IRH_Fallback;
+	case IROp::Vec4Mul:
+		return second == IROp::Vec4Add ? IRH_Vec4Mul_Vec4Add : IRH_Fallback;
+	case IROp::Vec4Scale:
+		return second == IROp::Vec4Add ? IRH_Vec4Scale_Vec4Add : IRH_Fallback;
+	default:
+		break;
+	}
+
+	if (second != IROp::ExitToConstIfEq && second != IROp::ExitToConstIfNeq)
+		return IRH_Fallback;
+	bool eq = second == IROp::ExitToConstIfEq;
+	switch (first) {
+	case IROp::Slt: return eq ? IRH_Slt_ExitToConstIfEq : IRH_Slt_ExitToConstIfNeq;
+	case IROp::SltU: return eq ? IRH_SltU_ExitToConstIfEq : IRH_SltU_ExitToConstIfNeq;
+	case IROp::SltConst: return eq ? IRH_SltConst_ExitToConstIfEq : IRH_SltConst_ExitToConstIfNeq;
+	case IROp::SltUConst: return eq ? IRH_SltUConst_ExitToConstIfEq : IRH_SltUConst_ExitToConstIfNeq;
+	default: return IRH_Fallback;
+	}
+}
+
+void IRThreadedDecode(const IRInst *insts, int count, IRThreadedInst *out) {
+#ifdef IR_THREADED_GOTO
+	if (!g_threadedLabels)
+		IRThreadedInterpret(nullptr, nullptr);
+#endif
+
+	for (int i = 0; i < count; ++i) {
+		out[i].inst = insts[i];
+		// If fused, the next entry is skipped over when running from here.  It still gets its own
+		// handler, which doesn't matter since nothing jumps into the middle of a block.
+		IRThreadedHandler handler = IRH_Fallback;
+		if (i + 1 < count)
+			handler = FusedHandler(insts[i].op, insts[i + 1].op);
+		if (handler == IRH_Fallback)
+			handler = SingleHandler(insts[i].op);
+		out[i].handler = handler;
+	}
+
+#ifdef IR_THREADED_GOTO
+	for (int i = 0; i < count; ++i)
+		out[i].label = g_threadedLabels[out[i].handler];
+#endif
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Common/CommonTypes.h"
+#include "Core/MIPS/IR/IRInst.h"
+
+class MIPSState;
+
+// Pre-decoded form of IR for the interpreter.  Each IRInst gets a handler up front, so running
+// it is a chain of indirect jumps (computed goto where the compiler supports it) rather than
+// a trip through the big switch in IRInterpret.  Common pairs of ops are fused into a single
+// handler.  Anything without a dedicated handler falls back to IRInterpret for that op.
+struct IRThreadedInst {
+	union {
+		const void *label;
+		uintptr_t handler;
+	};
+	IRInst inst;
+};
+
+// Decodes count instructions into out (which must have room for count entries), one entry per
+// instruction.  A fused entry covers the following instruction too.
+void IRThreadedDecode(const IRInst *insts, int count, IRThreadedInst *out);
+// Returns the new PC, like IRInterpret.
+u32 IRThreadedInterpret(MIPSState *mips, const IRThreadedInst *inst);
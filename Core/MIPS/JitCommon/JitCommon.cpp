@@ -32,6 +32,7 @@
 #include "Core/Config.h"
 
 #include "Core/MIPS/IR/IRJit.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
@@ -103,6 +104,14 @@ namespace MIPSComp {
 		return notTakenTarget;
 }
 
+	u32 JitInterface::GetBlockAddressFromCodePtr(const u8 *ptr) {
+		JitBlockCache *blocks = GetBlockCache();
+		if (!blocks)
+			return 0;
+		u32 addr = blocks->GetAddressFromBlockPtr(ptr);
+		return addr == (u32)-1 ? 0 : addr;
+	}
+
 	JitInterface *CreateNativeJit(MIPSState *mipsState, bool useIR) {
 #if PPSSPP_ARCH(ARM)
 		return new MIPSComp::ArmJit(mipsState);
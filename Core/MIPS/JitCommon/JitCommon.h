@@ -125,6 +125,8 @@ namespace MIPSComp {
 
 		virtual bool CodeInRange(const u8 *ptr) const = 0;
 		virtual bool DescribeCodePtr(const u8 *ptr, std::string &name) = 0;
+		// Guest start address of the block containing ptr, or 0 if it's not in a known block.
+		virtual u32 GetBlockAddressFromCodePtr(const u8 *ptr);
 		virtual bool IsAtDispatchFetch(const u8 *ptr) const {
 			return false;
 		}
@@ -210,8 +210,9 @@ namespace MIPSComp {
 		VFPU_MTX_VMMOV = 0x08000000,
 		VFPU_MTX_VMMUL = 0x10000000,
 		VFPU_MTX_VMSCL = 0x20000000,
+		IR_THREADED = 0x40000000,
 
-		ALL_FLAGS = 0x3FFFFFFF,
+		ALL_FLAGS = 0x7FFFFFFF,
 	};
 
 	struct JitOptions {
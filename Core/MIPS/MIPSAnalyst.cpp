@@ -40,6 +40,7 @@
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Debugger/DebugInterface.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/ReplaceTables.h"
 
 using namespace MIPSCodeUtils;
@@ -81,6 +82,33 @@ static std::unordered_set<HashMapFunc> hashMap;
 
 static Path hashmapFileName;
 
+// On-disk cache of ScanForFunctions() results, one file per scanned range.
+// Keyed by a hash of the range contents, so relocated or patched code just misses.
+static const u32 FUNCSCAN_CACHE_MAGIC = 0x31435346;  // FSC1
+static const u32 FUNCSCAN_CACHE_VERSION = 2;
+
+struct FuncScanCacheHeader {
+	u32_le magic;
+	u32_le version;
+	u32_le startAddr;
+	u32_le endAddr;
+	u64_le contentHash;
+	u32_le count;
+	// The scan also looks ahead past endAddr, up to here (exclusive.)  That part is hashed too.
+	u32_le readEnd;
+	u64_le readHash;
+};
+
+struct FuncScanCacheEntry {
+	u32_le start;
+	u32_le end;
+	u32_le flags;
+};
+
+enum {
+	FUNCSCAN_FLAG_STRAIGHT_LEAF = 1,
+};
+
 #define MIPSTABLE_IMM_MASK 0xFC000000
 
 // Similar to HashMapFunc but has a char pointer for the name for efficiency.
@@ -961,6 +989,9 @@ namespace MIPSAnalyst {
 		return IsDefaultFunction(name.c_str());
 	}
 
+	// How far the current ScanForFunctions has read, so the cache can check all of it.
+	static u32 scanReadEnd;
+
 	static u32 ScanAheadForJumpback(u32 fromAddr, u32 knownStart, u32 knownEnd) {
 		static const u32 MAX_AHEAD_SCAN = 0x1000;
 		// Maybe a bit high... just to make sure we don't get confused by recursive tail recursion.
@@ -980,6 +1011,7 @@ namespace MIPSAnalyst {
 		u32 furthestJumpbackAddr = INVALIDTARGET;
 
 		const u32 scanEnd = fromAddr + Memory::ValidSize(fromAddr, MAX_AHEAD_SCAN);
+		scanReadEnd = std::max(scanReadEnd, scanEnd);
 		for (u32 ahead = fromAddr; ahead < scanEnd; ahead += 4) {
 			MIPSOpcode aheadOp = Memory::Read_Instruction(ahead, true);
 			u32 target = GetBranchTargetNoRA(ahead, aheadOp);
@@ -1022,12 +1054,160 @@ namespace MIPSAnalyst {
 		return furthestJumpbackAddr;
 	}
 
+	static Path FuncScanCachePath(u64 contentHash, u32 startAddr, u32 endAddr) {
+		std::string discID = g_paramSFO.GetDiscID();
+		if (discID.empty())
+			discID = "_unknown";
+		return GetSysDirectory(DIRECTORY_CACHE) / "funcscan" / discID / StringFromFormat("%016llx_%08x_%08x.fsc", (unsigned long long)contentHash, startAddr, endAddr);
+	}
+
+	static bool HashScanRange(u32 startAddr, u32 endAddr, u64 *contentHash) {
+		if (endAddr < startAddr)
+			return false;
+		const u32 size = endAddr - startAddr + 4;
+		const u8 *ptr = Memory::GetPointerRange(startAddr, size);
+		if (!ptr)
+			return false;
+		*contentHash = XXH3_64bits(ptr, size);
+		return true;
+	}
+
+	// The part past the scanned range that the scan looked at, see scanReadEnd.
+	static bool HashScanReadTail(u32 endAddr, u32 readEnd, u64 *readHash) {
+		const u32 tailStart = endAddr + 4;
+		if (readEnd <= tailStart) {
+			*readHash = 0;
+			return true;
+		}
+		const u8 *ptr = Memory::GetPointerRange(tailStart, readEnd - tailStart);
+		if (!ptr)
+			return false;
+		*readHash = XXH3_64bits(ptr, readEnd - tailStart);
+		return true;
+	}
+
+	static bool LoadFuncScanCache(const Path &filename, u64 contentHash, u32 startAddr, u32 endAddr, FunctionsVector &out) {
+		std::string data;
+		if (!File::Exists(filename) || !File::ReadBinaryFileToString(filename, &data))
+			return false;
+		if (data.size() < sizeof(FuncScanCacheHeader))
+			return false;
+
+		FuncScanCacheHeader header;
+		memcpy(&header, data.data(), sizeof(header));
+		if (header.magic != FUNCSCAN_CACHE_MAGIC || header.version != FUNCSCAN_CACHE_VERSION)
+			return false;
+		if (header.contentHash != contentHash || header.startAddr != startAddr || header.endAddr != endAddr)
+			return false;
+		u64 readHash;
+		if (!HashScanReadTail(endAddr, header.readEnd, &readHash) || readHash != header.readHash)
+			return false;
+		if (data.size() != sizeof(header) + header.count * sizeof(FuncScanCacheEntry))
+			return false;
+
+		const FuncScanCacheEntry *entries = (const FuncScanCacheEntry *)(data.data() + sizeof(header));
+		out.reserve(header.count);
+		for (u32 i = 0; i < header.count; ++i) {
+			AnalyzedFunction f{};
+			f.start = entries[i].start;
+			f.end = entries[i].end;
+			f.isStraightLeaf = (entries[i].flags & FUNCSCAN_FLAG_STRAIGHT_LEAF) != 0;
+			if (f.end < f.start || f.start < startAddr || f.end > endAddr + 4) {
+				out.clear();
+				return false;
+			}
+			out.push_back(f);
+		}
+		return true;
+	}
+
+	static void StoreFuncScanCache(const Path &filename, u64 contentHash, u32 startAddr, u32 endAddr, u32 readEnd, const FunctionsVector &funcs) {
+		u64 readHash;
+		if (!HashScanReadTail(endAddr, readEnd, &readHash))
+			return;
+
+		FuncScanCacheHeader header{};
+		header.readEnd = readEnd;
+		header.readHash = readHash;
+		header.magic = FUNCSCAN_CACHE_MAGIC;
+		header.version = FUNCSCAN_CACHE_VERSION;
+		header.startAddr = startAddr;
+		header.endAddr = endAddr;
+		header.contentHash = contentHash;
+		header.count = (u32)funcs.size();
+
+		std::string data;
+		data.resize(sizeof(header) + funcs.size() * sizeof(FuncScanCacheEntry));
+		memcpy(&data[0], &header, sizeof(header));
+		FuncScanCacheEntry *entries = (FuncScanCacheEntry *)&data[sizeof(header)];
+		for (size_t i = 0; i < funcs.size(); ++i) {
+			entries[i].start = funcs[i].start;
+			entries[i].end = funcs[i].end;
+			entries[i].flags = funcs[i].isStraightLeaf ? FUNCSCAN_FLAG_STRAIGHT_LEAF : 0;
+		}
+
+		File::CreateFullPath(filename.NavigateUp());
+		if (!File::WriteDataToFile(false, data.data(), data.size(), filename)) {
+			WARN_LOG(Log::Loader, "Could not store function scan cache: %s", filename.c_str());
+		}
+	}
+
+	// Check if we already have symbol info starting here.  If so, it'll be skipped for insertion.
+	// We used to use the symbols to find the functions, but sometimes we'd find
+	// wrong ones due to two modules with the same name.
+	static bool CheckExistingSymbol(AnalyzedFunction &f, bool insertSymbols) {
+		u32 existingSize = g_symbolMap->GetFunctionSize(f.start);
+		if (existingSize != SymbolMap::INVALID_ADDRESS) {
+			f.foundInSymbolMap = true;
+
+			// If we run into a func with a different size, skip updating the hash map.
+			// This will prevent us saving incorrectly named funcs with wrong hashes.
+			u32 detectedSize = f.end - f.start + 4;
+			if (existingSize != detectedSize) {
+				insertSymbols = false;
+			}
+		}
+		return insertSymbols;
+	}
+
+	static bool FinishScannedFunctions(FunctionsVector &new_functions, bool insertSymbols) {
+		// Others looking up symbols meanwhile (e.g. the disassembler) shouldn't rebuild after each one.
+		g_symbolMap->BeginUpdate();
+		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
+			iter->size = iter->end - iter->start + 4;
+			if (insertSymbols && !iter->foundInSymbolMap) {
+				char temp[256];
+				g_symbolMap->AddFunction(DefaultFunctionName(temp, iter->start), iter->start, iter->end - iter->start + 4);
+			}
+		}
+		g_symbolMap->EndUpdate();
+
+		// Concatenate the new functions to the end of the old ones.
+		functions.insert(functions.end(), new_functions.begin(), new_functions.end());
+		return insertSymbols;
+	}
+
 	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 
 		FunctionsVector new_functions;
 
+		u64 contentHash = 0;
+		Path cacheFilename;
+		if (g_Config.bFuncScanCache && HashScanRange(startAddr, endAddr, &contentHash)) {
+			cacheFilename = FuncScanCachePath(contentHash, startAddr, endAddr);
+			if (LoadFuncScanCache(cacheFilename, contentHash, startAddr, endAddr, new_functions)) {
+				for (auto &f : new_functions) {
+					insertSymbols = CheckExistingSymbol(f, insertSymbols);
+				}
+				INFO_LOG(Log::Loader, "Loaded %d functions for %08x-%08x from scan cache", (int)new_functions.size(), startAddr, endAddr);
+				return FinishScannedFunctions(new_functions, insertSymbols);
+			}
+		}
+
 		AnalyzedFunction currentFunction = {startAddr};
+		// The delay slot after the last instruction may be read.
+		scanReadEnd = endAddr + 8;
 
 		u32 furthestBranch = 0;
 		bool looking = false;
@@ -1131,21 +1311,7 @@ namespace MIPSAnalyst {
 			if (end) {
 				currentFunction.end = addr + 4;
 				currentFunction.isStraightLeaf = isStraightLeaf;
-
-				// Check if we already have symbol info starting here.  If so, skip insertion.
-				// We used to use the symbols to find the functions, but sometimes we'd find
-				// wrong ones due to two modules with the same name.
-				u32 existingSize = g_symbolMap->GetFunctionSize(currentFunction.start);
-				if (existingSize != SymbolMap::INVALID_ADDRESS) {
-					currentFunction.foundInSymbolMap = true;
-
-					// If we run into a func with a different size, skip updating the hash map.
-					// This will prevent us saving incorrectly named funcs with wrong hashes.
-					u32 detectedSize = currentFunction.end - currentFunction.start + 4;
-					if (existingSize != detectedSize) {
-						insertSymbols = false;
-					}
-				}
+				insertSymbols = CheckExistingSymbol(currentFunction, insertSymbols);
 
 				new_functions.push_back(currentFunction);
 
@@ -1165,17 +1331,11 @@ namespace MIPSAnalyst {
 			new_functions.push_back(currentFunction);
 		}
 
-		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
-			iter->size = iter->end - iter->start + 4;
-			if (insertSymbols && !iter->foundInSymbolMap) {
-				char temp[256];
-				g_symbolMap->AddFunction(DefaultFunctionName(temp, iter->start), iter->start, iter->end - iter->start + 4);
-			}
+		if (!cacheFilename.empty()) {
+			StoreFuncScanCache(cacheFilename, contentHash, startAddr, endAddr, scanReadEnd, new_functions);
 		}
 
-		// Concatenate the new functions to the end of the old ones.
-		functions.insert(functions.end(), new_functions.begin(), new_functions.end());
-		return insertSymbols;
+		return FinishScannedFunctions(new_functions, insertSymbols);
 	}
 
 	void FinalizeScan(bool insertSymbols) {
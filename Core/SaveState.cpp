@@ -16,10 +16,14 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
 #include <vector>
 #include <thread>
 #include <mutex>
 
+#include <zstd.h>
+
 #include "Common/Data/Text/I18n.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Text/Parsers.h"
@@ -100,20 +104,19 @@ namespace SaveState
 		return CChunkFileReader::LoadPtr(&data[0], state, errorString);
 	}
 
-	// This ring buffer of states is for rewind save states, which are kept in RAM.
-	// Save states are compressed against one of two reference saves (bases_), and the reference
-	// is switched to a fresh save every N saves, where N is BASE_USAGE_INTERVAL.
-	// The compression is a simple block based scheme where 0 means to copy a block from the base,
-	// and 1 means that the following bytes are the next block. See Compress/LockedDecompress.
-	class StateRingbuffer {
+	// Rewind snapshots, kept in RAM as a timeline.  Every KEYFRAME_INTERVAL snapshots there's a
+	// keyframe (the whole state, zstd compressed), and the ones in between are deltas against the
+	// snapshot right before them: XOR, which is mostly zeros, then zstd.  Getting back to any
+	// snapshot decodes one keyframe and at most KEYFRAME_INTERVAL - 1 deltas.
+	// The newest snapshot is also kept decoded (last_), as the base for the next delta, and so
+	// rewinding to it doesn't decode anything.  After a rewind, the one before it is decoded on the
+	// compress thread while the game carries on.  Rather than keeping a fixed number of snapshots,
+	// the oldest are dropped, a keyframe and its deltas at a time, to stay within the budget.
+	class RewindTimeline {
 	public:
-		StateRingbuffer() {
-			size_ = REWIND_NUM_STATES;
-			states_.resize(size_);
-			baseMapping_.resize(size_);
-		}
+		typedef std::vector<u8> StateBuffer;
 
-		~StateRingbuffer() {
+		~RewindTimeline() {
 			if (compressThread_.joinable()) {
 				compressThread_.join();
 			}
@@ -123,124 +126,97 @@ namespace SaveState
 		{
 			rewindLastTime_ = time_now_d();
 
-			// Make sure we're not processing a previous save. That'll cause a hitch though, but at least won't
-			// crash due to contention over buffer_.
+			// Make sure we're not processing a previous save, the new delta is against it.
 			if (compressThread_.joinable())
 				compressThread_.join();
 
-			std::lock_guard<std::mutex> guard(lock_);
-
-			int n = next_++ % size_;
-			if ((next_ % size_) == first_)
-				++first_;
-
-			std::vector<u8> *compressBuffer = &buffer_;
-			CChunkFileReader::Error err;
-
-			if (base_ == -1 || ++baseUsage_ > BASE_USAGE_INTERVAL)
-			{
-				base_ = (base_ + 1) % ARRAY_SIZE(bases_);
-				baseUsage_ = 0;
-				err = SaveToRam(bases_[base_]);
-				// Let's not bother savestating twice.
-				compressBuffer = &bases_[base_];
-			}
-			else
-				err = SaveToRam(buffer_);
-
+			StateBuffer state;
+			CChunkFileReader::Error err = SaveToRam(state);
 			if (err == CChunkFileReader::ERROR_NONE)
-				ScheduleCompress(&states_[n], compressBuffer, &bases_[base_]);
-			else
-				states_[n].clear();
-
-			baseMapping_[n] = base_;
+				ScheduleCompress(std::move(state));
 			return err;
 		}
 
 		CChunkFileReader::Error Restore(std::string *errorString)
 		{
-			std::lock_guard<std::mutex> guard(lock_);
+			// Also makes sure a previous rewind has finished decoding into last_.
+			if (compressThread_.joinable())
+				compressThread_.join();
+
+			StateBuffer state;
+			{
+				std::lock_guard<std::mutex> guard(lock_);
 
-			// No valid states left.
-			if (Empty())
-				return CChunkFileReader::ERROR_BAD_FILE;
+				// No valid states left.
+				if (entries_.empty())
+					return CChunkFileReader::ERROR_BAD_FILE;
 
-			int n = (--next_ + size_) % size_;
-			if (states_[n].empty())
-				return CChunkFileReader::ERROR_BAD_FILE;
+				state = std::move(last_);
+				PopNewest();
+			}
 
-			static std::vector<u8> buffer;
-			LockedDecompress(buffer, states_[n], bases_[baseMapping_[n]]);
-			CChunkFileReader::Error error = LoadFromRam(buffer, errorString);
+			// Decode the one before, so we can keep going back (or delta against it.)  Anything that
+			// needs last_ joins the thread first.
+			compressThread_ = std::thread([this]() {
+				SetCurrentThreadName("SaveStateCompress");
+
+				std::lock_guard<std::mutex> guard(lock_);
+				if (!entries_.empty() && !Decode(entries_.size() - 1, last_)) {
+					ERROR_LOG(Log::SaveState, "Rewind: Failed to decode snapshot, dropping the rest");
+					DropAll();
+				}
+			});
+
+			CChunkFileReader::Error error = LoadFromRam(state, errorString);
 			rewindLastTime_ = time_now_d();
 			return error;
 		}
 
-		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base)
+		void ScheduleCompress(StateBuffer &&state)
 		{
 			if (compressThread_.joinable())
 				compressThread_.join();
-			compressThread_ = std::thread([=]{
+			compressThread_ = std::thread([this, state = std::move(state)]() mutable {
 				SetCurrentThreadName("SaveStateCompress");
 
 				// Should do no I/O, so no JNI thread context needed.
-				Compress(*result, *state, *base);
+				Compress(state);
 			});
 		}
 
-		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base)
+		void Compress(StateBuffer &state)
 		{
 			std::lock_guard<std::mutex> guard(lock_);
-			// Bail if we were cleared before locking.
-			if (first_ == 0 && next_ == 0)
-				return;
 
 			double start_time = time_now_d();
-			result.clear();
-			result.reserve(512 * 1024);
-			for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
-			{
-				int blockSize = std::min(BLOCK_SIZE, (int)(state.size() - i));
-				if (i + blockSize > base.size() || memcmp(&state[i], &base[i], blockSize) != 0)
-				{
-					result.push_back(1);
-					result.insert(result.end(), state.begin() + i, state.begin() + i + blockSize);
-				}
-				else
-					result.push_back(0);
+			Entry entry;
+			entry.size = state.size();
+			entry.keyframe = last_.empty() || EntriesSinceKeyframe() >= KEYFRAME_INTERVAL;
+			bool success;
+			if (entry.keyframe) {
+				success = CompressBlock(entry.data, state.data(), state.size());
+			} else {
+				// Where the sizes differ, the shorter one is treated as zero padded.
+				StateBuffer delta = state;
+				size_t common = std::min(state.size(), last_.size());
+				for (size_t i = 0; i < common; ++i)
+					delta[i] ^= last_[i];
+				success = CompressBlock(entry.data, delta.data(), delta.size());
+			}
+			if (!success) {
+				// The timeline still ends at last_, so we can just skip this one.
+				ERROR_LOG(Log::SaveState, "Rewind: Failed to compress snapshot");
+				return;
 			}
 
-			double taken_s = time_now_d() - start_time;
-			DEBUG_LOG(Log::SaveState, "Rewind: Compressed save from %d bytes to %d in %0.2f ms.", (int)state.size(), (int)result.size(), taken_s * 1000.0);
-		}
+			usedBytes_ += entry.data.size();
+			entries_.push_back(std::move(entry));
+			count_ = entries_.size();
+			last_ = std::move(state);
+			TrimToBudget();
 
-		void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
-		{
-			result.clear();
-			result.reserve(base.size());
-			auto basePos = base.begin();
-			for (size_t i = 0; i < compressed.size(); )
-			{
-				if (compressed[i] == 0)
-				{
-					++i;
-					int blockSize = std::min(BLOCK_SIZE, (int)(base.size() - result.size()));
-					result.insert(result.end(), basePos, basePos + blockSize);
-					basePos += blockSize;
-				}
-				else
-				{
-					++i;
-					int blockSize = std::min(BLOCK_SIZE, (int)(compressed.size() - i));
-					result.insert(result.end(), compressed.begin() + i, compressed.begin() + i + blockSize);
-					i += blockSize;
-					// This check is to avoid advancing basePos out of range, which MSVC catches.
-					// When this happens, we're at the end of decoding anyway.
-					if (base.end() - basePos >= blockSize) {
-						basePos += blockSize;
-					}
-				}
-			}
+			double taken_s = time_now_d() - start_time;
+			DEBUG_LOG(Log::SaveState, "Rewind: Compressed %s from %d bytes to %d in %0.2f ms, %d snapshots in %d bytes.", entries_.back().keyframe ? "keyframe" : "delta", (int)last_.size(), (int)entries_.back().data.size(), taken_s * 1000.0, (int)entries_.size(), (int)(usedBytes_ + last_.size()));
 		}
 
 		void Clear()
@@ -250,25 +226,13 @@ namespace SaveState
 
 			// This lock is mainly for shutdown.
 			std::lock_guard<std::mutex> guard(lock_);
-			first_ = 0;
-			next_ = 0;
-			for (auto &b : bases_) {
-				b.clear();
-			}
-			baseMapping_.clear();
-			baseMapping_.resize(size_);
-			for (auto &s : states_) {
-				s.clear();
-			}
-			buffer_.clear();
-			base_ = -1;
-			baseUsage_ = 0;
+			DropAll();
 			rewindLastTime_ = time_now_d();
 		}
 
 		bool Empty() const
 		{
-			return next_ == first_;
+			return count_ == 0;
 		}
 
 		void Process() {
@@ -295,26 +259,100 @@ namespace SaveState
 		}
 
 	private:
-		const int BLOCK_SIZE = 8192;
-		const int REWIND_NUM_STATES = 20;
-		// TODO: Instead, based on size of compressed state?
-		const int BASE_USAGE_INTERVAL = 15;
+		struct Entry {
+			// Compressed, either the whole state or the XOR against the previous one.
+			StateBuffer data;
+			// Decoded size.
+			size_t size;
+			bool keyframe;
+		};
 
-		typedef std::vector<u8> StateBuffer;
+		size_t EntriesSinceKeyframe() const {
+			size_t n = 0;
+			for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+				++n;
+				if (it->keyframe)
+					break;
+			}
+			return n;
+		}
+
+		bool Decode(size_t index, StateBuffer &result) {
+			size_t key = index;
+			while (key > 0 && !entries_[key].keyframe)
+				--key;
+			if (!entries_[key].keyframe || !DecompressBlock(result, entries_[key]))
+				return false;
+
+			StateBuffer delta;
+			for (size_t i = key + 1; i <= index; ++i) {
+				if (!DecompressBlock(delta, entries_[i]))
+					return false;
+				result.resize(delta.size(), 0);
+				for (size_t j = 0; j < delta.size(); ++j)
+					result[j] ^= delta[j];
+			}
+			return true;
+		}
 
-		int first_ = 0;
-		int next_ = 0;
-		int size_;
+		static bool CompressBlock(StateBuffer &result, const u8 *data, size_t size) {
+			// Temporary, like the delta buffers.  Kept around, these would be two whole states outside
+			// the budget.
+			StateBuffer buffer(ZSTD_compressBound(size));
+			// Speed matters more than ratio here, and the deltas are mostly zeros anyway.
+			size_t written = ZSTD_compress(buffer.data(), buffer.size(), data, size, 1);
+			if (ZSTD_isError(written))
+				return false;
+			// Exact size, this is what's counted against the budget.
+			result.assign(buffer.begin(), buffer.begin() + written);
+			return true;
+		}
+
+		static bool DecompressBlock(StateBuffer &result, const Entry &entry) {
+			result.resize(entry.size);
+			size_t read = ZSTD_decompress(result.data(), result.size(), entry.data.data(), entry.data.size());
+			return !ZSTD_isError(read) && read == entry.size;
+		}
+
+		void PopNewest() {
+			usedBytes_ -= entries_.back().data.size();
+			entries_.pop_back();
+			count_ = entries_.size();
+		}
+
+		void DropAll() {
+			entries_.clear();
+			count_ = 0;
+			usedBytes_ = 0;
+			last_.clear();
+		}
+
+		void TrimToBudget() {
+			size_t budget = (size_t)std::max(g_Config.iRewindMemoryBudget, 1) * 1024 * 1024;
+			while (usedBytes_ + last_.size() > budget) {
+				size_t end = 1;
+				while (end < entries_.size() && !entries_[end].keyframe)
+					++end;
+				// Always keep the newest keyframe and its deltas, or there'd be nothing to rewind to.
+				if (end >= entries_.size())
+					break;
+				for (size_t i = 0; i < end; ++i)
+					usedBytes_ -= entries_[i].data.size();
+				entries_.erase(entries_.begin(), entries_.begin() + end);
+				count_ = entries_.size();
+			}
+		}
+
+		const size_t KEYFRAME_INTERVAL = 10;
+
+		std::deque<Entry> entries_;
+		// Read without the lock, by CanRewind().
+		std::atomic<size_t> count_{};
+		size_t usedBytes_ = 0;
+		StateBuffer last_;
 
-		std::vector<StateBuffer> states_;
-		StateBuffer bases_[2];
-		std::vector<int> baseMapping_;
 		std::mutex lock_;
 		std::thread compressThread_;
-		std::vector<u8> buffer_;
-
-		int base_ = -1;
-		int baseUsage_ = 0;
 
 		double rewindLastTime_ = 0.0f;
 	};
@@ -335,7 +373,7 @@ namespace SaveState
 
 	// TODO: Should this be configurable?
 	static const int SCREENSHOT_FAILURE_RETRIES = 15;
-	static StateRingbuffer rewindStates;
+	static RewindTimeline rewindStates;
 
 	void SaveStart::DoState(PointerWrap &p)
 	{
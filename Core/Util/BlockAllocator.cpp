@@ -17,6 +17,7 @@
 
 #include <cstring>
 
+#include "Common/BitScan.h"
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -25,7 +26,12 @@
 #include "Core/Util/BlockAllocator.h"
 #include "Core/Reporting.h"
 
-// Slow freaking thing but works (eventually) :)
+// The block list is the real state.  Lookups go through address and free size indexes, which
+// must find exactly the block the list walk would, since the addresses are visible to games.
+
+static inline int FreeBin(u32 size) {
+	return 31 - (int)clz32_nonzero(size);
+}
 
 BlockAllocator::BlockAllocator(int grain) : bottom_(NULL), top_(NULL), grain_(grain)
 {
@@ -44,6 +50,7 @@ void BlockAllocator::Init(u32 rangeStart, u32 rangeSize, bool suballoc) {
 	top_ = new Block(rangeStart_, rangeSize_, false, NULL, NULL);
 	bottom_ = top_;
 	suballoc_ = suballoc;
+	IndexBlock(top_);
 }
 
 void BlockAllocator::Shutdown()
@@ -55,6 +62,81 @@ void BlockAllocator::Shutdown()
 		bottom_ = next;
 	}
 	top_ = NULL;
+	ClearIndex();
+}
+
+void BlockAllocator::IndexBlock(Block *b) {
+	// Empty blocks contain no addresses, and would collide with the next block's start.
+	if (b->size == 0)
+		return;
+	blocksByAddress_[b->start] = b;
+	if (!b->taken)
+		freeBins_[FreeBin(b->size)][b->start] = b;
+}
+
+void BlockAllocator::UnindexBlock(Block *b) {
+	if (b->size == 0)
+		return;
+	auto it = blocksByAddress_.find(b->start);
+	if (it != blocksByAddress_.end() && it->second == b)
+		blocksByAddress_.erase(it);
+	if (!b->taken) {
+		auto &bin = freeBins_[FreeBin(b->size)];
+		auto freeIt = bin.find(b->start);
+		if (freeIt != bin.end() && freeIt->second == b)
+			bin.erase(freeIt);
+	}
+}
+
+void BlockAllocator::ClearIndex() {
+	blocksByAddress_.clear();
+	for (auto &bin : freeBins_)
+		bin.clear();
+}
+
+void BlockAllocator::SetTaken(Block *b, bool taken) {
+	UnindexBlock(b);
+	b->taken = taken;
+	IndexBlock(b);
+}
+
+// Lowest free block the size fits in after aligning its start, like walking up from bottom_.
+BlockAllocator::Block *BlockAllocator::FindFreeBottom(u32 size, u32 grain) {
+	Block *best = nullptr;
+	// Blocks in lower bins are all too small.  Those in the first bin might be, too.
+	for (int i = FreeBin(size); i < FREE_BINS; ++i) {
+		for (auto &it : freeBins_[i]) {
+			Block *b = it.second;
+			if (best && b->start >= best->start)
+				break;
+			u32 offset = b->start % grain;
+			if (offset != 0)
+				offset = grain - offset;
+			if (b->size >= offset + size) {
+				best = b;
+				break;
+			}
+		}
+	}
+	return best;
+}
+
+// Highest free block the size fits in at its aligned end, like walking down from top_.
+BlockAllocator::Block *BlockAllocator::FindFreeTop(u32 size, u32 grain) {
+	Block *best = nullptr;
+	for (int i = FreeBin(size); i < FREE_BINS; ++i) {
+		for (auto it = freeBins_[i].rbegin(); it != freeBins_[i].rend(); ++it) {
+			Block *b = it->second;
+			if (best && b->start <= best->start)
+				break;
+			u32 offset = (b->start + b->size - size) % grain;
+			if (b->size >= offset + size) {
+				best = b;
+				break;
+			}
+		}
+	}
+	return best;
 }
 
 u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop, const char *tag)
@@ -77,62 +159,58 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	if (!fromTop)
 	{
 		//Allocate from bottom of mem
-		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		Block *bp = FindFreeBottom(size, grain);
+		if (bp != NULL)
 		{
 			Block &b = *bp;
 			u32 offset = b.start % grain;
 			if (offset != 0)
 				offset = grain - offset;
 			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
+			if (b.size == needed)
 			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeAfter(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
+				if (offset >= grain_)
+					InsertFreeBefore(&b, offset);
+				SetTaken(&b, true);
+				b.SetAllocated(tag, suballoc_);
+				return b.start;
+			}
+			else
+			{
+				InsertFreeAfter(&b, b.size - needed);
+				if (offset >= grain_)
+					InsertFreeBefore(&b, offset);
+				SetTaken(&b, true);
+				b.SetAllocated(tag, suballoc_);
+				return b.start;
 			}
 		}
 	}
 	else
 	{
 		// Allocate from top of mem.
-		for (Block *bp = top_; bp != NULL; bp = bp->prev)
+		Block *bp = FindFreeTop(size, grain);
+		if (bp != NULL)
 		{
 			Block &b = *bp;
 			u32 offset = (b.start + b.size - size) % grain;
 			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
+			if (b.size == needed)
 			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeBefore(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
+				if (offset >= grain_)
+					InsertFreeAfter(&b, offset);
+				SetTaken(&b, true);
+				b.SetAllocated(tag, suballoc_);
+				return b.start;
+			}
+			else
+			{
+				InsertFreeBefore(&b, b.size - needed);
+				if (offset >= grain_)
+					InsertFreeAfter(&b, offset);
+				SetTaken(&b, true);
+				b.SetAllocated(tag, suballoc_);
+				return b.start;
 			}
 		}
 	}
@@ -195,7 +273,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 			{
 				if (b.size != alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
+				SetTaken(&b, true);
 				b.SetAllocated(tag, suballoc_);
 				CheckBlocks();
 				return position;
@@ -205,7 +283,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 				InsertFreeBefore(&b, alignedPosition - b.start);
 				if (b.size > alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
+				SetTaken(&b, true);
 				b.SetAllocated(tag, suballoc_);
 
 				return position;
@@ -228,10 +306,12 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 {
 	DEBUG_LOG(Log::sceKernel, "Merging Blocks");
 
+	UnindexBlock(fromBlock);
 	Block *prev = fromBlock->prev;
 	while (prev != NULL && prev->taken == false)
 	{
 		DEBUG_LOG(Log::sceKernel, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(prev);
 		prev->size += fromBlock->size;
 		if (fromBlock->next == NULL)
 			top_ = prev;
@@ -252,6 +332,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (next != NULL && next->taken == false)
 	{
 		DEBUG_LOG(Log::sceKernel, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(next);
 		fromBlock->size += next->size;
 		fromBlock->next = next->next;
 		delete next;
@@ -262,6 +343,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 		top_ = fromBlock;
 	else
 		next->prev = fromBlock;
+	IndexBlock(fromBlock);
 }
 
 bool BlockAllocator::Free(u32 position)
@@ -270,7 +352,7 @@ bool BlockAllocator::Free(u32 position)
 	if (b && b->taken)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
-		b->taken = false;
+		SetTaken(b, false);
 		MergeFreeBlocks(b);
 		return true;
 	}
@@ -287,7 +369,7 @@ bool BlockAllocator::FreeExact(u32 position)
 	if (b && b->taken && b->start == position)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
-		b->taken = false;
+		SetTaken(b, false);
 		MergeFreeBlocks(b);
 		return true;
 	}
@@ -300,6 +382,7 @@ bool BlockAllocator::FreeExact(u32 position)
 
 BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start, size, false, b->prev, b);
 	b->prev = inserted;
 	if (inserted->prev == NULL)
@@ -309,11 +392,14 @@ BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 
 	b->start += size;
 	b->size -= size;
+	IndexBlock(inserted);
+	IndexBlock(b);
 	return inserted;
 }
 
 BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start + b->size - size, size, false, b, b->next);
 	b->next = inserted;
 	if (inserted->next == NULL)
@@ -322,6 +408,8 @@ BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 		inserted->next->prev = inserted;
 
 	b->size -= size;
+	IndexBlock(b);
+	IndexBlock(inserted);
 	return inserted;
 }
 
@@ -347,28 +435,21 @@ const char *BlockAllocator::GetBlockTag(u32 addr) const {
 
 inline BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
 {
-	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
-	return NULL;
+	return const_cast<Block *>(static_cast<const BlockAllocator *>(this)->GetBlockFromAddress(addr));
 }
 
 const BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr) const
 {
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	// The last block starting at or before addr is the only one that could contain it.
+	auto it = blocksByAddress_.upper_bound(addr);
+	if (it == blocksByAddress_.begin())
+		return NULL;
+	--it;
+	const Block &b = *it->second;
+	if (b.start <= addr && b.start + b.size > addr)
 	{
-		const Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
+		// Got one!
+		return it->second;
 	}
 	return NULL;
 }
@@ -405,13 +486,13 @@ void BlockAllocator::ListBlocks() const
 u32 BlockAllocator::GetLargestFreeBlockSize() const
 {
 	u32 maxFreeBlock = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	// Only the highest non-empty bin can have the largest.
+	for (int i = FREE_BINS - 1; i >= 0 && maxFreeBlock == 0; --i)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
+		for (const auto &it : freeBins_[i])
 		{
-			if (b.size > maxFreeBlock)
-				maxFreeBlock = b.size;
+			if (it.second->size > maxFreeBlock)
+				maxFreeBlock = it.second->size;
 		}
 	}
 	if (maxFreeBlock & (grain_ - 1))
@@ -459,6 +540,9 @@ void BlockAllocator::DoState(PointerWrap &p)
 			top_->next->DoState(p);
 			top_ = top_->next;
 		}
+
+		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+			IndexBlock(bp);
 	}
 	else
 	{
@@ -19,6 +19,8 @@
 
 class PointerWrap;
 
+#include <map>
+
 #include "Common/CommonTypes.h"
 
 class BlockAllocator
@@ -80,6 +82,21 @@ class BlockAllocator
 	u32 grain_;
 	bool suballoc_;
 
+	// Indexes over the block list, which stays the authority (and what's save stated.)
+	// Every block by start address, and free blocks binned by log2 of size, by address.
+	enum {
+		FREE_BINS = 32,
+	};
+	std::map<u32, Block *> blocksByAddress_;
+	std::map<u32, Block *> freeBins_[FREE_BINS];
+
+	void IndexBlock(Block *b);
+	void UnindexBlock(Block *b);
+	void ClearIndex();
+	void SetTaken(Block *b, bool taken);
+	Block *FindFreeBottom(u32 size, u32 grain);
+	Block *FindFreeTop(u32 size, u32 grain);
+
 	void MergeFreeBlocks(Block *fromBlock);
 	Block *GetBlockFromAddress(u32 addr);
 	const Block *GetBlockFromAddress(u32 addr) const;
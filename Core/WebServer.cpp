@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <thread>
 
@@ -76,7 +77,7 @@ static ServerStatus RetrieveStatus() {
 static bool RegisterServer(int port) {
 	bool success = false;
 	http::Client http;
-	bool cancelled = false;
+	std::atomic<bool> cancelled{ false };
 	net::RequestProgress progress(&cancelled);
 	Buffer theVoid = Buffer::Void();
 
@@ -202,7 +203,49 @@ static Path LocalFromRemotePath(const std::string &path) {
 	}
 }
 
+struct ByteRange {
+	s64 first;
+	s64 last;
+};
+
+// Parses "bytes=a-b,c-,-n" against the file size.  Returns false if the header is malformed,
+// otherwise ranges holds the satisfiable ranges (possibly none), clamped to the file.
+static bool ParseByteRanges(const std::string &header, s64 sz, std::vector<ByteRange> *ranges) {
+	if (!startsWith(header, "bytes="))
+		return false;
+
+	std::vector<std::string_view> specs;
+	SplitString(std::string_view(header).substr(6), ',', specs);
+	for (std::string_view spec : specs) {
+		std::string trimmed(StripSpaces(spec));
+		long long first = -1, last = -1;
+		if (sscanf(trimmed.c_str(), "%lld-%lld", &first, &last) == 2) {
+			if (first < 0 || first > last)
+				return false;
+		} else if (sscanf(trimmed.c_str(), "%lld-", &first) == 1 && first >= 0 && trimmed.back() == '-') {
+			last = sz - 1;
+		} else if (sscanf(trimmed.c_str(), "-%lld", &last) == 1 && last >= 0) {
+			// Suffix range: the last N bytes.
+			if (last == 0)
+				continue;
+			first = std::max(sz - last, (s64)0);
+			last = sz - 1;
+		} else {
+			return false;
+		}
+
+		if (first >= sz)
+			continue;
+		ranges->push_back({ first, std::min(last, sz - 1) });
+	}
+	return true;
+}
+
 static void DiscHandler(const http::ServerRequest &request, const Path &filename) {
+	// Keep this reasonable, multipart responses aren't free.
+	static const size_t MAX_RANGES = 64;
+	static const char *const BOUNDARY = "PPSSPP-BYTERANGES";
+
 	s64 sz = File::GetFileSize(filename);
 	if (sz == 0) {
 		// Probably failed
@@ -215,44 +258,53 @@ static void DiscHandler(const http::ServerRequest &request, const Path &filename
 	if (request.Method() == http::RequestHeader::HEAD) {
 		request.WriteHttpResponseHeader("1.0", 200, sz, "application/octet-stream", "Accept-Ranges: bytes\r\n");
 	} else if (request.GetHeader("range", &range)) {
-		s64 begin = 0, last = 0;
-		if (sscanf(range.c_str(), "bytes=%lld-%lld", &begin, &last) != 2) {
+		std::vector<ByteRange> ranges;
+		if (!ParseByteRanges(range, sz, &ranges) || ranges.size() > MAX_RANGES) {
 			request.WriteHttpResponseHeader("1.0", 400, -1, "text/plain");
 			request.Out()->Push("Could not understand range request.");
 			return;
 		}
 
-		if (begin < 0 || begin > last || last >= sz) {
-			request.WriteHttpResponseHeader("1.0", 416, -1, "text/plain");
+		if (ranges.empty()) {
+			std::string contentRange = StringFromFormat("Content-Range: bytes */%lld\r\n", sz);
+			request.WriteHttpResponseHeader("1.0", 416, -1, "text/plain", contentRange.c_str());
 			request.Out()->Push("Range goes outside of file.");
 			return;
 		}
 
 		FILE *fp = File::OpenCFile(filename, "rb");
-		if (!fp || fseek(fp, begin, SEEK_SET) != 0) {
+		if (!fp) {
 			request.WriteHttpResponseHeader("1.0", 500, -1, "text/plain");
 			request.Out()->Push("File access failed.");
-			if (fp) {
-				fclose(fp);
-			}
 			return;
 		}
 
-		s64 len = last - begin + 1;
-		char contentRange[1024];
-		snprintf(contentRange, sizeof(contentRange), "Content-Range: bytes %lld-%lld/%lld\r\n", begin, last, sz);
-		request.WriteHttpResponseHeader("1.0", 206, len, "application/octet-stream", contentRange);
-
-		const size_t CHUNK_SIZE = 16 * 1024;
-		char *buf = new char[CHUNK_SIZE];
-		for (s64 pos = 0; pos < len; pos += CHUNK_SIZE) {
-			s64 chunklen = std::min(len - pos, (s64)CHUNK_SIZE);
-			if (fread(buf, chunklen, 1, fp) != 1)
-				break;
-			request.Out()->Push(buf, chunklen);
+		if (ranges.size() == 1) {
+			const ByteRange &r = ranges[0];
+			std::string contentRange = StringFromFormat("Content-Range: bytes %lld-%lld/%lld\r\n", r.first, r.last, sz);
+			request.WriteHttpResponseHeader("1.0", 206, r.last - r.first + 1, "application/octet-stream", contentRange.c_str());
+			request.WriteFileRange(fp, r.first, r.last - r.first + 1);
+		} else {
+			// Each part gets its own header, so work out the total length up front.
+			std::vector<std::string> partHeaders;
+			s64 len = 0;
+			for (const ByteRange &r : ranges) {
+				partHeaders.push_back(StringFromFormat("\r\n--%s\r\nContent-Type: application/octet-stream\r\nContent-Range: bytes %lld-%lld/%lld\r\n\r\n", BOUNDARY, r.first, r.last, sz));
+				len += partHeaders.back().size() + (r.last - r.first + 1);
+			}
+			std::string trailer = StringFromFormat("\r\n--%s--\r\n", BOUNDARY);
+			len += trailer.size();
+
+			std::string mimeType = StringFromFormat("multipart/byteranges; boundary=%s", BOUNDARY);
+			request.WriteHttpResponseHeader("1.0", 206, len, mimeType.c_str());
+			for (size_t i = 0; i < ranges.size(); ++i) {
+				request.Out()->Push(partHeaders[i]);
+				if (!request.WriteFileRange(fp, ranges[i].first, ranges[i].last - ranges[i].first + 1))
+					break;
+			}
+			request.Out()->Push(trailer);
 		}
 		fclose(fp);
-		delete[] buf;
 		request.Out()->Flush();
 	} else {
 		request.WriteHttpResponseHeader("1.0", 418, -1, "text/plain");
@@ -420,6 +472,8 @@ static void ExecuteWebServer() {
 			return;
 		}
 	}
+	// Serve from a small worker pool where supported.  Remote ISO clients keep connections open.
+	http->UseEventLoop(4);
 	UpdateStatus(ServerStatus::RUNNING);
 
 	g_Config.iRemoteISOPort = http->Port();
@@ -57,6 +57,7 @@ static size_t FormatFramebufferName(const VirtualFramebuffer *vfb, char *tag, si
 FramebufferManagerCommon::FramebufferManagerCommon(Draw::DrawContext *draw)
 	: draw_(draw), draw2D_(draw_) {
 	presentation_ = new PresentationCommon(draw);
+	readbackPredictor_.SetDelayedReadbackSupported(draw->GetDeviceCaps().delayedReadbackSupported);
 }
 
 FramebufferManagerCommon::~FramebufferManagerCommon() {
@@ -3112,7 +3113,7 @@ bool FramebufferManagerCommon::GetOutputFramebuffer(GPUDebugBuffer &buffer) {
 // (Except using the GPU might cause problems because of various implementations'
 // dithering behavior and games that expect exact colors like Danganronpa, so we
 // can't entirely be rid of the CPU path.) -- unknown
-void FramebufferManagerCommon::ReadbackFramebuffer(VirtualFramebuffer *vfb, int x, int y, int w, int h, RasterChannel channel, Draw::ReadbackMode mode) {
+void FramebufferManagerCommon::ReadbackFramebuffer(VirtualFramebuffer *vfb, int x, int y, int w, int h, RasterChannel channel, Draw::ReadbackMode mode, bool blockOnDelayedMiss) {
 	if (w <= 0 || h <= 0) {
 		ERROR_LOG(Log::FrameBuf, "Bad inputs to ReadbackFramebufferSync: %d %d %d %d", x, y, w, h);
 		return;
@@ -3158,7 +3159,13 @@ void FramebufferManagerCommon::ReadbackFramebuffer(VirtualFramebuffer *vfb, int
 			x * vfb->renderScaleFactor, y * vfb->renderScaleFactor,
 			w * vfb->renderScaleFactor, h * vfb->renderScaleFactor, (uint16_t *)destPtr, stride, w, h, mode);
 	} else {
-		draw_->CopyFramebufferToMemory(vfb->fbo, channel == RASTER_COLOR ? Draw::FB_COLOR_BIT : Draw::FB_DEPTH_BIT, x, y, w, h, destFormat, destPtr, stride, mode, "ReadbackFramebufferSync");
+		const int channelBits = channel == RASTER_COLOR ? Draw::FB_COLOR_BIT : Draw::FB_DEPTH_BIT;
+		if (!draw_->CopyFramebufferToMemory(vfb->fbo, channelBits, x, y, w, h, destFormat, destPtr, stride, mode, "ReadbackFramebufferSync") && blockOnDelayedMiss && mode == Draw::ReadbackMode::OLD_DATA_OK) {
+			// Nothing from earlier frames to give us yet (the delayed copy is now queued for next time), so wait this once.
+			readbackPredictor_.NotifyDelayedMiss();
+			mode = Draw::ReadbackMode::BLOCK;
+			draw_->CopyFramebufferToMemory(vfb->fbo, channelBits, x, y, w, h, destFormat, destPtr, stride, mode, "ReadbackFramebufferSync");
+		}
 	}
 
 	char tag[128];
@@ -3195,25 +3202,23 @@ void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb,
 			if (channel == RASTER_COLOR)
 				vfb->memoryUpdated = true;
 			vfb->usageFlags |= FB_USAGE_DOWNLOAD;
-		} else {
-			// Let's try to set the flag eventually, if the game copies a lot.
-			// Some games (like Grand Knights History) copy subranges very frequently.
-			const static int FREQUENT_SEQUENTIAL_COPIES = 3;
-			static int frameLastCopy = 0;
-			static u32 bufferLastCopy = 0;
-			static int copiesThisFrame = 0;
-			if (frameLastCopy != gpuStats.numFlips || bufferLastCopy != vfb->fb_address) {
-				frameLastCopy = gpuStats.numFlips;
-				bufferLastCopy = vfb->fb_address;
-				copiesThisFrame = 0;
-			}
-			if (++copiesThisFrame > FREQUENT_SEQUENTIAL_COPIES) {
-				gameUsesSequentialCopies_ = true;
-			}
+		} else if (readbackPredictor_.NoteSubrangeCopy(vfb->fb_address, gpuStats.numFlips)) {
+			// Let's set the flag eventually, if the game copies a lot.
+			gameUsesSequentialCopies_ = true;
+		}
+
+		// Only readbacks the predictor delayed wait on a miss.  Callers asking for old data
+		// themselves are fine with whatever is (or isn't) there, same as always.
+		bool predicted = false;
+		if (channel == RASTER_COLOR && g_Config.bPredictReadbacks) {
+			// If the game reads this every frame, it can usually make do with last frame's pixels.
+			Draw::ReadbackMode predictedMode = readbackPredictor_.Predict(vfb->fb_address, x, y, w, h, gpuStats.numFlips, mode);
+			predicted = predictedMode != mode;
+			mode = predictedMode;
 		}
 
 		// This handles any required stretching internally.
-		ReadbackFramebuffer(vfb, x, y, w, h, channel, mode);
+		ReadbackFramebuffer(vfb, x, y, w, h, channel, mode, predicted);
 
 		draw_->Invalidate(InvalidationFlags::CACHED_RENDER_STATE);
 		textureCache_->ForgetLastTexture();
@@ -3265,7 +3270,7 @@ void FramebufferManagerCommon::DownloadFramebufferForClut(u32 fb_address, u32 lo
 			vfb->clutUpdatedBytes = loadBytes;
 
 			// This function now handles scaling down internally.
-			ReadbackFramebuffer(vfb, x, y, w, h, RASTER_COLOR, Draw::ReadbackMode::BLOCK);
+			ReadbackFramebuffer(vfb, x, y, w, h, RASTER_COLOR, Draw::ReadbackMode::BLOCK, false);
 
 			textureCache_->ForgetLastTexture();
 			RebindFramebuffer("RebindFramebuffer - DownloadFramebufferForClut");
@@ -3336,6 +3341,7 @@ void FramebufferManagerCommon::DeviceRestore(Draw::DrawContext *draw) {
 	draw_ = draw;
 	draw2D_.DeviceRestore(draw_);
 	presentation_->DeviceRestore(draw_);
+	readbackPredictor_.SetDelayedReadbackSupported(draw->GetDeviceCaps().delayedReadbackSupported);
 }
 
 void FramebufferManagerCommon::DrawActiveTexture(float x, float y, float w, float h, float destW, float destH, float u0, float v0, float u1, float v1, int uvRotation, int flags) {
@@ -35,6 +35,7 @@
 #include "GPU/ge_constants.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/Common/Draw2D.h"
+#include "GPU/Common/ReadbackPredictor.h"
 
 enum {
 	FB_USAGE_DISPLAYED_FRAMEBUFFER = 1,
@@ -489,7 +490,8 @@ class FramebufferManagerCommon {
 	bool PresentedThisFrame() const;
 
 protected:
-	virtual void ReadbackFramebuffer(VirtualFramebuffer *vfb, int x, int y, int w, int h, RasterChannel channel, Draw::ReadbackMode mode);
+	// If blockOnDelayedMiss is set, an OLD_DATA_OK readback that has no data ready yet blocks instead.
+	virtual void ReadbackFramebuffer(VirtualFramebuffer *vfb, int x, int y, int w, int h, RasterChannel channel, Draw::ReadbackMode mode, bool blockOnDelayedMiss);
 	// Used for when a shader is required, such as GLES.
 	virtual bool ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x, int y, int w, int h, uint16_t *pixels, int pixelsStride, int destW, int destH, Draw::ReadbackMode mode);
 	virtual bool ReadbackStencilbuffer(Draw::Framebuffer *fbo, int x, int y, int w, int h, uint8_t *pixels, int pixelsStride, Draw::ReadbackMode mode);
@@ -590,6 +592,7 @@ class FramebufferManagerCommon {
 	std::vector<DrawPixelsEntry> drawPixelsCache_;
 
 	bool gameUsesSequentialCopies_ = false;
+	ReadbackPredictor readbackPredictor_;
 
 	// Sampled in BeginFrame/UpdateSize for safety.
 	float renderWidth_ = 0.0f;
@@ -0,0 +1,91 @@
+// Copyright (c) 2025- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "GPU/Common/ReadbackPredictor.h"
+
+// Buffers not read back in this many frames are forgotten.
+static const int HISTORY_MAX_AGE = 60;
+
+Draw::ReadbackMode ReadbackPredictor::Predict(uint32_t address, int x, int y, int w, int h, int frame, Draw::ReadbackMode requested) {
+	if (requested != Draw::ReadbackMode::BLOCK)
+		return requested;
+
+	auto iter = history_.find(address);
+	if (iter == history_.end()) {
+		if (history_.size() >= 32)
+			Prune(frame);
+		history_[address] = History{ frame, x, y, w, h, 1, false };
+		return Draw::ReadbackMode::BLOCK;
+	}
+
+	History &hist = iter->second;
+	const bool sameRect = hist.x == x && hist.y == y && hist.w == w && hist.h == h;
+	if (frame == hist.lastFrame) {
+		// Reading more than once a frame means the game is likely waiting for something specific
+		// to be drawn, so don't trust it with old data.  It has to prove itself again.
+		hist.readTwice = true;
+		hist.steadyFrames = 0;
+	} else if (frame == hist.lastFrame + 1 && sameRect && !hist.readTwice) {
+		hist.steadyFrames++;
+	} else {
+		hist.steadyFrames = 1;
+		hist.readTwice = false;
+	}
+	hist.lastFrame = frame;
+	hist.x = x;
+	hist.y = y;
+	hist.w = w;
+	hist.h = h;
+
+	if (delayedSupported_ && hist.steadyFrames >= STEADY_FRAMES) {
+		delayedCount_++;
+		return Draw::ReadbackMode::OLD_DATA_OK;
+	}
+	return Draw::ReadbackMode::BLOCK;
+}
+
+void ReadbackPredictor::NotifyDelayedMiss() {
+	delayedMissCount_++;
+}
+
+bool ReadbackPredictor::NoteSubrangeCopy(uint32_t address, int frame) {
+	// Some games (like Grand Knights History) copy subranges very frequently.
+	if (subrangeFrame_ != frame || subrangeAddress_ != address) {
+		subrangeFrame_ = frame;
+		subrangeAddress_ = address;
+		subrangeCopies_ = 0;
+	}
+	return ++subrangeCopies_ > FREQUENT_SEQUENTIAL_COPIES;
+}
+
+void ReadbackPredictor::Prune(int frame) {
+	for (auto iter = history_.begin(); iter != history_.end(); ) {
+		if (frame - iter->second.lastFrame > HISTORY_MAX_AGE)
+			iter = history_.erase(iter);
+		else
+			++iter;
+	}
+}
+
+void ReadbackPredictor::Reset() {
+	history_.clear();
+	delayedCount_ = 0;
+	delayedMissCount_ = 0;
+	subrangeFrame_ = -1;
+	subrangeAddress_ = 0;
+	subrangeCopies_ = 0;
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2025- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "Common/GPU/thin3d.h"
+
+// Decides how framebuffer readbacks into PSP RAM are done, based on what the game did in
+// previous frames.
+//
+// A game that reads the same rectangle of the same framebuffer once every frame is usually
+// feeding a CPU side effect (motion blur, a lens flare test, a saved screenshot), and can live
+// with data that's a frame or two old.  Once we've seen that often enough in a row, readbacks are
+// switched to Draw::ReadbackMode::OLD_DATA_OK, so backends that keep their own ring of per-frame
+// staging buffers (see DeviceCaps::delayedReadbackSupported) can copy last frame's results out
+// without stalling.  Anything out of pattern - a second read in the same frame, a different
+// rectangle, a skipped frame - goes back to blocking readbacks until the pattern is re-established.
+//
+// Also tracks games that read framebuffers in many small pieces, in which case we're better off
+// reading the whole thing at once.
+class ReadbackPredictor {
+public:
+	// Needs this many frames in a row reading the same rectangle before delaying.
+	static constexpr int STEADY_FRAMES = 8;
+	// More small copies than this from one buffer in one frame means the game copies sequentially.
+	static constexpr int FREQUENT_SEQUENTIAL_COPIES = 3;
+
+	void SetDelayedReadbackSupported(bool supported) {
+		delayedSupported_ = supported;
+	}
+
+	// Returns the mode to use for a color readback requested with the given mode.
+	// Requests that already allow old data are left alone.
+	Draw::ReadbackMode Predict(uint32_t address, int x, int y, int w, int h, int frame, Draw::ReadbackMode requested);
+
+	// Call when a delayed readback had no data ready yet, and we had to block after all.
+	void NotifyDelayedMiss();
+
+	// Call for readbacks that only cover part of the buffer. Returns true once it's been seen
+	// often enough that the whole buffer should be read instead.
+	bool NoteSubrangeCopy(uint32_t address, int frame);
+
+	void Reset();
+
+	int DelayedCount() const { return delayedCount_; }
+	int DelayedMissCount() const { return delayedMissCount_; }
+
+private:
+	struct History {
+		int lastFrame;
+		int x, y, w, h;
+		int steadyFrames;
+		bool readTwice;
+	};
+
+	void Prune(int frame);
+
+	std::unordered_map<uint32_t, History> history_;
+	bool delayedSupported_ = false;
+
+	int delayedCount_ = 0;
+	int delayedMissCount_ = 0;
+
+	int subrangeFrame_ = -1;
+	uint32_t subrangeAddress_ = 0;
+	int subrangeCopies_ = 0;
+};
@@ -16,13 +16,17 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #include "ppsspp_config.h"
 
 #include <png.h>
+#include <zstd.h>
 
 #include "ext/basis_universal/basisu_transcoder.h"
 #include "ext/basis_universal/basisu_file_headers.h"
+#include "ext/xxhash.h"
 
 #include "GPU/Common/ReplacedTexture.h"
 #include "GPU/Common/TextureReplacer.h"
@@ -31,6 +35,9 @@
 #include "Common/Data/Format/DDSLoad.h"
 #include "Common/Data/Format/ZIMLoad.h"
 #include "Common/Data/Format/PNGLoad.h"
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
 #include "Common/Thread/ParallelLoop.h"
 #include "Common/Thread/Waitable.h"
 #include "Common/Thread/ThreadManager.h"
@@ -287,6 +294,292 @@ void ReplacedTexture::Prepare(VFSBackend *vfs) {
 	// the caller calls threadWaitable->notify().
 }
 
+KTX2Formats ChooseKTX2Formats(const GPUFormatSupport &support) {
+	KTX2Formats formats;
+	// ETC1S is opaque only, so plain BC1 or ETC2 RGB will do.
+	if (support.bc123) {
+		formats.etc1s = Draw::DataFormat::BC1_RGBA_UNORM_BLOCK;
+	} else if (support.etc2) {
+		formats.etc1s = Draw::DataFormat::ETC2_R8G8B8_UNORM_BLOCK;
+	} else {
+		formats.etc1s = Draw::DataFormat::R8G8B8A8_UNORM;
+	}
+	if (support.bc7) {
+		formats.uastc = Draw::DataFormat::BC7_UNORM_BLOCK;
+	} else if (support.astc) {
+		formats.uastc = Draw::DataFormat::ASTC_4x4_UNORM_BLOCK;
+	} else {
+		formats.uastc = Draw::DataFormat::R8G8B8A8_UNORM;
+	}
+	if (formats.etc1s == Draw::DataFormat::R8G8B8A8_UNORM || formats.uastc == Draw::DataFormat::R8G8B8A8_UNORM) {
+		// A bit slow and takes a lot of memory, but better than nothing.
+		INFO_LOG(Log::G3D, "Not all KTX2 replacement texture formats supported - will transcode some to RGBA8888");
+	}
+	return formats;
+}
+
+static basist::transcoder_texture_format KTX2TranscoderFormat(Draw::DataFormat fmt) {
+	switch (fmt) {
+	case Draw::DataFormat::BC1_RGBA_UNORM_BLOCK: return basist::transcoder_texture_format::cTFBC1;
+	case Draw::DataFormat::ETC2_R8G8B8_UNORM_BLOCK: return basist::transcoder_texture_format::cTFETC1_RGB;
+	case Draw::DataFormat::BC7_UNORM_BLOCK: return basist::transcoder_texture_format::cTFBC7_RGBA;
+	case Draw::DataFormat::ASTC_4x4_UNORM_BLOCK: return basist::transcoder_texture_format::cTFASTC_4x4_RGBA;
+	default: return basist::transcoder_texture_format::cTFRGBA32;
+	}
+}
+
+// Size of one transcoded level, matching what transcode_image_level writes.
+static size_t KTX2LevelDataSize(int w, int h, bool bc, int blockSize) {
+	if (bc)
+		return (size_t)((w + 3) / 4) * ((h + 3) / 4) * blockSize;
+	return (size_t)w * h * 4;
+}
+
+// UASTC blocks are independent, so large levels are split into bands of block rows.
+static const uint32_t KTX2_BAND_BLOCK_ROWS = 32;
+
+struct KTX2TranscodeJob {
+	uint32_t level;
+	uint32_t firstBlockRow;
+	uint32_t numBlockRows;
+};
+
+// Transcodes all levels of the texture into out, spread over the thread pool.
+static bool TranscodeKTX2Levels(basist::ktx2_transcoder &transcoder, Draw::DataFormat fmt, std::vector<std::vector<uint8_t>> &out) {
+	const basist::transcoder_texture_format transcoderFormat = KTX2TranscoderFormat(fmt);
+	int blockSize = 0;
+	const bool bc = Draw::DataFormatIsBlockCompressed(fmt, &blockSize);
+	const uint32_t numLevels = (uint32_t)transcoder.get_level_index().size();
+	const uint32_t outputBlockBytes = bc ? blockSize : 4;
+
+	std::vector<basist::ktx2_image_level_info> levelInfos(numLevels);
+	for (uint32_t i = 0; i < numLevels; i++) {
+		if (!transcoder.get_image_level_info(levelInfos[i], i, 0, 0))
+			return false;
+		out[i].resize(KTX2LevelDataSize(levelInfos[i].m_orig_width, levelInfos[i].m_orig_height, bc, blockSize));
+	}
+
+	std::atomic<bool> failed{};
+	std::vector<KTX2TranscodeJob> jobs;
+	if (transcoder.is_uastc()) {
+		// Bands need the raw UASTC blocks, so supercompressed levels are unpacked first.
+		const bool zstd = transcoder.get_header().m_supercompression_scheme == basist::KTX2_SS_ZSTANDARD;
+		std::vector<std::vector<uint8_t>> unpacked(zstd ? numLevels : 0);
+		if (zstd) {
+			ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+				for (int i = l; i < h; i++) {
+					const basist::ktx2_level_index &index = transcoder.get_level_index()[i];
+					unpacked[i].resize((size_t)index.m_uncompressed_byte_length);
+					size_t result = ZSTD_decompress(unpacked[i].data(), unpacked[i].size(), transcoder.get_data() + index.m_byte_offset, (size_t)index.m_byte_length);
+					if (ZSTD_isError(result) || result != unpacked[i].size())
+						failed = true;
+				}
+			}, 0, (int)numLevels, 1);
+			if (failed)
+				return false;
+		}
+
+		for (uint32_t i = 0; i < numLevels; i++) {
+			const uint32_t blockRows = levelInfos[i].m_num_blocks_y;
+			for (uint32_t row = 0; row < blockRows; row += KTX2_BAND_BLOCK_ROWS)
+				jobs.push_back(KTX2TranscodeJob{ i, row, std::min(KTX2_BAND_BLOCK_ROWS, blockRows - row) });
+		}
+
+		basist::basisu_lowlevel_uastc_transcoder uastc;
+		const bool hasAlpha = transcoder.get_has_alpha() != 0;
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			for (int j = l; j < h; j++) {
+				const KTX2TranscodeJob &job = jobs[j];
+				const basist::ktx2_image_level_info &info = levelInfos[job.level];
+				const uint8_t *levelData = zstd ? unpacked[job.level].data() : transcoder.get_data() + transcoder.get_level_index()[job.level].m_byte_offset;
+				const uint32_t levelDataSize = zstd ? (uint32_t)unpacked[job.level].size() : (uint32_t)transcoder.get_level_index()[job.level].m_byte_length;
+
+				const uint32_t srcOffset = job.firstBlockRow * info.m_num_blocks_x * basist::KTX2_UASTC_BLOCK_SIZE;
+				const uint32_t srcSize = job.numBlockRows * info.m_num_blocks_x * basist::KTX2_UASTC_BLOCK_SIZE;
+				if (srcOffset + srcSize > levelDataSize) {
+					failed = true;
+					continue;
+				}
+
+				// In pixels for RGBA, blocks otherwise.  The last band may be cut short by the image height.
+				const uint32_t firstPixelRow = job.firstBlockRow * 4;
+				const uint32_t bandHeight = std::min(job.numBlockRows * 4, info.m_orig_height - firstPixelRow);
+				const uint32_t outputPitch = bc ? info.m_num_blocks_x : info.m_orig_width;
+				const uint32_t outputRow = bc ? job.firstBlockRow : firstPixelRow;
+				const uint32_t outputSize = bc ? job.numBlockRows * info.m_num_blocks_x : bandHeight * info.m_orig_width;
+				uint8_t *dst = out[job.level].data() + (size_t)outputRow * outputPitch * outputBlockBytes;
+
+				if (!uastc.transcode_image(transcoderFormat, dst, outputSize, levelData + srcOffset, srcSize,
+						info.m_num_blocks_x, job.numBlockRows, info.m_orig_width, bandHeight, job.level, 0, srcSize,
+						0, hasAlpha, false, outputPitch, nullptr, bc ? 0 : bandHeight)) {
+					failed = true;
+				}
+			}
+		}, 0, (int)jobs.size(), 1);
+	} else {
+		// ETC1S is entropy coded across the whole level, so only whole levels can go in parallel.
+		if (!transcoder.start_transcoding())
+			return false;
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			basist::ktx2_transcoder_state state;  // Each thread needs one of these.
+			for (int i = l; i < h; i++) {
+				const basist::ktx2_image_level_info &info = levelInfos[i];
+				const uint32_t outputPitch = bc ? info.m_num_blocks_x : info.m_orig_width;
+				const uint32_t outputSize = bc ? info.m_total_blocks : info.m_orig_width * info.m_orig_height;
+				state.clear();
+				if (!transcoder.transcode_image_level(i, 0, 0, out[i].data(), outputSize, transcoderFormat, 0, outputPitch, bc ? 0 : info.m_orig_height, -1, -1, &state))
+					failed = true;
+			}
+		}, 0, (int)numLevels, 1);
+	}
+	return !failed;
+}
+
+// Transcoded KTX2 textures are cached by content hash and target format, so a texture pack that
+// has been loaded once can be uploaded straight from the cache afterwards.
+static const uint32_t TRANSCODE_CACHE_MAGIC = 0x4354504B;  // 'KPTC'
+// Bump if the layout changes, or the transcoder starts producing different output.
+static const uint32_t TRANSCODE_CACHE_VERSION = 1;
+
+struct TranscodeCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t contentHash;
+	uint32_t dataFormat;
+	uint32_t alphaStatus;
+	uint32_t numLevels;
+	uint32_t reserved;
+};
+
+struct TranscodeCacheLevel {
+	uint32_t w;
+	uint32_t h;
+};
+
+// Transcoded data is several times the size of the KTX2 it came from, so cap what a game can use.
+// Once over, the oldest entries are removed until it's down to the trim target, so we don't
+// have to trim again on the very next write.
+static const uint64_t TRANSCODE_CACHE_BUDGET = 1024ULL * 1024 * 1024;
+static const uint64_t TRANSCODE_CACHE_TRIM_TARGET = TRANSCODE_CACHE_BUDGET * 3 / 4;
+
+static std::mutex transcodeCacheSizeLock;
+// The directory transcodeCacheSize was counted for, empty if not counted yet.
+static Path transcodeCacheSizeDir;
+static uint64_t transcodeCacheSize;
+
+static Path TranscodeCacheFilename(const Path &dir, uint64_t contentHash, Draw::DataFormat fmt) {
+	return dir / StringFromFormat("%016llx_%d.ktc", (unsigned long long)contentHash, (int)fmt);
+}
+
+static bool ReadTranscodeCache(const Path &filename, uint64_t contentHash, Draw::DataFormat fmt, std::vector<TranscodeCacheLevel> *levels, std::vector<std::vector<uint8_t>> *data, ReplacedTextureAlpha *alphaStatus) {
+	File::IOFile file(filename, "rb");
+	if (!file.IsOpen())
+		return false;
+
+	TranscodeCacheHeader header;
+	if (!file.ReadArray(&header, 1))
+		return false;
+	if (header.magic != TRANSCODE_CACHE_MAGIC || header.version != TRANSCODE_CACHE_VERSION || header.contentHash != contentHash || header.dataFormat != (uint32_t)fmt)
+		return false;
+	if (header.numLevels == 0 || header.numLevels > MAX_REPLACEMENT_MIP_LEVELS)
+		return false;
+
+	levels->resize(header.numLevels);
+	if (!file.ReadArray(levels->data(), levels->size()))
+		return false;
+
+	int blockSize = 0;
+	bool bc = Draw::DataFormatIsBlockCompressed(fmt, &blockSize);
+	uint64_t expectedSize = sizeof(header) + sizeof(TranscodeCacheLevel) * header.numLevels;
+	for (const TranscodeCacheLevel &level : *levels) {
+		if (level.w == 0 || level.h == 0 || level.w > 16384 || level.h > 16384)
+			return false;
+		expectedSize += KTX2LevelDataSize(level.w, level.h, bc, blockSize);
+	}
+	if (file.GetSize() != expectedSize)
+		return false;
+
+	data->resize(header.numLevels);
+	for (uint32_t i = 0; i < header.numLevels; i++) {
+		std::vector<uint8_t> &out = (*data)[i];
+		out.resize(KTX2LevelDataSize((*levels)[i].w, (*levels)[i].h, bc, blockSize));
+		if (!file.ReadBytes(out.data(), out.size()))
+			return false;
+	}
+	*alphaStatus = (ReplacedTextureAlpha)header.alphaStatus;
+	return true;
+}
+
+static void TrimTranscodeCache(const Path &dir, const Path &keep) {
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(dir, &files, "ktc:");
+	// Oldest first.  Entries are only written once, so this is roughly least recently transcoded.
+	std::sort(files.begin(), files.end(), [](const File::FileInfo &a, const File::FileInfo &b) {
+		return a.mtime < b.mtime;
+	});
+
+	int removed = 0;
+	for (const File::FileInfo &file : files) {
+		if (transcodeCacheSize <= TRANSCODE_CACHE_TRIM_TARGET)
+			break;
+		if (file.isDirectory || file.fullName == keep)
+			continue;
+		if (File::Delete(file.fullName)) {
+			transcodeCacheSize -= std::min(transcodeCacheSize, file.size);
+			removed++;
+		}
+	}
+	INFO_LOG(Log::G3D, "Trimmed transcoded texture cache, removed %d files", removed);
+}
+
+static void AddTranscodeCacheSize(const Path &dir, const Path &filename, uint64_t bytes) {
+	std::lock_guard<std::mutex> guard(transcodeCacheSizeLock);
+	if (transcodeCacheSizeDir != dir) {
+		// First write for this game, count what's already there (including the new file.)
+		std::vector<File::FileInfo> files;
+		File::GetFilesInDir(dir, &files, "ktc:");
+		transcodeCacheSize = 0;
+		for (const File::FileInfo &file : files)
+			transcodeCacheSize += file.isDirectory ? 0 : file.size;
+		transcodeCacheSizeDir = dir;
+	} else {
+		transcodeCacheSize += bytes;
+	}
+
+	if (transcodeCacheSize > TRANSCODE_CACHE_BUDGET)
+		TrimTranscodeCache(dir, filename);
+}
+
+static void WriteTranscodeCache(const Path &dir, const Path &filename, uint64_t contentHash, Draw::DataFormat fmt, const std::vector<TranscodeCacheLevel> &levels, const std::vector<std::vector<uint8_t>> &data, ReplacedTextureAlpha alphaStatus) {
+	if (!File::Exists(dir) && !File::CreateFullPath(dir))
+		return;
+
+	// Write to the side and rename, so a crash or a full disk never leaves a bad entry behind.
+	Path tempFilename = filename.WithExtraExtension(".tmp");
+	bool success;
+	{
+		File::IOFile file(tempFilename, "wb");
+		if (!file.IsOpen())
+			return;
+
+		TranscodeCacheHeader header{ TRANSCODE_CACHE_MAGIC, TRANSCODE_CACHE_VERSION, contentHash, (uint32_t)fmt, (uint32_t)alphaStatus, (uint32_t)levels.size() };
+		success = file.WriteArray(&header, 1) && file.WriteArray(levels.data(), levels.size());
+		for (size_t i = 0; success && i < levels.size(); i++)
+			success = file.WriteBytes(data[i].data(), data[i].size());
+	}
+
+	if (!success || !File::Rename(tempFilename, filename)) {
+		WARN_LOG(Log::G3D, "Failed to write transcoded texture cache: %s", filename.ToVisualString().c_str());
+		File::Delete(tempFilename);
+		return;
+	}
+
+	uint64_t written = sizeof(TranscodeCacheHeader) + sizeof(TranscodeCacheLevel) * levels.size();
+	for (const std::vector<uint8_t> &levelData : data)
+		written += levelData.size();
+	AddTranscodeCacheSize(dir, filename, written);
+}
+
 // Returns true if Prepare should keep calling this to load more levels.
 ReplacedTexture::LoadLevelResult ReplacedTexture::LoadLevelData(VFSFileReference *fileRef, const std::string &filename, int mipLevel, Draw::DataFormat *pixelFormat) {
 	bool good = false;
@@ -457,52 +750,33 @@ ReplacedTexture::LoadLevelResult ReplacedTexture::LoadLevelData(VFSFileReference
 	level.fileRef = fileRef;
 
 	if (imageType == ReplacedImageType::KTX2) {
-		// Just slurp the whole file in one go and feed to the decoder.
+		// Transcode straight out of the pack if it's mapped, otherwise slurp the whole file in one go.
 		std::vector<uint8_t> buffer;
-		buffer.resize(fileSize);
-		buffer.resize(vfs_->Read(openFile, &buffer[0], buffer.size()));
+		size_t ktxSize = 0;
+		const uint8_t *ktxData = vfs_->MapFile(fileRef, &ktxSize);
+		if (!ktxData) {
+			buffer.resize(fileSize);
+			buffer.resize(vfs_->Read(openFile, &buffer[0], buffer.size()));
+			ktxData = buffer.data();
+			ktxSize = buffer.size();
+		}
 
 		basist::ktx2_transcoder transcoder;
-		if (!transcoder.init(buffer.data(), (int)buffer.size())) {
+		if (!transcoder.init(ktxData, (int)ktxSize) || transcoder.get_level_index().empty()) {
 			WARN_LOG(Log::G3D, "Error reading KTX file");
 			vfs_->CloseFile(openFile);
 			return LoadLevelResult::LOAD_ERROR;
 		}
 
-		// Figure out the target format.
-		basist::transcoder_texture_format transcoderFormat;
+		// The target format was picked up front, see ChooseKTX2Formats.
 		if (transcoder.is_etc1s()) {
 			// We only support opaque colors with this compression method.
 			alphaStatus_ = ReplacedTextureAlpha::FULL;
-			// Let's pick a suitable compatible format.
-			if (desc_.formatSupport.bc123) {
-				transcoderFormat = basist::transcoder_texture_format::cTFBC1;
-				*pixelFormat = Draw::DataFormat::BC1_RGBA_UNORM_BLOCK;
-			} else if (desc_.formatSupport.etc2) {
-				transcoderFormat = basist::transcoder_texture_format::cTFETC1_RGB;
-				*pixelFormat = Draw::DataFormat::ETC2_R8G8B8_UNORM_BLOCK;
-			} else {
-				// Transcode to RGBA8 instead as a fallback. A bit slow and takes a lot of memory, but better than nothing.
-				WARN_LOG(Log::G3D, "Replacement texture format not supported - transcoding to RGBA8888");
-				transcoderFormat = basist::transcoder_texture_format::cTFRGBA32;
-				*pixelFormat = Draw::DataFormat::R8G8B8A8_UNORM;
-			}
+			*pixelFormat = desc_.ktx2Formats.etc1s;
 		} else if (transcoder.is_uastc()) {
 			// TODO: Try to recover some indication of alpha from the actual data blocks.
 			alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
-			// Let's pick a suitable compatible format.
-			if (desc_.formatSupport.bc7) {
-				transcoderFormat = basist::transcoder_texture_format::cTFBC7_RGBA;
-				*pixelFormat = Draw::DataFormat::BC7_UNORM_BLOCK;
-			} else if (desc_.formatSupport.astc) {
-				transcoderFormat = basist::transcoder_texture_format::cTFASTC_4x4_RGBA;
-				*pixelFormat = Draw::DataFormat::ASTC_4x4_UNORM_BLOCK;
-			} else {
-				// Transcode to RGBA8 instead as a fallback. A bit slow and takes a lot of memory, but better than nothing.
-				WARN_LOG(Log::G3D, "Replacement texture format not supported - transcoding to RGBA8888");
-				transcoderFormat = basist::transcoder_texture_format::cTFRGBA32;
-				*pixelFormat = Draw::DataFormat::R8G8B8A8_UNORM;
-			}
+			*pixelFormat = desc_.ktx2Formats.uastc;
 		} else {
 			WARN_LOG(Log::G3D, "PPSSPP currently only supports KTX for basis/UASTC textures. This may change in the future.");
 			vfs_->CloseFile(openFile);
@@ -517,40 +791,51 @@ ReplacedTexture::LoadLevelResult ReplacedTexture::LoadLevelData(VFSFileReference
 			WARN_LOG(Log::G3D, "Block compressed replacement texture '%s' not divisible by 4x4 (%dx%d). In D3D11 (only!) we will have to expand (potentially causing glitches).", filename.c_str(), level.w, level.h);
 		}
 
-		data_.resize(numMips);
-
-		basist::ktx2_transcoder_state transcodeState;  // Each thread needs one of these.
+		uint64_t contentHash = 0;
+		Path cacheFilename;
+		std::vector<TranscodeCacheLevel> cacheLevels;
+		std::vector<std::vector<uint8_t>> levelData;
+		bool cached = false;
+		if (!desc_.transcodeCacheDir.empty()) {
+			contentHash = XXH3_64bits(ktxData, ktxSize);
+			cacheFilename = TranscodeCacheFilename(desc_.transcodeCacheDir, contentHash, *pixelFormat);
+			cached = ReadTranscodeCache(cacheFilename, contentHash, *pixelFormat, &cacheLevels, &levelData, &alphaStatus_);
+		}
 
-		transcoder.start_transcoding();
-		levels_.reserve(numMips);
-		for (int i = 0; i < numMips; i++) {
-			std::vector<uint8_t> &out = data_[mipLevel + i];
+		if (!cached) {
+			numMips = (int)transcoder.get_level_index().size();
+			levelData.resize(numMips);
+			if (!TranscodeKTX2Levels(transcoder, *pixelFormat, levelData)) {
+				ERROR_LOG(Log::G3D, "Failed to transcode KTX2 texture '%s'", filename.c_str());
+				transcoder.clear();
+				vfs_->CloseFile(openFile);
+				return LoadLevelResult::LOAD_ERROR;
+			}
 
-			basist::ktx2_image_level_info levelInfo{};
-			bool result = transcoder.get_image_level_info(levelInfo, i, 0, 0);
-			_dbg_assert_(result);
-
-			size_t dataSizeBytes = levelInfo.m_total_blocks * blockSize;
-			size_t outputSize = levelInfo.m_total_blocks;
-			size_t outputPitch = levelInfo.m_num_blocks_x;
-			// Support transcoded-to-RGBA8888 images too.
-			if (!bc) {
-				dataSizeBytes = levelInfo.m_orig_width * levelInfo.m_orig_height * 4;
-				outputSize = levelInfo.m_orig_width * levelInfo.m_orig_height;
-				outputPitch = levelInfo.m_orig_width;
+			cacheLevels.resize(numMips);
+			for (int i = 0; i < numMips; i++) {
+				basist::ktx2_image_level_info levelInfo{};
+				transcoder.get_image_level_info(levelInfo, i, 0, 0);
+				cacheLevels[i].w = levelInfo.m_orig_width;
+				cacheLevels[i].h = levelInfo.m_orig_height;
 			}
-			data_[i].resize(dataSizeBytes);
+			if (!desc_.transcodeCacheDir.empty())
+				WriteTranscodeCache(desc_.transcodeCacheDir, cacheFilename, contentHash, *pixelFormat, cacheLevels, levelData, alphaStatus_);
+		}
+		transcoder.clear();
+		vfs_->CloseFile(openFile);
 
-			transcodeState.clear();
-			transcoder.transcode_image_level(i, 0, 0, &out[0], (uint32_t)outputSize, transcoderFormat, 0, (uint32_t)outputPitch, level.h, -1, -1, &transcodeState);
-			level.w = levelInfo.m_orig_width;
-			level.h = levelInfo.m_orig_height;
+		numMips = (int)cacheLevels.size();
+		data_.resize(mipLevel + numMips);
+		levels_.reserve(mipLevel + numMips);
+		for (int i = 0; i < numMips; i++) {
+			data_[mipLevel + i] = std::move(levelData[i]);
+			level.w = cacheLevels[i].w;
+			level.h = cacheLevels[i].h;
 			if (i != 0)
 				level.fileRef = nullptr;
 			levels_.push_back(level);
 		}
-		transcoder.clear();
-		vfs_->CloseFile(openFile);
 
 		return LoadLevelResult::DONE;  // don't read more levels
 	} else if (imageType == ReplacedImageType::DDS) {
@@ -650,9 +935,15 @@ ReplacedTexture::LoadLevelResult ReplacedTexture::LoadLevelData(VFSFileReference
 		png.version = PNG_IMAGE_VERSION;
 
 		std::string pngdata;
-		pngdata.resize(fileSize);
-		pngdata.resize(vfs_->Read(openFile, &pngdata[0], fileSize));
-		if (!png_image_begin_read_from_memory(&png, &pngdata[0], pngdata.size())) {
+		size_t pngSize = 0;
+		const uint8_t *pngPtr = vfs_->MapFile(fileRef, &pngSize);
+		if (!pngPtr) {
+			pngdata.resize(fileSize);
+			pngdata.resize(vfs_->Read(openFile, &pngdata[0], fileSize));
+			pngPtr = (const uint8_t *)pngdata.data();
+			pngSize = pngdata.size();
+		}
+		if (!png_image_begin_read_from_memory(&png, pngPtr, pngSize)) {
 			ERROR_LOG(Log::G3D, "Could not load texture replacement info: %s - %s (zip)", filename.c_str(), png.message);
 			vfs_->CloseFile(openFile);
 			return LoadLevelResult::LOAD_ERROR;
@@ -69,6 +69,15 @@ struct GPUFormatSupport {
 	bool etc2;
 };
 
+// What we transcode KTX2 (basis) textures to, depending on what they contain.  Chosen once per
+// backend from the format support above.
+struct KTX2Formats {
+	Draw::DataFormat etc1s;
+	Draw::DataFormat uastc;
+};
+
+KTX2Formats ChooseKTX2Formats(const GPUFormatSupport &support);
+
 struct ReplacementDesc {
 	int newW;
 	int newH;
@@ -82,6 +91,9 @@ struct ReplacementDesc {
 	std::vector<std::string> filenames;
 	std::string logId;
 	GPUFormatSupport formatSupport;
+	KTX2Formats ktx2Formats;
+	// Where transcoded KTX2 textures are cached, empty to not cache them.
+	Path transcodeCacheDir;
 };
 
 class ReplacedTexture;
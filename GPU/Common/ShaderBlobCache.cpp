@@ -0,0 +1,162 @@
+// Copyright (c) 2024- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "GPU/Common/ShaderBlobCache.h"
+#include "ext/xxhash.h"
+
+static const uint32_t BLOB_CACHE_MAGIC = 0x42534850;  // 'PHSB'
+// Sanity limit, a single shader blob should never get close to this.
+static const uint32_t BLOB_MAX_SIZE = 4 * 1024 * 1024;
+
+struct BlobCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t reserved;
+};
+
+struct BlobEntryHeader {
+	uint64_t key;
+	uint32_t size;
+	uint32_t reserved;
+};
+
+uint64_t ShaderBlobCache::MakeKey(int stage, const char *code) {
+	XXH3_state_t *state = XXH3_createState();
+	XXH3_64bits_reset(state);
+	XXH3_64bits_update(state, &stage, sizeof(stage));
+	XXH3_64bits_update(state, code, strlen(code));
+	uint64_t key = XXH3_64bits_digest(state);
+	XXH3_freeState(state);
+	return key;
+}
+
+bool ShaderBlobCache::Find(uint64_t key, std::vector<uint8_t> *blob) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = blobs_.find(key);
+	if (it == blobs_.end())
+		return false;
+	*blob = it->second;
+	return true;
+}
+
+void ShaderBlobCache::Insert(uint64_t key, const void *data, size_t size) {
+	if (size == 0 || size > BLOB_MAX_SIZE)
+		return;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	blobs_[key].assign((const uint8_t *)data, (const uint8_t *)data + size);
+}
+
+void ShaderBlobCache::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	blobs_.clear();
+}
+
+size_t ShaderBlobCache::size() const {
+	std::lock_guard<std::mutex> guard(lock_);
+	return blobs_.size();
+}
+
+bool ShaderBlobCache::Load(const Path &filename, uint32_t version) {
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return false;
+
+	BlobCacheHeader header{};
+	bool success = fread(&header, sizeof(header), 1, f) == 1;
+	if (!success || header.magic != BLOB_CACHE_MAGIC || header.version != version) {
+		INFO_LOG(Log::G3D, "Shader blob cache %s is missing or out of date", filename.c_str());
+		fclose(f);
+		return false;
+	}
+
+	std::unordered_map<uint64_t, std::vector<uint8_t>> blobs;
+	blobs.reserve(header.count);
+	for (uint32_t i = 0; i < header.count; ++i) {
+		BlobEntryHeader entryHeader;
+		if (fread(&entryHeader, sizeof(entryHeader), 1, f) != 1 || entryHeader.size > BLOB_MAX_SIZE) {
+			success = false;
+			break;
+		}
+
+		std::vector<uint8_t> &data = blobs[entryHeader.key];
+		data.resize(entryHeader.size);
+		if (entryHeader.size != 0 && fread(&data[0], entryHeader.size, 1, f) != 1) {
+			success = false;
+			break;
+		}
+	}
+	fclose(f);
+
+	if (!success) {
+		// Partial files happen if we crashed while saving, just start over.
+		WARN_LOG(Log::G3D, "Shader blob cache %s is corrupt, ignoring", filename.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	// Keep anything already compiled this run.
+	for (auto &it : blobs) {
+		blobs_.emplace(it.first, std::move(it.second));
+	}
+	NOTICE_LOG(Log::G3D, "Loaded %d shader blobs from cache", (int)header.count);
+	return true;
+}
+
+bool ShaderBlobCache::Save(const Path &filename, uint32_t version, const std::vector<uint64_t> &keys) {
+	std::lock_guard<std::mutex> guard(lock_);
+
+	// Shaders still compiling (or that failed) don't have a blob, and identical sources share one.
+	std::vector<std::pair<uint64_t, const std::vector<uint8_t> *>> live;
+	live.reserve(keys.size());
+	for (uint64_t key : keys) {
+		auto it = blobs_.find(key);
+		if (it != blobs_.end())
+			live.emplace_back(key, &it->second);
+	}
+	std::sort(live.begin(), live.end());
+	live.erase(std::unique(live.begin(), live.end()), live.end());
+	uint32_t count = (uint32_t)live.size();
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f)
+		return false;
+
+	BlobCacheHeader header{ BLOB_CACHE_MAGIC, version, count, 0 };
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+	for (const auto &it : live) {
+		if (!success)
+			break;
+		BlobEntryHeader entryHeader{ it.first, (uint32_t)it.second->size(), 0 };
+		success = fwrite(&entryHeader, sizeof(entryHeader), 1, f) == 1;
+		success = success && fwrite(it.second->data(), it.second->size(), 1, f) == 1;
+	}
+	fclose(f);
+
+	if (!success) {
+		File::Delete(filename);
+		return false;
+	}
+	NOTICE_LOG(Log::G3D, "Saved %d shader blobs to cache", (int)count);
+	return true;
+}
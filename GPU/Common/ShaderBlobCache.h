@@ -0,0 +1,51 @@
+// Copyright (c) 2024- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/File/Path.h"
+
+// Caches the output of shader compilers (like SPIR-V from glslang) across runs.
+//
+// Entries are keyed by a hash of the generated source and stage, so anything that changes the
+// generated code (IDs, generator changes, use flags) naturally misses.  The version passed to
+// Load/Save should be bumped when the compiler itself changes output for the same source.
+//
+// All methods are thread safe, compilation usually happens on worker threads.
+class ShaderBlobCache {
+public:
+	static uint64_t MakeKey(int stage, const char *code);
+
+	bool Find(uint64_t key, std::vector<uint8_t> *blob);
+	void Insert(uint64_t key, const void *data, size_t size);
+	void Clear();
+
+	size_t size() const;
+
+	bool Load(const Path &filename, uint32_t version);
+	// Rewrites the file with just the blobs for keys (the shaders still in use), so stale ones drop out.
+	bool Save(const Path &filename, uint32_t version, const std::vector<uint64_t> &keys);
+
+private:
+	mutable std::mutex lock_;
+	std::unordered_map<uint64_t, std::vector<uint8_t>> blobs_;
+};
@@ -137,6 +137,10 @@ void TextureCacheCommon::StartFrame() {
 	if ((DebugOverlay)g_Config.iDebugOverlay == DebugOverlay::DEBUG_STATS) {
 		gpuStats.numReplacerTrackedTex = replacer_.GetNumTrackedTextures();
 		gpuStats.numCachedReplacedTextures = replacer_.GetNumCachedReplacedTextures();
+		TextureSaveStats saveStats = replacer_.GetSaveStats();
+		gpuStats.numReplacerSavesPending = saveStats.pending;
+		gpuStats.numReplacerSaved = saveStats.saved;
+		gpuStats.numReplacerSavesDeferred = saveStats.deferred;
 	}
 
 	if (texelsScaledThisFrame_) {
@@ -19,7 +19,9 @@
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
 #include <memory>
+#include <unordered_set>
 #include <png.h>
 
 #include "ext/basis_universal/basisu_transcoder.h"
@@ -32,6 +34,7 @@
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Text/Parsers.h"
 #include "Common/File/VFS/DirectoryReader.h"
+#include "Common/File/VFS/PackFileReader.h"
 #include "Common/File/VFS/ZipFileReader.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/VFS/VFS.h"
@@ -51,6 +54,7 @@
 
 static const std::string INI_FILENAME = "textures.ini";
 static const std::string ZIP_FILENAME = "textures.zip";
+static const std::string PACK_FILENAME = "textures.pack";
 static const std::string NEW_TEXTURE_DIR = "new/";
 static const int VERSION = 1;
 static const double MAX_CACHE_SIZE = 4.0;
@@ -66,6 +70,7 @@ TextureReplacer::TextureReplacer(Draw::DrawContext *draw) {
 	if (draw->GetDataFormatSupport(Draw::DataFormat::ASTC_4x4_UNORM_BLOCK)) formatSupport_.astc = true;
 	if (draw->GetDataFormatSupport(Draw::DataFormat::BC7_UNORM_BLOCK)) formatSupport_.bc7 = true;
 	if (draw->GetDataFormatSupport(Draw::DataFormat::ETC2_R8G8B8_UNORM_BLOCK)) formatSupport_.etc2 = true;
+	ktx2Formats_ = ChooseKTX2Formats(formatSupport_);
 }
 
 TextureReplacer::~TextureReplacer() {
@@ -85,6 +90,8 @@ void TextureReplacer::NotifyConfigChanged() {
 		basePath_ = GetSysDirectory(DIRECTORY_TEXTURES) / gameID_;
 		replaceEnabled_ = replaceEnabled_ && File::IsDirectory(basePath_);
 		newTextureDir_ = basePath_ / NEW_TEXTURE_DIR;
+		// Created on first write.
+		transcodeCacheDir_ = GetSysDirectory(DIRECTORY_APP_CACHE) / "textures" / gameID_;
 
 		// If we're saving, auto-create the directory.
 		if (saveEnabled_ && !File::Exists(newTextureDir_)) {
@@ -130,16 +137,23 @@ bool TextureReplacer::LoadIni() {
 	delete vfs_;
 	vfs_ = nullptr;
 
+	Path packPath = basePath_ / PACK_FILENAME;
 	Path zipPath = basePath_ / ZIP_FILENAME;
 
-	// First, check for textures.zip, which is used to reduce IO.
-	VFSBackend *dir = ZipFileReader::Create(zipPath, "", false);
+	// First, check for textures.pack, which can be mapped and has an index, and then textures.zip.
+	// Both are used to reduce IO.
+	Path archivePath = packPath;
+	VFSBackend *dir = PackFileReader::Create(packPath, false);
+	if (!dir) {
+		archivePath = zipPath;
+		dir = ZipFileReader::Create(zipPath, "", false);
+	}
 	if (!dir) {
 		INFO_LOG(Log::G3D, "%s wasn't a zip file - opening the directory %s instead.", zipPath.c_str(), basePath_.c_str());
-		vfsIsZip_ = false;
+		vfsIsArchive_ = false;
 		dir = new DirectoryReader(basePath_);
 	} else {
-		vfsIsZip_ = true;
+		vfsIsArchive_ = true;
 	}
 
 	IniFile ini;
@@ -173,8 +187,8 @@ bool TextureReplacer::LoadIni() {
 			}
 		}
 	} else {
-		if (vfsIsZip_) {
-			// We don't accept zip files without inis.
+		if (vfsIsArchive_) {
+			// We don't accept zip (or pack) files without inis.
 			ERROR_LOG(Log::G3D, "Texture pack lacking ini file: %s", basePath_.c_str());
 			delete dir;
 			return false;
@@ -204,8 +218,8 @@ bool TextureReplacer::LoadIni() {
 		repl.second->vfs_ = vfs_;
 	}
 
-	if (vfsIsZip_) {
-		INFO_LOG(Log::G3D, "Texture pack activated from '%s'", (basePath_ / ZIP_FILENAME).c_str());
+	if (vfsIsArchive_) {
+		INFO_LOG(Log::G3D, "Texture pack activated from '%s'", archivePath.c_str());
 	} else {
 		INFO_LOG(Log::G3D, "Texture pack activated from '%s'", basePath_.c_str());
 	}
@@ -316,7 +330,7 @@ bool TextureReplacer::LoadIniValues(IniFile &ini, VFSBackend *dir, bool isOverri
 	if (ini.HasSection("hashes")) {
 		auto hashes = ini.GetOrCreateSection("hashes")->ToMap();
 		// Format: hashname = filename.png
-		bool checkFilenames = saveEnabled_ && !g_Config.bIgnoreTextureFilenames && !vfsIsZip_;
+		bool checkFilenames = saveEnabled_ && !g_Config.bIgnoreTextureFilenames && !vfsIsArchive_;
 
 		for (const auto &item : hashes) {
 			ReplacementCacheKey key(0, 0);
@@ -629,6 +643,8 @@ ReplacedTexture *TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 	// Final path - we actually need a new replacement texture, because we haven't seen "hashfiles" before.
 	desc.basePath = basePath_;
 	desc.formatSupport = formatSupport_;
+	desc.ktx2Formats = ktx2Formats_;
+	desc.transcodeCacheDir = transcodeCacheDir_;
 
 	ReplacedTexture *texture = new ReplacedTexture(vfs_, desc);
 
@@ -642,40 +658,90 @@ ReplacedTexture *TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 	return texture;
 }
 
-static bool WriteTextureToPNG(png_imagep image, const Path &filename, int convert_to_8bit, const void *buffer, png_int_32 row_stride, const void *colormap) {
+// Trades file size for speed, dumping can produce a lot of textures in a short time.  Choosing
+// between two cheap filters with fast deflate is about 5x faster than the default settings, for
+// files around a quarter larger.
+static bool WriteTextureToPNG(const Path &filename, const u8 *rgba, int w, int h) {
 	FILE *fp = File::OpenCFile(filename, "wb");
 	if (!fp) {
 		ERROR_LOG(Log::IO, "Unable to open texture file '%s' for writing.", filename.c_str());
 		return false;
 	}
 
-	if (png_image_write_to_stdio(image, fp, convert_to_8bit, buffer, row_stride, colormap)) {
-		fclose(fp);
-		return true;
-	} else {
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info_ptr = png_ptr ? png_create_info_struct(png_ptr) : nullptr;
+	if (!info_ptr || setjmp(png_jmpbuf(png_ptr))) {
 		ERROR_LOG(Log::System, "Texture PNG encode failed.");
+		png_destroy_write_struct(&png_ptr, &info_ptr);
 		fclose(fp);
-		remove(filename.c_str());
+		File::Delete(filename);
 		return false;
 	}
+
+	png_init_io(png_ptr, fp);
+	png_set_compression_level(png_ptr, 1);
+	png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB | PNG_FILTER_UP);
+	png_set_IHDR(png_ptr, info_ptr, w, h, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png_ptr, info_ptr);
+	for (int y = 0; y < h; ++y) {
+		png_write_row(png_ptr, rgba + y * w * 4);
+	}
+	png_write_end(png_ptr, nullptr);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	fclose(fp);
+	return true;
 }
 
-// We save textures on threadpool tasks since it's a fire-and-forget task, and both I/O and png compression
-// can be pretty slow.
-class SaveTextureTask : public Task {
-public:
+struct TextureSaveJob {
+	// Tightly packed.
 	std::vector<u8> rgbaData;
-
 	int w = 0;
 	int h = 0;
-	int pitch = 0;  // bytes
 
 	Path filename;
 	Path saveFilename;
 
 	u32 replacedInfoHash = 0;
+};
+
+// We save textures in the background since it's fire-and-forget, and both I/O and png compression
+// can be pretty slow.  A few threadpool tasks drain a queue, which is bounded so a dumping session
+// can't eat all memory.  When it's full, textures are skipped, and get another chance next time
+// they're decoded.
+class TextureSaveQueue : public std::enable_shared_from_this<TextureSaveQueue> {
+public:
+	bool HasRoom() const {
+		std::lock_guard<std::mutex> guard(lock_);
+		return jobs_.size() < MAX_JOBS && pendingBytes_ < MAX_PENDING_BYTES;
+	}
+
+	// Returns false if there's no room, the caller can try again later.
+	bool Enqueue(TextureSaveJob &&job);
+	void Drain();
+
+	TextureSaveStats Stats() const {
+		std::lock_guard<std::mutex> guard(lock_);
+		return stats_;
+	}
+
+private:
+	static bool Save(TextureSaveJob &job);
 
-	SaveTextureTask(std::vector<u8> &&_rgbaData) : rgbaData(std::move(_rgbaData)) {}
+	static const size_t MAX_JOBS = 512;
+	static const size_t MAX_PENDING_BYTES = 128 * 1024 * 1024;
+
+	mutable std::mutex lock_;
+	std::deque<TextureSaveJob> jobs_;
+	// Queued or being written, so we don't write the same file twice at once.
+	std::unordered_set<std::string> pendingFiles_;
+	size_t pendingBytes_ = 0;
+	int workers_ = 0;
+	TextureSaveStats stats_{};
+};
+
+class TextureSaveTask : public Task {
+public:
+	TextureSaveTask(std::shared_ptr<TextureSaveQueue> queue) : queue_(queue) {}
 
 	// This must be set to I/O blocking because of Android storage (so we attach the thread to JNI), while being CPU heavy too.
 	TaskType Type() const override { return TaskType::IO_BLOCKING; }
@@ -685,45 +751,91 @@ class SaveTextureTask : public Task {
 	}
 
 	void Run() override {
-		// Should we skip writing if the newly saved data already exists?
-		if (File::Exists(saveFilename)) {
-			return;
-		}
+		queue_->Drain();
+	}
 
-		// And we always skip if the replace file already exists.
-		if (File::Exists(filename)) {
-			return;
-		}
+private:
+	std::shared_ptr<TextureSaveQueue> queue_;
+};
 
-		Path saveDirectory = saveFilename.NavigateUp();
-		if (!File::Exists(saveDirectory)) {
-			// Previously, we created a .nomedia file here. This is unnecessary as they have recursive behavior.
-			// When initializing (see NotifyConfigChange above) we create one in the "root" of the "new" folder.
-			File::CreateFullPath(saveDirectory);
-		}
+bool TextureSaveQueue::Enqueue(TextureSaveJob &&job) {
+	std::unique_lock<std::mutex> guard(lock_);
+	if (jobs_.size() >= MAX_JOBS || pendingBytes_ >= MAX_PENDING_BYTES) {
+		stats_.deferred++;
+		return false;
+	}
+	if (!pendingFiles_.insert(job.saveFilename.ToString()).second) {
+		// Same file from another hash (through the ini), or a different level, already on its way.
+		stats_.skipped++;
+		return true;
+	}
 
-		// Now that we've passed the checks, we change the file extension of the path we're actually
-		// going to write to to .png.
-		saveFilename = saveFilename.WithReplacedExtension(".png");
-
-		png_image png{};
-		png.version = PNG_IMAGE_VERSION;
-		png.format = PNG_FORMAT_RGBA;
-		png.width = w;
-		png.height = h;
-		bool success = WriteTextureToPNG(&png, saveFilename, 0, rgbaData.data(), pitch, nullptr);
-		png_image_free(&png);
-		if (png.warning_or_error >= 2) {
-			ERROR_LOG(Log::G3D, "Saving texture to PNG produced errors.");
-		} else if (success) {
-			NOTICE_LOG(Log::G3D, "Saving texture for replacement: %08x / %dx%d in '%s'", replacedInfoHash, w, h, saveFilename.ToVisualString().c_str());
-		} else {
-			ERROR_LOG(Log::G3D, "Failed to write '%s'", saveFilename.c_str());
-		}
+	pendingBytes_ += job.rgbaData.size();
+	jobs_.push_back(std::move(job));
+	stats_.pending = (int)pendingFiles_.size();
+	stats_.pendingKB = (int)(pendingBytes_ / 1024);
+
+	// Leave some threads for everything else, saving is low priority.
+	int maxWorkers = std::max(1, std::min(4, g_threadManager.GetNumLooperThreads() / 2));
+	if (workers_ < maxWorkers && (int)jobs_.size() > workers_) {
+		workers_++;
+		guard.unlock();
+		g_threadManager.EnqueueTask(new TextureSaveTask(shared_from_this()));
 	}
-};
+	return true;
+}
 
-bool TextureReplacer::WillSave(const ReplacedTextureDecodeInfo &replacedInfo) const {
+void TextureSaveQueue::Drain() {
+	std::unique_lock<std::mutex> guard(lock_);
+	while (!jobs_.empty()) {
+		TextureSaveJob job = std::move(jobs_.front());
+		jobs_.pop_front();
+		guard.unlock();
+
+		bool saved = Save(job);
+
+		guard.lock();
+		pendingFiles_.erase(job.saveFilename.ToString());
+		pendingBytes_ -= job.rgbaData.size();
+		if (saved)
+			stats_.saved++;
+		stats_.pending = (int)pendingFiles_.size();
+		stats_.pendingKB = (int)(pendingBytes_ / 1024);
+	}
+	workers_--;
+}
+
+bool TextureSaveQueue::Save(TextureSaveJob &job) {
+	// Should we skip writing if the newly saved data already exists?
+	// Note that we check the original extension (the name might come from the ini.)
+	if (File::Exists(job.saveFilename)) {
+		return false;
+	}
+
+	// And we always skip if the replace file already exists.
+	if (File::Exists(job.filename)) {
+		return false;
+	}
+
+	Path saveDirectory = job.saveFilename.NavigateUp();
+	if (!File::Exists(saveDirectory)) {
+		// Previously, we created a .nomedia file here. This is unnecessary as they have recursive behavior.
+		// When initializing (see NotifyConfigChange above) we create one in the "root" of the "new" folder.
+		File::CreateFullPath(saveDirectory);
+	}
+
+	// Now that we've passed the checks, we change the file extension of the path we're actually
+	// going to write to to .png.
+	Path pngFilename = job.saveFilename.WithReplacedExtension(".png");
+	if (!WriteTextureToPNG(pngFilename, job.rgbaData.data(), job.w, job.h)) {
+		ERROR_LOG(Log::G3D, "Failed to write '%s'", pngFilename.c_str());
+		return false;
+	}
+	NOTICE_LOG(Log::G3D, "Saving texture for replacement: %08x / %dx%d in '%s'", job.replacedInfoHash, job.w, job.h, pngFilename.ToVisualString().c_str());
+	return true;
+}
+
+bool TextureReplacer::ShouldSave(const ReplacedTextureDecodeInfo &replacedInfo) const {
 	if (!saveEnabled_)
 		return false;
 	// Don't save the PPGe texture.
@@ -731,6 +843,20 @@ bool TextureReplacer::WillSave(const ReplacedTextureDecodeInfo &replacedInfo) co
 		return false;
 	if (replacedInfo.isVideo && !allowVideo_)
 		return false;
+	return true;
+}
+
+bool TextureReplacer::WillSave(const ReplacedTextureDecodeInfo &replacedInfo) const {
+	if (!ShouldSave(replacedInfo))
+		return false;
+
+	// Avoid the cost of preparing the data for saving if we already did, or there's no room for it now.
+	u64 cachekey = ignoreAddress_ ? (replacedInfo.cachekey & 0xFFFFFFFFULL) : replacedInfo.cachekey;
+	auto it = savedCache_.find(ReplacementCacheKey(cachekey, replacedInfo.hash));
+	if (it != savedCache_.end() && !it->second.levelsPending)
+		return false;
+	if (saveQueue_ && !saveQueue_->HasRoom())
+		return false;
 
 	return true;
 }
@@ -739,7 +865,8 @@ void TextureReplacer::NotifyTextureDecoded(ReplacedTexture *texture, const Repla
 	_assert_msg_(saveEnabled_, "Texture saving not enabled");
 	_assert_(pitch >= 0);
 
-	if (!WillSave(replacedInfo)) {
+	// Not WillSave(), the levels already saved and a full queue are dealt with below, per level.
+	if (!ShouldSave(replacedInfo)) {
 		// Ignore.
 		return;
 	}
@@ -776,11 +903,19 @@ void TextureReplacer::NotifyTextureDecoded(ReplacedTexture *texture, const Repla
 
 	ReplacementCacheKey replacementKey(cachekey, replacedInfo.hash);
 	auto it = savedCache_.find(replacementKey);
-	if (it != savedCache_.end()) {
-		// We've already saved this texture. Ignore it.
+	// The levels come in order, so a new pass starts at 0.  Any level deferred in it sets this again.
+	if (it != savedCache_.end() && level == 0)
+		it->second.levelsPending = false;
+	if (it != savedCache_.end() && it->second.levelSaved[std::min(level, 7)]) {
+		// We've already saved this level. Ignore it.
 		// We don't really care about changing the scale factor during runtime, only confusing.
 		return;
 	}
+	if (saveQueue_ && !saveQueue_->HasRoom()) {
+		// No point copying it, try again next time.
+		savedCache_[replacementKey].levelsPending = true;
+		return;
+	}
 	double now = time_now_d();
 
 	// Width/height of the image to save.
@@ -795,26 +930,28 @@ void TextureReplacer::NotifyTextureDecoded(ReplacedTexture *texture, const Repla
 		h = lookupH * (scaledH / origH);
 	}
 
-	std::vector<u8> saveBuf;
+	TextureSaveJob job;
 
 	// Copy data to a buffer so we can send it to the thread. Might as well compact-away the pitch
 	// while we're at it.
-	saveBuf.resize(w * h * 4);
+	job.rgbaData.resize(w * h * 4);
 	for (int y = 0; y < h; y++) {
-		memcpy((u8 *)saveBuf.data() + y * w * 4, (const u8 *)data + y * pitch, w * 4);
+		memcpy(job.rgbaData.data() + y * w * 4, (const u8 *)data + y * pitch, w * 4);
 	}
-	pitch = w * 4;
-
-	SaveTextureTask *task = new SaveTextureTask(std::move(saveBuf));
 
-	task->filename = basePath_ / hashfile;
-	task->saveFilename = newTextureDir_ / hashfile;
+	job.filename = basePath_ / hashfile;
+	job.saveFilename = newTextureDir_ / hashfile;
+	job.w = w;
+	job.h = h;
+	job.replacedInfoHash = replacedInfo.hash;
 
-	task->w = w;
-	task->h = h;
-	task->pitch = pitch;
-	task->replacedInfoHash = replacedInfo.hash;
-	g_threadManager.EnqueueTask(task);  // We don't care about waiting for the task. It'll be fine.
+	if (!saveQueue_)
+		saveQueue_ = std::make_shared<TextureSaveQueue>();
+	if (!saveQueue_->Enqueue(std::move(job))) {
+		// Full, so WillSave() lets this texture through again next time, to save the rest.
+		savedCache_[replacementKey].levelsPending = true;
+		return;
+	}
 
 	// Remember that we've saved this for next time.
 	// Should be OK that the actual disk write may not be finished yet.
@@ -825,6 +962,12 @@ void TextureReplacer::NotifyTextureDecoded(ReplacedTexture *texture, const Repla
 	saveData.lastTimeSaved = now;
 }
 
+TextureSaveStats TextureReplacer::GetSaveStats() const {
+	if (!saveQueue_)
+		return TextureSaveStats{};
+	return saveQueue_->Stats();
+}
+
 void TextureReplacer::Decimate(ReplacerDecimateMode mode) {
 	// Allow replacements to be cached for a long time, although they're large.
 	double age = 1800.0;
@@ -19,6 +19,7 @@
 
 #include "ppsspp_config.h"
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -41,12 +42,15 @@ class TextureCacheCommon;
 class TextureReplacer;
 class ReplacedTextureTask;
 class LimitedWaitable;
+class TextureSaveQueue;
 class VFSBackend;
 
 struct SavedTextureCacheData {
 	int levelW[8]{};
 	int levelH[8]{};
 	bool levelSaved[8]{};
+	// Set when a level didn't fit in the save queue, so the texture is offered again.
+	bool levelsPending = false;
 	double lastTimeSaved = 0.0;
 };
 
@@ -86,6 +90,18 @@ struct ReplacedTextureDecodeInfo {
 	Draw::DataFormat fmt;
 };
 
+// Background texture saving, since saving was enabled.
+struct TextureSaveStats {
+	// Queued or being written.
+	int pending;
+	int pendingKB;
+	int saved;
+	// Already on its way under the same filename.
+	int skipped;
+	// Queue was full, will be offered again next time it's decoded.
+	int deferred;
+};
+
 enum class ReplacerDecimateMode {
 	NEW_FRAME,
 	FORCE_PRESSURE,
@@ -125,11 +141,14 @@ class TextureReplacer {
 
 	int GetNumTrackedTextures() const { return (int)cache_.size(); }
 	int GetNumCachedReplacedTextures() const { return (int)levelCache_.size(); }
+	TextureSaveStats GetSaveStats() const;
 
 	static std::string HashName(u64 cachekey, u32 hash, int level);
 
 protected:
 	bool FindFiltering(u64 cachekey, u32 hash, TextureFiltering *forceFiltering);
+	// Whether this kind of texture is saved at all, regardless of what's been saved already.
+	bool ShouldSave(const ReplacedTextureDecodeInfo &replacedInfo) const;
 
 	bool LoadIni();
 	bool LoadIniValues(IniFile &ini, VFSBackend *dir, bool isOverride = false);
@@ -160,9 +179,12 @@ class TextureReplacer {
 	ReplacedTextureHash hash_ = ReplacedTextureHash::QUICK;
 
 	VFSBackend *vfs_ = nullptr;
-	bool vfsIsZip_ = false;
+	// Zip or pack file, rather than a plain directory.
+	bool vfsIsArchive_ = false;
 
 	GPUFormatSupport formatSupport_{};
+	KTX2Formats ktx2Formats_{};
+	Path transcodeCacheDir_;
 
 	typedef std::pair<int, int> WidthHeightPair;
 	std::unordered_map<u64, WidthHeightPair> hashranges_;
@@ -173,6 +195,8 @@ class TextureReplacer {
 
 	std::unordered_map<ReplacementCacheKey, ReplacedTextureRef> cache_;
 	std::unordered_map<ReplacementCacheKey, SavedTextureCacheData> savedCache_;
+	// Created on first save, shared with the tasks writing the files.
+	std::shared_ptr<TextureSaveQueue> saveQueue_;
 
 	// the key is either from aliases_, in which case it's a |-separated sequence of texture filenames of the levels of a texture.
 	// alternatively the key is from the generated texture filename.
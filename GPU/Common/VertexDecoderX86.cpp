@@ -29,7 +29,7 @@
 
 // We start out by converting the active matrices into 4x4 which are easier to multiply with
 // using SSE / NEON and store them here.
-alignas(16) static float bones[16 * 8];
+alignas(32) static float bones[16 * 8];
 
 using namespace Gen;
 
@@ -96,6 +96,11 @@ static const X64Reg fpScratchReg4 = XMM4;
 // We're gonna keep the current skinning matrix in 4 XMM regs. Fortunately we easily
 // have space for that now.
 
+#if PPSSPP_ARCH(AMD64)
+// After the saved XMM regs, we keep 8 float weights on the stack for the AVX skinning path.
+static const int STACK_WEIGHTS_OFFSET = 96;
+#endif
+
 // To debug, just comment them out one at a time until it works. We fall back
 // on the interpreter if the compiler fails.
 
@@ -208,11 +213,11 @@ JittedVertexDecoder VertexDecoderJitCache::Compile(const VertexDecoder &dec, int
 	// Parameters automatically fall into place.
 
 	// This will align the stack properly to 16 bytes (the call of this function pushed RIP, which is 8 bytes).
-	const uint8_t STACK_FIXED_ALLOC = 96 + 8;
+	const uint8_t STACK_FIXED_ALLOC = 96 + 32 + 8;
 #endif
 
 	// Allocate temporary storage on the stack.
-	SUB(PTRBITS, R(ESP), Imm8(STACK_FIXED_ALLOC));
+	SUB(PTRBITS, R(ESP), Imm32(STACK_FIXED_ALLOC));
 	// Save XMM4/XMM5 which apparently can be problematic?
 	// Actually, if they are, it must be a compiler bug because they SHOULD be ok.
 	// So I won't bother.
@@ -312,7 +317,7 @@ JittedVertexDecoder VertexDecoderJitCache::Compile(const VertexDecoder &dec, int
 	MOVUPS(XMM8, MDisp(ESP, 64));
 	MOVUPS(XMM9, MDisp(ESP, 80));
 #endif
-	ADD(PTRBITS, R(ESP), Imm8(STACK_FIXED_ALLOC));
+	ADD(PTRBITS, R(ESP), Imm32(STACK_FIXED_ALLOC));
 
 #if PPSSPP_ARCH(X86)
 	// Restore register values
@@ -539,6 +544,15 @@ void VertexDecoderJitCache::Jit_WeightsU8Skin() {
 			MULPS(XMM9, MatR(tempReg1));
 	}
 
+	if (cpu_info.bAVX) {
+		// Spill the weights so each one can be broadcast straight from memory.
+		MOVAPS(MDisp(ESP, STACK_WEIGHTS_OFFSET), XMM8);
+		if (dec_->nweights > 4)
+			MOVAPS(MDisp(ESP, STACK_WEIGHTS_OFFSET + 16), XMM9);
+		Jit_BlendBonesAVX(ESP, STACK_WEIGHTS_OFFSET);
+		return;
+	}
+
 	auto weightToAllLanes = [this](X64Reg dst, int lane) {
 		X64Reg src = lane < 4 ? XMM8 : XMM9;
 		if (dst != INVALID_REG && dst != src) {
@@ -653,6 +667,15 @@ void VertexDecoderJitCache::Jit_WeightsU16Skin() {
 			MULPS(XMM9, MatR(tempReg1));
 	}
 
+	if (cpu_info.bAVX) {
+		// Spill the weights so each one can be broadcast straight from memory.
+		MOVAPS(MDisp(ESP, STACK_WEIGHTS_OFFSET), XMM8);
+		if (dec_->nweights > 4)
+			MOVAPS(MDisp(ESP, STACK_WEIGHTS_OFFSET + 16), XMM9);
+		Jit_BlendBonesAVX(ESP, STACK_WEIGHTS_OFFSET);
+		return;
+	}
+
 	auto weightToAllLanes = [this](X64Reg dst, int lane) {
 		X64Reg src = lane < 4 ? XMM8 : XMM9;
 		if (dst != INVALID_REG && dst != src) {
@@ -723,6 +746,13 @@ void VertexDecoderJitCache::Jit_WeightsU16Skin() {
 }
 
 void VertexDecoderJitCache::Jit_WeightsFloatSkin() {
+#if PPSSPP_ARCH(AMD64)
+	if (cpu_info.bAVX) {
+		Jit_BlendBonesAVX(srcReg, dec_->weightoff);
+		return;
+	}
+#endif
+
 	MOV(PTRBITS, R(tempReg2), ImmPtr(&bones));
 	for (int j = 0; j < dec_->nweights; j++) {
 		MOVSS(XMM1, MDisp(srcReg, dec_->weightoff + j * 4));
@@ -754,6 +784,38 @@ void VertexDecoderJitCache::Jit_WeightsFloatSkin() {
 	}
 }
 
+#if PPSSPP_ARCH(AMD64)
+// Blends the bones into XMM4-XMM7 like the SSE path, but using 256-bit ops on two rows at a time.
+// The float weights are read from weightBase + weightOff, 4 bytes apart.
+//
+// This is the only AVX path.  The jit still decodes one vertex per loop iteration, since going to two
+// would mean every step handling a pair, and morphs stay SSE: each frame is a single 128-bit
+// multiply-add already, and pairing frames would change the summation order vs. the steps.
+// TestVertexJitAVX in unittest/TestVertexJit.cpp checks this against the SSE jit and the steps.
+void VertexDecoderJitCache::Jit_BlendBonesAVX(X64Reg weightBase, int weightOff) {
+	MOV(PTRBITS, R(tempReg2), ImmPtr(&bones));
+	for (int j = 0; j < dec_->nweights; j++) {
+		VBROADCASTSS(256, XMM1, MDisp(weightBase, weightOff + j * 4));
+		if (j == 0) {
+			VMULPS(256, XMM4, XMM1, MDisp(tempReg2, 0));
+			VMULPS(256, XMM6, XMM1, MDisp(tempReg2, 32));
+		} else {
+			// Not using FMA, so the result matches the SSE path and the interpreter exactly.
+			VMULPS(256, XMM2, XMM1, MDisp(tempReg2, j * 64));
+			VMULPS(256, XMM3, XMM1, MDisp(tempReg2, j * 64 + 32));
+			VADDPS(256, XMM4, XMM4, R(XMM2));
+			VADDPS(256, XMM6, XMM6, R(XMM3));
+		}
+	}
+
+	// Now split out the odd rows, the rest of the steps expect one row per XMM reg.
+	VEXTRACTF128(R(XMM5), XMM4, 1);
+	VEXTRACTF128(R(XMM7), XMM6, 1);
+	// Avoid SSE/AVX transition penalties in the following steps.
+	VZEROUPPER();
+}
+#endif
+
 void VertexDecoderJitCache::Jit_TcU8ToFloat() {
 	Jit_AnyU8ToFloat(dec_->tcoff, 16);
 	MOVQ_xmm(MDisp(dstReg, dec_->decFmt.uvoff), XMM3);
@@ -105,6 +105,9 @@ struct GPUStatistics {
 		numBlockTransfers = 0;
 		numReplacerTrackedTex = 0;
 		numCachedReplacedTextures = 0;
+		numReplacerSavesPending = 0;
+		numReplacerSaved = 0;
+		numReplacerSavesDeferred = 0;
 		msProcessingDisplayLists = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
@@ -142,6 +145,9 @@ struct GPUStatistics {
 	int numBlockTransfers;
 	int numReplacerTrackedTex;
 	int numCachedReplacedTextures;
+	int numReplacerSavesPending;
+	int numReplacerSaved;
+	int numReplacerSavesDeferred;
 	double msProcessingDisplayLists;
 	int vertexGPUCycles;
 	int otherGPUCycles;
@@ -816,6 +816,53 @@ void GPUCommonHW::ExecuteOp(u32 op, u32 diff) {
 	}
 }
 
+// Shorter runs aren't worth the separate path, longer ones just continue in the next one.
+static const int MIN_STATE_RUN = 4;
+static const int MAX_STATE_RUN = 1024;
+
+static inline bool IsStateOnlyCmd(const CommandInfo &info) {
+	return (info.flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE)) == 0;
+}
+
+// Applies the run of consecutive commands at pc that only write state (no execute funcs.)
+// Nothing gets drawn within the run, so it needs at most one flush, before the first changing
+// flush-on-change command, and a single combined dirty update.
+// There's deliberately no cache of decoded runs: checking one against the list (which games
+// rewrite every frame) reads the same words this walk does, so it can't come out ahead.
+// Returns the number of commands applied.
+int GPUCommonHW::ExecuteStateRun(u32 pc, int maxCount) {
+	const u32_le *src = (const u32_le *)(Memory::base + pc);
+	const CommandInfo *cmdInfo = cmdInfo_;
+	int count = std::min(maxCount, MAX_STATE_RUN);
+	count = std::min(count, (int)(Memory::ValidSize(pc, count * 4) / 4));
+
+	uint64_t dirty = 0;
+	bool flushed = false;
+	int n = 0;
+	for (; n < count; ++n) {
+		const u32 op = src[n];
+		const u32 cmd = op >> 24;
+		const uint64_t flags = cmdInfo[cmd].flags;
+		if (!IsStateOnlyCmd(cmdInfo[cmd]))
+			break;
+		if (op == gstate.cmdmem[cmd])
+			continue;
+		if ((flags & FLAG_FLUSHBEFOREONCHANGE) && !flushed) {
+			if (dirty) {
+				gstate_c.Dirty(dirty);
+				dirty = 0;
+			}
+			drawEngineCommon_->DispatchFlush();
+			flushed = true;
+		}
+		gstate.cmdmem[cmd] = op;
+		dirty |= flags >> 8;
+	}
+	if (dirty)
+		gstate_c.Dirty(dirty);
+	return n;
+}
+
 void GPUCommonHW::FastRunLoop(DisplayList &list) {
 	PROFILE_THIS_SCOPE("gpuloop");
 
@@ -827,11 +874,25 @@ void GPUCommonHW::FastRunLoop(DisplayList &list) {
 
 	const CommandInfo *cmdInfo = cmdInfo_;
 	int dc = downcount;
-	for (; dc > 0; --dc) {
+	while (dc > 0) {
 		// We know that display list PCs have the upper nibble == 0 - no need to mask the pointer
-		const u32 op = *(const u32_le *)(Memory::base + list.pc);
+		const u32_le *src = (const u32_le *)(Memory::base + list.pc);
+		const u32 op = src[0];
 		const u32 cmd = op >> 24;
 		const CommandInfo &info = cmdInfo[cmd];
+
+		// Cheaply check that a run of state writes starts here.  Without a stall address, the list
+		// can run right up to the end of RAM, so check that before peeking ahead.
+		if (dc >= MIN_STATE_RUN && IsStateOnlyCmd(info) && Memory::IsValidRange(list.pc, MIN_STATE_RUN * 4) &&
+			IsStateOnlyCmd(cmdInfo[src[1] >> 24]) && IsStateOnlyCmd(cmdInfo[src[MIN_STATE_RUN - 1] >> 24])) {
+			int count = ExecuteStateRun(list.pc, dc);
+			if (count != 0) {
+				list.pc += count * 4;
+				dc -= count;
+				continue;
+			}
+		}
+
 		const u32 diff = op ^ gstate.cmdmem[cmd];
 		if (diff == 0) {
 			if (info.flags & FLAG_EXECUTE) {
@@ -856,6 +917,7 @@ void GPUCommonHW::FastRunLoop(DisplayList &list) {
 			}
 		}
 		list.pc += 4;
+		dc--;
 	}
 	downcount = 0;
 }
@@ -1754,7 +1816,7 @@ size_t GPUCommonHW::FormatGPUStatsCommon(char *buffer, size_t size) {
 		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
 		"readbacks %d (%d non-block), upload %d (cached %d), depal %d\n"
 		"block transfers: %d\n"
-		"replacer: tracks %d references, %d unique textures\n"
+		"replacer: tracks %d references, %d unique textures, saves: %d pending, %d done, %d deferred\n"
 		"Cpy: depth %d, color %d, reint %d, blend %d, self %d\n"
 		"GPU cycles: %d (%0.1f per vertex)\n%s",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
@@ -1784,6 +1846,9 @@ size_t GPUCommonHW::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numBlockTransfers,
 		gpuStats.numReplacerTrackedTex,
 		gpuStats.numCachedReplacedTextures,
+		gpuStats.numReplacerSavesPending,
+		gpuStats.numReplacerSaved,
+		gpuStats.numReplacerSavesDeferred,
 		gpuStats.numDepthCopies,
 		gpuStats.numColorCopies,
 		gpuStats.numReinterpretCopies,
@@ -72,6 +72,9 @@ class GPUCommonHW : public GPUCommon {
 	void CheckDepthUsage(VirtualFramebuffer *vfb) override;
 	void CheckFlushOp(int cmd, u32 diff);
 
+	// Applies a run of consecutive state-only commands in one go, with a single dirty update.
+	int ExecuteStateRun(u32 pc, int maxCount);
+
 protected:
 	size_t FormatGPUStatsCommon(char *buf, size_t size);
 	void UpdateCmdInfo() override;
@@ -901,7 +901,7 @@ void PixelJitCache::Compile(const PixelFuncID &id) {
 		Clear();
 	}
 
-#if PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)
+#if (PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)) || PPSSPP_ARCH(ARM64_NEON)
 	addresses_[id] = GetCodePointer();
 	SingleFunc func = CompileSingle(id);
 	cache_.Insert(std::hash<PixelFuncID>()(id), func);
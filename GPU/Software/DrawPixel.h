@@ -144,6 +144,13 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	std::vector<Gen::FixupBranch> skipStandardWrites_;
 	int stackIDOffset_ = 0;
 	bool colorIs16Bit_ = false;
+#elif PPSSPP_ARCH(ARM64_NEON)
+	void Discard();
+	void Discard(CCFlags cc);
+
+	// Used for any test failure.
+	std::vector<Arm64Gen::FixupBranch> discards_;
+	bool colorIs16Bit_ = false;
 #endif
 };
 
@@ -0,0 +1,803 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(ARM64_NEON)
+
+#include "Common/Arm64Emitter.h"
+#include "Common/LogReporting.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/ge_constants.h"
+
+using namespace Arm64Gen;
+
+namespace Rasterizer {
+
+// Note: PixelFuncID is packed, so offsets into cached may be unaligned.  We use LDUR for those.
+
+static bool CanCompileSingle(const PixelFuncID &id) {
+	// These aren't implemented yet, and will use the generic func instead.
+	if (id.alphaBlend && !id.clearMode)
+		return false;
+	if (id.stencilTest && !id.clearMode)
+		return false;
+	if (id.applyLogicOp && !id.clearMode)
+		return false;
+	return true;
+}
+
+SingleFunc PixelJitCache::CompileSingle(const PixelFuncID &id) {
+	if (!CanCompileSingle(id))
+		return nullptr;
+
+	// Setup the reg cache and disallow spill for arguments.
+	regCache_.SetupABI({
+		RegCache::GEN_ARG_X,
+		RegCache::GEN_ARG_Y,
+		RegCache::GEN_ARG_Z,
+		RegCache::GEN_ARG_FOG,
+		RegCache::VEC_ARG_COLOR,
+		RegCache::GEN_ARG_ID,
+	});
+
+	BeginWrite(64);
+	Describe("Init");
+	WriteConstantPool(id);
+
+	const u8 *resetPos = AlignCode16();
+	EndWrite();
+	bool success = true;
+
+	_assert_(regCache_.Has(RegCache::GEN_ARG_ID));
+	WriteProlog(0, {}, {});
+
+	// Start with the depth range.
+	success = success && Jit_ApplyDepthRange(id);
+
+	// Next, let's clamp the color (might affect alpha test, and everything expects it clamped.)
+	// We simply convert to 4x8-bit to clamp.  Everything else expects color in this format.
+	Describe("ClampColor");
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	fp.SQXTUN(16, EncodeRegToDouble(argColorReg), argColorReg);
+	fp.UQXTN(8, EncodeRegToDouble(argColorReg), argColorReg);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+	colorIs16Bit_ = false;
+
+	success = success && Jit_AlphaTest(id);
+	// Fog is applied prior to color test.  Maybe before alpha test too, but it doesn't affect it...
+	success = success && Jit_ApplyFog(id);
+	success = success && Jit_ColorTest(id);
+
+	if (!id.clearMode)
+		success = success && Jit_DepthTest(id);
+	success = success && Jit_WriteDepth(id);
+
+	success = success && Jit_Dither(id);
+	success = success && Jit_WriteColor(id);
+
+	for (auto &fixup : discards_) {
+		SetJumpTarget(fixup);
+	}
+	discards_.clear();
+
+	if (regCache_.Has(RegCache::GEN_ARG_ID))
+		regCache_.ForceRelease(RegCache::GEN_ARG_ID);
+
+	if (!success) {
+		ERROR_LOG_REPORT(Log::G3D, "Could not compile pixel func: %s", DescribePixelFuncID(id).c_str());
+
+		regCache_.Reset(false);
+		EndWrite();
+		ResetCodePtr(GetOffset(resetPos));
+		return nullptr;
+	}
+
+	const u8 *start = WriteFinalizedEpilog();
+	regCache_.Reset(true);
+	return (SingleFunc)start;
+}
+
+RegCache::Reg PixelJitCache::GetPixelID() {
+	// With eight arg regs, the id is always in a register.
+	return regCache_.Find(RegCache::GEN_ARG_ID);
+}
+
+void PixelJitCache::UnlockPixelID(RegCache::Reg &r) {
+	regCache_.Unlock(r, RegCache::GEN_ARG_ID);
+}
+
+RegCache::Reg PixelJitCache::GetColorOff(const PixelFuncID &id) {
+	if (!regCache_.Has(RegCache::GEN_COLOR_OFF)) {
+		Describe("GetColorOff");
+		// We have plenty of regs, so unlike x86 we just keep x and y around until the end.
+		ARM64Reg argYReg = regCache_.Find(RegCache::GEN_ARG_Y);
+		ARM64Reg r = regCache_.Alloc(RegCache::GEN_COLOR_OFF);
+		if (id.useStandardStride) {
+			LSL(DecodeReg(r), DecodeReg(argYReg), 9);
+		} else {
+			ARM64Reg idReg = GetPixelID();
+			LDURH(DecodeReg(r), idReg, offsetof(PixelFuncID, cached.framebufStride));
+			UnlockPixelID(idReg);
+			MUL(DecodeReg(r), DecodeReg(r), DecodeReg(argYReg));
+		}
+		regCache_.Unlock(argYReg, RegCache::GEN_ARG_Y);
+
+		ARM64Reg argXReg = regCache_.Find(RegCache::GEN_ARG_X);
+		ADD(DecodeReg(r), DecodeReg(r), DecodeReg(argXReg));
+		regCache_.Unlock(argXReg, RegCache::GEN_ARG_X);
+
+		ARM64Reg temp = regCache_.Alloc(RegCache::GEN_TEMP_HELPER);
+		MOVP2R(temp, &fb.data);
+		LDR(INDEX_UNSIGNED, temp, temp, 0);
+		ADD(r, temp, r, ArithOption(r, ST_LSL, id.FBFormat() == GE_FORMAT_8888 ? 2 : 1));
+		regCache_.Release(temp, RegCache::GEN_TEMP_HELPER);
+
+		return r;
+	}
+	return regCache_.Find(RegCache::GEN_COLOR_OFF);
+}
+
+RegCache::Reg PixelJitCache::GetDepthOff(const PixelFuncID &id) {
+	if (!regCache_.Has(RegCache::GEN_DEPTH_OFF)) {
+		Describe("GetDepthOff");
+		ARM64Reg argYReg = regCache_.Find(RegCache::GEN_ARG_Y);
+		ARM64Reg r = regCache_.Alloc(RegCache::GEN_DEPTH_OFF);
+		if (id.useStandardStride) {
+			LSL(DecodeReg(r), DecodeReg(argYReg), 9);
+		} else {
+			ARM64Reg idReg = GetPixelID();
+			LDURH(DecodeReg(r), idReg, offsetof(PixelFuncID, cached.depthbufStride));
+			UnlockPixelID(idReg);
+			MUL(DecodeReg(r), DecodeReg(r), DecodeReg(argYReg));
+		}
+		regCache_.Unlock(argYReg, RegCache::GEN_ARG_Y);
+
+		ARM64Reg argXReg = regCache_.Find(RegCache::GEN_ARG_X);
+		ADD(DecodeReg(r), DecodeReg(r), DecodeReg(argXReg));
+		regCache_.Unlock(argXReg, RegCache::GEN_ARG_X);
+
+		ARM64Reg temp = regCache_.Alloc(RegCache::GEN_TEMP_HELPER);
+		MOVP2R(temp, &depthbuf.data);
+		LDR(INDEX_UNSIGNED, temp, temp, 0);
+		ADD(r, temp, r, ArithOption(r, ST_LSL, 1));
+		regCache_.Release(temp, RegCache::GEN_TEMP_HELPER);
+
+		return r;
+	}
+	return regCache_.Find(RegCache::GEN_DEPTH_OFF);
+}
+
+void PixelJitCache::Discard() {
+	discards_.push_back(B());
+}
+
+void PixelJitCache::Discard(CCFlags cc) {
+	discards_.push_back(B(cc));
+}
+
+void PixelJitCache::WriteConstantPool(const PixelFuncID &id) {
+	// Nothing yet, MOVI covers the constants we use so far.
+}
+
+bool PixelJitCache::Jit_ApplyDepthRange(const PixelFuncID &id) {
+	if (id.applyDepthRange && !id.earlyZChecks) {
+		Describe("ApplyDepthR");
+		ARM64Reg argZReg = regCache_.Find(RegCache::GEN_ARG_Z);
+		ARM64Reg idReg = GetPixelID();
+		ARM64Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+		// We expanded this to 32 bits, so it's convenient to compare.
+		LDUR(DecodeReg(tempReg), idReg, offsetof(PixelFuncID, cached.minz));
+		CMP(DecodeReg(argZReg), DecodeReg(tempReg));
+		Discard(CC_LT);
+
+		// We load the low 16 bits, but compare all 32 of z.  Above handles < 0.
+		LDUR(DecodeReg(tempReg), idReg, offsetof(PixelFuncID, cached.maxz));
+		CMP(DecodeReg(argZReg), DecodeReg(tempReg));
+		Discard(CC_GT);
+
+		regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+		UnlockPixelID(idReg);
+		regCache_.Unlock(argZReg, RegCache::GEN_ARG_Z);
+	}
+
+	// Since this is early on, try to free up the z reg if we don't need it anymore.
+	if (id.clearMode && !id.DepthClear())
+		regCache_.ForceRelease(RegCache::GEN_ARG_Z);
+	else if (!id.clearMode && !id.depthWrite && (id.DepthTestFunc() == GE_COMP_ALWAYS || id.earlyZChecks))
+		regCache_.ForceRelease(RegCache::GEN_ARG_Z);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaTest(const PixelFuncID &id) {
+	// Take care of ALWAYS/NEVER first.  ALWAYS is common, means disabled.
+	if (id.clearMode)
+		return true;
+	Describe("AlphaTest");
+	switch (id.AlphaTestFunc()) {
+	case GE_COMP_NEVER:
+		Discard();
+		return true;
+
+	case GE_COMP_ALWAYS:
+		return true;
+
+	default:
+		break;
+	}
+
+	// Load alpha into its own general reg.
+	ARM64Reg alphaReg;
+	if (regCache_.Has(RegCache::GEN_SRC_ALPHA)) {
+		alphaReg = regCache_.Find(RegCache::GEN_SRC_ALPHA);
+	} else {
+		alphaReg = regCache_.Alloc(RegCache::GEN_SRC_ALPHA);
+		_assert_(!colorIs16Bit_);
+		ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+		fp.UMOV(8, DecodeReg(alphaReg), argColorReg, 3);
+		regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+	}
+
+	if (id.hasAlphaTestMask) {
+		// Note: we leave the ALPHA purpose untouched and free it, because later code may reuse.
+		ARM64Reg idReg = GetPixelID();
+		ARM64Reg maskedReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+		LDURB(DecodeReg(maskedReg), idReg, offsetof(PixelFuncID, cached.alphaTestMask));
+		UnlockPixelID(idReg);
+		AND(DecodeReg(maskedReg), DecodeReg(maskedReg), DecodeReg(alphaReg));
+		regCache_.Unlock(alphaReg, RegCache::GEN_SRC_ALPHA);
+
+		// Okay now do the rest using the masked reg, which we modified.
+		alphaReg = maskedReg;
+	}
+
+	// We hardcode the ref into this jit func.
+	CMP(DecodeReg(alphaReg), id.alphaTestRef);
+	if (id.hasAlphaTestMask)
+		regCache_.Release(alphaReg, RegCache::GEN_TEMP0);
+	else
+		regCache_.Unlock(alphaReg, RegCache::GEN_SRC_ALPHA);
+
+	switch (id.AlphaTestFunc()) {
+	case GE_COMP_NEVER:
+	case GE_COMP_ALWAYS:
+		break;
+
+	case GE_COMP_EQUAL:
+		Discard(CC_NEQ);
+		break;
+
+	case GE_COMP_NOTEQUAL:
+		Discard(CC_EQ);
+		break;
+
+	case GE_COMP_LESS:
+		Discard(CC_HS);
+		break;
+
+	case GE_COMP_LEQUAL:
+		Discard(CC_HI);
+		break;
+
+	case GE_COMP_GREATER:
+		Discard(CC_LS);
+		break;
+
+	case GE_COMP_GEQUAL:
+		Discard(CC_LO);
+		break;
+	}
+
+	return true;
+}
+
+bool PixelJitCache::Jit_ColorTest(const PixelFuncID &id) {
+	if (!id.colorTest || id.clearMode)
+		return true;
+
+	Describe("ColorTest");
+	ARM64Reg idReg = GetPixelID();
+	ARM64Reg funcReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	ARM64Reg maskReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg refReg = regCache_.Alloc(RegCache::GEN_TEMP2);
+
+	// First, load the registers: mask and ref.
+	LDUR(DecodeReg(maskReg), idReg, offsetof(PixelFuncID, cached.colorTestMask));
+	LDUR(DecodeReg(refReg), idReg, offsetof(PixelFuncID, cached.colorTestRef));
+
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	if (colorIs16Bit_) {
+		// If it's expanded, we need to clamp anyway if it was fogged.
+		fp.SQXTUN(8, EncodeRegToDouble(argColorReg), argColorReg);
+		colorIs16Bit_ = false;
+	}
+
+	// Temporarily abuse funcReg to grab the color into maskReg.
+	fp.UMOV(32, DecodeReg(funcReg), argColorReg, 0);
+	AND(DecodeReg(maskReg), DecodeReg(maskReg), DecodeReg(funcReg));
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	// Now that we're setup, get the func and follow it.
+	LDURB(DecodeReg(funcReg), idReg, offsetof(PixelFuncID, cached.colorTestFunc));
+	UnlockPixelID(idReg);
+
+	CMP(DecodeReg(funcReg), GE_COMP_ALWAYS);
+	// Discard for GE_COMP_NEVER...
+	Discard(CC_LO);
+	FixupBranch skip = B(CC_EQ);
+
+	CMP(DecodeReg(funcReg), GE_COMP_EQUAL);
+	FixupBranch doEqual = B(CC_EQ);
+	regCache_.Release(funcReg, RegCache::GEN_TEMP0);
+
+	// The not equal path here... if they are equal, we discard.
+	CMP(DecodeReg(refReg), DecodeReg(maskReg));
+	Discard(CC_EQ);
+	FixupBranch skip2 = B();
+
+	SetJumpTarget(doEqual);
+	CMP(DecodeReg(refReg), DecodeReg(maskReg));
+	Discard(CC_NEQ);
+
+	regCache_.Release(maskReg, RegCache::GEN_TEMP1);
+	regCache_.Release(refReg, RegCache::GEN_TEMP2);
+
+	SetJumpTarget(skip);
+	SetJumpTarget(skip2);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_ApplyFog(const PixelFuncID &id) {
+	if (!id.applyFog || id.clearMode) {
+		// Okay, anyone can use the fog register then.
+		regCache_.ForceRelease(RegCache::GEN_ARG_FOG);
+		return true;
+	}
+
+	// Load fog and expand to 16 bit.  Ignore the high 8 bits, which'll match up with A.
+	Describe("ApplyFog");
+	ARM64Reg fogColorReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	ARM64Reg idReg = GetPixelID();
+	fp.LDUR(32, EncodeRegToSingle(fogColorReg), idReg, offsetof(PixelFuncID, cached.fogColor));
+	fp.UXTL(8, fogColorReg, EncodeRegToDouble(fogColorReg));
+	UnlockPixelID(idReg);
+
+	// Load a set of 255s at 16 bit into a reg for later...
+	ARM64Reg invertReg = regCache_.Alloc(RegCache::VEC_TEMP2);
+	fp.MOVI(16, invertReg, 0xFF);
+
+	// Expand (we clamped) color to 16 bit as well, so we can multiply with fog.
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	if (!colorIs16Bit_) {
+		fp.UXTL(8, argColorReg, EncodeRegToDouble(argColorReg));
+		colorIs16Bit_ = true;
+	}
+
+	// Save A so we can put it back, we don't "fog" A.
+	ARM64Reg alphaReg;
+	if (regCache_.Has(RegCache::GEN_SRC_ALPHA)) {
+		alphaReg = regCache_.Find(RegCache::GEN_SRC_ALPHA);
+	} else {
+		alphaReg = regCache_.Alloc(RegCache::GEN_SRC_ALPHA);
+		fp.UMOV(16, DecodeReg(alphaReg), argColorReg, 3);
+	}
+
+	// Okay, let's broadcast fog to a vector.
+	ARM64Reg fogMultReg = regCache_.Alloc(RegCache::VEC_TEMP3);
+	ARM64Reg argFogReg = regCache_.Find(RegCache::GEN_ARG_FOG);
+	fp.DUP(16, fogMultReg, DecodeReg(argFogReg));
+	regCache_.Unlock(argFogReg, RegCache::GEN_ARG_FOG);
+	// We can free up the actual fog reg now.
+	regCache_.ForceRelease(RegCache::GEN_ARG_FOG);
+
+	// Our goal here is to calculate this formula:
+	// (argColor * fog + fogColor * (255 - fog) + 255) / 256
+
+	// Now we multiply the existing color by fog...
+	fp.MUL(16, argColorReg, argColorReg, fogMultReg);
+	// Before inversing, let's add that 255 we loaded in as well, since we have it.
+	fp.ADD(16, argColorReg, argColorReg, invertReg);
+	// And then inverse the fog value using those 255s, and multiply by fog color.
+	fp.SUB(16, invertReg, invertReg, fogMultReg);
+	fp.MUL(16, fogColorReg, fogColorReg, invertReg);
+	// At this point, argColorReg and fogColorReg are multiplied at 16-bit, so we need to sum.
+	fp.ADD(16, argColorReg, argColorReg, fogColorReg);
+	regCache_.Release(fogColorReg, RegCache::VEC_TEMP1);
+	regCache_.Release(invertReg, RegCache::VEC_TEMP2);
+	regCache_.Release(fogMultReg, RegCache::VEC_TEMP3);
+
+	// Now we simply divide by 256, or in other words shift by 8.
+	fp.USHR(16, argColorReg, argColorReg, 8);
+
+	// Okay, put A back in, we'll shrink it to 8888 when needed.
+	fp.INS(16, argColorReg, 3, DecodeReg(alphaReg));
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	// We most likely won't use alphaReg again.
+	regCache_.Unlock(alphaReg, RegCache::GEN_SRC_ALPHA);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteStencilOnly(const PixelFuncID &id, RegCache::Reg stencilReg) {
+	_assert_(stencilReg != INVALID_REG);
+
+	// It's okay to destroy stencilReg here, we know we're the last writing it.
+	ARM64Reg colorOffReg = GetColorOff(id);
+	Describe("WriteStencil");
+	// Only the high byte ever has stencil bits.
+	int byteOffset = id.FBFormat() == GE_FORMAT_8888 ? 3 : 1;
+	uint32_t keepBits = 0;
+	if (id.FBFormat() == GE_FORMAT_5551)
+		keepBits = 0x7F;
+	else if (id.FBFormat() == GE_FORMAT_4444)
+		keepBits = 0x0F;
+
+	if (id.FBFormat() == GE_FORMAT_565) {
+		// Nothing to write.
+	} else if (id.applyColorWriteMask) {
+		ARM64Reg idReg = GetPixelID();
+		ARM64Reg maskReg = regCache_.Alloc(RegCache::GEN_TEMP5);
+		ARM64Reg destReg = regCache_.Alloc(RegCache::GEN_TEMP4);
+
+		// Read the high 8 bits of the color mask, and keep non-stencil bits too.
+		LDURB(DecodeReg(maskReg), idReg, offsetof(PixelFuncID, cached.colorWriteMask) + byteOffset);
+		if (keepBits != 0)
+			ORRI2R(DecodeReg(maskReg), DecodeReg(maskReg), keepBits);
+		UnlockPixelID(idReg);
+
+		BIC(DecodeReg(stencilReg), DecodeReg(stencilReg), DecodeReg(maskReg));
+		LDRB(INDEX_UNSIGNED, DecodeReg(destReg), colorOffReg, byteOffset);
+		AND(DecodeReg(destReg), DecodeReg(destReg), DecodeReg(maskReg));
+		ORR(DecodeReg(destReg), DecodeReg(destReg), DecodeReg(stencilReg));
+		STRB(INDEX_UNSIGNED, DecodeReg(destReg), colorOffReg, byteOffset);
+
+		regCache_.Release(maskReg, RegCache::GEN_TEMP5);
+		regCache_.Release(destReg, RegCache::GEN_TEMP4);
+	} else if (keepBits != 0) {
+		ARM64Reg destReg = regCache_.Alloc(RegCache::GEN_TEMP4);
+		LDRB(INDEX_UNSIGNED, DecodeReg(destReg), colorOffReg, byteOffset);
+		ANDI2R(DecodeReg(destReg), DecodeReg(destReg), keepBits);
+		ANDI2R(DecodeReg(stencilReg), DecodeReg(stencilReg), 0xFF & ~keepBits);
+		ORR(DecodeReg(destReg), DecodeReg(destReg), DecodeReg(stencilReg));
+		STRB(INDEX_UNSIGNED, DecodeReg(destReg), colorOffReg, byteOffset);
+		regCache_.Release(destReg, RegCache::GEN_TEMP4);
+	} else {
+		STRB(INDEX_UNSIGNED, DecodeReg(stencilReg), colorOffReg, byteOffset);
+	}
+
+	regCache_.Unlock(colorOffReg, RegCache::GEN_COLOR_OFF);
+	return true;
+}
+
+bool PixelJitCache::Jit_DepthTest(const PixelFuncID &id) {
+	if (id.DepthTestFunc() == GE_COMP_ALWAYS || id.earlyZChecks)
+		return true;
+
+	if (id.DepthTestFunc() == GE_COMP_NEVER) {
+		Discard();
+		// This should be uncommon, just keep going to have shared cleanup...
+	}
+
+	ARM64Reg depthOffReg = GetDepthOff(id);
+	Describe("DepthTest");
+	ARM64Reg argZReg = regCache_.Find(RegCache::GEN_ARG_Z);
+	ARM64Reg depthReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	ARM64Reg zReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	LDRH(INDEX_UNSIGNED, DecodeReg(depthReg), depthOffReg, 0);
+	// Only the low 16 bits of z matter here.
+	UXTH(DecodeReg(zReg), DecodeReg(argZReg));
+	CMP(DecodeReg(zReg), DecodeReg(depthReg));
+	regCache_.Release(depthReg, RegCache::GEN_TEMP0);
+	regCache_.Release(zReg, RegCache::GEN_TEMP1);
+	regCache_.Unlock(depthOffReg, RegCache::GEN_DEPTH_OFF);
+	regCache_.Unlock(argZReg, RegCache::GEN_ARG_Z);
+
+	// We discard the opposite of the passing test.
+	switch (id.DepthTestFunc()) {
+	case GE_COMP_NEVER:
+	case GE_COMP_ALWAYS:
+		break;
+
+	case GE_COMP_EQUAL:
+		Discard(CC_NEQ);
+		break;
+
+	case GE_COMP_NOTEQUAL:
+		Discard(CC_EQ);
+		break;
+
+	case GE_COMP_LESS:
+		Discard(CC_HS);
+		break;
+
+	case GE_COMP_LEQUAL:
+		Discard(CC_HI);
+		break;
+
+	case GE_COMP_GREATER:
+		Discard(CC_LS);
+		break;
+
+	case GE_COMP_GEQUAL:
+		Discard(CC_LO);
+		break;
+	}
+
+	// If we're not writing, we don't need Z anymore.  We'll free GEN_DEPTH_OFF in Jit_WriteDepth().
+	if (!id.depthWrite)
+		regCache_.ForceRelease(RegCache::GEN_ARG_Z);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteDepth(const PixelFuncID &id) {
+	// Clear mode shares depthWrite for DepthClear().
+	if (id.depthWrite) {
+		ARM64Reg depthOffReg = GetDepthOff(id);
+		Describe("WriteDepth");
+		ARM64Reg argZReg = regCache_.Find(RegCache::GEN_ARG_Z);
+		STRH(INDEX_UNSIGNED, DecodeReg(argZReg), depthOffReg, 0);
+		regCache_.Unlock(depthOffReg, RegCache::GEN_DEPTH_OFF);
+		regCache_.Unlock(argZReg, RegCache::GEN_ARG_Z);
+		regCache_.ForceRelease(RegCache::GEN_ARG_Z);
+	}
+
+	// We can free up this reg now.
+	if (regCache_.Has(RegCache::GEN_DEPTH_OFF)) {
+		regCache_.ForceRelease(RegCache::GEN_DEPTH_OFF);
+	}
+
+	return true;
+}
+
+bool PixelJitCache::Jit_Dither(const PixelFuncID &id) {
+	if (!id.dithering)
+		return true;
+
+	Describe("Dither");
+	ARM64Reg valueReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+	// Compute (y & 3) * 4 + (x & 3) to index the dither matrix.
+	ARM64Reg argYReg = regCache_.Find(RegCache::GEN_ARG_Y);
+	UBFIZ(DecodeReg(valueReg), DecodeReg(argYReg), 2, 2);
+	regCache_.Unlock(argYReg, RegCache::GEN_ARG_Y);
+	ARM64Reg argXReg = regCache_.Find(RegCache::GEN_ARG_X);
+	BFI(DecodeReg(valueReg), DecodeReg(argXReg), 0, 2);
+	regCache_.Unlock(argXReg, RegCache::GEN_ARG_X);
+
+	ARM64Reg idReg = GetPixelID();
+	ADD(valueReg, valueReg, idReg);
+	UnlockPixelID(idReg);
+	LDURSB(DecodeReg(valueReg), valueReg, offsetof(PixelFuncID, cached.ditherMatrix));
+
+	// Now we want to broadcast RGB in 16-bit, but keep A as 0.
+	// We use 16-bit because we need a signed add, but we also want to saturate.
+	ARM64Reg vecValueReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	fp.DUP(16, vecValueReg, DecodeReg(valueReg));
+	fp.INS(16, vecValueReg, 3, WZR);
+	regCache_.Release(valueReg, RegCache::GEN_TEMP0);
+
+	// With that, now let's convert the color to 16 bit...
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	if (!colorIs16Bit_) {
+		fp.UXTL(8, argColorReg, EncodeRegToDouble(argColorReg));
+		colorIs16Bit_ = true;
+	}
+	// And simply add the dither values.
+	fp.SQADD(16, argColorReg, argColorReg, vecValueReg);
+	regCache_.Release(vecValueReg, RegCache::VEC_TEMP0);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteColor(const PixelFuncID &id) {
+	ARM64Reg colorOff = GetColorOff(id);
+	Describe("WriteColor");
+	// Now that we have the offset, we're done with x and y.
+	regCache_.ForceRelease(RegCache::GEN_ARG_X);
+	regCache_.ForceRelease(RegCache::GEN_ARG_Y);
+
+	// Convert back to 8888 and clamp.
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	if (colorIs16Bit_) {
+		fp.SQXTUN(8, EncodeRegToDouble(argColorReg), argColorReg);
+		colorIs16Bit_ = false;
+	}
+
+	if (id.clearMode) {
+		bool drawingDone = false;
+		if (!id.ColorClear() && !id.StencilClear())
+			drawingDone = true;
+		if (!id.ColorClear() && id.FBFormat() == GE_FORMAT_565)
+			drawingDone = true;
+
+		bool success = true;
+		if (!id.ColorClear() && !drawingDone) {
+			// Let's reuse Jit_WriteStencilOnly for this path.
+			ARM64Reg alphaReg;
+			if (regCache_.Has(RegCache::GEN_SRC_ALPHA)) {
+				alphaReg = regCache_.Find(RegCache::GEN_SRC_ALPHA);
+			} else {
+				alphaReg = regCache_.Alloc(RegCache::GEN_SRC_ALPHA);
+				fp.UMOV(8, DecodeReg(alphaReg), argColorReg, 3);
+			}
+			success = Jit_WriteStencilOnly(id, alphaReg);
+			regCache_.Release(alphaReg, RegCache::GEN_SRC_ALPHA);
+
+			drawingDone = true;
+		}
+
+		if (drawingDone) {
+			regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+			regCache_.ForceRelease(RegCache::VEC_ARG_COLOR);
+			regCache_.Release(colorOff, RegCache::GEN_COLOR_OFF);
+			return success;
+		}
+
+		// In this case, we're clearing only color or only color and stencil.  Proceed.
+	}
+
+	ARM64Reg colorReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	fp.UMOV(32, DecodeReg(colorReg), argColorReg, 0);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+	regCache_.ForceRelease(RegCache::VEC_ARG_COLOR);
+
+	ARM64Reg temp1Reg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg temp2Reg = regCache_.Alloc(RegCache::GEN_TEMP2);
+	// Without a stencil test, only stencil clears write the alpha bits.
+	bool convertAlpha = id.clearMode && id.StencilClear();
+	uint32_t fixedKeepMask = 0x00000000;
+
+	bool success = true;
+
+	// Step 1: Load the color into colorReg.
+	switch (id.fbFormat) {
+	case GE_FORMAT_565:
+		// In this case, stencil doesn't matter.
+		success = success && Jit_ConvertTo565(id, colorReg, temp1Reg, temp2Reg);
+		break;
+
+	case GE_FORMAT_5551:
+		success = success && Jit_ConvertTo5551(id, colorReg, temp1Reg, temp2Reg, convertAlpha);
+		if (!convertAlpha)
+			fixedKeepMask = 0x8000;
+		break;
+
+	case GE_FORMAT_4444:
+		success = success && Jit_ConvertTo4444(id, colorReg, temp1Reg, temp2Reg, convertAlpha);
+		if (!convertAlpha)
+			fixedKeepMask = 0xF000;
+		break;
+
+	case GE_FORMAT_8888:
+		if (!convertAlpha)
+			fixedKeepMask = 0xFF000000;
+		break;
+	}
+
+	// Step 2: Load write mask if needed.
+	// Note that we apply the write mask at the destination bit depth.
+	Describe("WriteColor");
+	ARM64Reg maskReg = INVALID_REG;
+	if (id.applyColorWriteMask) {
+		maskReg = regCache_.Alloc(RegCache::GEN_TEMP3);
+		// Load the pre-converted and combined write mask.
+		ARM64Reg idReg = GetPixelID();
+		LDUR(DecodeReg(maskReg), idReg, offsetof(PixelFuncID, cached.colorWriteMask));
+		UnlockPixelID(idReg);
+	}
+
+	// Step 3: Write and apply write mask.  We use temp2Reg for the old value.
+	bool is16Bit = id.FBFormat() != GE_FORMAT_8888;
+	if (maskReg != INVALID_REG) {
+		// Keep the masked bits from the old value, and take the rest from the new color.
+		if (is16Bit)
+			LDRH(INDEX_UNSIGNED, DecodeReg(temp2Reg), colorOff, 0);
+		else
+			LDR(INDEX_UNSIGNED, DecodeReg(temp2Reg), colorOff, 0);
+		AND(DecodeReg(temp2Reg), DecodeReg(temp2Reg), DecodeReg(maskReg));
+		BIC(DecodeReg(colorReg), DecodeReg(colorReg), DecodeReg(maskReg));
+		ORR(DecodeReg(colorReg), DecodeReg(colorReg), DecodeReg(temp2Reg));
+	} else if (fixedKeepMask == 0xFF000000) {
+		// We want to set 24 bits only, since we're not changing stencil.
+		STRH(INDEX_UNSIGNED, DecodeReg(colorReg), colorOff, 0);
+		LSR(DecodeReg(colorReg), DecodeReg(colorReg), 16);
+		STRB(INDEX_UNSIGNED, DecodeReg(colorReg), colorOff, 2);
+	} else if (fixedKeepMask != 0) {
+		// Clear the non-stencil bits and or in the color.
+		LDRH(INDEX_UNSIGNED, DecodeReg(temp2Reg), colorOff, 0);
+		ANDI2R(DecodeReg(temp2Reg), DecodeReg(temp2Reg), fixedKeepMask);
+		ORR(DecodeReg(colorReg), DecodeReg(colorReg), DecodeReg(temp2Reg));
+	}
+
+	if (maskReg != INVALID_REG || fixedKeepMask != 0xFF000000) {
+		if (is16Bit)
+			STRH(INDEX_UNSIGNED, DecodeReg(colorReg), colorOff, 0);
+		else
+			STR(INDEX_UNSIGNED, DecodeReg(colorReg), colorOff, 0);
+	}
+
+	regCache_.Release(colorOff, RegCache::GEN_COLOR_OFF);
+	regCache_.Release(colorReg, RegCache::GEN_TEMP0);
+	regCache_.Release(temp1Reg, RegCache::GEN_TEMP1);
+	regCache_.Release(temp2Reg, RegCache::GEN_TEMP2);
+	if (maskReg != INVALID_REG)
+		regCache_.Release(maskReg, RegCache::GEN_TEMP3);
+
+	return success;
+}
+
+bool PixelJitCache::Jit_ConvertTo565(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg) {
+	Describe("ConvertTo565");
+
+	// Take the top 5 bits of R, then insert the top 6 of G and 5 of B above it.
+	UBFX(DecodeReg(temp1Reg), DecodeReg(colorReg), 3, 5);
+	UBFX(DecodeReg(temp2Reg), DecodeReg(colorReg), 10, 6);
+	BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 5, 6);
+	UBFX(DecodeReg(temp2Reg), DecodeReg(colorReg), 19, 5);
+	BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 11, 5);
+	MOV(DecodeReg(colorReg), DecodeReg(temp1Reg));
+
+	return true;
+}
+
+bool PixelJitCache::Jit_ConvertTo5551(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha) {
+	Describe("ConvertTo5551");
+
+	UBFX(DecodeReg(temp1Reg), DecodeReg(colorReg), 3, 5);
+	UBFX(DecodeReg(temp2Reg), DecodeReg(colorReg), 11, 5);
+	BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 5, 5);
+	UBFX(DecodeReg(temp2Reg), DecodeReg(colorReg), 19, 5);
+	BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 10, 5);
+
+	if (keepAlpha) {
+		LSR(DecodeReg(temp2Reg), DecodeReg(colorReg), 31);
+		BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 15, 1);
+	}
+	MOV(DecodeReg(colorReg), DecodeReg(temp1Reg));
+
+	return true;
+}
+
+bool PixelJitCache::Jit_ConvertTo4444(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha) {
+	Describe("ConvertTo4444");
+
+	UBFX(DecodeReg(temp1Reg), DecodeReg(colorReg), 4, 4);
+	UBFX(DecodeReg(temp2Reg), DecodeReg(colorReg), 12, 4);
+	BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 4, 4);
+	UBFX(DecodeReg(temp2Reg), DecodeReg(colorReg), 20, 4);
+	BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 8, 4);
+
+	if (keepAlpha) {
+		LSR(DecodeReg(temp2Reg), DecodeReg(colorReg), 28);
+		BFI(DecodeReg(temp1Reg), DecodeReg(temp2Reg), 12, 4);
+	}
+	MOV(DecodeReg(colorReg), DecodeReg(temp1Reg));
+
+	return true;
+}
+
+};
+
+#endif
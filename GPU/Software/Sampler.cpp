@@ -42,6 +42,13 @@
 #endif
 #endif
 
+// Fetch is also jitted on ARM64, but nearest and linear sampling only on x86-64 so far.
+#if PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)
+#define SAMPLER_JIT_SAMPLING 1
+#else
+#define SAMPLER_JIT_SAMPLING 0
+#endif
+
 using namespace Math3D;
 using namespace Rasterizer;
 
@@ -210,7 +217,7 @@ NearestFunc SamplerJitCache::GetByID(const SamplerID &id, size_t key, BinManager
 }
 
 NearestFunc SamplerJitCache::GetNearest(const SamplerID &id, BinManager *binner) {
-	if (!g_Config.bSoftwareRenderingJit)
+	if (!g_Config.bSoftwareRenderingJit || !SAMPLER_JIT_SAMPLING)
 		return nullptr;
 
 	const size_t key = std::hash<SamplerID>()(id);
@@ -223,7 +230,7 @@ NearestFunc SamplerJitCache::GetNearest(const SamplerID &id, BinManager *binner)
 }
 
 LinearFunc SamplerJitCache::GetLinear(const SamplerID &id, BinManager *binner) {
-	if (!g_Config.bSoftwareRenderingJit)
+	if (!g_Config.bSoftwareRenderingJit || !SAMPLER_JIT_SAMPLING)
 		return nullptr;
 
 	const size_t key = std::hash<SamplerID>()(id);
@@ -256,13 +263,15 @@ void SamplerJitCache::Compile(const SamplerID &id) {
 
 	// We compile them together so the cache can't possibly be cleared in between.
 	// We might vary between nearest and linear, so we can't clear between.
-#if PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)
+#if (PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)) || PPSSPP_ARCH(ARM64_NEON)
 	SamplerID fetchID = id;
 	fetchID.linear = false;
 	fetchID.fetch = true;
 	addresses_[fetchID] = GetCodePointer();
 	cache_.Insert(std::hash<SamplerID>()(fetchID), (NearestFunc)CompileFetch(fetchID));
+#endif
 
+#if SAMPLER_JIT_SAMPLING
 	SamplerID nearestID = id;
 	nearestID.linear = false;
 	nearestID.fetch = false;
@@ -0,0 +1,179 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(ARM64_NEON)
+
+#include "Common/Arm64Emitter.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/Sampler.h"
+#include "GPU/ge_constants.h"
+
+using namespace Arm64Gen;
+using namespace Rasterizer;
+
+namespace Sampler {
+
+FetchFunc SamplerJitCache::CompileFetch(const SamplerID &id) {
+	_assert_msg_(id.fetch && !id.linear, "Only fetch should be set on sampler id");
+
+	// Only direct color formats are supported so far, others use the generic func.
+	if (id.swizzle)
+		return nullptr;
+	switch (id.TexFmt()) {
+	case GE_TFMT_8888:
+	case GE_TFMT_5650:
+	case GE_TFMT_5551:
+	case GE_TFMT_4444:
+		break;
+	default:
+		return nullptr;
+	}
+
+	regCache_.SetupABI({
+		RegCache::GEN_ARG_U,
+		RegCache::GEN_ARG_V,
+		RegCache::GEN_ARG_TEXPTR,
+		RegCache::GEN_ARG_BUFW,
+		RegCache::GEN_ARG_LEVEL,
+		RegCache::GEN_ARG_ID,
+	});
+	regCache_.ChangeReg(Q0, RegCache::VEC_RESULT);
+	// We don't use these at all.
+	regCache_.ForceRelease(RegCache::GEN_ARG_LEVEL);
+	regCache_.ForceRelease(RegCache::GEN_ARG_ID);
+
+	BeginWrite(2048);
+	Describe("Init");
+	const u8 *start = AlignCode16();
+
+	// Early exit on !srcPtr.
+	FixupBranch zeroSrc;
+	if (id.hasInvalidPtr) {
+		ARM64Reg srcReg = regCache_.Find(RegCache::GEN_ARG_TEXPTR);
+		FixupBranch nonZeroSrc = CBNZ(srcReg);
+		regCache_.Unlock(srcReg, RegCache::GEN_ARG_TEXPTR);
+
+		ARM64Reg vecResultReg = regCache_.Find(RegCache::VEC_RESULT);
+		fp.EOR(vecResultReg, vecResultReg, vecResultReg);
+		regCache_.Unlock(vecResultReg, RegCache::VEC_RESULT);
+		zeroSrc = B();
+		SetJumpTarget(nonZeroSrc);
+	}
+
+	// Calculate the offset, which is (v * bufw + u) * bytes per pixel.
+	Describe("Offset");
+	ARM64Reg offReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	ARM64Reg bufwReg = regCache_.Find(RegCache::GEN_ARG_BUFW);
+	ARM64Reg vReg = regCache_.Find(RegCache::GEN_ARG_V);
+	// Only the low 16 bits of bufw are valid.
+	UXTH(DecodeReg(bufwReg), DecodeReg(bufwReg));
+	MUL(DecodeReg(offReg), DecodeReg(vReg), DecodeReg(bufwReg));
+	regCache_.Unlock(bufwReg, RegCache::GEN_ARG_BUFW);
+	regCache_.ForceRelease(RegCache::GEN_ARG_BUFW);
+	regCache_.Unlock(vReg, RegCache::GEN_ARG_V);
+	regCache_.ForceRelease(RegCache::GEN_ARG_V);
+
+	ARM64Reg uReg = regCache_.Find(RegCache::GEN_ARG_U);
+	ADD(DecodeReg(offReg), DecodeReg(offReg), DecodeReg(uReg));
+	regCache_.Unlock(uReg, RegCache::GEN_ARG_U);
+	regCache_.ForceRelease(RegCache::GEN_ARG_U);
+
+	bool is32Bit = id.TexFmt() == GE_TFMT_8888;
+	LSL(DecodeReg(offReg), DecodeReg(offReg), is32Bit ? 2 : 1);
+	// The offset is signed, like the generic func.
+	SXTW(offReg, DecodeReg(offReg));
+
+	ARM64Reg srcReg = regCache_.Find(RegCache::GEN_ARG_TEXPTR);
+	ARM64Reg resultReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	if (is32Bit)
+		LDR(DecodeReg(resultReg), srcReg, offReg);
+	else
+		LDRH(DecodeReg(resultReg), srcReg, offReg);
+	regCache_.Unlock(srcReg, RegCache::GEN_ARG_TEXPTR);
+	regCache_.ForceRelease(RegCache::GEN_ARG_TEXPTR);
+
+	// Now decode into 8888, reusing offReg as the destination.
+	ARM64Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP2);
+	auto expandChannel = [&](int srcShift, int bits, int dstByte) {
+		// Expands to 8 bits by repeating the high bits, i.e. (c << 3) | (c >> 2) for 5 bits.
+		UBFX(DecodeReg(tempReg), DecodeReg(resultReg), srcShift, bits);
+		BFI(DecodeReg(offReg), DecodeReg(tempReg), dstByte * 8 + 8 - bits, bits);
+		if (2 * bits != 8)
+			LSR(DecodeReg(tempReg), DecodeReg(tempReg), 2 * bits - 8);
+		BFI(DecodeReg(offReg), DecodeReg(tempReg), dstByte * 8, 8 - bits);
+	};
+
+	switch (id.TexFmt()) {
+	case GE_TFMT_8888:
+		MOV(DecodeReg(offReg), DecodeReg(resultReg));
+		break;
+
+	case GE_TFMT_5650:
+		Describe("5650");
+		expandChannel(0, 5, 0);
+		expandChannel(5, 6, 1);
+		expandChannel(11, 5, 2);
+		ORRI2R(DecodeReg(offReg), DecodeReg(offReg), 0xFF000000);
+		break;
+
+	case GE_TFMT_5551:
+		Describe("5551");
+		expandChannel(0, 5, 0);
+		expandChannel(5, 5, 1);
+		expandChannel(10, 5, 2);
+		// Alpha is all or nothing, so just sign extend the top bit.
+		SBFM(DecodeReg(tempReg), DecodeReg(resultReg), 15, 15);
+		BFI(DecodeReg(offReg), DecodeReg(tempReg), 24, 8);
+		break;
+
+	case GE_TFMT_4444:
+		Describe("4444");
+		for (int i = 0; i < 4; ++i)
+			expandChannel(i * 4, 4, i);
+		break;
+
+	default:
+		break;
+	}
+	regCache_.Release(tempReg, RegCache::GEN_TEMP2);
+	regCache_.Release(resultReg, RegCache::GEN_TEMP1);
+
+	// Finally, expand each channel to 32 bits in the result.
+	ARM64Reg vecResultReg = regCache_.Find(RegCache::VEC_RESULT);
+	fp.INS(32, vecResultReg, 0, DecodeReg(offReg));
+	fp.UXTL(8, vecResultReg, EncodeRegToDouble(vecResultReg));
+	fp.UXTL(16, vecResultReg, EncodeRegToDouble(vecResultReg));
+	regCache_.Unlock(vecResultReg, RegCache::VEC_RESULT);
+	regCache_.Release(offReg, RegCache::GEN_TEMP0);
+
+	Describe("Init");
+	if (id.hasInvalidPtr) {
+		SetJumpTarget(zeroSrc);
+	}
+
+	RET();
+
+	regCache_.Reset(true);
+	FlushIcache();
+	EndWrite();
+	return (FetchFunc)start;
+}
+
+};
+
+#endif
@@ -97,6 +97,9 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	}
 }
 
+// Bump this when glslang is updated or GLSLtoSPV options change, since the cache is keyed on source only.
+static const uint32_t SPIRV_CACHE_VERSION = 1;
+
 void GPU_Vulkan::LoadCache(const Path &filename) {
 	if (!g_Config.bShaderCache) {
 		WARN_LOG(Log::G3D, "Shader cache disabled. Not loading.");
@@ -104,6 +107,9 @@ void GPU_Vulkan::LoadCache(const Path &filename) {
 	}
 
 	PSP_SetLoading("Loading shader cache...");
+	// Load the SPIR-V first, so the shader compiles below can skip glslang entirely.
+	shaderManagerVulkan_->GetBlobCache().Load(filename.WithReplacedExtension(".vkspirvcache"), SPIRV_CACHE_VERSION);
+
 	// Actually precompiled by IsReady() since we're single-threaded.
 	FILE *f = File::OpenCFile(filename, "rb");
 	if (!f)
@@ -162,6 +168,8 @@ void GPU_Vulkan::SaveCache(const Path &filename) {
 	pipelineManager_->SavePipelineCache(f, false, shaderManagerVulkan_, draw_);
 	INFO_LOG(Log::G3D, "Saved Vulkan pipeline cache");
 	fclose(f);
+
+	shaderManagerVulkan_->SaveBlobCache(filename.WithReplacedExtension(".vkspirvcache"), SPIRV_CACHE_VERSION);
 }
 
 GPU_Vulkan::~GPU_Vulkan() {
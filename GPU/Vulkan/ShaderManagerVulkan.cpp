@@ -27,6 +27,7 @@
 #include "Common/GPU/thin3d.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/TimeUtil.h"
+#include "Common/Thread/ParallelLoop.h"
 
 #include "Common/StringUtils.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
@@ -48,14 +49,26 @@
 // takes time here, and makes this worthy of parallelization, is GLSLtoSPV.
 // Takes ownership over tag.
 // This always returns something, checking the return value for null is not meaningful.
-static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, VkShaderStageFlagBits stage, const char *code, std::string *tag) {
+// If blobCache is set, previously compiled SPIR-V for the same source is reused.
+static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, VkShaderStageFlagBits stage, const char *code, std::string *tag, ShaderBlobCache *blobCache) {
 	auto compile = [=] {
 		PROFILE_THIS_SCOPE("shadercomp");
 
 		std::string errorMessage;
 		std::vector<uint32_t> spirv;
 
-		bool success = GLSLtoSPV(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+		uint64_t blobKey = blobCache ? ShaderBlobCache::MakeKey((int)stage, code) : 0;
+		std::vector<uint8_t> blob;
+		bool success;
+		if (blobCache && blobCache->Find(blobKey, &blob) && (blob.size() & 3) == 0) {
+			spirv.resize(blob.size() / sizeof(uint32_t));
+			memcpy(spirv.data(), blob.data(), blob.size());
+			success = true;
+		} else {
+			success = GLSLtoSPV(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+			if (success && blobCache)
+				blobCache->Insert(blobKey, spirv.data(), spirv.size() * sizeof(uint32_t));
+		}
 
 		if (!errorMessage.empty()) {
 			if (success) {
@@ -111,11 +124,11 @@ static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan,
 	}
 }
 
-VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code)
+VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code, ShaderBlobCache *blobCache)
 	: vulkan_(vulkan), id_(id), flags_(flags) {
 	_assert_(!id.is_invalid());
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)));
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)), blobCache);
 	VERBOSE_LOG(Log::G3D, "Compiled fragment shader:\n%s\n", (const char *)code);
 }
 
@@ -143,11 +156,11 @@ std::string VulkanFragmentShader::GetShaderString(DebugShaderStringType type) co
 	}
 }
 
-VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform)
+VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform, ShaderBlobCache *blobCache)
 	: vulkan_(vulkan), useHWTransform_(useHWTransform), flags_(flags), id_(id) {
 	_assert_(!id.is_invalid());
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)));
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)), blobCache);
 	VERBOSE_LOG(Log::G3D, "Compiled vertex shader:\n%s\n", (const char *)code);
 }
 
@@ -175,11 +188,11 @@ std::string VulkanVertexShader::GetShaderString(DebugShaderStringType type) cons
 	}
 }
 
-VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code)
+VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code, ShaderBlobCache *blobCache)
 	: vulkan_(vulkan), id_(id) {
 	_assert_(!id.is_invalid());
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()));
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()), blobCache);
 	VERBOSE_LOG(Log::G3D, "Compiled geometry shader:\n%s\n", (const char *)code);
 }
 
@@ -311,7 +324,7 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 			_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
 
 			// Don't need to re-lookup anymore, now that we lock wider.
-			vs = new VulkanVertexShader(vulkan, VSID, flags, codeBuffer_, useHWTransform);
+			vs = new VulkanVertexShader(vulkan, VSID, flags, codeBuffer_, useHWTransform, &blobCache_);
 			vsCache_.Insert(VSID, vs);
 		}
 		lastVShader_ = vs;
@@ -339,7 +352,7 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 			_assert_msg_(success, "FS gen error: %s", genErrorString.c_str());
 			_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
 
-			fs = new VulkanFragmentShader(vulkan, FSID, flags, codeBuffer_);
+			fs = new VulkanFragmentShader(vulkan, FSID, flags, codeBuffer_, &blobCache_);
 			fsCache_.Insert(FSID, fs);
 		}
 		lastFShader_ = fs;
@@ -366,7 +379,7 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 				_assert_msg_(success, "GS gen error: %s", genErrorString.c_str());
 				_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
 
-				gs = new VulkanGeometryShader(vulkan, GSID, codeBuffer_);
+				gs = new VulkanGeometryShader(vulkan, GSID, codeBuffer_, &blobCache_);
 				gsCache_.Insert(GSID, gs);
 			}
 		} else {
@@ -549,77 +562,131 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		gstate_c.useFlagsChanged = false;
 	}
 
-	int failCount = 0;
+	// Counts come straight from the file, check them against what's left of it before allocating.
+	long idsStart = ftell(f);
+	long fileEnd = -1;
+	if (success && idsStart >= 0 && fseek(f, 0, SEEK_END) == 0) {
+		fileEnd = ftell(f);
+		success = fseek(f, idsStart, SEEK_SET) == 0;
+	}
+	if (!success || fileEnd < idsStart) {
+		ERROR_LOG(Log::G3D, "Vulkan shader cache truncated (in header)");
+		return false;
+	}
+	// Compared in size_t, so a negative count fails too.
+	size_t bytesLeft = (size_t)(fileEnd - idsStart);
+	auto countFits = [&](int count, size_t idSize) {
+		if (count < 0 || (size_t)count > bytesLeft / idSize)
+			return false;
+		bytesLeft -= (size_t)count * idSize;
+		return true;
+	};
+	if (!countFits(header.numVertexShaders, sizeof(VShaderID)) || !countFits(header.numFragmentShaders, sizeof(FShaderID)) || !countFits(header.numGeometryShaders, sizeof(GShaderID))) {
+		ERROR_LOG(Log::G3D, "Vulkan shader cache has bad shader counts (%d, %d, %d)", header.numVertexShaders, header.numFragmentShaders, header.numGeometryShaders);
+		return false;
+	}
 
-	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
-	for (int i = 0; i < header.numVertexShaders; i++) {
-		VShaderID id;
-		if (fread(&id, sizeof(id), 1, f) != 1) {
-			ERROR_LOG(Log::G3D, "Vulkan shader cache truncated (in VertexShaders)");
+	// Read all the IDs up front, so we can generate the source in parallel.
+	std::vector<VShaderID> vsIDs(header.numVertexShaders);
+	std::vector<FShaderID> fsIDs(header.numFragmentShaders);
+	std::vector<GShaderID> gsIDs;
+	if (!vsIDs.empty() && fread(&vsIDs[0], sizeof(VShaderID), vsIDs.size(), f) != vsIDs.size()) {
+		ERROR_LOG(Log::G3D, "Vulkan shader cache truncated (in VertexShaders)");
+		return false;
+	}
+	if (!fsIDs.empty() && fread(&fsIDs[0], sizeof(FShaderID), fsIDs.size(), f) != fsIDs.size()) {
+		ERROR_LOG(Log::G3D, "Vulkan shader cache truncated (in FragmentShaders)");
+		return false;
+	}
+	// If it's not enabled, don't create shaders cached from earlier runs - creation will likely fail.
+	if (gstate_c.Use(GPU_USE_GS_CULLING)) {
+		gsIDs.resize(header.numGeometryShaders);
+		if (!gsIDs.empty() && fread(&gsIDs[0], sizeof(GShaderID), gsIDs.size(), f) != gsIDs.size()) {
+			ERROR_LOG(Log::G3D, "Vulkan shader cache truncated (in GeometryShaders)");
 			return false;
 		}
-		bool useHWTransform = id.Bit(VS_BIT_USE_HW_TRANSFORM);
-		std::string genErrorString;
-		uint32_t attributeMask = 0;
-		uint64_t uniformMask = 0;
-		VertexShaderFlags flags;
-		if (!GenerateVertexShader(id, codeBuffer_, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &flags, &genErrorString)) {
+	}
+
+	struct GeneratedShader {
+		std::string code;
+		bool success = false;
+		VertexShaderFlags vsFlags{};
+		FragmentShaderFlags fsFlags{};
+	};
+
+	// Generation is pure CPU work on the IDs, so spread it across workers.  Indices are VS, then FS, then GS.
+	const int vsEnd = (int)vsIDs.size();
+	const int fsEnd = vsEnd + (int)fsIDs.size();
+	const int total = fsEnd + (int)gsIDs.size();
+	std::vector<GeneratedShader> generated(total);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		char *buffer = new char[CODE_BUFFER_SIZE];
+		for (int i = l; i < h; ++i) {
+			GeneratedShader &gen = generated[i];
+			std::string genErrorString;
+			if (i < vsEnd) {
+				uint32_t attributeMask = 0;
+				uint64_t uniformMask = 0;
+				gen.success = GenerateVertexShader(vsIDs[i], buffer, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &gen.vsFlags, &genErrorString);
+			} else if (i < fsEnd) {
+				uint64_t uniformMask = 0;
+				gen.success = GenerateFragmentShader(fsIDs[i - vsEnd], buffer, compat_, draw_->GetBugs(), &uniformMask, &gen.fsFlags, &genErrorString);
+			} else {
+				gen.success = GenerateGeometryShader(gsIDs[i - fsEnd], buffer, compat_, draw_->GetBugs(), &genErrorString);
+			}
+			if (gen.success) {
+				_assert_msg_(strlen(buffer) < CODE_BUFFER_SIZE, "Shader length error: %d", (int)strlen(buffer));
+				gen.code = buffer;
+			}
+		}
+		delete[] buffer;
+	}, 0, total, 4);
+
+	int failCount = 0;
+
+	// Creating the shaders kicks off the SPIR-V compiles on worker threads (or hits the blob cache.)
+	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
+	for (int i = 0; i < vsEnd; i++) {
+		const VShaderID &id = vsIDs[i];
+		if (!generated[i].success) {
 			ERROR_LOG(Log::G3D, "Failed to generate vertex shader during cache load");
 			// We just ignore this one and carry on.
 			failCount++;
 			continue;
 		}
-		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
 		// Don't add the new shader if already compiled - though this should no longer happen.
 		if (!vsCache_.ContainsKey(id)) {
-			VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, flags, codeBuffer_, useHWTransform);
+			bool useHWTransform = id.Bit(VS_BIT_USE_HW_TRANSFORM);
+			VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, generated[i].vsFlags, generated[i].code.c_str(), useHWTransform, &blobCache_);
 			vsCache_.Insert(id, vs);
 		}
 	}
-	uint32_t vendorID = vulkan->GetPhysicalDeviceProperties().properties.vendorID;
 
-	for (int i = 0; i < header.numFragmentShaders; i++) {
-		FShaderID id;
-		if (fread(&id, sizeof(id), 1, f) != 1) {
-			ERROR_LOG(Log::G3D, "Vulkan shader cache truncated (in FragmentShaders)");
-			return false;
-		}
-		std::string genErrorString;
-		uint64_t uniformMask = 0;
-		FragmentShaderFlags flags;
-		if (!GenerateFragmentShader(id, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &flags, &genErrorString)) {
+	for (int i = vsEnd; i < fsEnd; i++) {
+		const FShaderID &id = fsIDs[i - vsEnd];
+		if (!generated[i].success) {
 			ERROR_LOG(Log::G3D, "Failed to generate fragment shader during cache load");
 			// We just ignore this one and carry on.
 			failCount++;
 			continue;
 		}
-		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
 		if (!fsCache_.ContainsKey(id)) {
-			VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, flags, codeBuffer_);
+			VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, generated[i].fsFlags, generated[i].code.c_str(), &blobCache_);
 			fsCache_.Insert(id, fs);
 		}
 	}
 
-	// If it's not enabled, don't create shaders cached from earlier runs - creation will likely fail.
-	if (gstate_c.Use(GPU_USE_GS_CULLING)) {
-		for (int i = 0; i < header.numGeometryShaders; i++) {
-			GShaderID id;
-			if (fread(&id, sizeof(id), 1, f) != 1) {
-				ERROR_LOG(Log::G3D, "Vulkan shader cache truncated (in GeometryShaders)");
-				return false;
-			}
-			std::string genErrorString;
-			if (!GenerateGeometryShader(id, codeBuffer_, compat_, draw_->GetBugs(), &genErrorString)) {
-				ERROR_LOG(Log::G3D, "Failed to generate geometry shader during cache load");
-				// We just ignore this one and carry on.
-				failCount++;
-				continue;
-			}
-			_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
-			if (!gsCache_.ContainsKey(id)) {
-				VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, codeBuffer_);
-				gsCache_.Insert(id, gs);
-			}
+	for (int i = fsEnd; i < total; i++) {
+		const GShaderID &id = gsIDs[i - fsEnd];
+		if (!generated[i].success) {
+			ERROR_LOG(Log::G3D, "Failed to generate geometry shader during cache load");
+			// We just ignore this one and carry on.
+			failCount++;
+			continue;
+		}
+		if (!gsCache_.ContainsKey(id)) {
+			VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, generated[i].code.c_str(), &blobCache_);
+			gsCache_.Insert(id, gs);
 		}
 	}
 
@@ -627,6 +694,21 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 	return true;
 }
 
+bool ShaderManagerVulkan::SaveBlobCache(const Path &filename, uint32_t version) {
+	std::vector<uint64_t> keys;
+	keys.reserve(vsCache_.size() + fsCache_.size() + gsCache_.size());
+	vsCache_.Iterate([&](const VShaderID &id, VulkanVertexShader *vs) {
+		keys.push_back(ShaderBlobCache::MakeKey(VK_SHADER_STAGE_VERTEX_BIT, vs->source().c_str()));
+	});
+	fsCache_.Iterate([&](const FShaderID &id, VulkanFragmentShader *fs) {
+		keys.push_back(ShaderBlobCache::MakeKey(VK_SHADER_STAGE_FRAGMENT_BIT, fs->source().c_str()));
+	});
+	gsCache_.Iterate([&](const GShaderID &id, VulkanGeometryShader *gs) {
+		keys.push_back(ShaderBlobCache::MakeKey(VK_SHADER_STAGE_GEOMETRY_BIT, gs->source().c_str()));
+	});
+	return blobCache_.Save(filename, version, keys);
+}
+
 void ShaderManagerVulkan::SaveCache(FILE *f, DrawEngineVulkan *drawEngine) {
 	VulkanCacheHeader header{};
 	header.magic = CACHE_HEADER_MAGIC;
@@ -24,6 +24,7 @@
 #include "Common/Thread/Promise.h"
 #include "Common/Data/Collections/Hashmaps.h"
 #include "Common/GPU/Vulkan/VulkanMemory.h"
+#include "GPU/Common/ShaderBlobCache.h"
 #include "GPU/Common/ShaderCommon.h"
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/VertexShaderGenerator.h"
@@ -38,7 +39,7 @@ class VulkanPushPool;
 
 class VulkanFragmentShader {
 public:
-	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code);
+	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code, ShaderBlobCache *blobCache = nullptr);
 	~VulkanFragmentShader();
 
 	const std::string &source() const { return source_; }
@@ -61,7 +62,7 @@ class VulkanFragmentShader {
 
 class VulkanVertexShader {
 public:
-	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform);
+	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform, ShaderBlobCache *blobCache = nullptr);
 	~VulkanVertexShader();
 
 	const std::string &source() const { return source_; }
@@ -85,7 +86,7 @@ class VulkanVertexShader {
 
 class VulkanGeometryShader {
 public:
-	VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code);
+	VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code, ShaderBlobCache *blobCache = nullptr);
 	~VulkanGeometryShader();
 
 	const std::string &source() const { return source_; }
@@ -154,6 +155,11 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 	bool LoadCache(FILE *f);
 	void SaveCache(FILE *f, DrawEngineVulkan *drawEngine);
 
+	// Compiled SPIR-V, so cached shaders don't have to go through glslang again.
+	ShaderBlobCache &GetBlobCache() { return blobCache_; }
+	// Saves the blobs of the shaders currently in the cache, dropping any others.
+	bool SaveBlobCache(const Path &filename, uint32_t version);
+
 private:
 	void Clear();
 
@@ -169,6 +175,7 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 	GSCache gsCache_;
 
 	char *codeBuffer_;
+	ShaderBlobCache blobCache_;
 
 	uint64_t uboAlignment_;
 	// Uniform block scratchpad. These (the relevant ones) are copied to the current pushbuffer at draw time.
@@ -1233,6 +1233,273 @@ rijndaelDecrypt(const u32 rk[/*4*(Nr + 1)*/], int Nr, const u8 ct[16],
 	PUTU32(pt + 12, s3);
 }
 
+/*
+ * Hardware accelerated paths (AES-NI, ARMv8 crypto extensions), picked at runtime.
+ *
+ * These run off the same key schedules as above: the words are big endian, so each needs
+ * a byte swap, and dk is already in the "equivalent inverse cipher" form aesdec expects.
+ */
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AES_ACCEL_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AES_ACCEL_TARGET
+#else
+#include <cpuid.h>
+#define AES_ACCEL_TARGET __attribute__((target("aes,ssse3")))
+#endif
+#elif defined(_M_ARM64) || (defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)))
+#define AES_ACCEL_ARM64
+#ifdef _MSC_VER
+#include <windows.h>
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#define AES_ACCEL_TARGET
+#endif
+
+/* -1 until detected. */
+static int aes_accel = -1;
+static int aes_accel_supported = -1;
+
+static int AES_detect_accel(void)
+{
+#if defined(AES_ACCEL_X86)
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 1);
+	/* ECX bit 25 is AES-NI, bit 9 is SSSE3. */
+	return (regs[2] & (1 << 25)) != 0 && (regs[2] & (1 << 9)) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return 0;
+	return (ecx & bit_AES) != 0 && (ecx & bit_SSSE3) != 0;
+#endif
+#elif defined(AES_ACCEL_ARM64)
+#if defined(__APPLE__)
+	return 1;
+#elif defined(_MSC_VER)
+	return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__linux__)
+	return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#else
+	/* Compiled assuming the extension is there. */
+	return 1;
+#endif
+#else
+	return 0;
+#endif
+}
+
+int AES_accel_enabled(void)
+{
+	if (aes_accel < 0) {
+		aes_accel_supported = AES_detect_accel();
+		aes_accel = aes_accel_supported;
+	}
+	return aes_accel;
+}
+
+void AES_set_accel(int enable)
+{
+	AES_accel_enabled();
+	aes_accel = enable && aes_accel_supported;
+}
+
+#if defined(AES_ACCEL_X86)
+
+typedef __m128i aes_block;
+
+static AES_ACCEL_TARGET void aes_accel_load_keys(const u32 *rk, int Nr, aes_block *keys)
+{
+	const __m128i swap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	int i;
+	for (i = 0; i <= Nr; i++)
+		keys[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(rk + 4 * i)), swap);
+}
+
+#define AES_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define AES_STORE(p, b) _mm_storeu_si128((__m128i *)(p), b)
+#define AES_XOR(a, b) _mm_xor_si128(a, b)
+#define AES_ZERO() _mm_setzero_si128()
+
+static AES_ACCEL_TARGET aes_block aes_accel_enc(const aes_block *k, int Nr, aes_block b)
+{
+	int r;
+	b = _mm_xor_si128(b, k[0]);
+	for (r = 1; r < Nr; r++)
+		b = _mm_aesenc_si128(b, k[r]);
+	return _mm_aesenclast_si128(b, k[Nr]);
+}
+
+static AES_ACCEL_TARGET aes_block aes_accel_dec(const aes_block *k, int Nr, aes_block b)
+{
+	int r;
+	b = _mm_xor_si128(b, k[0]);
+	for (r = 1; r < Nr; r++)
+		b = _mm_aesdec_si128(b, k[r]);
+	return _mm_aesdeclast_si128(b, k[Nr]);
+}
+
+/* Four independent blocks at once, to hide the instruction latency. */
+static AES_ACCEL_TARGET void aes_accel_dec4(const aes_block *k, int Nr, aes_block *b)
+{
+	int r;
+	b[0] = _mm_xor_si128(b[0], k[0]);
+	b[1] = _mm_xor_si128(b[1], k[0]);
+	b[2] = _mm_xor_si128(b[2], k[0]);
+	b[3] = _mm_xor_si128(b[3], k[0]);
+	for (r = 1; r < Nr; r++) {
+		b[0] = _mm_aesdec_si128(b[0], k[r]);
+		b[1] = _mm_aesdec_si128(b[1], k[r]);
+		b[2] = _mm_aesdec_si128(b[2], k[r]);
+		b[3] = _mm_aesdec_si128(b[3], k[r]);
+	}
+	b[0] = _mm_aesdeclast_si128(b[0], k[Nr]);
+	b[1] = _mm_aesdeclast_si128(b[1], k[Nr]);
+	b[2] = _mm_aesdeclast_si128(b[2], k[Nr]);
+	b[3] = _mm_aesdeclast_si128(b[3], k[Nr]);
+}
+
+#elif defined(AES_ACCEL_ARM64)
+
+typedef uint8x16_t aes_block;
+
+static void aes_accel_load_keys(const u32 *rk, int Nr, aes_block *keys)
+{
+	int i;
+	for (i = 0; i <= Nr; i++)
+		keys[i] = vrev32q_u8(vld1q_u8((const uint8_t *)(rk + 4 * i)));
+}
+
+#define AES_LOAD(p) vld1q_u8((const uint8_t *)(p))
+#define AES_STORE(p, b) vst1q_u8((uint8_t *)(p), b)
+#define AES_XOR(a, b) veorq_u8(a, b)
+#define AES_ZERO() vdupq_n_u8(0)
+
+/* AESE/AESD do the round key add first, so the last key is applied separately. */
+static aes_block aes_accel_enc(const aes_block *k, int Nr, aes_block b)
+{
+	int r;
+	for (r = 0; r < Nr - 1; r++)
+		b = vaesmcq_u8(vaeseq_u8(b, k[r]));
+	b = vaeseq_u8(b, k[Nr - 1]);
+	return veorq_u8(b, k[Nr]);
+}
+
+static aes_block aes_accel_dec(const aes_block *k, int Nr, aes_block b)
+{
+	int r;
+	for (r = 0; r < Nr - 1; r++)
+		b = vaesimcq_u8(vaesdq_u8(b, k[r]));
+	b = vaesdq_u8(b, k[Nr - 1]);
+	return veorq_u8(b, k[Nr]);
+}
+
+static void aes_accel_dec4(const aes_block *k, int Nr, aes_block *b)
+{
+	int r;
+	for (r = 0; r < Nr - 1; r++) {
+		b[0] = vaesimcq_u8(vaesdq_u8(b[0], k[r]));
+		b[1] = vaesimcq_u8(vaesdq_u8(b[1], k[r]));
+		b[2] = vaesimcq_u8(vaesdq_u8(b[2], k[r]));
+		b[3] = vaesimcq_u8(vaesdq_u8(b[3], k[r]));
+	}
+	b[0] = veorq_u8(vaesdq_u8(b[0], k[Nr - 1]), k[Nr]);
+	b[1] = veorq_u8(vaesdq_u8(b[1], k[Nr - 1]), k[Nr]);
+	b[2] = veorq_u8(vaesdq_u8(b[2], k[Nr - 1]), k[Nr]);
+	b[3] = veorq_u8(vaesdq_u8(b[3], k[Nr - 1]), k[Nr]);
+}
+
+#endif
+
+#if defined(AES_ACCEL_X86) || defined(AES_ACCEL_ARM64)
+
+static AES_ACCEL_TARGET void aes_accel_encrypt(const u32 *ek, int Nr, const u8 *src, u8 *dst)
+{
+	aes_block k[AES_MAXROUNDS + 1];
+	aes_accel_load_keys(ek, Nr, k);
+	AES_STORE(dst, aes_accel_enc(k, Nr, AES_LOAD(src)));
+}
+
+static AES_ACCEL_TARGET void aes_accel_decrypt(const u32 *dk, int Nr, const u8 *src, u8 *dst)
+{
+	aes_block k[AES_MAXROUNDS + 1];
+	aes_accel_load_keys(dk, Nr, k);
+	AES_STORE(dst, aes_accel_dec(k, Nr, AES_LOAD(src)));
+}
+
+/* Same block handling as AES_cbc_encrypt below: zero IV, a partial block at the end is padded out. */
+static AES_ACCEL_TARGET void aes_accel_cbc_encrypt(const u32 *ek, int Nr, const u8 *src, u8 *dst, int size)
+{
+	aes_block k[AES_MAXROUNDS + 1];
+	aes_block prev = AES_ZERO();
+	int i;
+	aes_accel_load_keys(ek, Nr, k);
+	for (i = 0; i < size; i += 16) {
+		prev = aes_accel_enc(k, Nr, AES_XOR(AES_LOAD(src + i), prev));
+		AES_STORE(dst + i, prev);
+	}
+}
+
+/* Like AES_cbc_decrypt below, always does at least one block.  Safe in place. */
+static AES_ACCEL_TARGET void aes_accel_cbc_decrypt(const u32 *dk, int Nr, const u8 *src, u8 *dst, int size)
+{
+	aes_block k[AES_MAXROUNDS + 1];
+	aes_block prev = AES_ZERO();
+	int blocks = size <= 16 ? 1 : (size + 15) / 16;
+	int n = 0;
+	aes_accel_load_keys(dk, Nr, k);
+
+	for (; n + 4 <= blocks; n += 4) {
+		aes_block c[4], b[4];
+		c[0] = AES_LOAD(src + n * 16);
+		c[1] = AES_LOAD(src + n * 16 + 16);
+		c[2] = AES_LOAD(src + n * 16 + 32);
+		c[3] = AES_LOAD(src + n * 16 + 48);
+		b[0] = c[0];
+		b[1] = c[1];
+		b[2] = c[2];
+		b[3] = c[3];
+		aes_accel_dec4(k, Nr, b);
+		AES_STORE(dst + n * 16, AES_XOR(b[0], prev));
+		AES_STORE(dst + n * 16 + 16, AES_XOR(b[1], c[0]));
+		AES_STORE(dst + n * 16 + 32, AES_XOR(b[2], c[1]));
+		AES_STORE(dst + n * 16 + 48, AES_XOR(b[3], c[2]));
+		prev = c[3];
+	}
+	for (; n < blocks; n++) {
+		aes_block c = AES_LOAD(src + n * 16);
+		AES_STORE(dst + n * 16, AES_XOR(aes_accel_dec(k, Nr, c), prev));
+		prev = c;
+	}
+}
+
+/* The CBC-MAC chain of AES_CMAC: blocks full blocks of input, then the prepared last block. */
+static AES_ACCEL_TARGET void aes_accel_cmac_chain(const u32 *ek, int Nr, const u8 *input, int blocks, const u8 *last, u8 *mac)
+{
+	aes_block k[AES_MAXROUNDS + 1];
+	aes_block x = AES_ZERO();
+	int i;
+	aes_accel_load_keys(ek, Nr, k);
+	for (i = 0; i < blocks; i++)
+		x = aes_accel_enc(k, Nr, AES_XOR(x, AES_LOAD(input + i * 16)));
+	AES_STORE(mac, aes_accel_enc(k, Nr, AES_XOR(x, AES_LOAD(last))));
+}
+
+#define AES_ACCEL_AVAILABLE
+#endif
+
 /* setup key context for encryption only */
 int
 rijndael_set_key_enc_only(rijndael_ctx *ctx, const u8 *key, int bits)
@@ -1270,12 +1537,24 @@ rijndael_set_key(rijndael_ctx *ctx, const u8 *key, int bits)
 void
 rijndael_decrypt(rijndael_ctx *ctx, const u8 *src, u8 *dst)
 {
+#ifdef AES_ACCEL_AVAILABLE
+	if (AES_accel_enabled()) {
+		aes_accel_decrypt(ctx->dk, ctx->Nr, src, dst);
+		return;
+	}
+#endif
 	rijndaelDecrypt(ctx->dk, ctx->Nr, src, dst);
 }
 
 void
 rijndael_encrypt(rijndael_ctx *ctx, const u8 *src, u8 *dst)
 {
+#ifdef AES_ACCEL_AVAILABLE
+	if (AES_accel_enabled()) {
+		aes_accel_encrypt(ctx->ek, ctx->Nr, src, dst);
+		return;
+	}
+#endif
 	rijndaelEncrypt(ctx->ek, ctx->Nr, src, dst);
 }
 
@@ -1286,12 +1565,12 @@ int AES_set_key(AES_ctx *ctx, const u8 *key, int bits)
 
 void AES_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst)
 {
-	rijndaelDecrypt(ctx->dk, ctx->Nr, src, dst);
+	rijndael_decrypt((rijndael_ctx *)ctx, src, dst);
 }
 
 void AES_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst)
 {
-	rijndaelEncrypt(ctx->ek, ctx->Nr, src, dst);
+	rijndael_encrypt((rijndael_ctx *)ctx, src, dst);
 }
 
 void xor_128(const unsigned char *a, const unsigned char *b, unsigned char *out)
@@ -1309,6 +1588,12 @@ void AES_cbc_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size)
 	u8 block_buff[16];
 	
 	int i;
+#ifdef AES_ACCEL_AVAILABLE
+	if (AES_accel_enabled()) {
+		aes_accel_cbc_encrypt(ctx->ek, ctx->Nr, src, dst, size);
+		return;
+	}
+#endif
 	for(i = 0; i < size; i+=16)
 	{
 		//step 1: copy block to dst
@@ -1330,6 +1615,13 @@ void AES_cbc_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size)
 	u8 block_buff[16];
 	u8 block_buff_previous[16];
 	int i;
+
+#ifdef AES_ACCEL_AVAILABLE
+	if (AES_accel_enabled()) {
+		aes_accel_cbc_decrypt(ctx->dk, ctx->Nr, src, dst, size);
+		return;
+	}
+#endif
 	
 	memcpy(block_buff, src, 16);
 	memcpy(block_buff_previous, src, 16);
@@ -1448,6 +1740,13 @@ void AES_CMAC (AES_ctx *ctx, unsigned char *input, int length, unsigned char *ma
         xor_128(padded,K2,M_last);
     }
 
+#ifdef AES_ACCEL_AVAILABLE
+    if (AES_accel_enabled()) {
+        aes_accel_cmac_chain(ctx->ek, ctx->Nr, input, n - 1, M_last, mac);
+        return;
+    }
+#endif
+
     for ( i=0; i<16; i++ ) X[i] = 0;
     for ( i=0; i<n-1; i++ ) 
     {
@@ -44,6 +44,11 @@ void AES_cbc_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size);
 void AES_cbc_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size);
 void AES_CMAC(AES_ctx *ctx, unsigned char *input, int length, unsigned char *mac);
 
+/* Whether AES-NI / ARMv8 crypto instructions are used.  On by default when supported. */
+int AES_accel_enabled(void);
+/* Mainly for testing against the table based implementation. */
+void AES_set_accel(int enable);
+
 int	rijndaelKeySetupEnc(unsigned int [], const unsigned char [], int);
 int	rijndaelKeySetupDec(unsigned int [], const unsigned char [], int);
 void rijndaelEncrypt(const unsigned int [], int, const unsigned char [],
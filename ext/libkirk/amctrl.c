@@ -515,6 +515,11 @@ int sceDrmBBCipherInit(CIPHER_KEY *ckey, int type, int mode, u8 *header_key, u8
 }
 
 int sceDrmBBCipherUpdate(CIPHER_KEY *ckey, u8 *data, int size)
+{
+	return bbcipher_update(ckey, kirk_buf, data, size);
+}
+
+int bbcipher_update(CIPHER_KEY *ckey, u8 *kbuf, u8 *data, int size)
 {
 	int p, retv, dsize;
 
@@ -523,7 +528,7 @@ int sceDrmBBCipherUpdate(CIPHER_KEY *ckey, u8 *data, int size)
 
 	while(size>0){
 		dsize = (size>=0x0800)? 0x0800 : size;
-		retv = sub_428(kirk_buf, data+p, dsize, ckey);
+		retv = sub_428(kbuf, data+p, dsize, ckey);
 		if(retv)
 			break;
 		size -= dsize;
@@ -55,6 +55,11 @@ int sceDrmBBCipherInit(CIPHER_KEY *ckey, int type, int mode, u8 *header_key, u8
 int sceDrmBBCipherUpdate(CIPHER_KEY *ckey, u8 *data, int size);
 int sceDrmBBCipherFinal(CIPHER_KEY *ckey);
 
+// Same as sceDrmBBCipherUpdate for decryption with fixed keys, but using a caller provided
+// scratch buffer of AMCTRL_KIRK_BUF_SIZE bytes, so it can be used from several threads at once.
+#define AMCTRL_KIRK_BUF_SIZE 0x0814
+int bbcipher_update(CIPHER_KEY *ckey, u8 *kbuf, u8 *data, int size);
+
 // npdrm.prx
 int sceNpDrmGetFixedKey(u8 *key, char *npstr, int type);
 
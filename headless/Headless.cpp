@@ -27,6 +27,8 @@
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/VFS/ZipFileReader.h"
 #include "Common/File/VFS/DirectoryReader.h"
+#include "Common/File/VFS/PackFileReader.h"
+#include "Common/Data/Format/JSONWriter.h"
 #include "Common/File/FileUtil.h"
 #include "Common/GraphicsContext.h"
 #include "Common/TimeUtil.h"
@@ -37,6 +39,8 @@
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/WebServer.h"
+#include "Core/Debugger/JitSampler.h"
+#include "Core/HLE/HLEProfiler.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
@@ -172,11 +176,44 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "  --bench               run multiple times and output speed\n");
+	fprintf(stderr, "  --hle-profile=FILE    write per HLE function timings as JSON to FILE\n");
+	fprintf(stderr, "  --jit-profile=FILE    sample the emu thread, write folded stacks to FILE\n");
+	fprintf(stderr, "  --pack-textures=DIR   pack a texture pack (directory or textures.zip) into\n");
+	fprintf(stderr, "                        DIR/textures.pack, and exit\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
 }
 
+static int PackTextures(const Path &dir) {
+	Path packPath = dir / "textures.pack";
+	// It's about to be replaced, don't pack the old one into it.
+	if (File::Exists(packPath))
+		File::Delete(packPath);
+
+	VFSBackend *source = ZipFileReader::Create(dir / "textures.zip", "", false);
+	if (!source)
+		source = new DirectoryReader(dir);
+
+	std::string error;
+	bool success = WritePackFile(source, packPath, &error);
+	delete source;
+	if (!success) {
+		fprintf(stderr, "Failed to pack textures: %s\n", error.c_str());
+		File::Delete(packPath);
+		return 1;
+	}
+
+	PackFileReader *pack = PackFileReader::Create(packPath);
+	if (!pack) {
+		fprintf(stderr, "Failed to verify %s\n", packPath.c_str());
+		return 1;
+	}
+	printf("Packed %d files into %s\n", (int)pack->FileCount(), packPath.c_str());
+	delete pack;
+	return 0;
+}
+
 static HeadlessHost *getHost(GPUCore gpuCore) {
 	switch (gpuCore) {
 	case GPUCORE_SOFTWARE:
@@ -345,6 +382,9 @@ int main(int argc, const char* argv[])
 	const char *mountIso = nullptr;
 	const char *mountRoot = nullptr;
 	const char *screenshotFilename = nullptr;
+	const char *hleProfileFilename = nullptr;
+	const char *jitProfileFilename = nullptr;
+	const char *packTexturesDir = nullptr;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -414,12 +454,21 @@ int main(int argc, const char* argv[])
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
 			stateToLoad = argv[i] + strlen("--state=");
+		else if (!strncmp(argv[i], "--hle-profile=", strlen("--hle-profile=")) && strlen(argv[i]) > strlen("--hle-profile="))
+			hleProfileFilename = argv[i] + strlen("--hle-profile=");
+		else if (!strncmp(argv[i], "--jit-profile=", strlen("--jit-profile=")) && strlen(argv[i]) > strlen("--jit-profile="))
+			jitProfileFilename = argv[i] + strlen("--jit-profile=");
+		else if (!strncmp(argv[i], "--pack-textures=", strlen("--pack-textures=")) && strlen(argv[i]) > strlen("--pack-textures="))
+			packTexturesDir = argv[i] + strlen("--pack-textures=");
 		else if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
 			return printUsage(argv[0], NULL);
 		else
 			testFilenames.push_back(argv[i]);
 	}
 
+	if (packTexturesDir)
+		return PackTextures(Path(std::string(packTexturesDir)));
+
 	if (testFilenames.size() == 1 && testFilenames[0][0] == '@')
 		testFilenames = ReadFromListFile(testFilenames[0].substr(1));
 
@@ -562,6 +611,12 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(Path(stateToLoad), -1);
 
+	if (hleProfileFilename)
+		HLEProfilerSetEnabled(true);
+	// The tests run on this thread, so that's the one to sample.
+	if (jitProfileFilename && !JitSamplerStart())
+		fprintf(stderr, "JIT profiling is not supported on this platform\n");
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
@@ -608,6 +663,29 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (hleProfileFilename) {
+		HLEProfilerSetEnabled(false);
+		json::JsonWriter json(json::JsonWriter::PRETTY);
+		json.begin();
+		HLEProfilerWriteJson(json, (size_t)-1);
+		json.end();
+
+		FILE *fp = File::OpenCFile(Path(std::string(hleProfileFilename)), "wb");
+		if (fp) {
+			std::string data = json.str();
+			fwrite(data.data(), 1, data.size(), fp);
+			fclose(fp);
+		} else {
+			fprintf(stderr, "Unable to write HLE profile to '%s'\n", hleProfileFilename);
+		}
+	}
+
+	if (jitProfileFilename && JitSamplerActive()) {
+		JitSamplerStop();
+		if (!JitSamplerWriteFoldedStacks(Path(std::string(jitProfileFilename))))
+			fprintf(stderr, "Unable to write JIT profile to '%s'\n", jitProfileFilename);
+	}
+
 	if (debuggerPort > 0) {
 		ShutdownWebServer();
 	}
@@ -19,6 +19,7 @@
 
 #include "ppsspp_config.h"
 
+#include "Common/Data/Random/Rng.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
 #include "Common/TimeUtil.h"
@@ -26,6 +27,9 @@
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/IR/IRThreadedInterpreter.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSAsm.h"
@@ -224,3 +228,135 @@ bool TestJit() {
 
 	return jit_speed >= interp_speed;
 }
+
+struct IRBenchmarkBlock {
+	const char *name;
+	std::vector<IRInst> insts;
+};
+
+// These mirror what the frontend produces for some common game code: a pointer walking
+// integer loop, a vfpu vector transform, and some ops the threaded interpreter leaves to IRInterpret.
+static const IRBenchmarkBlock irBenchmarkBlocks[] = {
+	{
+		"IntLoop",
+		{
+			{ IROp::AddConst, { MIPS_REG_A0 }, MIPS_REG_A0, 0, 4 },
+			{ IROp::Load32, { MIPS_REG_T0 }, MIPS_REG_A0, 0, 0 },
+			{ IROp::AddConst, { MIPS_REG_T0 }, MIPS_REG_T0, 0, 1 },
+			{ IROp::Store32, { MIPS_REG_T0 }, MIPS_REG_A0, 0, 0 },
+			{ IROp::Load32, { MIPS_REG_T1 }, MIPS_REG_A0, 0, 4 },
+			{ IROp::Xor, { MIPS_REG_T2 }, MIPS_REG_T0, MIPS_REG_T1 },
+			{ IROp::ShlImm, { MIPS_REG_T3 }, MIPS_REG_T2, 3 },
+			{ IROp::Add, { MIPS_REG_V0 }, MIPS_REG_V0, MIPS_REG_T3 },
+			{ IROp::Load8, { MIPS_REG_T4 }, MIPS_REG_A0, 0, 9 },
+			{ IROp::Store16, { MIPS_REG_T4 }, MIPS_REG_A0, 0, 12 },
+			{ IROp::SltConst, { MIPS_REG_T5 }, MIPS_REG_A0, 0, 0x08900400 },
+			{ IROp::ExitToConstIfEq, { MIPS_REG_T5 }, MIPS_REG_ZERO, 0, 0x08804000 },
+			{ IROp::ExitToConst, { 0 }, 0, 0, 0x08804100 },
+		},
+	},
+	{
+		"Vec4Transform",
+		{
+			{ IROp::LoadVec4, { 32 }, MIPS_REG_A1, 0, 0 },
+			{ IROp::LoadVec4, { 36 }, MIPS_REG_A1, 0, 16 },
+			{ IROp::Vec4Scale, { 40 }, 32, 48 },
+			{ IROp::Vec4Mul, { 44 }, 36, 32 },
+			{ IROp::Vec4Add, { 40 }, 40, 44 },
+			{ IROp::Vec4Scale, { 44 }, 36, 49 },
+			{ IROp::Vec4Add, { 40 }, 40, 44 },
+			{ IROp::StoreVec4, { 40 }, MIPS_REG_A1, 0, 32 },
+			{ IROp::FAdd, { 50 }, 50, 40 },
+			{ IROp::FSub, { 51 }, 51, 41 },
+			{ IROp::ExitToConst, { 0 }, 0, 0, 0x08804200 },
+		},
+	},
+	{
+		"Mixed",
+		{
+			{ IROp::Mult, { 0 }, MIPS_REG_A2, MIPS_REG_A3 },
+			{ IROp::MfLo, { MIPS_REG_T0 } },
+			{ IROp::Clz, { MIPS_REG_T1 }, MIPS_REG_T0 },
+			{ IROp::SltU, { MIPS_REG_T2 }, MIPS_REG_T1, MIPS_REG_A2 },
+			{ IROp::Or, { MIPS_REG_V1 }, MIPS_REG_T1, MIPS_REG_T2 },
+			{ IROp::SarImm, { MIPS_REG_V1 }, MIPS_REG_V1, 1 },
+			{ IROp::Slt, { MIPS_REG_T5 }, MIPS_REG_A2, MIPS_REG_A3 },
+			{ IROp::ExitToConstIfNeq, { MIPS_REG_T5 }, MIPS_REG_ZERO, 0, 0x08804300 },
+			{ IROp::ExitToReg, { 0 }, MIPS_REG_RA },
+		},
+	},
+};
+
+// The interpreters use r[] as a flat register file up to the FP control regs.
+static const int IR_STATE_WORDS = 246;
+static const u32 IR_BENCH_DATA = 0x08900000;
+
+static void ResetIRBenchmarkState(MIPSState *mips, const u32 *initial) {
+	memcpy(mips->r, initial, IR_STATE_WORDS * sizeof(u32));
+	mips->r[MIPS_REG_A0] = IR_BENCH_DATA;
+	mips->r[MIPS_REG_A1] = IR_BENCH_DATA + 0x100;
+}
+
+bool TestIRThreaded() {
+	SetupJitHarness();
+
+	MIPSState *mips = currentMIPS;
+	GMRng rng;
+	u32 initial[IR_STATE_WORDS];
+	for (int i = 0; i < IR_STATE_WORDS; ++i)
+		initial[i] = rng.R32();
+	initial[MIPS_REG_ZERO] = 0;
+	// Keep the float regs finite, so the comparisons below don't trip on NaNs.
+	for (int i = 32; i < 32 + 32 + 128; ++i) {
+		float value = (float)((int)(rng.R32() & 0xFFFF) - 0x8000) / 256.0f;
+		memcpy(&initial[i], &value, sizeof(value));
+	}
+	initial[MIPS_REG_RA] = 0x08804400;
+
+	u8 *data = Memory::GetPointerWrite(IR_BENCH_DATA);
+	std::vector<u8> initialData(0x1000);
+	for (auto &b : initialData)
+		b = (u8)rng.R32();
+
+	bool success = true;
+	for (const auto &block : irBenchmarkBlocks) {
+		std::vector<IRThreadedInst> threaded(block.insts.size());
+		IRThreadedDecode(block.insts.data(), (int)block.insts.size(), threaded.data());
+
+		// First, check they agree.
+		memcpy(data, initialData.data(), initialData.size());
+		ResetIRBenchmarkState(mips, initial);
+		u32 expectedPC = IRInterpret(mips, block.insts.data());
+		std::vector<u32> expectedState(mips->r, mips->r + IR_STATE_WORDS);
+		std::vector<u8> expectedData(data, data + initialData.size());
+
+		memcpy(data, initialData.data(), initialData.size());
+		ResetIRBenchmarkState(mips, initial);
+		u32 actualPC = IRThreadedInterpret(mips, threaded.data());
+		if (actualPC != expectedPC || memcmp(expectedState.data(), mips->r, IR_STATE_WORDS * sizeof(u32)) != 0 || memcmp(expectedData.data(), data, initialData.size()) != 0) {
+			printf("IR threaded interpreter mismatch in block %s\n", block.name);
+			success = false;
+			continue;
+		}
+
+		auto timeRuns = [&](const std::function<void()> &run) {
+			int runs = 0;
+			double st = time_now_d();
+			do {
+				for (int j = 0; j < 10000; ++j) {
+					ResetIRBenchmarkState(mips, initial);
+					run();
+				}
+				runs += 10000;
+			} while (time_now_d() - st < 0.25);
+			return runs / (time_now_d() - st);
+		};
+
+		double switchSpeed = timeRuns([&] { IRInterpret(mips, block.insts.data()); });
+		double threadedSpeed = timeRuns([&] { IRThreadedInterpret(mips, threaded.data()); });
+		printf("IR block %s: switch %0.2f M/s, threaded %0.2f M/s (%0.2fx)\n", block.name, switchSpeed / 1000000.0, threadedSpeed / 1000000.0, threadedSpeed / switchSpeed);
+	}
+
+	DestroyJitHarness();
+	return success;
+}
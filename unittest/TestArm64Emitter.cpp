@@ -69,6 +69,19 @@ bool TestArm64Emitter() {
 	fp.SMAX(16, D0, D3, D4);
 	RET(CheckLast(emitter, "0e646460 smax.16 d0, d3, d4"));
 
+	fp.ADD(16, Q0, Q3, Q4);
+	RET(CheckLast(emitter, "4e648460 add.16 q0, q3, q4"));
+	fp.SUB(8, Q5, Q6, Q7);
+	RET(CheckLast(emitter, "6e2784c5 sub.8 q5, q6, q7"));
+	fp.MUL(16, D0, D1, D2);
+	RET(CheckLast(emitter, "0e629c20 mul.16 d0, d1, d2"));
+	fp.SQADD(16, Q1, Q2, Q3);
+	RET(CheckLast(emitter, "4e630c41 sqadd.16 q1, q2, q3"));
+	fp.UQSUB(16, D1, D2, D3);
+	RET(CheckLast(emitter, "2e632c41 uqsub.16 d1, d2, d3"));
+	fp.SQXTUN(16, D0, Q1);
+	RET(CheckLast(emitter, "2e612820 sqxtun.16.32 d0, q1"));
+
 	fp.SHL(32, D0, D3, 18);
 	RET(CheckLast(emitter, "0f325460 shl.32 d0, d3, #18"));
 	fp.USHR(16, Q0, Q3, 7);
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <list>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Core/Util/BlockAllocator.h"
+
+#include "UnitTest.h"
+
+// The allocator as it was before the address and free size indexes: a plain walk over the block
+// list.  Games can depend on exactly where things land, so the indexed one has to pick the same.
+class LinearBlockAllocator {
+public:
+	explicit LinearBlockAllocator(u32 grain) : grain_(grain) {}
+
+	void Init(u32 rangeStart, u32 rangeSize) {
+		rangeSize_ = rangeSize;
+		blocks_.clear();
+		blocks_.push_back(Block{ rangeStart, rangeSize, false });
+	}
+
+	u32 AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop) {
+		if (size == 0 || size > rangeSize_)
+			return -1;
+		if (grain < grain_)
+			grain = grain_;
+		if (sizeGrain < grain_)
+			sizeGrain = grain_;
+		size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
+
+		if (!fromTop) {
+			for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+				u32 offset = it->start % grain;
+				if (offset != 0)
+					offset = grain - offset;
+				u32 needed = offset + size;
+				if (!it->taken && it->size >= needed) {
+					if (it->size != needed)
+						InsertFreeAfter(it, it->size - needed);
+					if (offset >= grain_)
+						InsertFreeBefore(it, offset);
+					it->taken = true;
+					return it->start;
+				}
+			}
+		} else {
+			for (auto it = blocks_.end(); it != blocks_.begin(); ) {
+				--it;
+				u32 offset = (it->start + it->size - size) % grain;
+				u32 needed = offset + size;
+				if (!it->taken && it->size >= needed) {
+					if (it->size != needed)
+						InsertFreeBefore(it, it->size - needed);
+					if (offset >= grain_)
+						InsertFreeAfter(it, offset);
+					it->taken = true;
+					return it->start;
+				}
+			}
+		}
+		return -1;
+	}
+
+	u32 AllocAt(u32 position, u32 size) {
+		if (size > rangeSize_)
+			return -1;
+		u32 alignedPosition = position & ~(grain_ - 1);
+		u32 alignedSize = size + (position - alignedPosition);
+		alignedSize = (alignedSize + grain_ - 1) & ~(grain_ - 1);
+
+		auto it = Find(alignedPosition);
+		if (it == blocks_.end() || it->taken || it->start + it->size < alignedPosition + alignedSize)
+			return -1;
+		if (it->start != alignedPosition)
+			InsertFreeBefore(it, alignedPosition - it->start);
+		if (it->size != alignedSize)
+			InsertFreeAfter(it, it->size - alignedSize);
+		it->taken = true;
+		return position;
+	}
+
+	bool Free(u32 position) {
+		auto it = Find(position);
+		if (it == blocks_.end() || !it->taken)
+			return false;
+		it->taken = false;
+		while (it != blocks_.begin() && !std::prev(it)->taken) {
+			auto prev = std::prev(it);
+			prev->size += it->size;
+			blocks_.erase(it);
+			it = prev;
+		}
+		for (auto next = std::next(it); next != blocks_.end() && !next->taken; next = std::next(it)) {
+			it->size += next->size;
+			blocks_.erase(next);
+		}
+		return true;
+	}
+
+	u32 GetBlockStartFromAddress(u32 addr) const {
+		for (const Block &b : blocks_) {
+			if (b.start <= addr && b.start + b.size > addr)
+				return b.start;
+		}
+		return -1;
+	}
+
+	u32 GetTotalFreeBytes() const {
+		u32 sum = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken)
+				sum += b.size;
+		}
+		return sum;
+	}
+
+	u32 GetLargestFreeBlockSize() const {
+		u32 largest = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken)
+				largest = std::max(largest, b.size);
+		}
+		return largest;
+	}
+
+private:
+	struct Block {
+		u32 start;
+		u32 size;
+		bool taken;
+	};
+	typedef std::list<Block>::iterator Iter;
+
+	Iter Find(u32 addr) {
+		for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+			if (it->start <= addr && it->start + it->size > addr)
+				return it;
+		}
+		return blocks_.end();
+	}
+
+	void InsertFreeBefore(Iter it, u32 size) {
+		blocks_.insert(it, Block{ it->start, size, false });
+		it->start += size;
+		it->size -= size;
+	}
+
+	void InsertFreeAfter(Iter it, u32 size) {
+		blocks_.insert(std::next(it), Block{ it->start + it->size - size, size, false });
+		it->size -= size;
+	}
+
+	std::list<Block> blocks_;
+	u32 rangeSize_ = 0;
+	u32 grain_;
+};
+
+static bool RunAllocatorSequence(u32 grain, u32 rangeStart, u32 rangeSize, int seed, int ops) {
+	BlockAllocator binned(grain);
+	LinearBlockAllocator linear(grain);
+	binned.Init(rangeStart, rangeSize, false);
+	linear.Init(rangeStart, rangeSize);
+
+	GMRng rng;
+	rng.Init(seed);
+	std::vector<u32> live;
+	for (int i = 0; i < ops; ++i) {
+		u32 r = rng.R32() % 100;
+		u32 expected, actual;
+		const char *what;
+		if (r < 40) {
+			// Mostly small, sometimes large, like kernel and user allocations.
+			u32 size = (rng.R32() & 7) == 0 ? rng.R32() % (rangeSize / 8) + 1 : rng.R32() % 0x4000 + 1;
+			bool fromTop = (rng.R32() & 1) != 0;
+			u32 sizeA = size, sizeB = size;
+			actual = binned.Alloc(sizeA, fromTop, "test");
+			expected = linear.AllocAligned(sizeB, grain, grain, fromTop);
+			EXPECT_EQ_INT(sizeA, sizeB);
+			what = fromTop ? "Alloc (top)" : "Alloc";
+		} else if (r < 50) {
+			u32 size = rng.R32() % 0x10000 + 1;
+			u32 sizeGrain = 1 << (rng.R32() % 13);
+			u32 alignGrain = 1 << (rng.R32() % 17);
+			bool fromTop = (rng.R32() & 1) != 0;
+			u32 sizeA = size, sizeB = size;
+			actual = binned.AllocAligned(sizeA, sizeGrain, alignGrain, fromTop, "test");
+			expected = linear.AllocAligned(sizeB, sizeGrain, alignGrain, fromTop);
+			EXPECT_EQ_INT(sizeA, sizeB);
+			what = "AllocAligned";
+		} else if (r < 60) {
+			u32 position = rangeStart + rng.R32() % rangeSize;
+			u32 size = rng.R32() % 0x8000 + 1;
+			actual = binned.AllocAt(position, size, "test");
+			expected = linear.AllocAt(position, size);
+			what = "AllocAt";
+		} else if (r < 95 && !live.empty()) {
+			size_t index = rng.R32() % live.size();
+			u32 position = live[index];
+			live[index] = live.back();
+			live.pop_back();
+			actual = binned.Free(position);
+			expected = linear.Free(position);
+			what = "Free";
+		} else {
+			// Probably not the start of a block, or not taken.
+			u32 position = rangeStart + rng.R32() % rangeSize;
+			actual = binned.Free(position);
+			expected = linear.Free(position);
+			what = "Free (random)";
+		}
+
+		if (actual != expected) {
+			printf("BlockAllocator: grain %x seed %d op %d %s: got %08x, expected %08x\n", grain, seed, i, what, actual, expected);
+			return false;
+		}
+		if ((what[0] == 'A') && actual != (u32)-1)
+			live.push_back(actual);
+
+		EXPECT_EQ_INT(binned.GetTotalFreeBytes(), linear.GetTotalFreeBytes());
+		EXPECT_EQ_INT(binned.GetLargestFreeBlockSize(), linear.GetLargestFreeBlockSize());
+		u32 probe = rangeStart + rng.R32() % rangeSize;
+		EXPECT_EQ_INT(binned.GetBlockStartFromAddress(probe), linear.GetBlockStartFromAddress(probe));
+	}
+	return true;
+}
+
+bool TestBlockAllocator() {
+	static const u32 grains[] = { 0x10, 0x100, 0x1000 };
+	for (u32 grain : grains) {
+		for (int seed = 1; seed <= 4; ++seed) {
+			if (!RunAllocatorSequence(grain, 0x08800000, 0x01800000, seed, 4000))
+				return false;
+			// A small range fills up, so the failure paths get exercised too.
+			if (!RunAllocatorSequence(grain, 0x08400000, 0x00040000, seed + 100, 4000))
+				return false;
+		}
+	}
+	return true;
+}
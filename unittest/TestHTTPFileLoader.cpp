@@ -0,0 +1,253 @@
+#include "ppsspp_config.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket close
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Common/File/FileDescriptor.h"
+#include "Common/Net/HTTPServer.h"
+#include "Common/Net/NetBuffer.h"
+#include "Common/Net/Resolve.h"
+#include "Common/Net/Sinks.h"
+#include "Common/StringUtils.h"
+#include "Core/FileLoaders/HTTPFileLoader.h"
+
+#include "UnitTest.h"
+
+// A minimal stand-in for a file server: HEAD, and GET with a single byte range.
+// Can either keep connections alive (handling pipelined requests), or close after each response.
+class RangeServer {
+public:
+	RangeServer(const std::vector<u8> &data, bool keepAlive) : data_(data), keepAlive_(keepAlive) {}
+	~RangeServer() {
+		// Clients are done by now, so handlers are just waiting for more requests.
+		stop_ = true;
+		if (acceptThread_.joinable())
+			acceptThread_.join();
+		for (auto &t : connectionThreads_)
+			t.join();
+		if (listener_ != -1)
+			closesocket(listener_);
+	}
+
+	bool Start() {
+		listener_ = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (listener_ == -1)
+			return false;
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		socklen_t len = sizeof(addr);
+		if (bind(listener_, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener_, 16) < 0)
+			return false;
+		if (getsockname(listener_, (sockaddr *)&addr, &len) < 0)
+			return false;
+		port_ = ntohs(addr.sin_port);
+
+		acceptThread_ = std::thread([this] {
+			while (!stop_) {
+				if (!fd_util::WaitUntilReady(listener_, 0.05, false))
+					continue;
+				int fd = (int)accept(listener_, nullptr, nullptr);
+				if (fd == -1)
+					continue;
+				connections_++;
+				connectionThreads_.emplace_back([this, fd] {
+					HandleConnection(fd);
+					closesocket(fd);
+				});
+			}
+		});
+		return true;
+	}
+
+	int Port() const { return port_; }
+	int Connections() const { return connections_; }
+	int Requests() const { return requests_; }
+
+private:
+	void HandleConnection(int fd) {
+		net::Buffer in;
+		do {
+			if (!in.ReadUntil(fd, "\r\n\r\n", 65536, 5.0, &stop_))
+				return;
+
+			std::string line;
+			in.TakeLineCRLF(&line);
+			bool head = startsWith(line, "HEAD ");
+			long long first = 0, last = (long long)data_.size() - 1;
+			bool range = false;
+			while (in.TakeLineCRLF(&line) > 0) {
+				if (sscanf(line.c_str(), "Range: bytes=%lld-%lld", &first, &last) == 2)
+					range = true;
+			}
+			requests_++;
+
+			net::Buffer out;
+			const char *connection = keepAlive_ ? "keep-alive" : "close";
+			if (head) {
+				out.Printf("HTTP/1.1 200 OK\r\nContent-Length: %lld\r\nAccept-Ranges: bytes\r\nConnection: %s\r\n\r\n", (long long)data_.size(), connection);
+			} else if (range && first <= last && last < (long long)data_.size()) {
+				out.Printf("HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %lld-%lld/%lld\r\nContent-Length: %lld\r\nConnection: %s\r\n\r\n", first, last, (long long)data_.size(), last - first + 1, connection);
+				memcpy(out.Append((size_t)(last - first + 1)), &data_[first], (size_t)(last - first + 1));
+			} else {
+				out.Printf("HTTP/1.1 416 Range Not Satisfiable\r\nContent-Length: 0\r\nConnection: %s\r\n\r\n", connection);
+			}
+			if (!out.FlushSocket(fd, 5.0, &stop_))
+				return;
+		} while (keepAlive_);
+	}
+
+	const std::vector<u8> &data_;
+	bool keepAlive_;
+	std::atomic<bool> stop_{};
+	int listener_ = -1;
+	int port_ = 0;
+	std::atomic<int> connections_{};
+	std::atomic<int> requests_{};
+	std::thread acceptThread_;
+	std::vector<std::thread> connectionThreads_;
+};
+
+static bool CheckRead(HTTPFileLoader &loader, const std::vector<u8> &data, s64 pos, size_t size) {
+	std::vector<u8> buf(size);
+	size_t expected = pos < (s64)data.size() ? std::min(size, (size_t)(data.size() - pos)) : 0;
+	size_t readBytes = loader.ReadAt(pos, size, buf.data());
+	if (readBytes != expected) {
+		printf("HTTPFileLoader: read at %lld size %d returned %d\n", (long long)pos, (int)size, (int)readBytes);
+		return false;
+	}
+	if (expected != 0 && memcmp(buf.data(), &data[pos], expected) != 0) {
+		printf("HTTPFileLoader: read at %lld size %d returned bad data\n", (long long)pos, (int)size);
+		return false;
+	}
+	return true;
+}
+
+static bool CheckLoader(HTTPFileLoader &loader, const std::vector<u8> &data) {
+	EXPECT_TRUE(loader.Exists());
+	EXPECT_EQ_INT(loader.FileSize(), (s64)data.size());
+
+	// Sector sized reads, a large read that gets split and pipelined, and a read past the end.
+	RET(CheckRead(loader, data, 0, 2048));
+	RET(CheckRead(loader, data, 0x8000, 65536));
+	RET(CheckRead(loader, data, 12345, 2 * 1024 * 1024 + 777));
+	RET(CheckRead(loader, data, data.size() - 1000, 65536));
+	RET(CheckRead(loader, data, data.size() + 10, 2048));
+
+	// Concurrent readers, like the read-ahead thread, get their own connections.
+	std::atomic<bool> threadOK{ true };
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 3; ++i) {
+		readers.emplace_back([&, i] {
+			for (int j = 0; j < 8; ++j) {
+				if (!CheckRead(loader, data, (i * 8 + j) * 100000, 200000))
+					threadOK = false;
+			}
+		});
+	}
+	for (auto &t : readers)
+		t.join();
+	EXPECT_TRUE(threadOK);
+	return true;
+}
+
+static void MakeTestData(std::vector<u8> &data) {
+	GMRng rng;
+	data.resize(3 * 1024 * 1024 + 1234);
+	for (auto &b : data)
+		b = (u8)rng.R32();
+}
+
+static bool TestHTTPFileLoaderWith(bool keepAlive) {
+	std::vector<u8> data;
+	MakeTestData(data);
+
+	RangeServer server(data, keepAlive);
+	EXPECT_TRUE(server.Start());
+
+	HTTPFileLoader loader(Path(StringFromFormat("http://127.0.0.1:%d/test.iso", server.Port())));
+	RET(CheckLoader(loader, data));
+
+	if (keepAlive) {
+		// Everything above should have shared a few connections.
+		EXPECT_TRUE(server.Connections() <= 4);
+		EXPECT_TRUE(server.Requests() > server.Connections() * 4);
+	}
+	EXPECT_TRUE(loader.ReadAheadSize() >= 256 * 1024);
+	return true;
+}
+
+// Same again against our own server, which serves ranges straight from a file.
+static bool TestHTTPFileLoaderWithServer(bool eventLoop) {
+	std::vector<u8> data;
+	MakeTestData(data);
+	FILE *fp = tmpfile();
+	EXPECT_TRUE(fp != nullptr);
+	EXPECT_TRUE(fwrite(data.data(), 1, data.size(), fp) == data.size());
+	fflush(fp);
+
+	http::Server server(new NewThreadExecutor());
+	server.SetFallbackHandler([&](const http::ServerRequest &request) {
+		std::string range;
+		long long first = 0, last = 0;
+		if (request.Method() == http::RequestHeader::HEAD) {
+			request.WriteHttpResponseHeader("1.1", 200, data.size(), "application/octet-stream", "Accept-Ranges: bytes\r\n");
+		} else if (request.GetHeader("range", &range) && sscanf(range.c_str(), "bytes=%lld-%lld", &first, &last) == 2 && first <= last && last < (long long)data.size()) {
+			std::string contentRange = StringFromFormat("Content-Range: bytes %lld-%lld/%lld\r\n", first, last, (long long)data.size());
+			request.WriteHttpResponseHeader("1.1", 206, last - first + 1, "application/octet-stream", contentRange.c_str());
+			request.WriteFileRange(fp, first, last - first + 1);
+		} else {
+			request.WriteHttpResponseHeader("1.1", 416, 0, "text/plain");
+		}
+	});
+	EXPECT_TRUE(server.Listen(0, net::DNSType::IPV4));
+	// Where unsupported, this just keeps using a thread per connection.
+	if (eventLoop)
+		server.UseEventLoop(2);
+
+	std::atomic<bool> stop{};
+	std::thread serverThread([&] {
+		while (!stop)
+			server.RunSlice(0.05);
+	});
+
+	bool success;
+	{
+		HTTPFileLoader loader(Path(StringFromFormat("http://127.0.0.1:%d/test.iso", server.Port())));
+		success = CheckLoader(loader, data);
+	}
+
+	stop = true;
+	serverThread.join();
+	server.Stop();
+	fclose(fp);
+	return success;
+}
+
+bool TestHTTPFileLoader() {
+	net::Init();
+	bool success = TestHTTPFileLoaderWith(true) && TestHTTPFileLoaderWith(false);
+	success = success && TestHTTPFileLoaderWithServer(true) && TestHTTPFileLoaderWithServer(false);
+	net::Shutdown();
+	return success;
+}
@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Common/TimeUtil.h"
+
+extern "C" {
+#include "ext/libkirk/AES.h"
+}
+
+#include "UnitTest.h"
+
+static void FromHex(const char *hex, u8 *out) {
+	for (size_t i = 0; hex[i * 2] && hex[i * 2 + 1]; ++i) {
+		unsigned int b;
+		sscanf(hex + i * 2, "%2x", &b);
+		out[i] = (u8)b;
+	}
+}
+
+static bool ExpectBlock(const char *what, const u8 *actual, const char *expectedHex) {
+	u8 expected[16];
+	FromHex(expectedHex, expected);
+	if (memcmp(actual, expected, 16) == 0)
+		return true;
+	printf("KirkAES: %s (accel %d) mismatch, got ", what, AES_accel_enabled());
+	for (int i = 0; i < 16; ++i)
+		printf("%02x", actual[i]);
+	printf(" expected %s\n", expectedHex);
+	return false;
+}
+
+// FIPS-197 appendix C.1 and RFC 4493 section 4, with whichever implementation is active.
+static bool TestKirkAESKnownAnswers() {
+	u8 key[16], block[16], out[16];
+	AES_ctx ctx;
+
+	FromHex("000102030405060708090a0b0c0d0e0f", key);
+	FromHex("00112233445566778899aabbccddeeff", block);
+	AES_set_key(&ctx, key, 128);
+	AES_encrypt(&ctx, block, out);
+	RET(ExpectBlock("encrypt", out, "69c4e0d86a7b0430d8cdb78070b4c55a"));
+	AES_decrypt(&ctx, out, out);
+	RET(ExpectBlock("decrypt", out, "00112233445566778899aabbccddeeff"));
+	// The first CBC block has no IV to mix in.
+	AES_cbc_encrypt(&ctx, block, out, 16);
+	RET(ExpectBlock("cbc encrypt", out, "69c4e0d86a7b0430d8cdb78070b4c55a"));
+
+	u8 message[64];
+	FromHex("6bc1bee22e409f96e93d7e117393172a"
+		"ae2d8a571e03ac9c9eb76fac45af8e51"
+		"30c81c46a35ce411e5fbc1191a0a52ef"
+		"f69f2445df4f9b17ad2b417be66c3710", message);
+	FromHex("2b7e151628aed2a6abf7158809cf4f3c", key);
+	AES_set_key(&ctx, key, 128);
+	AES_CMAC(&ctx, message, 0, out);
+	RET(ExpectBlock("cmac 0", out, "bb1d6929e95937287fa37d129b756746"));
+	AES_CMAC(&ctx, message, 16, out);
+	RET(ExpectBlock("cmac 16", out, "070a16b46b4d4144f79bdd9dd04a287c"));
+	AES_CMAC(&ctx, message, 40, out);
+	RET(ExpectBlock("cmac 40", out, "dfa66747de9ae63030ca32611497c827"));
+	AES_CMAC(&ctx, message, 64, out);
+	RET(ExpectBlock("cmac 64", out, "51f0bebf7e3b9d92fc49741779363cfe"));
+	return true;
+}
+
+// The accelerated paths have their own block handling, so compare them against the tables
+// at a variety of sizes, including in place.
+static bool TestKirkAESCrossCheck() {
+	GMRng rng;
+	AES_ctx ctx;
+	u8 key[16];
+	std::vector<u8> src(4096 + 16), soft(src.size()), hard(src.size());
+
+	for (int iter = 0; iter < 200; ++iter) {
+		for (u8 &b : key)
+			b = (u8)rng.R32();
+		for (u8 &b : src)
+			b = (u8)rng.R32();
+		AES_set_key(&ctx, key, 128);
+		int size = iter < 64 ? iter : (int)(rng.R32() % 4096) & ~15;
+
+		AES_set_accel(0);
+		AES_cbc_encrypt(&ctx, src.data(), soft.data(), size);
+		AES_set_accel(1);
+		AES_cbc_encrypt(&ctx, src.data(), hard.data(), size);
+		EXPECT_TRUE(memcmp(soft.data(), hard.data(), (size + 15) & ~15) == 0);
+
+		AES_set_accel(0);
+		AES_cbc_decrypt(&ctx, src.data(), soft.data(), size);
+		AES_set_accel(1);
+		hard = src;
+		AES_cbc_decrypt(&ctx, hard.data(), hard.data(), size);
+		EXPECT_TRUE(memcmp(soft.data(), hard.data(), size <= 16 ? 16 : (size + 15) & ~15) == 0);
+
+		AES_set_accel(0);
+		AES_CMAC(&ctx, src.data(), size, soft.data());
+		AES_set_accel(1);
+		AES_CMAC(&ctx, src.data(), size, hard.data());
+		EXPECT_TRUE(memcmp(soft.data(), hard.data(), 16) == 0);
+	}
+	return true;
+}
+
+static double BenchmarkCBCDecrypt(AES_ctx *ctx, std::vector<u8> &buf) {
+	int iterations = 0;
+	double start = time_now_d();
+	double elapsed;
+	do {
+		AES_cbc_decrypt(ctx, buf.data(), buf.data(), (int)buf.size());
+		iterations++;
+		elapsed = time_now_d() - start;
+	} while (elapsed < 0.1);
+	return iterations * (double)buf.size() / elapsed / (1024.0 * 1024.0);
+}
+
+bool TestKirkAES() {
+	bool supported = AES_accel_enabled() != 0;
+	bool success = true;
+
+	AES_set_accel(0);
+	success = success && TestKirkAESKnownAnswers();
+	if (supported) {
+		AES_set_accel(1);
+		success = success && TestKirkAESKnownAnswers() && TestKirkAESCrossCheck();
+	}
+
+	if (success) {
+		AES_ctx ctx;
+		u8 key[16]{};
+		std::vector<u8> buf(64 * 1024);
+		AES_set_key(&ctx, key, 128);
+		AES_set_accel(0);
+		double soft = BenchmarkCBCDecrypt(&ctx, buf);
+		if (supported) {
+			AES_set_accel(1);
+			double hard = BenchmarkCBCDecrypt(&ctx, buf);
+			printf("KirkAES: CBC decrypt %.1f MB/s tables, %.1f MB/s accelerated\n", soft, hard);
+		} else {
+			printf("KirkAES: CBC decrypt %.1f MB/s tables, no acceleration available\n", soft);
+		}
+	}
+
+	AES_set_accel(1);
+	return success;
+}
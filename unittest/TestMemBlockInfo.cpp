@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Core/Debugger/MemBlockInfo.h"
+#include "Core/MIPS/MIPS.h"
+
+#include "UnitTest.h"
+
+static bool HasTag(MemBlockFlags flags, uint32_t start, uint32_t size, const std::string &tag) {
+	std::vector<MemBlockInfo> results = FindMemInfoByFlag(flags, start, size);
+	for (const auto &info : results) {
+		if (info.tag == tag && info.start <= start && info.start + info.size >= start + size)
+			return true;
+	}
+	printf("MemBlockInfo: no '%s' at %08x (%d results)\n", tag.c_str(), start, (int)results.size());
+	for (const auto &info : results)
+		printf("  %08x-%08x '%s'\n", info.start, info.start + info.size, info.tag.c_str());
+	return false;
+}
+
+static bool TestMemBlockInfoBasics() {
+	NotifyMemInfoPC(MemBlockFlags::ALLOC, 0x08800000, 0x10000, 0x08804000, "TestAlloc", strlen("TestAlloc"));
+	NotifyMemInfoPC(MemBlockFlags::WRITE, 0x08800000, 0x1000, 0x08804000, "First", strlen("First"));
+	// Later writes win, even when they come in through the merge of duplicates.
+	NotifyMemInfoPC(MemBlockFlags::WRITE, 0x08801000, 0x1000, 0x08804000, "Second", strlen("Second"));
+	NotifyMemInfoPC(MemBlockFlags::WRITE, 0x08801000, 0x1000, 0x08804000, "Third", strlen("Third"));
+	NotifyMemInfoCopy(0x08802000, 0x08800000, 0x1000, "Copy/");
+
+	RET(HasTag(MemBlockFlags::ALLOC, 0x08800000, 0x10000, "TestAlloc"));
+	RET(HasTag(MemBlockFlags::WRITE, 0x08800000, 0x1000, "First"));
+	RET(HasTag(MemBlockFlags::WRITE, 0x08801000, 0x1000, "Third"));
+	RET(HasTag(MemBlockFlags::WRITE, 0x08802000, 0x1000, "Copy/First"));
+
+	NotifyMemInfoPC(MemBlockFlags::FREE, 0x08800000, 0x10000, 0x08804000, "TestFree", strlen("TestFree"));
+	std::vector<MemBlockInfo> results = FindMemInfoByFlag(MemBlockFlags::ALLOC, 0x08800000, 0x10000);
+	EXPECT_EQ_INT((int)results.size(), 1);
+	EXPECT_FALSE(results[0].allocated);
+
+	// Merged runs keep the pc they started at, not wherever the CPU is when they're flushed.
+	const uint32_t oldPC = currentMIPS->pc;
+	currentMIPS->pc = 0x08804100;
+	NotifyMemInfoRun(0x08803000, 0x08802000, 0x10, "RunCopy/");
+	currentMIPS->pc = 0x08804110;
+	NotifyMemInfoRun(0x08803010, 0x08802010, 0x10, "RunCopy/");
+	currentMIPS->pc = 0x08804200;
+	results = FindMemInfoByFlag(MemBlockFlags::WRITE, 0x08803000, 0x20);
+	currentMIPS->pc = oldPC;
+	EXPECT_EQ_INT((int)results.size(), 1);
+	EXPECT_EQ_HEX(results[0].pc, 0x08804100);
+	return true;
+}
+
+static bool TestMemBlockInfoThreads() {
+	// Each thread writes its own region with far more distinct tags than fit in a ring's table.
+	static const int THREADS = 3;
+	static const int WRITES = 5000;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < THREADS; ++t) {
+		threads.emplace_back([t] {
+			char tag[64];
+			for (int i = 0; i < WRITES; ++i) {
+				uint32_t addr = 0x09000000 + t * 0x100000 + (i % 256) * 0x100;
+				size_t len = snprintf(tag, sizeof(tag), "Thread%d_%d", t, i);
+				NotifyMemInfoPC(MemBlockFlags::WRITE, addr, 0x100, 0x08804000, tag, len);
+			}
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+
+	for (int t = 0; t < THREADS; ++t) {
+		for (int i = WRITES - 256; i < WRITES; ++i) {
+			uint32_t addr = 0x09000000 + t * 0x100000 + (i % 256) * 0x100;
+			RET(HasTag(MemBlockFlags::WRITE, addr, 0x100, StringFromFormat("Thread%d_%d", t, i)));
+		}
+	}
+	return true;
+}
+
+struct RecordedNotify {
+	MemBlockFlags flags;
+	uint32_t start;
+	uint32_t size;
+	uint32_t copySrc;
+	uint32_t pc;
+	std::string tag;
+};
+
+// Shaped like a recording from a game streaming data: file reads into a few buffers, DMA copies
+// out of them, texture uploads, and heap churn, plus the odd formatted tag.
+static std::vector<RecordedNotify> MakeNotifyStream(size_t count) {
+	static const char *const ioTags[] = { "IoRead/disc0:/PSP_GAME/USRDIR/DATA.BIN", "IoRead/disc0:/PSP_GAME/USRDIR/SOUND.PAK", "IoRead/ms0:/PSP/SAVEDATA/DATA.BIN" };
+	static const char *const allocTags[] = { "KernelHeap", "FplAlloc/Stream", "VplAlloc/Game", "ThreadStack/main" };
+
+	GMRng rng;
+	std::vector<RecordedNotify> stream;
+	stream.reserve(count);
+	while (stream.size() < count) {
+		uint32_t r = rng.R32();
+		uint32_t pc = 0x08804000 + (r & 0xFFC);
+		uint32_t buffer = 0x08A00000 + (r % 4) * 0x40000;
+		switch ((r >> 12) % 8) {
+		case 0:
+		case 1:
+		case 2:
+			stream.push_back({ MemBlockFlags::WRITE, buffer, 0x800U << ((r >> 16) & 3), 0, pc, ioTags[(r >> 20) % 3] });
+			break;
+		case 3:
+		case 4:
+			stream.push_back({ MemBlockFlags::WRITE, 0x09000000 + ((r >> 8) & 0xFFF00), 0x400, buffer, pc, "DmaCopy/" });
+			break;
+		case 5:
+			stream.push_back({ MemBlockFlags::TEXTURE, 0x04000000 + ((r >> 10) & 0xFF000), 0x8000, 0, pc, StringFromFormat("Texture_%08x", 0x04000000 + ((r >> 10) & 0xFF000)) });
+			break;
+		case 6:
+			stream.push_back({ MemBlockFlags::SUB_ALLOC, 0x08C00000 + ((r >> 8) & 0xFF00), 0x200, 0, pc, allocTags[(r >> 20) % 4] });
+			break;
+		default:
+			stream.push_back({ MemBlockFlags::SUB_FREE, 0x08C00000 + ((r >> 8) & 0xFF00), 0x200, 0, pc, "" });
+			break;
+		}
+	}
+	return stream;
+}
+
+static void BenchmarkMemBlockInfo() {
+	std::vector<RecordedNotify> stream = MakeNotifyStream(200000);
+
+	// Replay in frame sized bursts, so recording (the emu thread's cost) and applying can be
+	// timed separately.
+	static const size_t BURST = 800;
+	double recordTime = 0.0;
+	double applyTime = 0.0;
+	for (size_t pos = 0; pos < stream.size(); pos += BURST) {
+		double start = time_now_d();
+		for (size_t i = pos; i < std::min(pos + BURST, stream.size()); ++i) {
+			const RecordedNotify &n = stream[i];
+			if (n.copySrc != 0)
+				NotifyMemInfoCopy(n.start, n.copySrc, n.size, n.tag.c_str());
+			else
+				NotifyMemInfoPC(n.flags, n.start, n.size, n.pc, n.tag.c_str(), n.tag.size());
+		}
+		double recorded = time_now_d();
+		// Forces everything to be applied.
+		FindMemInfo(0, 0x40000000);
+		applyTime += time_now_d() - recorded;
+		recordTime += recorded - start;
+	}
+
+	printf("MemBlockInfo: %d notifies, %.1f ns each to record, %.1f ns each to apply\n", (int)stream.size(), recordTime * 1000000000.0 / stream.size(), applyTime * 1000000000.0 / stream.size());
+}
+
+bool TestMemBlockInfo() {
+	MemBlockOverrideDetailed();
+	MemBlockInfoInit();
+
+	bool success = TestMemBlockInfoBasics() && TestMemBlockInfoThreads();
+	if (success)
+		BenchmarkMemBlockInfo();
+
+	MemBlockInfoShutdown();
+	MemBlockReleaseDetailed();
+	return success;
+}
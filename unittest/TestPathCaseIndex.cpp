@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Core/FileSystems/DirectoryFileSystem.h"
+
+#include "UnitTest.h"
+
+#if HOST_IS_CASE_SENSITIVE
+
+// Names that only differ in case from a sibling are left out: FixPathCase() picks whichever the
+// directory listing returns last, while the index prefers an exact match.
+static const char *const pathCaseQueries[] = {
+	"",
+	"/",
+	"top.txt",
+	"TOP.TXT",
+	"Top.txt/",
+	"data",
+	"DATA/",
+	"data/readme.MD",
+	"Data//README.md",
+	"data/sub dir/file.txt",
+	"DATA/SUB DIR/FILE.TXT",
+	"data/Sub Dir/Other.BIN",
+	"data/sub dir/renamed.txt",
+	"data/sub dir/missing.txt",
+	"data/missing dir/file.txt",
+	"data/new.DAT",
+	"save/gamex/param.sfo",
+	"SAVE/GAMEY/PARAM.SFO",
+	"save/gamey",
+	"save/gamex/",
+	"nothing/at/all",
+};
+
+static const FixPathCaseBehavior pathCaseBehaviors[] = {
+	FPC_FILE_MUST_EXIST,
+	FPC_PATH_MUST_EXIST,
+	FPC_PARTIAL_ALLOWED,
+};
+
+static bool CompareWithFixPathCase(PathCaseIndex &index, const Path &base, const char *stage) {
+	for (const char *query : pathCaseQueries) {
+		for (FixPathCaseBehavior behavior : pathCaseBehaviors) {
+			std::string expected = query;
+			std::string actual = query;
+			bool expectedResult = FixPathCase(base, expected, behavior);
+			bool actualResult = index.FixPathCase(actual, behavior);
+			if (expectedResult != actualResult || expected != actual) {
+				printf("PathCaseIndex (%s): '%s' behavior %d gave %d '%s', FixPathCase %d '%s'\n", stage, query, (int)behavior, actualResult, actual.c_str(), expectedResult, expected.c_str());
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool TestPathCaseIndex() {
+	const Path base = File::GetCurDirectory() / "pathcasetest";
+	File::DeleteDirRecursively(base);
+	EXPECT_TRUE(File::CreateFullPath(base / "Data/Sub Dir"));
+	EXPECT_TRUE(File::CreateFullPath(base / "SAVE/GameX"));
+	EXPECT_TRUE(File::CreateEmptyFile(base / "Top.txt"));
+	EXPECT_TRUE(File::CreateEmptyFile(base / "Data/ReadMe.md"));
+	EXPECT_TRUE(File::CreateEmptyFile(base / "Data/Sub Dir/File.TXT"));
+	EXPECT_TRUE(File::CreateEmptyFile(base / "Data/Sub Dir/other.bin"));
+	EXPECT_TRUE(File::CreateEmptyFile(base / "SAVE/GameX/PARAM.SFO"));
+
+	PathCaseIndex index(base);
+	// Twice, so the second round is answered from the listings the first one loaded.
+	RET(CompareWithFixPathCase(index, base, "initial"));
+	RET(CompareWithFixPathCase(index, base, "cached"));
+
+	// Now change things without telling the index, like another program would.
+	EXPECT_TRUE(File::Rename(base / "Data/Sub Dir/File.TXT", base / "Data/Sub Dir/Renamed.Txt"));
+	EXPECT_TRUE(File::Delete(base / "Data/ReadMe.md"));
+	EXPECT_TRUE(File::Rename(base / "SAVE/GameX", base / "SAVE/gameY"));
+	EXPECT_TRUE(File::CreateEmptyFile(base / "Data/New.dat"));
+	RET(CompareWithFixPathCase(index, base, "changed"));
+
+	// And a listing handed over by a directory listing of our own, then a whole directory gone.
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(base / "Data", &files);
+	index.AddListing("Data", files);
+	RET(CompareWithFixPathCase(index, base, "added"));
+	EXPECT_TRUE(File::DeleteDirRecursively(base / "Data"));
+	RET(CompareWithFixPathCase(index, base, "deleted"));
+
+	File::DeleteDirRecursively(base);
+	return true;
+}
+
+#else
+
+bool TestPathCaseIndex() {
+	// No case fixing needed on this host.
+	return true;
+}
+
+#endif
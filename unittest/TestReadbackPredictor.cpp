@@ -0,0 +1,270 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Core/Config.h"
+#include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/Common/ReadbackPredictor.h"
+#include "GPU/Common/ShaderCommon.h"
+#include "GPU/Common/TextureCacheCommon.h"
+#include "GPU/GPU.h"
+
+#include "UnitTest.h"
+
+using Draw::ReadbackMode;
+
+static const uint32_t FB_ADDR = 0x04000000;
+static const uint32_t FB_ADDR2 = 0x04088000;
+
+// Reads the same full buffer once a frame, starting at startFrame, returns the number of delayed readbacks.
+static int ReadEveryFrame(ReadbackPredictor &predictor, int startFrame, int frames) {
+	int delayed = 0;
+	for (int frame = startFrame; frame < startFrame + frames; ++frame) {
+		if (predictor.Predict(FB_ADDR, 0, 0, 480, 272, frame, ReadbackMode::BLOCK) == ReadbackMode::OLD_DATA_OK)
+			delayed++;
+	}
+	return delayed;
+}
+
+static bool TestReadbackPredictorSteady() {
+	ReadbackPredictor predictor;
+	// Nothing is delayed unless the backend can do it.
+	EXPECT_EQ_INT(ReadEveryFrame(predictor, 0, 30), 0);
+
+	predictor.Reset();
+	predictor.SetDelayedReadbackSupported(true);
+	for (int frame = 0; frame < ReadbackPredictor::STEADY_FRAMES - 1; ++frame) {
+		EXPECT_TRUE(predictor.Predict(FB_ADDR, 0, 0, 480, 272, frame, ReadbackMode::BLOCK) == ReadbackMode::BLOCK);
+	}
+	EXPECT_TRUE(predictor.Predict(FB_ADDR, 0, 0, 480, 272, ReadbackPredictor::STEADY_FRAMES - 1, ReadbackMode::BLOCK) == ReadbackMode::OLD_DATA_OK);
+	EXPECT_EQ_INT(ReadEveryFrame(predictor, ReadbackPredictor::STEADY_FRAMES, 10), 10);
+	EXPECT_EQ_INT(predictor.DelayedCount(), 11);
+
+	// Other buffers have their own history.
+	EXPECT_TRUE(predictor.Predict(FB_ADDR2, 0, 0, 480, 272, ReadbackPredictor::STEADY_FRAMES + 10, ReadbackMode::BLOCK) == ReadbackMode::BLOCK);
+	// And callers that already accept old data are left alone.
+	EXPECT_TRUE(predictor.Predict(FB_ADDR2, 0, 0, 64, 64, 100, ReadbackMode::OLD_DATA_OK) == ReadbackMode::OLD_DATA_OK);
+	return true;
+}
+
+static bool TestReadbackPredictorBreaks() {
+	ReadbackPredictor predictor;
+	predictor.SetDelayedReadbackSupported(true);
+	const int steady = ReadbackPredictor::STEADY_FRAMES;
+
+	// Reading twice in a frame: block, and start over next frame.
+	EXPECT_EQ_INT(ReadEveryFrame(predictor, 0, steady), 1);
+	EXPECT_TRUE(predictor.Predict(FB_ADDR, 0, 0, 480, 272, steady - 1, ReadbackMode::BLOCK) == ReadbackMode::BLOCK);
+	EXPECT_EQ_INT(ReadEveryFrame(predictor, steady, steady), 1);
+
+	// A different rectangle.
+	EXPECT_TRUE(predictor.Predict(FB_ADDR, 0, 0, 480, 136, steady * 2, ReadbackMode::BLOCK) == ReadbackMode::BLOCK);
+	EXPECT_EQ_INT(ReadEveryFrame(predictor, steady * 2 + 1, steady), 1);
+
+	// Skipping a frame.
+	EXPECT_EQ_INT(ReadEveryFrame(predictor, steady * 3 + 2, steady), 1);
+	return true;
+}
+
+// Stands in for a backend with a ring of per-frame staging buffers, like Vulkan's frameData_: a delayed
+// readback gets what was queued the last time the same frame slot was in use, so there's nothing to
+// return (false) until each slot has been through the ring once.  Everything else is a no-op.
+class FakeReadbackDrawContext : public Draw::DrawContext {
+public:
+	static constexpr int INFLIGHT_FRAMES = 3;
+
+	FakeReadbackDrawContext() {
+		memset(vsPresets_, 0, sizeof(vsPresets_));
+		memset(fsPresets_, 0, sizeof(fsPresets_));
+		memset(&caps_, 0, sizeof(caps_));
+		caps_.delayedReadbackSupported = true;
+	}
+
+	bool CopyFramebufferToMemory(Draw::Framebuffer *src, int channelBits, int x, int y, int w, int h, Draw::DataFormat format, void *pixels, int pixelStride, ReadbackMode mode, const char *tag) override {
+		if (mode == ReadbackMode::BLOCK) {
+			blocking++;
+			return true;
+		}
+		delayed++;
+		int &queuedFrame = queuedFrames_[frame % INFLIGHT_FRAMES];
+		bool ready = queuedFrame >= 0 && queuedFrame < frame;
+		queuedFrame = frame;
+		return ready;
+	}
+
+	const Draw::DeviceCaps &GetDeviceCaps() const override { return caps_; }
+	uint32_t GetDataFormatSupport(Draw::DataFormat fmt) const override { return 0; }
+	uint32_t GetSupportedShaderLanguages() const override { return 0; }
+
+	Draw::DepthStencilState *CreateDepthStencilState(const Draw::DepthStencilStateDesc &desc) override { return new Draw::DepthStencilState(); }
+	Draw::BlendState *CreateBlendState(const Draw::BlendStateDesc &desc) override { return new Draw::BlendState(); }
+	Draw::SamplerState *CreateSamplerState(const Draw::SamplerStateDesc &desc) override { return new Draw::SamplerState(); }
+	Draw::RasterState *CreateRasterState(const Draw::RasterStateDesc &desc) override { return new Draw::RasterState(); }
+	Draw::InputLayout *CreateInputLayout(const Draw::InputLayoutDesc &desc) override { return new Draw::InputLayout(); }
+	Draw::ShaderModule *CreateShaderModule(ShaderStage stage, ShaderLanguage language, const uint8_t *data, size_t dataSize, const char *tag) override { return nullptr; }
+	Draw::Pipeline *CreateGraphicsPipeline(const Draw::PipelineDesc &desc, const char *tag) override { return new Draw::Pipeline(); }
+	Draw::Buffer *CreateBuffer(size_t size, uint32_t usageFlags) override { return new Draw::Buffer(); }
+	Draw::Texture *CreateTexture(const Draw::TextureDesc &desc) override { return nullptr; }
+	Draw::Framebuffer *CreateFramebuffer(const Draw::FramebufferDesc &desc) override { return nullptr; }
+
+	void UpdateBuffer(Draw::Buffer *buffer, const uint8_t *data, size_t offset, size_t size, Draw::UpdateBufferFlags flags) override {}
+	void UpdateTextureLevels(Draw::Texture *texture, const uint8_t **data, Draw::TextureCallback initDataCallback, int numLevels) override {}
+	void CopyFramebufferImage(Draw::Framebuffer *src, int level, int x, int y, int z, Draw::Framebuffer *dst, int dstLevel, int dstX, int dstY, int dstZ, int width, int height, int depth, int channelBits, const char *tag) override {}
+	bool BlitFramebuffer(Draw::Framebuffer *src, int srcX1, int srcY1, int srcX2, int srcY2, Draw::Framebuffer *dst, int dstX1, int dstY1, int dstX2, int dstY2, int channelBits, Draw::FBBlitFilter filter, const char *tag) override { return false; }
+	void BindFramebufferAsRenderTarget(Draw::Framebuffer *fbo, const Draw::RenderPassInfo &rp, const char *tag) override {}
+	void BindFramebufferAsTexture(Draw::Framebuffer *fbo, int binding, Draw::FBChannel channelBit, int layer) override {}
+	void GetFramebufferDimensions(Draw::Framebuffer *fbo, int *w, int *h) override { *w = 480; *h = 272; }
+
+	void SetScissorRect(int left, int top, int width, int height) override {}
+	void SetViewport(const Draw::Viewport &viewport) override {}
+	void SetBlendFactor(float color[4]) override {}
+	void SetStencilParams(uint8_t refValue, uint8_t writeMask, uint8_t compareMask) override {}
+	void BindSamplerStates(int start, int count, Draw::SamplerState **state) override {}
+	void BindTextures(int start, int count, Draw::Texture **textures, Draw::TextureBindFlags flags) override {}
+	void BindVertexBuffer(Draw::Buffer *vertexBuffer, int offset) override {}
+	void BindIndexBuffer(Draw::Buffer *indexBuffer, int offset) override {}
+	void BindNativeTexture(int sampler, void *nativeTexture) override {}
+	void UpdateDynamicUniformBuffer(const void *ub, size_t size) override {}
+	void Invalidate(InvalidationFlags flags) override {}
+	void BindPipeline(Draw::Pipeline *pipeline) override {}
+	void Draw(int vertexCount, int offset) override {}
+	void DrawIndexed(int vertexCount, int offset) override {}
+	void DrawUP(const void *vdata, int vertexCount) override {}
+	void BeginFrame(Draw::DebugFlags debugFlags) override {}
+	void EndFrame() override {}
+	void Present(Draw::PresentMode presentMode, int vblanks) override {}
+	void Clear(int mask, uint32_t colorval, float depthVal, int stencilVal) override {}
+	std::string GetInfoString(Draw::InfoField info) const override { return ""; }
+	uint64_t GetNativeObject(Draw::NativeObject obj, void *srcObject) override { return 0; }
+	void HandleEvent(Draw::Event ev, int width, int height, void *param1, void *param2) override {}
+	void SetInvalidationCallback(InvalidationCallback callback) override {}
+	int GetFrameCount() override { return frame; }
+
+	// Like after a device restore: nothing queued, so the next delayed copies all come back empty.
+	void ClearQueued() {
+		for (int &queuedFrame : queuedFrames_)
+			queuedFrame = -1;
+	}
+
+	int frame = 0;
+	int blocking = 0;
+	int delayed = 0;
+
+private:
+	Draw::DeviceCaps caps_;
+	int queuedFrames_[INFLIGHT_FRAMES]{ -1, -1, -1 };
+};
+
+// ReadFramebufferToMemory only needs these to forget their bindings afterwards.
+class FakeTextureCache : public TextureCacheCommon {
+public:
+	FakeTextureCache(Draw::DrawContext *draw, Draw2D *draw2D) : TextureCacheCommon(draw, draw2D) {}
+	void ForgetLastTexture() override {}
+	void DeviceLost() override {}
+	void DeviceRestore(Draw::DrawContext *draw) override {}
+
+protected:
+	void ApplySamplingParams(const SamplerCacheKey &key) override {}
+	void *GetNativeTextureView(const TexCacheEntry *entry) override { return nullptr; }
+	void BindTexture(TexCacheEntry *entry) override {}
+	void Unbind() override {}
+	void ReleaseTexture(TexCacheEntry *entry, bool delete_them) override {}
+	void BuildTexture(TexCacheEntry *const entry) override {}
+	void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) override {}
+};
+
+class FakeShaderManager : public ShaderManagerCommon {
+public:
+	FakeShaderManager(Draw::DrawContext *draw) : ShaderManagerCommon(draw) {}
+	void ClearShaders() override {}
+	void DirtyLastShader() override {}
+	void DeviceLost() override {}
+	void DeviceRestore(Draw::DrawContext *draw) override {}
+	std::vector<std::string> DebugGetShaderIDs(DebugShaderType type) override { return std::vector<std::string>(); }
+	std::string DebugGetShaderString(std::string id, DebugShaderType type, DebugShaderStringType stringType) override { return ""; }
+};
+
+// Reads the full buffer every frame through FramebufferManagerCommon, the way a game's block transfers do.
+static void ReadbackFrames(FramebufferManagerCommon &framebufferManager, FakeReadbackDrawContext &draw, VirtualFramebuffer *vfb, ReadbackMode mode, int frames) {
+	for (int i = 0; i < frames; ++i) {
+		framebufferManager.ReadFramebufferToMemory(vfb, 0, 0, vfb->width, vfb->height, RASTER_COLOR, mode);
+		draw.frame++;
+		gpuStats.numFlips++;
+	}
+}
+
+static bool TestReadbackPredictorBackend() {
+	const bool oldPredict = g_Config.bPredictReadbacks;
+	g_Config.bPredictReadbacks = true;
+	gpuStats.numFlips = 0;
+
+	FakeReadbackDrawContext draw;
+	Draw2D draw2D(&draw);
+	FakeTextureCache textureCache(&draw, &draw2D);
+	FakeShaderManager shaderManager(&draw);
+	FramebufferManagerCommon framebufferManager(&draw);
+	framebufferManager.SetTextureCache(&textureCache);
+	framebufferManager.SetShaderManager(&shaderManager);
+
+	VirtualFramebuffer vfb{};
+	vfb.fb_address = FB_ADDR;
+	vfb.fb_stride = 512;
+	vfb.fb_format = GE_FORMAT_8888;
+	vfb.width = 480;
+	vfb.height = 272;
+	vfb.bufferWidth = 512;
+	vfb.bufferHeight = 272;
+	vfb.renderScaleFactor = 1;
+	vfb.fbo = new Draw::Framebuffer();
+
+	// Only the warmup and the first trip around the frame ring have to wait: the warmup blocks
+	// outright, and each delayed copy that comes back empty falls back to one blocking copy.
+	const int frames = 100;
+	const int stalls = ReadbackPredictor::STEADY_FRAMES - 1 + FakeReadbackDrawContext::INFLIGHT_FRAMES;
+	int blockingStat = gpuStats.numBlockingReadbacks;
+	ReadbackFrames(framebufferManager, draw, &vfb, ReadbackMode::BLOCK, frames);
+	EXPECT_EQ_INT(draw.blocking, stalls);
+	EXPECT_EQ_INT(draw.delayed, frames - (ReadbackPredictor::STEADY_FRAMES - 1));
+	EXPECT_EQ_INT(gpuStats.numBlockingReadbacks - blockingStat, stalls);
+
+	// Callers that ask for old data themselves never get the blocking fallback, even on a miss.
+	VirtualFramebuffer vfb2 = vfb;
+	vfb2.fb_address = FB_ADDR2;
+	draw.ClearQueued();
+	draw.blocking = 0;
+	draw.delayed = 0;
+	ReadbackFrames(framebufferManager, draw, &vfb2, ReadbackMode::OLD_DATA_OK, FakeReadbackDrawContext::INFLIGHT_FRAMES);
+	EXPECT_EQ_INT(draw.delayed, FakeReadbackDrawContext::INFLIGHT_FRAMES);
+	EXPECT_EQ_INT(draw.blocking, 0);
+
+	// And with the setting off, nothing is predicted: every readback blocks, and there's no delayed copy to miss.
+	g_Config.bPredictReadbacks = false;
+	draw.blocking = 0;
+	draw.delayed = 0;
+	ReadbackFrames(framebufferManager, draw, &vfb2, ReadbackMode::BLOCK, 10);
+	EXPECT_EQ_INT(draw.blocking, 10);
+	EXPECT_EQ_INT(draw.delayed, 0);
+
+	g_Config.bPredictReadbacks = oldPredict;
+	vfb.fbo->Release();
+	return true;
+}
+
+static bool TestReadbackPredictorSubranges() {
+	ReadbackPredictor predictor;
+	for (int i = 0; i < ReadbackPredictor::FREQUENT_SEQUENTIAL_COPIES; ++i) {
+		EXPECT_FALSE(predictor.NoteSubrangeCopy(FB_ADDR, 1));
+	}
+	EXPECT_TRUE(predictor.NoteSubrangeCopy(FB_ADDR, 1));
+	// Counted per buffer and frame.
+	EXPECT_FALSE(predictor.NoteSubrangeCopy(FB_ADDR2, 1));
+	EXPECT_FALSE(predictor.NoteSubrangeCopy(FB_ADDR2, 2));
+	return true;
+}
+
+bool TestReadbackPredictor() {
+	RET(TestReadbackPredictorSteady());
+	RET(TestReadbackPredictorBreaks());
+	RET(TestReadbackPredictorBackend());
+	RET(TestReadbackPredictorSubranges());
+	return true;
+}
@@ -7,6 +7,7 @@
 #include "GPU/Common/ShaderCommon.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "Common/Data/Random/Rng.h"
+#include "Common/TimeUtil.h"
 
 #include "GPU/Vulkan/VulkanContext.h"
 
@@ -16,6 +17,7 @@
 #include "GPU/Common/ReinterpretFramebuffer.h"
 #include "GPU/Common/StencilCommon.h"
 #include "GPU/Common/DepalettizeShaderCommon.h"
+#include "GPU/Common/ShaderBlobCache.h"
 
 #if PPSSPP_PLATFORM(WINDOWS)
 #include "GPU/D3D11/D3D11Util.h"
@@ -617,6 +619,91 @@ bool TestGeometryShaders() {
 	return true;
 }
 
+// Measures how long it takes to regenerate a recorded set of IDs, like a shader cache load does,
+// and how much the SPIR-V blob cache saves over compiling them again.
+static void BenchmarkShaderGenerators() {
+	GMRng rng;
+	Draw::Bugs bugs;
+
+	// Record a set of IDs that generate successfully, with the same adjustments as the tests above.
+	std::vector<VShaderID> vsIDs;
+	std::vector<FShaderID> fsIDs;
+	char *buffer = new char[65536];
+	while (vsIDs.size() < 200) {
+		VShaderID id;
+		id.d[0] = rng.R32();
+		id.d[1] = rng.R32();
+		id.SetBits(VS_BIT_WEIGHT_FMTSCALE, 2, 0);
+		if (id.Bit(VS_BIT_IS_THROUGH))
+			id.SetBit(VS_BIT_USE_HW_TRANSFORM, 0);
+		if (!id.Bit(VS_BIT_USE_HW_TRANSFORM))
+			id.SetBit(VS_BIT_ENABLE_BONES, 0);
+		if (id.Bit(VS_BIT_VERTEX_RANGE_CULLING))
+			continue;
+		std::string genErrorString;
+		if (GenerateVShader(id, buffer, ShaderLanguage::GLSL_VULKAN, bugs, &genErrorString))
+			vsIDs.push_back(id);
+	}
+	while (fsIDs.size() < 200) {
+		FShaderID id;
+		id.d[0] = rng.R32();
+		id.d[1] = rng.R32();
+		id.SetBit(FS_BIT_NO_DEPTH_CANNOT_DISCARD_STENCIL, false);
+		std::string genErrorString;
+		if (GenerateFShader(id, buffer, ShaderLanguage::GLSL_VULKAN, bugs, &genErrorString))
+			fsIDs.push_back(id);
+	}
+
+	// Generate every ID in the set a few times over.
+	const int passes = 5;
+	size_t totalBytes = 0;
+	double st = time_now_d();
+	for (int pass = 0; pass < passes; ++pass) {
+		for (const VShaderID &id : vsIDs) {
+			std::string genErrorString;
+			GenerateVShader(id, buffer, ShaderLanguage::GLSL_VULKAN, bugs, &genErrorString);
+			totalBytes += strlen(buffer);
+		}
+		for (const FShaderID &id : fsIDs) {
+			std::string genErrorString;
+			GenerateFShader(id, buffer, ShaderLanguage::GLSL_VULKAN, bugs, &genErrorString);
+			totalBytes += strlen(buffer);
+		}
+	}
+	double elapsed = time_now_d() - st;
+	int generated = passes * (int)(vsIDs.size() + fsIDs.size());
+	printf("Shader generation: %d shaders in %0.3f ms (%0.1f shaders/ms, %0.1f MB/s)\n", generated, elapsed * 1000.0, generated / (elapsed * 1000.0), totalBytes / (elapsed * 1024.0 * 1024.0));
+
+	// Now compile a subset to SPIR-V, and compare against hitting the blob cache.
+	const int compileCount = 50;
+	std::vector<std::string> sources;
+	for (int i = 0; i < compileCount; ++i) {
+		std::string genErrorString;
+		GenerateFShader(fsIDs[i], buffer, ShaderLanguage::GLSL_VULKAN, bugs, &genErrorString);
+		sources.push_back(buffer);
+	}
+	delete[] buffer;
+
+	ShaderBlobCache blobCache;
+	st = time_now_d();
+	for (const std::string &source : sources) {
+		std::vector<uint32_t> spirv;
+		std::string errorMessage;
+		if (GLSLtoSPV(VK_SHADER_STAGE_FRAGMENT_BIT, source.c_str(), GLSLVariant::VULKAN, spirv, &errorMessage))
+			blobCache.Insert(ShaderBlobCache::MakeKey(VK_SHADER_STAGE_FRAGMENT_BIT, source.c_str()), spirv.data(), spirv.size() * sizeof(uint32_t));
+	}
+	double compileElapsed = time_now_d() - st;
+
+	int hits = 0;
+	st = time_now_d();
+	for (const std::string &source : sources) {
+		std::vector<uint8_t> blob;
+		if (blobCache.Find(ShaderBlobCache::MakeKey(VK_SHADER_STAGE_FRAGMENT_BIT, source.c_str()), &blob))
+			hits++;
+	}
+	double hitElapsed = time_now_d() - st;
+	printf("SPIR-V: %d compiled in %0.3f ms, %d cache hits in %0.3f ms\n", compileCount, compileElapsed * 1000.0, hits, hitElapsed * 1000.0);
+}
 
 bool TestShaderGenerators() {
 #if PPSSPP_PLATFORM(WINDOWS)
@@ -651,5 +738,6 @@ bool TestShaderGenerators() {
 		return false;
 	}
 
+	BenchmarkShaderGenerators();
 	return true;
 } 
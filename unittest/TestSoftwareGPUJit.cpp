@@ -109,6 +109,62 @@ static bool TestSamplerJit() {
 
 	delete cache;
 	return successes == count && !HitAnyAsserts();
+#elif PPSSPP_ARCH(ARM64_NEON)
+	// Only some fetch funcs are supported, so compare those against the generic func.
+	using namespace Sampler;
+	Sampler::Init();
+	SamplerJitCache *cache = new SamplerJitCache();
+	BinManager binner;
+
+	GMRng rng;
+	int compiled = 0;
+	int mismatches = 0;
+	int count = 3000;
+
+	const int texSize = 512 * 512 * 4;
+	u8 *tptr = new u8[texSize];
+	for (int i = 0; i < texSize; ++i)
+		tptr[i] = (u8)rng.R32();
+
+	for (int i = 0; i < count; ) {
+		SamplerID id;
+		memset(&id, 0, sizeof(id));
+		id.fullKey = rng.R32();
+		id.linear = false;
+		id.fetch = true;
+
+		std::string desc = DescribeSamplerID(id);
+		if (startsWith(desc, "INVALID"))
+			continue;
+		i++;
+
+		FetchFunc fetchFunc = cache->GetFetch(id, &binner);
+		if (fetchFunc == nullptr)
+			continue;
+		compiled++;
+
+		g_Config.bSoftwareRenderingJit = false;
+		FetchFunc genericFunc = GetFetchFunc(id, &binner);
+		g_Config.bSoftwareRenderingJit = true;
+
+		int u = rng.R32() & 255;
+		int v = rng.R32() & 255;
+		uint16_t bufw = 256 + (rng.R32() & 255);
+		Math3D::Vec4<int> jitResult = fetchFunc(u, v, tptr, bufw, 0, id);
+		Math3D::Vec4<int> genericResult = genericFunc(u, v, tptr, bufw, 0, id);
+		if (jitResult.x != genericResult.x || jitResult.y != genericResult.y || jitResult.z != genericResult.z || jitResult.w != genericResult.w) {
+			printf(" * Fetch mismatch: %s\n", desc.c_str());
+			mismatches++;
+		}
+	}
+
+	if (compiled == 0)
+		printf("SamplerFunc: no fetch funcs compiled\n");
+
+	delete [] tptr;
+	delete cache;
+	Sampler::Shutdown();
+	return compiled != 0 && mismatches == 0 && !HitAnyAsserts();
 #else
 	// Don't test sampler jit, not supported.
 	return true;
@@ -165,6 +221,92 @@ static bool TestPixelJit() {
 	delete [] zb_data;
 	delete cache;
 	return successes == count && !HitAnyAsserts();
+#elif PPSSPP_ARCH(ARM64_NEON)
+	// Only some pixel funcs are supported, so compare those against the generic func.
+	using namespace Rasterizer;
+	PixelJitCache *cache = new PixelJitCache();
+	BinManager binner;
+
+	GMRng rng;
+	int compiled = 0;
+	int mismatches = 0;
+	int count = 3000;
+
+	u32 *fb_data = new u32[512 * 2];
+	u16 *zb_data = new u16[512 * 2];
+	u32 *fb_orig = new u32[512 * 2];
+	u16 *zb_orig = new u16[512 * 2];
+	u32 *fb_jit = new u32[512 * 2];
+	u16 *zb_jit = new u16[512 * 2];
+
+	for (int i = 0; i < count; ) {
+		PixelFuncID id;
+		memset(&id, 0, sizeof(id));
+		id.fullKey = (uint64_t)rng.R32() | ((uint64_t)rng.R32() << 32);
+
+		std::string desc = DescribePixelFuncID(id);
+		if (startsWith(desc, "INVALID"))
+			continue;
+		i++;
+
+		SingleFunc func = cache->GetSingle(id, &binner);
+		if (func == nullptr)
+			continue;
+		compiled++;
+
+		id.cached.colorWriteMask = rng.R32();
+		for (int j = 0; j < 16; ++j)
+			id.cached.ditherMatrix[j] = (int8_t)((rng.R32() & 15) - 8);
+		id.cached.fogColor = rng.R32();
+		id.cached.minz = rng.R32() & 0x7FFF;
+		id.cached.maxz = id.cached.minz + (rng.R32() & 0x7FFF);
+		id.cached.framebufStride = 512;
+		id.cached.depthbufStride = 512;
+		id.cached.alphaTestMask = (uint8_t)rng.R32();
+		id.cached.colorTestFunc = GEComparison(rng.R32() & 3);
+		id.cached.colorTestMask = rng.R32() & 0x00FFFFFF;
+		id.cached.colorTestRef = rng.R32() & id.cached.colorTestMask;
+
+		for (int j = 0; j < 512 * 2; ++j) {
+			fb_orig[j] = rng.R32();
+			zb_orig[j] = (u16)rng.R32();
+		}
+
+		int x = rng.R32() & 511;
+		int y = rng.R32() & 1;
+		int z = rng.R32() & 0xFFFF;
+		int fog = rng.R32() & 255;
+		Math3D::Vec4<int> color((int)(rng.R32() & 511) - 128, (int)(rng.R32() & 511) - 128, (int)(rng.R32() & 511) - 128, (int)(rng.R32() & 511) - 128);
+
+		fb.as32 = fb_jit;
+		depthbuf.as16 = zb_jit;
+		memcpy(fb_jit, fb_orig, sizeof(u32) * 512 * 2);
+		memcpy(zb_jit, zb_orig, sizeof(u16) * 512 * 2);
+		func(x, y, z, fog, ToVec4IntArg(color), id);
+
+		fb.as32 = fb_data;
+		depthbuf.as16 = zb_data;
+		memcpy(fb_data, fb_orig, sizeof(u32) * 512 * 2);
+		memcpy(zb_data, zb_orig, sizeof(u16) * 512 * 2);
+		cache->GenericSingle(id)(x, y, z, fog, ToVec4IntArg(color), id);
+
+		if (memcmp(fb_jit, fb_data, sizeof(u32) * 512 * 2) != 0 || memcmp(zb_jit, zb_data, sizeof(u16) * 512 * 2) != 0) {
+			printf(" * Pixel mismatch: %s\n", desc.c_str());
+			mismatches++;
+		}
+	}
+
+	if (compiled == 0)
+		printf("PixelFunc: no funcs compiled\n");
+
+	delete [] fb_data;
+	delete [] zb_data;
+	delete [] fb_orig;
+	delete [] zb_orig;
+	delete [] fb_jit;
+	delete [] zb_jit;
+	delete cache;
+	return compiled != 0 && mismatches == 0 && !HitAnyAsserts();
 #else
 	// Not yet supported
 	return true;
@@ -1,7 +1,9 @@
 #include <thread>
 #include <vector>
 #include <cstdio>
+#include <cstring>
 
+#include "Common/Data/Random/Rng.h"
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
 #include "Common/Thread/Barrier.h"
@@ -64,6 +66,87 @@ bool TestParallelLoop(ThreadManager *threadMan) {
 	return true;
 }
 
+static bool TestMemcpyVariants(ThreadManager *threadMan) {
+	std::vector<uint8_t> src(3 * 1024 * 1024), dst(src.size() + 64);
+	for (size_t i = 0; i < src.size(); ++i)
+		src[i] = (uint8_t)(i * 7 + (i >> 8));
+
+	// Odd sizes and misaligned destinations, to hit the heads and tails.
+	static const size_t sizes[] = { 0, 1, 255, 256, 1000, 65536 + 13, 2 * 1024 * 1024 + 5 };
+	for (size_t size : sizes) {
+		for (size_t offset : { 0, 3, 16 }) {
+			memset(dst.data(), 0xCC, dst.size());
+			StreamingMemcpy(&dst[offset], src.data(), size);
+			EXPECT_TRUE(memcmp(&dst[offset], src.data(), size) == 0);
+			EXPECT_EQ_INT(dst[offset + size], 0xCC);
+
+			StreamingMemset(&dst[offset], 0x5A, size);
+			EXPECT_TRUE(size == 0 || (dst[offset] == 0x5A && dst[offset + size - 1] == 0x5A));
+			EXPECT_EQ_INT(dst[offset + size], 0xCC);
+
+			ParallelMemset(threadMan, &dst[offset], 0xA5, size);
+			EXPECT_TRUE(size == 0 || (dst[offset] == 0xA5 && dst[offset + size / 2] == 0xA5 && dst[offset + size - 1] == 0xA5));
+			EXPECT_EQ_INT(dst[offset + size], 0xCC);
+		}
+	}
+	return true;
+}
+
+// Roughly the sizes games pass to the replaced memcpy: mostly small structs and strings,
+// some buffers, and the odd big texture or video frame.
+static void BenchmarkMemcpy(ThreadManager *threadMan) {
+	struct SizeBucket {
+		int weight;
+		uint32_t minSize;
+		uint32_t maxSize;
+	};
+	static const SizeBucket buckets[] = {
+		{ 450, 16, 64 },
+		{ 250, 64, 256 },
+		{ 200, 256, 4096 },
+		{ 80, 4096, 65536 },
+		{ 15, 65536, 512 * 1024 },
+		{ 5, 512 * 1024, 2 * 1024 * 1024 },
+	};
+
+	GMRng rng;
+	std::vector<uint32_t> copies;
+	for (int i = 0; i < 20000; ++i) {
+		int pick = rng.R32() % 1000;
+		const SizeBucket *bucket = buckets;
+		while (pick >= bucket->weight) {
+			pick -= bucket->weight;
+			bucket++;
+		}
+		copies.push_back(bucket->minSize + rng.R32() % (bucket->maxSize - bucket->minSize));
+	}
+
+	// Big enough that the larger copies don't just bounce around in cache.
+	std::vector<uint8_t> src(32 * 1024 * 1024, 1), dst(32 * 1024 * 1024);
+	auto run = [&](int method) {
+		double start = time_now_d();
+		size_t pos = 0;
+		for (uint32_t size : copies) {
+			if (pos + size > src.size())
+				pos = 0;
+			if (method == 0 || (method == 1 && size < 512 * 1024) || (method == 2 && size < 256 * 1024))
+				memcpy(&dst[pos], &src[pos], size);
+			else if (method == 1)
+				ParallelMemcpy(threadMan, &dst[pos], &src[pos], size);
+			else
+				StreamingMemcpy(&dst[pos], &src[pos], size);
+			pos += (size + 63) & ~63;
+		}
+		return time_now_d() - start;
+	};
+
+	run(0);
+	double plain = run(0);
+	double parallel = run(1);
+	double streaming = run(2);
+	printf("Memcpy: %d copies, memcpy %.2f ms, parallel large %.2f ms, streaming large %.2f ms\n", (int)copies.size(), plain * 1000.0, parallel * 1000.0, streaming * 1000.0);
+}
+
 const size_t THREAD_COUNT = 9;
 const size_t ITERATIONS = 40000;
 
@@ -152,5 +235,10 @@ bool TestThreadManager() {
 		return false;
 	}
 
+	if (!TestMemcpyVariants(&manager)) {
+		return false;
+	}
+	BenchmarkMemcpy(&manager);
+
 	return true;
 }
@@ -1,7 +1,9 @@
+#include <cstring>
 #include <thread>
 #include <vector>
 
 #include "Common/Log.h"
+#include "Common/File/VFS/PackFileReader.h"
 #include "Common/File/VFS/ZipFileReader.h"
 
 #include "UnitTest.h"
@@ -87,8 +89,96 @@ bool TestZipFile() {
 	return true;
 }
 
+static bool SameFile(VFSBackend *a, VFSBackend *b, const char *path) {
+	size_t sizeA = 0, sizeB = 0;
+	uint8_t *dataA = a->ReadFile(path, &sizeA);
+	uint8_t *dataB = b->ReadFile(path, &sizeB);
+	bool same = dataA && dataB && sizeA == sizeB && memcmp(dataA, dataB, sizeA) == 0;
+	delete[] dataA;
+	delete[] dataB;
+	return same;
+}
+
+// Packs ziptest.zip, and checks that the result looks the same.
+bool TestPackFile() {
+	Path zipPath = Path("../source_assets/ziptest.zip");
+	if (!File::Exists(zipPath)) {
+		zipPath = Path("source_assets/ziptest.zip");
+	}
+	Path packPath = Path("ziptest.pack");
+
+	ZipFileReader *zip = ZipFileReader::Create(zipPath, "", true);
+	EXPECT_TRUE(zip != nullptr);
+	std::string error;
+	bool written = WritePackFile(zip, packPath, &error);
+	if (!written)
+		printf("WritePackFile: %s\n", error.c_str());
+	EXPECT_TRUE(written);
+
+	PackFileReader *pack = PackFileReader::Create(packPath, true);
+	EXPECT_TRUE(pack != nullptr);
+	EXPECT_EQ_INT(pack->FileCount(), 8);
+
+	std::vector<File::FileInfo> listing;
+	EXPECT_TRUE(pack->GetFileListing("", &listing, nullptr));
+	EXPECT_EQ_INT(listing.size(), 2);
+	EXPECT_TRUE(CheckContainsDir(listing, "ziptest"));
+	EXPECT_TRUE(CheckContainsFile(listing, "in_root.txt"));
+	EXPECT_TRUE(pack->GetFileListing("ziptest/data", &listing, nullptr));
+	EXPECT_EQ_INT(listing.size(), 4);
+	EXPECT_TRUE(CheckContainsDir(listing, "a"));
+	EXPECT_TRUE(CheckContainsFile(listing, "big.txt"));
+	EXPECT_FALSE(pack->GetFileListing("ziptestwrong", &listing, nullptr));
+
+	EXPECT_TRUE(SameFile(zip, pack, "in_root.txt"));
+	EXPECT_TRUE(SameFile(zip, pack, "ziptest/data/big.txt"));
+	EXPECT_TRUE(SameFile(zip, pack, "ziptest/lang/sv_se.txt"));
+
+	// Lookups ignore case, like in zips.
+	VFSFileReference *ref = pack->GetFile("ZipTest/Data/A/IN_A.TXT");
+	EXPECT_TRUE(ref != nullptr);
+	EXPECT_TRUE(pack->GetFile("ziptest/data/a/in_b.txt") == nullptr);
+
+	// Reads in pieces should add up to the whole file.
+	size_t size = 0;
+	VFSOpenFile *openFile = pack->OpenFileForRead(ref, &size);
+	std::string pieces;
+	char buf[3];
+	size_t readBytes;
+	while ((readBytes = pack->Read(openFile, buf, sizeof(buf))) != 0)
+		pieces.append(buf, readBytes);
+	pack->CloseFile(openFile);
+	EXPECT_EQ_INT(pieces.size(), size);
+
+	size_t mappedSize = 0;
+	const uint8_t *mapped = pack->MapFile(ref, &mappedSize);
+	if (mapped) {
+		EXPECT_EQ_INT(mappedSize, size);
+		EXPECT_TRUE(memcmp(mapped, pieces.data(), size) == 0);
+	}
+	pack->ReleaseFile(ref);
+
+	delete pack;
+
+	// A names size that wraps around past the end of the file must not get through.
+	FILE *f = File::OpenCFile(packPath, "r+b");
+	EXPECT_TRUE(f != nullptr);
+	const uint64_t hugeNamesSize = 0xFFFFFFFFFFFFFFF0ULL;
+	// magic, version, entryCount, bucketBits, then three offsets before namesSize.
+	EXPECT_TRUE(fseek(f, 16 + 3 * 8, SEEK_SET) == 0);
+	EXPECT_TRUE(fwrite(&hugeNamesSize, sizeof(hugeNamesSize), 1, f) == 1);
+	fclose(f);
+	EXPECT_TRUE(PackFileReader::Create(packPath, false) == nullptr);
+
+	delete zip;
+	File::Delete(packPath);
+	return true;
+}
+
 bool TestVFS() {
 	if (!TestZipFile())
 		return false;
+	if (!TestPackFile())
+		return false;
 	return true;
 }
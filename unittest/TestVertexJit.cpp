@@ -15,9 +15,15 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <math.h>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/Data/Random/Rng.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
@@ -81,7 +87,7 @@ class VertexDecoderTestHarness {
 		dec_->DecodeVerts(dst_, src_, &gstate_c.uv, indexLowerBound_, indexUpperBound);
 	}
 
-	double ExecuteTimed(int vtype, int indexUpperBound, bool useJit) {
+	double ExecuteTimed(int vtype, int indexUpperBound, bool useJit, double duration = 0.5) {
 		SetupExecute(vtype, useJit);
 
 		int total = 0;
@@ -91,7 +97,7 @@ class VertexDecoderTestHarness {
 				dec_->DecodeVerts(dst_, src_, &gstate_c.uv, indexLowerBound_, indexUpperBound);
 				++total;
 			}
-		} while (time_now_d() - st < 0.5);
+		} while (time_now_d() - st < duration);
 		double elapsed = time_now_d() - st;
 
 		return total / elapsed;
@@ -262,6 +268,10 @@ class VertexDecoderTestHarness {
 		return 0;
 	}
 
+	const DecVtxFormat &GetDecFmt() {
+		return dec_->decFmt;
+	}
+
 	bool HasFailed() {
 		return assertFailed_;
 	}
@@ -638,6 +648,125 @@ static bool TestVertexFloatSkin() {
 
 // TODO: Morph (col, pos, nrm), weights (no skin), morph + weights?
 
+struct VertexBenchmark {
+	const char *name;
+	int vtype;
+	bool skin;
+};
+
+static const VertexBenchmark vertdecBenchmarks[] = {
+	{ "pos8", GE_VTYPE_POS_8BIT, false },
+	{ "pos16", GE_VTYPE_POS_16BIT, false },
+	{ "posf", GE_VTYPE_POS_FLOAT, false },
+	{ "tc16 col8888 pos16", GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT, false },
+	{ "tcf col565 nrmf posf", GE_VTYPE_TC_FLOAT | GE_VTYPE_COL_565 | GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT, false },
+	{ "tc8 nrm8 pos8 w8x4", GE_VTYPE_TC_8BIT | GE_VTYPE_NRM_8BIT | GE_VTYPE_POS_8BIT | GE_VTYPE_WEIGHT_8BIT | (3 << GE_VTYPE_WEIGHTCOUNT_SHIFT), true },
+	{ "tc16 nrm16 pos16 w16x4", GE_VTYPE_TC_16BIT | GE_VTYPE_NRM_16BIT | GE_VTYPE_POS_16BIT | GE_VTYPE_WEIGHT_16BIT | (3 << GE_VTYPE_WEIGHTCOUNT_SHIFT), true },
+	{ "nrm16 pos16 w8x8", GE_VTYPE_NRM_16BIT | GE_VTYPE_POS_16BIT | GE_VTYPE_WEIGHT_8BIT | (7 << GE_VTYPE_WEIGHTCOUNT_SHIFT), true },
+	{ "nrmf posf wfx8", GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT | GE_VTYPE_WEIGHT_FLOAT | (7 << GE_VTYPE_WEIGHTCOUNT_SHIFT), true },
+	{ "col8888 pos16 morph2", GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT | (1 << GE_VTYPE_MORPHCOUNT_SHIFT), false },
+	{ "nrmf posf morph4", GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT | (3 << GE_VTYPE_MORPHCOUNT_SHIFT), false },
+};
+
+// Prints decoding throughput for some common vertex formats.  This isn't pass/fail.
+static void BenchmarkVertexJit() {
+	static const int VERTS = 1000;
+
+	for (int i = 0; i < 8 * 12; ++i)
+		gstate.boneMatrix[i] = (float)(i % 5) * 0.25f;
+	for (int i = 0; i < 8; ++i)
+		gstate_c.morphWeights[i] = 1.0f / (i + 1);
+
+	printf("Vertex decoder throughput (Mverts/s):\n");
+	for (const VertexBenchmark &bench : vertdecBenchmarks) {
+		VertexDecoderTestHarness dec;
+		VertexDecoderOptions opts{};
+		opts.applySkinInDecode = bench.skin;
+		dec.SetOptions(opts);
+
+		// The contents don't matter much, but avoid denormals.  0x3F3F3F3F is about 0.75f.
+		for (int i = 0; i < VERTS * 64; ++i)
+			dec.Add8(0x3F);
+
+		double yesJit = dec.ExecuteTimed(bench.vtype, VERTS, true, 0.1) * VERTS / 1000000.0;
+		double noJit = dec.ExecuteTimed(bench.vtype, VERTS, false, 0.1) * VERTS / 1000000.0;
+		printf("  %-26s jit %8.2f  steps %8.2f  (%.2fx)\n", bench.name, yesJit, noJit, yesJit / noJit);
+	}
+	printf("\n");
+}
+
+static bool CompareDecoded(const char *name, const char *what, const std::vector<u8> &expected, const u8 *actual, const DecVtxFormat &fmt) {
+	// Skinning and morphing are float math, so compare word by word, allowing a little rounding difference.
+	const int stride = fmt.stride;
+	for (size_t i = 0; i + 4 <= expected.size(); i += 4) {
+		if (memcmp(&expected[i], actual + i, 4) == 0)
+			continue;
+		if (fmt.c0fmt == DEC_U8_4 && (int)(i % stride) == fmt.c0off) {
+			// Morphed colors are rounded back to bytes, the steps and the jit may round differently.
+			bool close = true;
+			for (int c = 0; c < 4; ++c)
+				close = close && abs(expected[i + c] - actual[i + c]) <= 1;
+			if (close)
+				continue;
+			printf("%s: %s color differs at vertex %d: %08x != expected %08x\n", name, what, (int)(i / stride), *(const u32 *)(actual + i), *(const u32 *)&expected[i]);
+			return false;
+		}
+		float a, b;
+		memcpy(&a, &expected[i], 4);
+		memcpy(&b, actual + i, 4);
+		if (fabsf(a - b) <= 0.00001f * std::max(1.0f, fabsf(a)))
+			continue;
+		printf("%s: %s differs at vertex %d offset %d: %f != expected %f\n", name, what, (int)(i / stride), (int)(i % stride), b, a);
+		return false;
+	}
+	return true;
+}
+
+// Decodes the same skinned and morphed vertices with the steps, and the jit with AVX forced off and on.
+static bool TestVertexJitAVX() {
+	static const int VERTS = 64;
+	const bool hostAVX = cpu_info.bAVX;
+
+	GMRng rng;
+	rng.Init(0x28);
+	for (int i = 0; i < 8 * 12; ++i)
+		gstate.boneMatrix[i] = (float)((int)(rng.R32() % 2001) - 1000) / 500.0f;
+	for (int i = 0; i < 8; ++i)
+		gstate_c.morphWeights[i] = (float)(rng.R32() % 1001) / 1000.0f;
+
+	bool pass = true;
+	for (const VertexBenchmark &bench : vertdecBenchmarks) {
+		if (!bench.skin && (bench.vtype & GE_VTYPE_MORPHCOUNT_MASK) == 0)
+			continue;
+
+		VertexDecoderTestHarness dec;
+		VertexDecoderOptions opts{};
+		opts.applySkinInDecode = bench.skin;
+		dec.SetOptions(opts);
+		// Every fourth byte keeps float components within +/-0.5 to 2, no denormals or NaNs.
+		for (int i = 0; i < VERTS * 128; ++i)
+			dec.Add8((i & 3) == 3 ? (0x3F | (rng.R32() & 0x80)) : (u8)rng.R32());
+
+		dec.Execute(bench.vtype, VERTS - 1, false);
+		const DecVtxFormat fmt = dec.GetDecFmt();
+		const u8 *data = (const u8 *)dec.GetData();
+		std::vector<u8> expected(data, data + VERTS * fmt.stride);
+
+		cpu_info.bAVX = false;
+		dec.Execute(bench.vtype, VERTS - 1, true);
+		pass = CompareDecoded(bench.name, "jit", expected, data, fmt) && pass;
+
+		if (hostAVX) {
+			cpu_info.bAVX = true;
+			dec.Execute(bench.vtype, VERTS - 1, true);
+			pass = CompareDecoded(bench.name, "jit (AVX)", expected, data, fmt) && pass;
+		}
+		cpu_info.bAVX = hostAVX;
+	}
+
+	return pass;
+}
+
 typedef bool (*VertexTestFunc)();
 
 static VertexTestFunc vertdecTestFuncs[] = {
@@ -657,6 +786,8 @@ static VertexTestFunc vertdecTestFuncs[] = {
 	&TestVertex8Skin,
 	&TestVertex16Skin,
 	&TestVertexFloatSkin,
+
+	&TestVertexJitAVX,
 };
 
 bool TestVertexJit() {
@@ -682,6 +813,8 @@ bool TestVertexJit() {
 	printf("Result: %f, %f, %f\n", x, y, z);
 	printf("Jit was %fx faster than steps.\n\n", yesJit / noJit);
 
+	BenchmarkVertexJit();
+
 	bool pass = true;
 	for (size_t i = 0; i < ARRAY_SIZE(vertdecTestFuncs); ++i) {
 		if (!vertdecTestFuncs[i]()) {
@@ -48,6 +48,7 @@
 
 #include "Common/Data/Collections/TinySet.h"
 #include "Common/Data/Collections/FastVec.h"
+#include "Common/Data/Collections/EytzingerIndex.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Data/Text/Parsers.h"
 #include "Common/Data/Text/WrapText.h"
@@ -413,6 +414,55 @@ bool TestFastVec() {
 	return true;
 }
 
+bool TestEytzingerIndex() {
+	EytzingerIndex unbuilt;
+	EXPECT_EQ_INT((int)unbuilt.size(), 0);
+	EXPECT_EQ_INT((int)unbuilt.LowerBound(5), 0);
+	EXPECT_EQ_INT((int)unbuilt.UpperBound(5), 0);
+
+	EytzingerIndex empty;
+	empty.Build({});
+	EXPECT_EQ_INT((int)empty.size(), 0);
+	EXPECT_EQ_INT((int)empty.LowerBound(0), 0);
+	EXPECT_EQ_INT((int)empty.UpperBound(0xFFFFFFFF), 0);
+
+	EytzingerIndex one;
+	one.Build({ 100 });
+	EXPECT_EQ_INT((int)one.size(), 1);
+	EXPECT_EQ_INT((int)one.LowerBound(99), 0);
+	EXPECT_EQ_INT((int)one.UpperBound(99), 0);
+	EXPECT_EQ_INT((int)one.LowerBound(100), 0);
+	EXPECT_EQ_INT((int)one.UpperBound(100), 1);
+	EXPECT_EQ_INT((int)one.LowerBound(101), 1);
+	EXPECT_EQ_INT((int)one.UpperBound(101), 1);
+
+	EytzingerIndex dupes;
+	dupes.Build({ 0, 10, 10, 10, 20, 0xFFFFFFFF });
+	EXPECT_EQ_INT((int)dupes.LowerBound(0), 0);
+	EXPECT_EQ_INT((int)dupes.UpperBound(0), 1);
+	EXPECT_EQ_INT((int)dupes.LowerBound(10), 1);
+	EXPECT_EQ_INT((int)dupes.UpperBound(10), 4);
+	EXPECT_EQ_INT((int)dupes.LowerBound(15), 4);
+	EXPECT_EQ_INT((int)dupes.UpperBound(15), 4);
+	EXPECT_EQ_INT((int)dupes.LowerBound(0xFFFFFFFF), 5);
+	EXPECT_EQ_INT((int)dupes.UpperBound(0xFFFFFFFF), 6);
+
+	// Every size up to a few full levels, against the standard library.
+	for (int n = 0; n < 70; n++) {
+		std::vector<u32> keys;
+		for (int i = 0; i < n; i++)
+			keys.push_back(i * 4 + (i & 1) * 2);
+		EytzingerIndex index;
+		index.Build(keys);
+		EXPECT_EQ_INT((int)index.size(), n);
+		for (u32 key = 0; key < (u32)n * 4 + 4; key++) {
+			EXPECT_EQ_INT((int)index.LowerBound(key), (int)(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin()));
+			EXPECT_EQ_INT((int)index.UpperBound(key), (int)(std::upper_bound(keys.begin(), keys.end(), key) - keys.begin()));
+		}
+	}
+	return true;
+}
+
 bool TestVFPUSinCos() {
 	float sine, cosine;
 	// Needed for VFPU tables.
@@ -1048,6 +1098,12 @@ bool TestShaderGenerators();
 bool TestSoftwareGPUJit();
 bool TestIRPassSimplify();
 bool TestThreadManager();
+bool TestHTTPFileLoader();
+bool TestMemBlockInfo();
+bool TestKirkAES();
+bool TestReadbackPredictor();
+bool TestBlockAllocator();
+bool TestPathCaseIndex();
 bool TestVFS();
 
 TestItem availableTests[] = {
@@ -1070,6 +1126,7 @@ TestItem availableTests[] = {
 	TEST_ITEM(MathUtil),
 	TEST_ITEM(Parsers),
 	TEST_ITEM(IRPassSimplify),
+	TEST_ITEM(IRThreaded),
 	TEST_ITEM(Jit),
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
@@ -1084,11 +1141,18 @@ TestItem availableTests[] = {
 	TEST_ITEM(WrapText),
 	TEST_ITEM(TinySet),
 	TEST_ITEM(FastVec),
+	TEST_ITEM(EytzingerIndex),
 	TEST_ITEM(SmallDataConvert),
 	TEST_ITEM(DepthMath),
 	TEST_ITEM(InputMapping),
 	TEST_ITEM(EscapeMenuString),
 	TEST_ITEM(VFS),
+	TEST_ITEM(HTTPFileLoader),
+	TEST_ITEM(MemBlockInfo),
+	TEST_ITEM(KirkAES),
+	TEST_ITEM(ReadbackPredictor),
+	TEST_ITEM(BlockAllocator),
+	TEST_ITEM(PathCaseIndex),
 	TEST_ITEM(Substitutions),
 	TEST_ITEM(IniFile),
 	TEST_ITEM(ColorConv),